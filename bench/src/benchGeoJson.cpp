@@ -0,0 +1,160 @@
+#include "benchmark/benchmark.h"
+
+#include "data/formats/geoJson.h"
+#include "data/formats/topoJson.h"
+#include "data/tileData.h"
+#include "data/tileSource.h"
+#include "log.h"
+#include "tile/tileTask.h"
+#include "util/json.h"
+
+#include <string>
+
+using namespace Tangram;
+
+// Number of features per collection of the generated tiles
+const int num_features = 2000;
+
+const char* collections[] = { "water", "roads", "buildings", "pois" };
+
+// Large GeoJSON tile of named collections with polygons, lines and points
+static std::string makeGeoJson() {
+    std::string json = "{";
+    for (int c = 0; c < 4; c++) {
+        json += std::string(c ? "," : "") + "\"" + collections[c] +
+            "\":{\"type\":\"FeatureCollection\",\"features\":[";
+        for (int i = 0; i < num_features; i++) {
+            double x = -122.5 + 0.0001 * (i % 100);
+            double y = 37.7 + 0.0001 * (i / 100);
+            std::string p = "[" + std::to_string(x) + "," + std::to_string(y) + "]";
+            std::string q = "[" + std::to_string(x + 0.00005) + "," + std::to_string(y) + "]";
+            std::string r = "[" + std::to_string(x + 0.00005) + "," + std::to_string(y + 0.00005) + "]";
+
+            json += std::string(i ? "," : "") + "{\"type\":\"Feature\",\"properties\":{\"id\":" +
+                std::to_string(i) + ",\"kind\":\"" + collections[c] + "\",\"name\":\"feature " +
+                std::to_string(i) + "\",\"visible\":true},\"geometry\":";
+
+            if (c == 3) {
+                json += "{\"type\":\"Point\",\"coordinates\":" + p + "}}";
+            } else if (c == 1) {
+                json += "{\"type\":\"LineString\",\"coordinates\":[" + p + "," + q + "," + r + "]}}";
+            } else {
+                json += "{\"type\":\"Polygon\",\"coordinates\":[[" + p + "," + q + "," + r + "," + p + "]]}}";
+            }
+        }
+        json += "]}";
+    }
+    json += "}";
+    return json;
+}
+
+// TopoJSON tile with one quantized arc per line or polygon feature
+static std::string makeTopoJson() {
+    std::string objects, arcs;
+    int arc = 0;
+    for (int c = 0; c < 4; c++) {
+        objects += std::string(c ? "," : "") + "\"" + collections[c] +
+            "\":{\"type\":\"GeometryCollection\",\"geometries\":[";
+        for (int i = 0; i < num_features; i++) {
+            objects += std::string(i ? "," : "") + "{\"properties\":{\"id\":" + std::to_string(i) +
+                ",\"kind\":\"" + collections[c] + "\"},";
+            if (c == 3) {
+                objects += "\"type\":\"Point\",\"coordinates\":[" + std::to_string(i % 100) + "," +
+                    std::to_string(i / 100) + "]}";
+                continue;
+            }
+            objects += c == 1
+                ? "\"type\":\"LineString\",\"arcs\":[" + std::to_string(arc) + "]}"
+                : "\"type\":\"Polygon\",\"arcs\":[[" + std::to_string(arc) + "]]}";
+
+            arcs += std::string(arc ? "," : "") + "[[" + std::to_string(i % 100) + "," +
+                std::to_string(i / 100) + "],[5,0],[0,5],[-5,-5]]";
+            arc++;
+        }
+        objects += "]}";
+    }
+    return "{\"type\":\"Topology\",\"transform\":{\"scale\":[0.0001,0.0001],"
+        "\"translate\":[-122.5,37.7]},\"objects\":{" + objects + "},\"arcs\":[" + arcs + "]}";
+}
+
+struct JsonFixture : public benchmark::Fixture {
+    std::shared_ptr<TileSource> source;
+    std::shared_ptr<TileTask> geoJsonTask;
+    std::shared_ptr<TileTask> topoJsonTask;
+    std::shared_ptr<TileData> tileData;
+
+    std::shared_ptr<TileTask> makeTask(const std::string& _json) {
+        auto task = source->createTask({163, 395, 10});
+        auto& t = dynamic_cast<BinaryTileTask&>(*task);
+        t.rawTileData = std::make_shared<std::vector<char>>(_json.begin(), _json.end());
+        return task;
+    }
+
+    void SetUp(const ::benchmark::State& state) override {
+        source = std::make_shared<TileSource>("test", nullptr);
+        geoJsonTask = makeTask(makeGeoJson());
+        topoJsonTask = makeTask(makeTopoJson());
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        tileData.reset();
+    }
+
+    size_t size(const std::shared_ptr<TileTask>& _task) {
+        return dynamic_cast<BinaryTileTask&>(*_task).rawTileData->size();
+    }
+};
+
+// Reference: building the rapidjson DOM alone, which GeoJson used to do
+// before converting the document into TileData
+BENCHMARK_DEFINE_F(JsonFixture, JsonDocumentBench)(benchmark::State& st) {
+    auto& data = *dynamic_cast<BinaryTileTask&>(*geoJsonTask).rawTileData;
+    const char* error;
+    size_t offset;
+
+    while (st.KeepRunning()) {
+        auto document = JsonParseBytes(data.data(), data.size(), &error, &offset);
+        benchmark::DoNotOptimize(document);
+    }
+    st.SetBytesProcessed(st.iterations() * data.size());
+}
+BENCHMARK_REGISTER_F(JsonFixture, JsonDocumentBench);
+
+BENCHMARK_DEFINE_F(JsonFixture, GeoJsonBench)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        tileData = GeoJson::parseTile(*geoJsonTask, 0);
+
+        if (tileData->layers.size() != 4) {
+            LOGE("Invalid GeoJSON tile");
+            exit(-1);
+        }
+    }
+    st.SetBytesProcessed(st.iterations() * size(geoJsonTask));
+}
+BENCHMARK_REGISTER_F(JsonFixture, GeoJsonBench);
+
+// Only one collection is used by the scene, the others are skipped
+BENCHMARK_DEFINE_F(JsonFixture, GeoJsonSkipCollectionsBench)(benchmark::State& st) {
+    std::vector<std::string> used = { "roads" };
+
+    while (st.KeepRunning()) {
+        tileData = GeoJson::parseTile(*geoJsonTask, 0, used);
+    }
+    st.SetBytesProcessed(st.iterations() * size(geoJsonTask));
+}
+BENCHMARK_REGISTER_F(JsonFixture, GeoJsonSkipCollectionsBench);
+
+BENCHMARK_DEFINE_F(JsonFixture, TopoJsonBench)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        tileData = TopoJson::parseTile(*topoJsonTask, 0);
+
+        if (tileData->layers.size() != 4) {
+            LOGE("Invalid TopoJSON tile");
+            exit(-1);
+        }
+    }
+    st.SetBytesProcessed(st.iterations() * size(topoJsonTask));
+}
+BENCHMARK_REGISTER_F(JsonFixture, TopoJsonBench);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,69 @@
+#include "benchmark/benchmark.h"
+
+#include "gl/hardware.h"
+#include "gl/mesh.h"
+#include "gl/renderState.h"
+
+#include <memory>
+
+using namespace Tangram;
+
+struct PolygonVertex {
+    glm::vec3 pos;
+    glm::vec3 norm;
+    GLuint abgr;
+};
+
+static std::shared_ptr<VertexLayout> layout = std::shared_ptr<VertexLayout>(new VertexLayout({
+    {"a_position", 3, GL_FLOAT, false, 0},
+    {"a_normal", 3, GL_FLOAT, false, 0},
+    {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+}));
+
+struct BenchMesh : public Mesh<PolygonVertex> {
+    using Mesh<PolygonVertex>::Mesh;
+
+    // One draw call per batch of vertices
+    size_t drawCalls() const { return m_vertexOffsets.size(); }
+};
+
+// Extruded building walls: one quad per feature part
+static MeshData<PolygonVertex> createWalls(size_t _quads) {
+    MeshData<PolygonVertex> meshData;
+
+    for (size_t i = 0; i < _quads; i++) {
+        float x = i;
+        meshData.vertices.push_back({ {x, 0, 0}, {0, 1, 0}, 0xffffffff });
+        meshData.vertices.push_back({ {x + 1, 0, 0}, {0, 1, 0}, 0xffffffff });
+        meshData.vertices.push_back({ {x + 1, 0, 1}, {0, 1, 0}, 0xffffffff });
+        meshData.vertices.push_back({ {x, 0, 1}, {0, 1, 0}, 0xffffffff });
+        meshData.indices.insert(meshData.indices.end(), { 0, 1, 2, 2, 3, 0 });
+        meshData.offsets.emplace_back(6, 4);
+    }
+    return meshData;
+}
+
+// Compile and upload a tile mesh with 16 or 32 bit indices
+template<bool LargeIndices>
+static void BM_CompileMesh(benchmark::State& st) {
+    Hardware::supportsElementIndexUint = LargeIndices;
+
+    RenderState rs;
+    auto meshData = createWalls(st.range(0));
+    size_t drawCalls = 0;
+
+    while (st.KeepRunning()) {
+        BenchMesh mesh(layout, GL_TRIANGLES);
+        mesh.compile(meshData);
+        mesh.upload(rs, SIZE_MAX);
+        drawCalls = mesh.drawCalls();
+    }
+    st.counters["drawCalls"] = drawCalls;
+    st.SetItemsProcessed(st.iterations() * meshData.indices.size());
+
+    Hardware::supportsElementIndexUint = false;
+}
+BENCHMARK_TEMPLATE(BM_CompileMesh, false)->RangeMultiplier(4)->Range(1024, 262144);
+BENCHMARK_TEMPLATE(BM_CompileMesh, true)->RangeMultiplier(4)->Range(1024, 262144);
+
+BENCHMARK_MAIN();
@@ -1,5 +1,6 @@
 #include "benchmark/benchmark.h"
 
+#include "data/propertyItem.h"
 #include "data/tileData.h"
 #include "js/JavaScript.h"
 #include "scene/styleContext.h"
@@ -108,6 +109,7 @@ RUN(DuktapeGetPropertyFixture, DuktapeGetPropertyBench)
 struct JSTileStyleFnFixture : public benchmark::Fixture {
     StyleContext ctx;
     Feature feature;
+    DecodeBuffers buffers;
     uint32_t numFunctions = 0;
     uint32_t evalCnt = 0;
 
@@ -133,7 +135,7 @@ struct JSTileStyleFnFixture : public benchmark::Fixture {
                     if (!layerContainsCollection) { continue; }
                 }
 
-                for (const auto& feat : collection.features) {
+                auto styleFeature = [&](const Feature& feat) {
                     ctx.setFeature(feat);
 
                     std::function<void(const SceneLayer& layer)> filter;
@@ -154,6 +156,18 @@ struct JSTileStyleFnFixture : public benchmark::Fixture {
                         }
                     };
                     filter(datalayer);
+                };
+
+                for (const auto& feat : collection.features) {
+                    styleFeature(feat);
+                }
+
+                if (collection.decoder) {
+                    for (size_t i = 0; i < collection.decoder->featureCount(); i++) {
+                        if (collection.decoder->decodeFeature(i, feature, buffers)) {
+                            styleFeature(feature);
+                        }
+                    }
                 }
             }
         }
@@ -162,6 +176,66 @@ struct JSTileStyleFnFixture : public benchmark::Fixture {
 
 RUN(JSTileStyleFnFixture, TileStyleFnBench);
 
+// Match all scene layer filters against the features of the tile,
+// walking the Filter trees or running the compiled FilterPrograms.
+template<bool compiled>
+struct TileFilterFixture : public benchmark::Fixture {
+    StyleContext ctx;
+    Feature feature;
+    DecodeBuffers buffers;
+    std::vector<Feature> features;
+    uint32_t matchCnt = 0;
+
+    void SetUp(const ::benchmark::State& state) override {
+        globalSetup();
+        ctx.initFunctions(*scene);
+        ctx.setKeywordZoom(10);
+
+        // Decode once, only filter matching is measured
+        features.clear();
+        for (const auto& collection : tileData->layers) {
+            for (const auto& feat : collection.features) {
+                features.push_back(feat);
+            }
+            if (collection.decoder) {
+                for (size_t i = 0; i < collection.decoder->featureCount(); i++) {
+                    if (collection.decoder->decodeFeature(i, feature, buffers)) {
+                        features.push_back(feature);
+                    }
+                }
+            }
+        }
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        LOG(">>> %d", matchCnt);
+    }
+    __attribute__ ((noinline)) void run() {
+        std::function<void(const SceneLayer&, const Feature&)> match;
+        match = [&](const SceneLayer& layer, const Feature& feat) {
+            bool matched = compiled
+                ? layer.filterProgram().eval(feat, ctx)
+                : layer.filter().eval(feat, ctx);
+            if (!matched) { return; }
+            matchCnt++;
+            for (const auto& sublayer : layer.sublayers()) {
+                match(sublayer, feat);
+            }
+        };
+
+        for (const auto& feat : features) {
+            ctx.setFeature(feat);
+            for (const auto& datalayer : scene->layers()) {
+                match(datalayer, feat);
+            }
+        }
+    }
+};
+
+using TileFilterTreeFixture = TileFilterFixture<false>;
+RUN(TileFilterTreeFixture, TileFilterTreeBench);
+using TileFilterProgramFixture = TileFilterFixture<true>;
+RUN(TileFilterProgramFixture, TileFilterProgramBench);
+
 class DirectGetPropertyFixture : public benchmark::Fixture {
 public:
     Feature feature;
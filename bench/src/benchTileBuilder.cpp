@@ -1,5 +1,6 @@
 #include "benchmark/benchmark.h"
 
+#include "data/propertyItem.h"
 #include "data/tileSource.h"
 #include "gl.h"
 #include "log.h"
@@ -14,8 +15,13 @@
 #include "tile/tileBuilder.h"
 #include "tile/tileTask.h"
 
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 
@@ -95,6 +101,150 @@ public:
 
 RUN(TileBuilderFixture, TileBuilderBench);
 
+// Same as TileBuilderBench, reports the scratch memory used per tile
+BENCHMARK_DEFINE_F(TileBuilderFixture, TileBuilderArenaBench)(benchmark::State& st) {
+    while (st.KeepRunning()) { run(); }
+
+    auto stats = tileBuilder->arena().stats();
+    st.SetLabel("arena peak " + std::to_string(stats.peak / 1024) + "kB, " +
+                std::to_string(stats.blocks) + " blocks");
+}
+BENCHMARK_REGISTER_F(TileBuilderFixture, TileBuilderArenaBench);
+
+// Same as TileBuilderBench with the scratch memory of the StyleBuilders taken
+// from the heap, to compare with the arena
+class HeapTileBuilderFixture : public TileBuilderFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        TileBuilderFixture::SetUp(state);
+        for (auto& style : scene->styles()) {
+            if (auto* builder = tileBuilder->getStyleBuilder(style->getName())) {
+                builder->setArena(nullptr);
+            }
+        }
+    }
+};
+
+RUN(HeapTileBuilderFixture, TileBuilderHeapBench);
+
+// Decode all features of the tile with their geometry. With @reuse, into one
+// Feature and DecodeBuffers like the TileBuilder does, otherwise into new ones
+// for each feature, so that properties and geometry go through the heap.
+template<bool reuse>
+class DecodeFixture : public benchmark::Fixture {
+public:
+    Feature feature;
+    DecodeBuffers buffers;
+    size_t numFeatures = 0;
+    void SetUp(const ::benchmark::State& state) override {
+        globalSetup();
+    }
+    __attribute__ ((noinline)) void run() {
+        for (const auto& layer : tileData->layers) {
+            if (!layer.decoder) { continue; }
+
+            for (size_t i = 0, n = layer.decoder->featureCount(); i < n; i++) {
+                if (reuse) {
+                    decode(*layer.decoder, i, feature, buffers);
+                } else {
+                    Feature newFeature;
+                    DecodeBuffers newBuffers;
+                    decode(*layer.decoder, i, newFeature, newBuffers);
+                }
+            }
+        }
+    }
+    void decode(const FeatureDecoder& _decoder, size_t _index, Feature& _feature, DecodeBuffers& _buffers) {
+        if (_decoder.decodeFeature(_index, _feature, _buffers) &&
+            _decoder.decodeGeometry(_index, _feature, _buffers)) {
+            numFeatures++;
+        }
+    }
+};
+
+using HeapDecodeFixture = DecodeFixture<false>;
+RUN(HeapDecodeFixture, DecodeHeapBench);
+using ReuseDecodeFixture = DecodeFixture<true>;
+RUN(ReuseDecodeFixture, DecodeReuseBench);
+
+// Helper threads with their own TileBuilder, like the idle TileWorkers
+class PartPool : public TileBuilder::PartQueue {
+public:
+    explicit PartPool(size_t _numThreads) {
+        for (size_t i = 0; i < _numThreads; i++) {
+            m_threads.emplace_back([this] { run(); });
+        }
+    }
+
+    ~PartPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_condition.notify_all();
+        for (auto& thread : m_threads) { thread.join(); }
+    }
+
+    size_t idleWorkers() override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_idle > m_parts.size() ? m_idle - m_parts.size() : 0;
+    }
+
+    void enqueue(std::shared_ptr<TileBuilder::Part> _part) override {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_parts.push_back(std::move(_part));
+        }
+        m_condition.notify_one();
+    }
+
+private:
+    void run() {
+        TileBuilder builder(scene, new StyleContext());
+
+        while (true) {
+            std::shared_ptr<TileBuilder::Part> part;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_idle++;
+                m_condition.wait(lock, [this] { return !m_running || !m_parts.empty(); });
+                m_idle--;
+
+                if (!m_running) { return; }
+
+                part = std::move(m_parts.front());
+                m_parts.pop_front();
+            }
+            builder.buildPart(*part);
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::shared_ptr<TileBuilder::Part>> m_parts;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    size_t m_idle = 0;
+    bool m_running = true;
+};
+
+// Same tile with its layers split across three helper threads
+class ParallelTileBuilderFixture : public TileBuilderFixture {
+public:
+    std::unique_ptr<PartPool> pool;
+    void SetUp(const ::benchmark::State& state) override {
+        TileBuilderFixture::SetUp(state);
+        pool = std::make_unique<PartPool>(3);
+        tileBuilder->setPartQueue(pool.get());
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        TileBuilderFixture::TearDown(state);
+        tileBuilder.reset();
+        pool.reset();
+    }
+};
+
+RUN(ParallelTileBuilderFixture, ParallelTileBuilderBench);
+
 
 
 BENCHMARK_MAIN();
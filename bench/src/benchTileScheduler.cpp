@@ -0,0 +1,117 @@
+#include "benchmark/benchmark.h"
+
+#include "data/tileSource.h"
+#include "tile/tileScheduler.h"
+#include "tile/tileTask.h"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+// Reference implementation of the previous TileWorker queue:
+// one mutex-guarded vector with linear scans on each pop.
+struct LinearQueue {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TileTask>> queue;
+
+    void push(std::shared_ptr<TileTask> _task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(_task));
+    }
+
+    std::shared_ptr<TileTask> pop(size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto removes = std::remove_if(queue.begin(), queue.end(),
+                                      [](const auto& a) { return a->isCanceled(); });
+        queue.erase(removes, queue.end());
+
+        if (queue.empty()) { return nullptr; }
+
+        auto it = std::min_element(queue.begin(), queue.end(),
+            [](const auto& a, const auto& b) {
+                if (a->isProxy() != b->isProxy()) {
+                    return !a->isProxy();
+                }
+                if (a->sourceId() == b->sourceId() &&
+                    a->sourceGeneration() != b->sourceGeneration()) {
+                    return a->sourceGeneration() < b->sourceGeneration();
+                }
+                return a->getPriority() < b->getPriority();
+            });
+
+        auto task = std::move(*it);
+        queue.erase(it);
+        return task;
+    }
+};
+
+struct SchedulerQueue {
+    TileScheduler scheduler{4};
+
+    void push(std::shared_ptr<TileTask> _task) { scheduler.push(std::move(_task)); }
+    std::shared_ptr<TileTask> pop(size_t _worker) { return scheduler.pop(_worker); }
+};
+
+static std::vector<std::shared_ptr<TileTask>> createTasks(size_t _count) {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> priority(0, 1000);
+
+    std::vector<std::shared_ptr<TileTask>> tasks;
+    for (size_t i = 0; i < _count; i++) {
+        TileID tileId(i % 1024, i / 1024, 10);
+        auto task = std::make_shared<TileTask>(tileId, source, -1);
+        task->setPriority(priority(random));
+        task->setProxyState(i % 8 == 0);
+        tasks.push_back(std::move(task));
+    }
+    return tasks;
+}
+
+// Pop latency at a constant queue depth: pop one task and push it back.
+template<class Queue>
+static void BM_PopAtDepth(benchmark::State& st) {
+    Queue queue;
+    auto tasks = createTasks(st.range(0));
+    for (auto& task : tasks) { queue.push(task); }
+
+    while (st.KeepRunning()) {
+        auto task = queue.pop(0);
+        queue.push(std::move(task));
+    }
+    st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK_TEMPLATE(BM_PopAtDepth, LinearQueue)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK_TEMPLATE(BM_PopAtDepth, SchedulerQueue)->RangeMultiplier(4)->Range(16, 4096);
+
+// Throughput: drain a queue of the given depth with four worker threads.
+template<class Queue>
+static void BM_DrainWithWorkers(benchmark::State& st) {
+    const size_t numWorkers = 4;
+    auto tasks = createTasks(st.range(0));
+
+    while (st.KeepRunning()) {
+        st.PauseTiming();
+        Queue queue;
+        for (auto& task : tasks) { queue.push(task); }
+        st.ResumeTiming();
+
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < numWorkers; w++) {
+            workers.emplace_back([&queue, w] {
+                while (queue.pop(w)) {}
+            });
+        }
+        for (auto& worker : workers) { worker.join(); }
+    }
+    st.SetItemsProcessed(st.iterations() * tasks.size());
+}
+BENCHMARK_TEMPLATE(BM_DrainWithWorkers, LinearQueue)->RangeMultiplier(4)->Range(64, 4096)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_DrainWithWorkers, SchedulerQueue)->RangeMultiplier(4)->Range(64, 4096)->UseRealTime();
+
+BENCHMARK_MAIN();
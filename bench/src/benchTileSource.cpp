@@ -1,5 +1,6 @@
 #include "benchmark/benchmark.h"
 
+#include "data/tileData.h"
 #include "data/tileSource.h"
 #include "log.h"
 #include "map.h"
@@ -44,5 +45,36 @@ BENCHMARK_DEFINE_F(TileSourceFixture, TileSourceBench)(benchmark::State& st) {
 }
 BENCHMARK_REGISTER_F(TileSourceFixture, TileSourceBench);
 
+// Parse and decode all features including geometry, i.e. the worst case
+// when every feature of every layer matches a draw rule.
+BENCHMARK_DEFINE_F(TileSourceFixture, TileSourceDecodeAllBench)(benchmark::State& st) {
+    Feature feature;
+    DecodeBuffers buffers;
+    size_t numFeatures = 0;
+
+    while (st.KeepRunning()) {
+
+        tileData = source->parse(*tileTask);
+
+        if (!tileData) {
+            LOGE("Invalid tile file '%s'", tile_file);
+            exit(-1);
+        }
+
+        for (auto& layer : tileData->layers) {
+            if (!layer.decoder) { continue; }
+
+            for (size_t i = 0, n = layer.decoder->featureCount(); i < n; i++) {
+                if (layer.decoder->decodeFeature(i, feature, buffers) &&
+                    layer.decoder->decodeGeometry(i, feature, buffers)) {
+                    numFeatures++;
+                }
+            }
+        }
+    }
+    st.SetItemsProcessed(numFeatures);
+}
+BENCHMARK_REGISTER_F(TileSourceFixture, TileSourceDecodeAllBench);
+
 
 BENCHMARK_MAIN();
@@ -28,9 +28,20 @@ public:
 
     // Add geometry from a GeoJSON string
     void addData(const std::string& _data);
-    void addPoint(const Properties& _tags, LngLat _point);
-    void addLine(const Properties& _tags, const Coordinates& _line);
-    void addPoly(const Properties& _tags, const std::vector<Coordinates>& _poly);
+
+    // Add a feature and return its id for later updates
+    uint64_t addPoint(const Properties& _tags, LngLat _point);
+    uint64_t addLine(const Properties& _tags, const Coordinates& _line);
+    uint64_t addPoly(const Properties& _tags, const std::vector<Coordinates>& _poly);
+
+    // Replace geometry and properties of feature @_id, returns false when it does not exist
+    bool updatePoint(uint64_t _id, const Properties& _tags, LngLat _point);
+    bool updateLine(uint64_t _id, const Properties& _tags, const Coordinates& _line);
+    bool updatePoly(uint64_t _id, const Properties& _tags, const std::vector<Coordinates>& _poly);
+
+    // Remove feature @_id, returns false when it does not exist
+    bool removeFeature(uint64_t _id);
+
     void generateLabelCentroidFeature();
 
     virtual void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
@@ -39,6 +50,10 @@ public:
     virtual void cancelLoadingTile(TileTask& _task) override {};
     virtual void clearData() override;
 
+    // Only tiles intersecting changed features get a new generation
+    using TileSource::generation;
+    virtual int64_t generation(const TileID& _tileId) const override;
+
 protected:
 
     virtual std::shared_ptr<TileData> parse(const TileTask& _task) const override;
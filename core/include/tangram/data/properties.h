@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -25,6 +26,10 @@ struct Properties {
 
     const Value& get(const std::string& key) const;
 
+    // Lookup by interned key id (see PropertyKeys). Falls back to compare
+    // @key when the items were not set with resolved key ids.
+    const Value& get(int32_t keyId, const std::string& key) const;
+
     void sort();
 
     void clear();
@@ -52,6 +57,10 @@ struct Properties {
 
     void setSorted(std::vector<Item>&& _items);
 
+    // Move out the items, so that their storage can be reused for the
+    // items passed to the next setSorted()
+    std::vector<Item> takeItems();
+
     // template <typename... Args> void set(std::string key, Args&&... args) {
     //     props.emplace_back(std::move(key), Value{std::forward<Args>(args)...});
     //     sort();
@@ -70,6 +79,8 @@ struct Properties {
     }
 private:
     std::vector<Item> props;
+    // True when all items have a resolved keyId
+    bool m_hasKeyIds = true;
 };
 
 }
@@ -2,14 +2,18 @@
 
 #include "util/variant.h"
 
+#include <cstdint>
+
 namespace Tangram {
 
 struct PropertyItem {
-    PropertyItem(std::string _key, Value _value) :
-        key(std::move(_key)), value(std::move(_value)) {}
+    PropertyItem(std::string _key, Value _value, int32_t _keyId = -1) :
+        key(std::move(_key)), value(std::move(_value)), keyId(_keyId) {}
 
     std::string key;
     Value value;
+    // Interned id of key, see PropertyKeys. -1 when not resolved.
+    int32_t keyId;
     bool operator<(const PropertyItem& _rhs) const {
         return key.size() == _rhs.key.size()
             ? key < _rhs.key
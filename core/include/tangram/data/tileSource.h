@@ -14,6 +14,7 @@ struct TileID;
 struct Raster;
 class Tile;
 class TileManager;
+class TileMeshCache;
 struct RawCache;
 class Texture;
 
@@ -118,6 +119,10 @@ public:
     /* Generation ID of TileSource state (incremented for each update, e.g. on clearData()) */
     int64_t generation() const { return m_generation; }
 
+    /* Generation in which the data of @_tileId last changed. Sources that track
+     * changes per tile override this so that unaffected tiles are kept. */
+    virtual int64_t generation(const TileID& _tileId) const { return m_generation; }
+
     const ZoomOptions& zoomOptions() { return m_zoomOptions; }
     int32_t minDisplayZoom() const { return m_zoomOptions.minDisplayZoom; }
     int32_t maxDisplayZoom() const { return m_zoomOptions.maxDisplayZoom; }
@@ -137,11 +142,21 @@ public:
     bool generateGeometry() const { return m_generateGeometry; }
     void generateGeometry(bool generateGeometry) { m_generateGeometry = generateGeometry; }
 
+    /* Register data collections referenced by scene layers. When set, the
+     * parser may skip collections that no layer uses. */
+    void addCollections(const std::vector<std::string>& _collections);
+    const auto& collections() const { return m_collections; }
+
     /* Avoid RTTI by adding a boolean check on the data source object */
     virtual bool isRaster() const { return false; }
 
     void setFormat(Format format) { m_format = format; }
 
+    /* Store built tiles in @_meshCache and restore them from it when they are
+     * loaded again, see <TileMeshCache> */
+    void setMeshCache(std::shared_ptr<TileMeshCache> _meshCache) { m_meshCache = std::move(_meshCache); }
+    TileMeshCache* meshCache() const { return m_meshCache.get(); }
+
 protected:
 
     void createSubTasks(std::shared_ptr<TileTask> _task);
@@ -153,6 +168,9 @@ protected:
     // Name used to identify this source in the style sheet
     std::string m_name;
 
+    // Data collections used by scene layers, empty when unknown
+    std::vector<std::string> m_collections;
+
     // zoom dependent props
     ZoomOptions m_zoomOptions;
 
@@ -168,6 +186,8 @@ protected:
     std::vector<std::shared_ptr<TileSource>> m_rasterSources;
 
     std::unique_ptr<DataSource> m_sources;
+
+    std::shared_ptr<TileMeshCache> m_meshCache;
 };
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "data/properties.h"
+#include "tile/tileStats.h"
 #include "util/types.h"
 
 #include <array>
@@ -78,6 +79,16 @@ struct SceneError {
     Error error;
 };
 
+struct TextCacheStats {
+    // Label texts that were laid out from the cache, or shaped
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Shaped texts dropped from the cache to stay within its size limit
+    uint64_t evictions = 0;
+    // Number of cached shaped texts
+    uint64_t entries = 0;
+};
+
 using SceneID = int32_t;
 
 // Function type for a sceneReady callback
@@ -184,6 +195,17 @@ public:
     // Initialize graphics resources; OpenGL context must be created prior to calling this
     void setupGL();
 
+    // Keep binaries of linked shader programs in the directory _path, so that later
+    // runs with the same driver can skip compiling; with an empty path binaries are
+    // only kept in memory. Call before setupGL().
+    void setShaderCachePath(const std::string& _path);
+
+    // Build the shader programs of all styles in the current scene, loading them from
+    // the shader cache where possible, to avoid compiling during the first frames.
+    // Must be called on the GL thread once the scene is ready. Returns the number of
+    // programs built.
+    int warmShaderPrograms();
+
     // Resize the map view to a new width and height (in pixels)
     void resize(int _newWidth, int _newHeight);
 
@@ -363,6 +385,27 @@ public:
     // are invalidated after this.
     void markerRemoveAll();
 
+    // Add _count point markers at the positions in _lngLats which all use the same styling; _styling
+    // is a string of YAML that specifies a 'draw rule' or, if _isPath is true, a path to a draw rule
+    // in the current scene; the IDs of the new markers are written to _markers, which must have room
+    // for _count IDs; the marker meshes are built on worker threads and appear in a later frame;
+    // returns true if the markers were added, or false if the styling is invalid.
+    bool markerAddPoints(const LngLat* _lngLats, int _count, const char* _styling, bool _isPath,
+                         MarkerID* _markers);
+
+    // Set the geometry of _count markers to points at the positions in _lngLats; markers that are
+    // already points are moved without rebuilding their meshes; returns the number of marker IDs
+    // that were found and updated.
+    int markerSetPoints(const MarkerID* _markers, const LngLat* _lngLats, int _count);
+
+    // Set the same styling for _count markers, see 'markerAddPoints'; returns true if the styling
+    // is valid, otherwise returns false and leaves the markers unchanged.
+    bool markerSetStyling(const MarkerID* _markers, int _count, const char* _styling, bool _isPath);
+
+    // Remove _count marker objects from the map; returns the number of marker IDs that were found
+    // and removed.
+    int markerRemove(const MarkerID* _markers, int _count);
+
     // Respond to a tap at the given screen coordinates (x right, y down)
     void handleTapGesture(float _posX, float _posY);
 
@@ -420,6 +463,20 @@ public:
 
     std::shared_ptr<Platform>& getPlatform();
 
+    // Get hit, miss and eviction counts and the memory usage of the tile cache
+    TileCacheStats getTileCacheStats();
+
+    // Get hit, miss and eviction counts of the shaped text cache of the current scene
+    TextCacheStats getTextCacheStats();
+
+    // Load tiles which are expected to become visible during flings and camera animations.
+    // At most _maxTiles prefetch tasks run at a time, and no more are started while ready
+    // prefetched tiles take _maxBytes. Prefetching is disabled with _maxTiles = 0.
+    void setTilePrefetchBudget(uint32_t _maxTiles, uint64_t _maxBytes);
+
+    // Get the number of prefetched tiles which were used or wasted
+    TilePrefetchStats getTilePrefetchStats();
+
 private:
 
     class Impl;
@@ -81,6 +81,11 @@ public:
     // will have an error string and the data may not be complete.
     virtual void cancelUrlRequest(UrlRequestHandle _request) = 0;
 
+    // Hint the order in which pending URL requests are started, lower values
+    // first. Requests which are already transferring are not affected. The
+    // default implementation ignores the hint.
+    virtual void setUrlRequestPriority(UrlRequestHandle _request, float _priority);
+
     virtual FontSourceHandle systemFont(const std::string& _name, const std::string& _weight, const std::string& _face) const;
 
     virtual std::vector<FontSourceHandle> systemFontFallbacksHandle() const;
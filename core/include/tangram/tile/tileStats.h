@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Tangram {
+
+struct TileCacheStats {
+    // Tile lookups that were served from the cache, or not
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Tiles dropped from the cache to stay within its size limit
+    uint64_t evictions = 0;
+    // Bytes of cached tiles uploaded to GPU and held in client memory
+    uint64_t gpuBytes = 0;
+    uint64_t cpuBytes = 0;
+    // Size limit of the cache in bytes
+    uint64_t maxBytes = 0;
+    // Number of cached tiles
+    uint64_t tiles = 0;
+};
+
+struct TilePrefetchStats {
+    // Tiles loaded ahead of the camera motion
+    uint64_t requested = 0;
+    // Prefetched tiles which became visible, or were dropped before
+    uint64_t hits = 0;
+    uint64_t wasted = 0;
+    // Prefetch tasks in progress
+    uint64_t pending = 0;
+    // Bytes of prefetched tiles which are ready and wait to become visible
+    uint64_t bytes = 0;
+};
+
+}
@@ -15,6 +15,7 @@ class TileBuilder;
 class TileSource;
 class Tile;
 class MapProjection;
+class RenderState;
 struct TileData;
 
 
@@ -32,6 +33,10 @@ public:
 
     virtual bool hasData() const { return true; }
 
+    // Hash of the data the tile is built from, to validate tiles restored
+    // from a <TileMeshCache>
+    virtual uint32_t dataHash() const { return 0; }
+
     virtual bool isReady() const {
         if (needsLoading()) { return false; }
 
@@ -44,7 +49,7 @@ public:
     void setTile(std::unique_ptr<Tile>&& _tile);
 
     std::shared_ptr<TileSource> source() { return m_source.lock(); }
-    int64_t sourceId() { return m_sourceId; }
+    int64_t sourceId() const { return m_sourceId; }
     int64_t sourceGeneration() const { return m_sourceGeneration; }
 
     TileID tileId() const { return m_tileId; }
@@ -63,6 +68,10 @@ public:
     void setProxyState(bool isProxy) { m_proxyState = isProxy; }
     bool isProxy() const { return m_proxyState; }
 
+    // Prefetch tasks rank behind all tasks of tiles in view and their proxies
+    void setPrefetchState(bool _prefetch) { m_prefetchState = _prefetch; }
+    bool isPrefetch() const { return m_prefetchState; }
+
     auto& subTasks() { return m_subTasks; }
     int subTaskId() const { return m_subTaskId; }
     bool isSubTask() const { return m_subTaskId >= 0; }
@@ -76,6 +85,13 @@ public:
     // onDone for sub-tasks
     virtual void complete(TileTask& _mainTask) {}
 
+    // Whether meshes of the tile or textures of this task or its sub-tasks
+    // still have to be uploaded. Called on the render thread once ready.
+    virtual bool needsUpload() const;
+
+    // Upload about @_maxBytes of pending data, returns the number of bytes uploaded
+    virtual size_t upload(RenderState& _rs, size_t _maxBytes);
+
     int rawSource = 0;
 
     bool needsLoading() const { return m_needsLoading; }
@@ -111,6 +127,7 @@ protected:
 
     std::atomic<float> m_priority;
     std::atomic<bool> m_proxyState;
+    std::atomic<bool> m_prefetchState;
 };
 
 class BinaryTileTask : public TileTask {
@@ -121,6 +138,9 @@ public:
     virtual bool hasData() const override {
         return rawTileData && !rawTileData->empty();
     }
+
+    uint32_t dataHash() const override;
+
     // Raw tile data that will be processed by TileSource.
     std::shared_ptr<std::vector<char>> rawTileData;
 
@@ -132,6 +152,9 @@ public:
 
 struct TileTaskQueue {
     virtual void enqueue(std::shared_ptr<TileTask> task) = 0;
+
+    // Called after the priority or proxy state of enqueued tasks changed
+    virtual void updatePriorities() {}
 };
 
 struct TileTaskCb {
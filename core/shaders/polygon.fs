@@ -22,7 +22,13 @@ uniform mat3 u_inverse_normal_matrix;
 
 varying vec4 v_world_position;
 varying vec4 v_position;
-varying vec4 v_color;
+#ifdef TANGRAM_COMPACT_VERTICES
+    uniform sampler2D u_palette;
+    varying vec2 v_palette_coord;
+    vec4 v_color;
+#else
+    varying vec4 v_color;
+#endif
 varying vec3 v_normal;
 
 #ifdef TANGRAM_USE_TEX_COORDS
@@ -52,6 +58,10 @@ vec3 worldNormal() {
 
 void main(void) {
 
+    #ifdef TANGRAM_COMPACT_VERTICES
+        v_color = texture2D(u_palette, v_palette_coord);
+    #endif
+
     // Initialize globals
     #pragma tangram: setup
 
@@ -6,23 +6,45 @@ precision highp float;
 
 #pragma tangram: defines
 
-uniform mat4 u_model;
 uniform mat4 u_view;
 uniform mat4 u_proj;
 uniform mat3 u_normal_matrix;
-uniform vec4 u_tile_origin;
 uniform vec3 u_map_position;
 uniform vec2 u_resolution;
 uniform float u_time;
 uniform float u_meters_per_pixel;
 uniform float u_device_pixel_ratio;
-uniform float u_proxy_depth;
+
+#ifdef TANGRAM_TILE_BATCHING
+    // Tile transforms of the batch, selected by the slot of the vertex: the
+    // translation, scale and proxy depth followed by the tile origin
+    attribute float a_tile_slot;
+    uniform vec4 u_batch_tiles[2 * TANGRAM_BATCH_SLOTS];
+    mat4 u_model;
+    vec4 u_tile_origin;
+    float u_proxy_depth;
+#else
+    uniform mat4 u_model;
+    uniform vec4 u_tile_origin;
+    uniform float u_proxy_depth;
+#endif
 
 #pragma tangram: uniforms
 
 attribute vec4 a_position;
-attribute vec4 a_color;
-attribute vec3 a_normal;
+#ifdef TANGRAM_COMPACT_VERTICES
+    // Octahedron encoded normal, decoded into a_normal at the start of main()
+    attribute vec2 a_packed_normal;
+    vec3 a_normal;
+
+    // Colors are looked up in the palette texture by the fragment shader
+    attribute vec2 a_palette_index;
+    uniform vec2 u_palette_size;
+    varying vec2 v_palette_coord;
+#else
+    attribute vec4 a_color;
+    attribute vec3 a_normal;
+#endif
 
 #ifdef TANGRAM_USE_TEX_COORDS
     attribute vec2 a_texcoord;
@@ -33,13 +55,17 @@ attribute vec3 a_normal;
     // Make sure lighting is a no-op for feature selection pass
     #undef TANGRAM_LIGHTING_VERTEX
 
-    attribute vec4 a_selection_color;
-    varying vec4 v_selection_color;
+    #ifndef TANGRAM_COMPACT_VERTICES
+        attribute vec4 a_selection_color;
+        varying vec4 v_selection_color;
+    #endif
 #endif
 
 varying vec4 v_world_position;
 varying vec4 v_position;
-varying vec4 v_color;
+#ifndef TANGRAM_COMPACT_VERTICES
+    varying vec4 v_color;
+#endif
 varying vec3 v_normal;
 
 #ifdef TANGRAM_LIGHTING_VERTEX
@@ -73,23 +99,61 @@ vec4 modelPositionBaseZoom() {
     varying vec4 v_modelpos_base_zoom;
 #endif
 
+#ifdef TANGRAM_COMPACT_VERTICES
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1. - abs(e.x) - abs(e.y));
+    if (n.z < 0.) {
+        n.xy = (1. - abs(n.yx)) * vec2(n.x >= 0. ? 1. : -1., n.y >= 0. ? 1. : -1.);
+    }
+    return normalize(n);
+}
+#endif
+
 void main() {
 
+    #ifdef TANGRAM_TILE_BATCHING
+        int slot = 2 * int(a_tile_slot);
+        vec4 tile = u_batch_tiles[slot];
+        u_model = mat4(tile.z, 0., 0., 0.,
+                       0., tile.z, 0., 0.,
+                       0., 0., tile.z, 0.,
+                       tile.x, tile.y, 0., 1.);
+        u_tile_origin = u_batch_tiles[slot + 1];
+        u_proxy_depth = tile.w;
+    #endif
+
+    #ifdef TANGRAM_COMPACT_VERTICES
+        a_normal = octDecode(a_packed_normal);
+    #endif
+
     vec4 position = vec4(UNPACK_POSITION(a_position.xyz), 1.0);
 
     #ifdef TANGRAM_FEATURE_SELECTION
-        v_selection_color = a_selection_color;
-        // Skip non-selectable meshes
-        if (v_selection_color == vec4(0.0)) {
-            gl_Position = vec4(0.0);
-            return;
-        }
+        #ifndef TANGRAM_COMPACT_VERTICES
+            v_selection_color = a_selection_color;
+            // Skip non-selectable meshes
+            if (v_selection_color == vec4(0.0)) {
+                gl_Position = vec4(0.0);
+                return;
+            }
+        #endif
     #else
         // Initialize globals
         #pragma tangram: setup
     #endif
 
-    v_color = a_color;
+    #ifdef TANGRAM_COMPACT_VERTICES
+        // Entries are two texels, the color followed by the selection color.
+        // Indices are split into their low and high 16 bits.
+        float texel = (a_palette_index.x + a_palette_index.y * 65536.) * 2.;
+        #ifdef TANGRAM_FEATURE_SELECTION
+            texel += 1.;
+        #endif
+        float row = floor(texel / u_palette_size.x);
+        v_palette_coord = vec2(texel - row * u_palette_size.x + .5, row + .5) / u_palette_size;
+    #else
+        v_color = a_color;
+    #endif
 
     #ifdef TANGRAM_USE_TEX_COORDS
         v_texcoord = a_texcoord;
@@ -24,7 +24,13 @@ uniform sampler2D u_texture;
 
 varying vec4 v_world_position;
 varying vec4 v_position;
-varying vec4 v_color;
+#ifdef TANGRAM_COMPACT_VERTICES
+    uniform sampler2D u_palette;
+    varying vec2 v_palette_coord;
+    vec4 v_color;
+#else
+    varying vec4 v_color;
+#endif
 varying vec3 v_normal;
 
 #ifdef TANGRAM_USE_TEX_COORDS
@@ -54,6 +60,10 @@ vec3 worldNormal() {
 
 void main(void) {
 
+    #ifdef TANGRAM_COMPACT_VERTICES
+        v_color = texture2D(u_palette, v_palette_coord);
+    #endif
+
     // Initialize globals
     #pragma tangram: setup
 
@@ -3,8 +3,25 @@
 precision highp float;
 #endif
 
-varying vec4 v_selection_color;
+#pragma tangram: defines
+
+#ifdef TANGRAM_COMPACT_VERTICES
+    uniform sampler2D u_palette;
+    // Points at the selection color of the palette entry
+    varying vec2 v_palette_coord;
+#else
+    varying vec4 v_selection_color;
+#endif
 
 void main(void) {
-    gl_FragColor = v_selection_color;
+    #ifdef TANGRAM_COMPACT_VERTICES
+        vec4 selection_color = texture2D(u_palette, v_palette_coord);
+        // Skip non-selectable features
+        if (selection_color == vec4(0.0)) {
+            discard;
+        }
+        gl_FragColor = selection_color;
+    #else
+        gl_FragColor = v_selection_color;
+    #endif
 }
@@ -16,8 +16,16 @@ uniform LOWP int u_pass;
 
 #pragma tangram: uniforms
 
+#ifdef TANGRAM_LABEL_SLOTS
+    // Screen position and alpha of the labels of a static label batch,
+    // selected by the slot of the vertex: (x, y, alpha, unused)
+    attribute float a_slot;
+    uniform vec4 u_label_slots[TANGRAM_LABEL_SLOTS];
+#else
+    attribute LOWP float a_alpha;
+#endif
+
 attribute vec2 a_uv;
-attribute LOWP float a_alpha;
 attribute LOWP vec4 a_color;
 attribute vec2 a_position;
 attribute LOWP vec4 a_stroke;
@@ -42,7 +50,12 @@ varying float v_alpha;
 
 void main() {
 
+#ifdef TANGRAM_LABEL_SLOTS
+    vec4 label = u_label_slots[int(a_slot)];
+    v_alpha = label.z;
+#else
     v_alpha = a_alpha;
+#endif
     v_color = a_color;
 
 #ifdef TANGRAM_FEATURE_SELECTION
@@ -54,7 +67,16 @@ void main() {
     }
 #endif
 
+#ifdef TANGRAM_LABEL_SLOTS
+    // Skip labels which are not placed in this frame
+    if (v_alpha == 0.0) {
+        gl_Position = vec4(0.0);
+        return;
+    }
+    vec2 vertex_pos = label.xy + UNPACK_POSITION(a_position);
+#else
     vec2 vertex_pos = UNPACK_POSITION(a_position);
+#endif
     v_texcoords = UNPACK_TEXTURE(a_uv);
     float sdf_scale = a_scale / 64.0;
     v_sdf_pixel = 0.5 / (u_max_stroke_width * sdf_scale);
@@ -6,6 +6,7 @@
 #include "util/geom.h"
 #include "data/propertyItem.h"
 #include "data/tileData.h"
+#include "data/tileFeatureIndex.h"
 #include "tile/tile.h"
 #include "view/view.h"
 
@@ -15,17 +16,22 @@
 #include "mapbox/geojson.hpp"
 #include <mapbox/geojson_impl.hpp>
 
-
+#include <limits>
 #include <regex>
+#include <unordered_map>
 
 namespace Tangram {
 
 using namespace mapbox;
 
-geojsonvt::Options options() {
+// Tiles up to this zoom are made from a shared index of all features, which is
+// only rebuilt after the features changed
+static const uint8_t LOW_ZOOM = 5;
+
+static geojsonvt::Options options(uint8_t _indexMaxZoom) {
     geojsonvt::Options opt;
     opt.maxZoom = 18;
-    opt.indexMaxZoom = 5;
+    opt.indexMaxZoom = _indexMaxZoom;
     opt.indexMaxPoints = 100000;
     opt.solidChildren = true;
     opt.tolerance = 3;
@@ -34,10 +40,50 @@ geojsonvt::Options options() {
     return opt;
 }
 
-struct ClientGeoJsonData {
+// Features are immutable once stored, so that tile tasks can take a snapshot
+// of the features of their tile and release the store before tiling them.
+struct ClientGeoJsonFeature {
+    geometry::geometry<double> geometry;
+    Properties props;
+
+    // Label placement point of polygons when centroids are generated
+    bool hasCentroid = false;
+    geometry::point<double> centroid;
+    Properties centroidProps;
+};
+
+// Tiles a snapshot of stored features
+struct ClientGeoJsonTiler {
+    using Features = std::vector<std::shared_ptr<const ClientGeoJsonFeature>>;
+
+    // Keeps the properties alive while tiles are made
+    Features features;
+    // Properties of the features by their id in the tiler
+    std::vector<const Properties*> properties;
     std::unique_ptr<geojsonvt::GeoJSONVT> tiles;
-    mapbox::geometry::feature_collection<double> features;
-    std::vector<Properties> properties;
+
+    ClientGeoJsonTiler(Features&& _features, const geojsonvt::Options& _options);
+
+    // Add the features of @_tileId to @_layer, getTile() splits tiles on demand
+    // and so must not be called concurrently
+    void addFeatures(const TileID& _tileId, int32_t _sourceId, Layer& _layer);
+};
+
+struct ClientGeoJsonData {
+    std::unordered_map<uint64_t, std::shared_ptr<const ClientGeoJsonFeature>> features;
+    TileFeatureIndex index;
+    uint64_t nextId = 0;
+
+    // Tiler of all features for tiles up to LOW_ZOOM and the source generation
+    // it was made at. Guarded by lowZoomMutex, which is taken before the store.
+    std::unique_ptr<ClientGeoJsonTiler> lowZoomTiler;
+    int64_t lowZoomGeneration = 0;
+    std::mutex lowZoomMutex;
+
+    void set(uint64_t _id, geometry::geometry<double>&& _geometry, Properties&& _props,
+             bool _centroid, int64_t _generation);
+
+    bool remove(uint64_t _id, int64_t _generation);
 };
 
 std::shared_ptr<TileTask> ClientGeoJsonSource::createTask(TileID _tileId, int _subTask) {
@@ -137,51 +183,104 @@ struct prop_visitor {
     }
 };
 
+struct add_bounds {
+
+    BoundingBox& bounds;
+
+    void operator()(const geometry::point<double>& p) {
+        bounds.expand(p.x, p.y);
+    }
+
+    void operator()(const geometry::geometry<double>& geom) {
+        geometry::geometry<double>::visit(geom, *this);
+    }
+
+    // Lines, rings, polygons, multi geometries and collections
+    template <typename T>
+    void operator()(const std::vector<T>& geom) {
+        for (auto& g : geom) { (*this)(g); }
+    }
+};
+
+static bool setCentroid(ClientGeoJsonFeature& _feature) {
+    if (!geometry::geometry<double>::visit(_feature.geometry, add_centroid{ _feature.centroid })) {
+        return false;
+    }
+    _feature.hasCentroid = true;
+    _feature.centroidProps = _feature.props;
+    _feature.centroidProps.set("label_placement", 1.0);
+    return true;
+}
+
+void ClientGeoJsonData::set(uint64_t _id, geometry::geometry<double>&& _geometry, Properties&& _props,
+                            bool _centroid, int64_t _generation) {
+
+    auto feature = std::make_shared<ClientGeoJsonFeature>();
+    feature->geometry = std::move(_geometry);
+    feature->props = std::move(_props);
+
+    if (_centroid) { setCentroid(*feature); }
+
+    const double inf = std::numeric_limits<double>::infinity();
+    BoundingBox bounds{ { inf, inf }, { -inf, -inf } };
+    add_bounds{ bounds }(feature->geometry);
+
+    if (bounds.min.x <= bounds.max.x) {
+        index.insert(_id, bounds, _generation);
+    } else {
+        // Empty geometry, not part of any tile
+        index.remove(_id, _generation);
+    }
+
+    features[_id] = std::move(feature);
+}
+
+bool ClientGeoJsonData::remove(uint64_t _id, int64_t _generation) {
+    if (features.erase(_id) == 0) { return false; }
+
+    index.remove(_id, _generation);
+    return true;
+}
+
 void ClientGeoJsonSource::generateLabelCentroidFeature() {
-    for (const auto &feat : m_store->features) {
-        geometry::point<double> centroid;
-        const auto& properties = m_store->properties[feat.id.get<uint64_t>()];
-        if (geometry::geometry<double>::visit(feat.geometry, add_centroid{ centroid })) {
-            uint64_t id = m_store->features.size();
-            m_store->features.emplace_back(centroid, id);
-            m_store->properties.push_back(properties);
-            auto& props = m_store->properties.back();
-            props.set("label_placement", 1.0);
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    m_generation++;
+
+    for (auto& it : m_store->features) {
+        if (it.second->hasCentroid) { continue; }
+
+        auto feature = std::make_shared<ClientGeoJsonFeature>(*it.second);
+        if (setCentroid(*feature)) {
+            it.second = std::move(feature);
+            m_store->index.touch(it.first, m_generation);
         }
     }
 }
 
 void ClientGeoJsonSource::addData(const std::string& _data) {
 
-    std::lock_guard<std::mutex> lock(m_mutexStore);
-
     const auto json = geojson::parse(_data);
     auto features = geojsonvt::geojson::visit(json, geojsonvt::ToFeatureCollection{});
 
-    for (auto& feature : features) {
+    std::lock_guard<std::mutex> lock(m_mutexStore);
 
-        feature.id = uint64_t(m_store->properties.size());
-        m_store->properties.emplace_back();
-        Properties& props = m_store->properties.back();
+    // All features of one call share a generation
+    m_generation++;
 
+    for (auto& feature : features) {
+
+        Properties props;
         for (const auto& prop : feature.properties) {
             auto key = prop.first;
             prop_visitor visitor = {props, key};
             mapbox::util::apply_visitor(visitor, prop.second);
         }
-        feature.properties.clear();
-    }
 
-    m_store->features.insert(m_store->features.end(),
-                             std::make_move_iterator(features.begin()),
-                             std::make_move_iterator(features.end()));
-
-    if (m_generateCentroids) {
-        generateLabelCentroidFeature();
+        m_store->set(m_store->nextId++, std::move(feature.geometry), std::move(props),
+                     m_generateCentroids, m_generation);
     }
-
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
 }
 
 void ClientGeoJsonSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -204,72 +303,117 @@ void ClientGeoJsonSource::clearData() {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    m_store->features.clear();
-    m_store->properties.clear();
-    m_store->tiles.reset();
-
     m_generation++;
+
+    m_store->features.clear();
+    m_store->index.clear(m_generation);
 }
 
-void ClientGeoJsonSource::addPoint(const Properties& _tags, LngLat _point) {
+int64_t ClientGeoJsonSource::generation(const TileID& _tileId) const {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    geometry::point<double> geom { _point.longitude, _point.latitude };
+    return m_store->index.generation(_tileId);
+}
 
-    uint64_t id = m_store->features.size();
+static geometry::line_string<double> lineGeometry(const Coordinates& _line) {
+    geometry::line_string<double> geom;
+    for (auto& p : _line) {
+        geom.emplace_back(p.longitude, p.latitude);
+    }
+    return geom;
+}
 
-    m_store->features.emplace_back(geom, id);
-    m_store->properties.emplace_back(_tags);
+static geometry::polygon<double> polyGeometry(const std::vector<Coordinates>& _poly) {
+    geometry::polygon<double> geom;
+    for (auto& ring : _poly) {
+        geom.emplace_back();
+        auto &line = geom.back();
+        for (auto& p : ring) {
+            line.emplace_back(p.longitude, p.latitude);
+        }
+    }
+    return geom;
+}
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
+uint64_t ClientGeoJsonSource::addPoint(const Properties& _tags, LngLat _point) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    uint64_t id = m_store->nextId++;
+
+    m_store->set(id, geometry::point<double>{ _point.longitude, _point.latitude },
+                 Properties(_tags), false, ++m_generation);
+
+    return id;
 }
 
-void ClientGeoJsonSource::addLine(const Properties& _tags, const Coordinates& _line) {
+uint64_t ClientGeoJsonSource::addLine(const Properties& _tags, const Coordinates& _line) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    uint64_t id = m_store->nextId++;
+
+    m_store->set(id, lineGeometry(_line), Properties(_tags), false, ++m_generation);
+
+    return id;
+}
 
+uint64_t ClientGeoJsonSource::addPoly(const Properties& _tags, const std::vector<Coordinates>& _poly) {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    geometry::line_string<double> geom;
-    for (auto& p : _line) {
-        geom.emplace_back(p.longitude, p.latitude);
-    }
+    uint64_t id = m_store->nextId++;
+
+    m_store->set(id, polyGeometry(_poly), Properties(_tags), m_generateCentroids, ++m_generation);
 
-    uint64_t id = m_store->features.size();
+    return id;
+}
 
-    m_store->features.emplace_back(geom, id);
-    m_store->properties.emplace_back(_tags);
+bool ClientGeoJsonSource::updatePoint(uint64_t _id, const Properties& _tags, LngLat _point) {
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    if (m_store->features.find(_id) == m_store->features.end()) { return false; }
+
+    m_store->set(_id, geometry::point<double>{ _point.longitude, _point.latitude },
+                 Properties(_tags), false, ++m_generation);
+
+    return true;
 }
 
-void ClientGeoJsonSource::addPoly(const Properties& _tags, const std::vector<Coordinates>& _poly) {
+bool ClientGeoJsonSource::updateLine(uint64_t _id, const Properties& _tags, const Coordinates& _line) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    if (m_store->features.find(_id) == m_store->features.end()) { return false; }
+
+    m_store->set(_id, lineGeometry(_line), Properties(_tags), false, ++m_generation);
 
+    return true;
+}
+
+bool ClientGeoJsonSource::updatePoly(uint64_t _id, const Properties& _tags,
+                                     const std::vector<Coordinates>& _poly) {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    geometry::polygon<double> geom;
-    for (auto& ring : _poly) {
-        geom.emplace_back();
-        auto &line = geom.back();
-        for (auto& p : ring) {
-            line.emplace_back(p.longitude, p.latitude);
-        }
-    }
+    if (m_store->features.find(_id) == m_store->features.end()) { return false; }
 
-    uint64_t id = m_store->features.size();
+    m_store->set(_id, polyGeometry(_poly), Properties(_tags), m_generateCentroids, ++m_generation);
 
-    m_store->features.emplace_back(geom, id);
-    m_store->properties.emplace_back(_tags);
+    return true;
+}
 
-    if (m_generateCentroids) {
-        generateLabelCentroidFeature();
-    }
+bool ClientGeoJsonSource::removeFeature(uint64_t _id) {
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    if (m_store->features.find(_id) == m_store->features.end()) { return false; }
+
+    m_store->remove(_id, ++m_generation);
+
+    return true;
 }
 
 struct add_geometry {
@@ -336,27 +480,102 @@ struct add_geometry {
     }
 };
 
+ClientGeoJsonTiler::ClientGeoJsonTiler(Features&& _features, const geojsonvt::Options& _options)
+    : features(std::move(_features)) {
+
+    // Feature ids of the collection index the properties
+    geometry::feature_collection<double> collection;
+
+    for (auto& feature : features) {
+        collection.emplace_back(feature->geometry, uint64_t(properties.size()));
+        properties.push_back(&feature->props);
+
+        if (feature->hasCentroid) {
+            collection.emplace_back(feature->centroid, uint64_t(properties.size()));
+            properties.push_back(&feature->centroidProps);
+        }
+    }
+
+    tiles = std::make_unique<geojsonvt::GeoJSONVT>(collection, _options);
+}
+
+void ClientGeoJsonTiler::addFeatures(const TileID& _tileId, int32_t _sourceId, Layer& _layer) {
+
+    auto& tile = tiles->getTile(_tileId.z, _tileId.x, _tileId.y);
+
+    for (auto& it : tile.features) {
+        Feature feature(_sourceId);
+
+        if (geometry::geometry<int16_t>::visit(it.geometry, add_geometry{ feature })) {
+            feature.props = *properties[it.id.get<uint64_t>()];
+            _layer.features.emplace_back(std::move(feature));
+        }
+    }
+}
+
 std::shared_ptr<TileData> ClientGeoJsonSource::parse(const TileTask& _task) const {
 
-    std::lock_guard<std::mutex> lock(m_mutexStore);
+    auto tileId = _task.tileId();
 
     auto data = std::make_shared<TileData>();
 
-    if (!m_store->tiles) { return nullptr; }
-    auto tile = m_store->tiles->getTile(_task.tileId().z, _task.tileId().x, _task.tileId().y);
-
     data->layers.emplace_back("");  // empty name will skip filtering by 'collection'
     Layer& layer = data->layers.back();
 
-    for (auto& it : tile.features) {
-        Feature feature(m_id);
+    if (tileId.z <= LOW_ZOOM) {
+        std::lock_guard<std::mutex> lowZoomLock(m_store->lowZoomMutex);
 
-        if (geometry::geometry<int16_t>::visit(it.geometry, add_geometry{ feature })) {
-            feature.props = m_store->properties[it.id.get<uint64_t>()];
-            layer.features.emplace_back(std::move(feature));
+        ClientGeoJsonTiler::Features features;
+        int64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(m_mutexStore);
+
+            if (m_store->features.empty()) {
+                m_store->lowZoomTiler.reset();
+                return nullptr;
+            }
+
+            generation = m_generation;
+            if (!m_store->lowZoomTiler || m_store->lowZoomGeneration != generation) {
+                features.reserve(m_store->features.size());
+                for (auto& it : m_store->features) { features.push_back(it.second); }
+            }
+        }
+
+        // Tile outside of the store, so that mutations are not blocked by it
+        if (!features.empty()) {
+            m_store->lowZoomTiler = std::make_unique<ClientGeoJsonTiler>(std::move(features),
+                                                                         options(LOW_ZOOM));
+            m_store->lowZoomGeneration = generation;
         }
+
+        m_store->lowZoomTiler->addFeatures(tileId, m_id, layer);
+
+        return data;
     }
 
+    // Only collect the features of this tile while holding the store, so that
+    // mutations are not blocked by tiling.
+    ClientGeoJsonTiler::Features features;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexStore);
+
+        if (m_store->features.empty()) { return nullptr; }
+
+        std::vector<uint64_t> ids;
+        m_store->index.query(tileId, ids);
+
+        features.reserve(ids.size());
+        for (auto id : ids) {
+            features.push_back(m_store->features.at(id));
+        }
+    }
+
+    if (features.empty()) { return data; }
+
+    // Split from the root only on the way to this tile
+    ClientGeoJsonTiler tiler(std::move(features), options(0));
+    tiler.addFeatures(tileId, m_id, layer);
 
     return data;
 }
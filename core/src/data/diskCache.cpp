@@ -0,0 +1,624 @@
+#include "data/diskCache.h"
+
+#include "util/asyncWorker.h"
+#include "util/zlibHelper.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Tangram {
+
+static const uint32_t SEGMENT_MAGIC = 0x43444754; // 'TGDC'
+static const uint32_t RECORD_MAGIC = 0x52444754;  // 'TGDR'
+static const uint32_t INDEX_MAGIC = 0x49444754;   // 'TGDI'
+static const uint32_t VERSION = 2;
+
+// Write the index after this many bytes were appended, so that less of the
+// segment needs to be scanned after a crash
+static const size_t INDEX_INTERVAL = 4 * 1024 * 1024;
+
+// Compaction keeps the most recently used tiles up to this share of the limit
+static const double COMPACT_RATIO = 0.75;
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    // CRC-32 over x, y, z, tag, size and the tile data
+    uint32_t checksum;
+    int32_t x;
+    int32_t y;
+    int32_t z;
+    uint32_t tag;
+    uint32_t size;
+};
+
+struct IndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    // Segment length covered by the index
+    uint64_t segmentSize;
+    uint64_t clock;
+    uint64_t count;
+};
+
+struct IndexRecord {
+    int32_t x;
+    int32_t y;
+    int32_t z;
+    uint32_t tag;
+    uint32_t size;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t stamp;
+};
+
+static uint32_t recordChecksum(const RecordHeader& _header, const char* _data) {
+    const size_t fieldsSize = offsetof(RecordHeader, size) + sizeof(_header.size) - offsetof(RecordHeader, x);
+    uint32_t crc = zlib::crc32(0, reinterpret_cast<const char*>(&_header.x), fieldsSize);
+    return zlib::crc32(crc, _data, _header.size);
+}
+
+static bool syncData(int _fd) {
+#ifdef __APPLE__
+    return fsync(_fd) == 0;
+#else
+    return fdatasync(_fd) == 0;
+#endif
+}
+
+static bool writeAll(int _fd, const char* _data, size_t _size, off_t _offset) {
+    while (_size > 0) {
+        ssize_t n = pwrite(_fd, _data, _size, _offset);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        _data += n;
+        _size -= n;
+        _offset += n;
+    }
+    return true;
+}
+
+// Read-only mapping of the segment; readers keep it alive while copying
+struct SegmentMapping {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    SegmentMapping(int _fd, size_t _size) {
+        if (_size == 0) { return; }
+        void* ptr = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+        if (ptr == MAP_FAILED) {
+            LOGE("Disk cache: mmap failed: %s", strerror(errno));
+            return;
+        }
+        data = static_cast<const char*>(ptr);
+        size = _size;
+    }
+
+    ~SegmentMapping() {
+        if (data) { munmap(const_cast<char*>(data), size); }
+    }
+};
+
+DiskCache::DiskCache(const std::string& _path, size_t _maxSize) :
+    m_path(_path), m_maxSize(_maxSize) {}
+
+DiskCache::~DiskCache() {
+    // Stop the writer before writing the remaining tiles on this thread
+    m_writer.reset();
+
+    if (m_fd < 0) { return; }
+
+    writeBatch();
+    if (m_fileSize > m_maxSize) { compact(); }
+    writeIndex();
+
+    m_mapping.reset();
+    ::close(m_fd);
+}
+
+size_t DiskCache::recordSize(uint32_t _dataSize) {
+    return sizeof(RecordHeader) + _dataSize;
+}
+
+bool DiskCache::openSegment() {
+    m_fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        LOGE("Disk cache: cannot open '%s': %s", m_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    // A previous cache for this path may still be shutting down
+    int attempts = 0;
+    while (flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+        if (++attempts > 100) {
+            LOGE("Disk cache: '%s' is in use", m_path.c_str());
+            ::close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) { return false; }
+
+    SegmentHeader header{};
+    bool valid = st.st_size >= off_t(sizeof(header)) &&
+        pread(m_fd, &header, sizeof(header), 0) == ssize_t(sizeof(header)) &&
+        header.magic == SEGMENT_MAGIC && header.version == VERSION;
+
+    if (!valid) {
+        if (st.st_size > 0) {
+            LOGW("Disk cache: resetting invalid segment '%s'", m_path.c_str());
+        }
+        header = { SEGMENT_MAGIC, VERSION };
+        if (ftruncate(m_fd, 0) != 0 ||
+            !writeAll(m_fd, reinterpret_cast<const char*>(&header), sizeof(header), 0)) {
+            LOGE("Disk cache: cannot initialize '%s'", m_path.c_str());
+            return false;
+        }
+        m_fileSize = sizeof(header);
+        return true;
+    }
+
+    m_fileSize = st.st_size;
+    m_mapping = std::make_shared<SegmentMapping>(m_fd, m_fileSize);
+
+    uint64_t scanStart = sizeof(SegmentHeader);
+    if (readIndex()) {
+        scanStart = m_indexedSize;
+    } else {
+        m_index.clear();
+        m_liveSize = 0;
+        m_clock = 0;
+    }
+    scanSegment(scanStart);
+
+    return true;
+}
+
+// Add records after @_offset to the index. The segment is cut off at the
+// first incomplete or corrupt record, which remains from a crash.
+void DiskCache::scanSegment(uint64_t _offset) {
+    const char* data = m_mapping->data;
+    if (!data) { return; }
+
+    while (_offset + sizeof(RecordHeader) <= m_fileSize) {
+        RecordHeader header;
+        memcpy(&header, data + _offset, sizeof(header));
+
+        if (header.magic != RECORD_MAGIC ||
+            _offset + recordSize(header.size) > m_fileSize ||
+            recordChecksum(header, data + _offset + sizeof(header)) != header.checksum) {
+            break;
+        }
+        addEntry(Key(header.x, header.y, header.z, header.tag), { _offset, header.size, ++m_clock });
+        _offset += recordSize(header.size);
+    }
+
+    if (_offset != m_fileSize) {
+        LOGW("Disk cache: truncating '%s' from %llu to %llu bytes", m_path.c_str(),
+             (unsigned long long)m_fileSize, (unsigned long long)_offset);
+        if (ftruncate(m_fd, _offset) != 0) {
+            LOGE("Disk cache: truncate failed: %s", strerror(errno));
+        }
+        m_fileSize = _offset;
+        m_mapping = std::make_shared<SegmentMapping>(m_fd, m_fileSize);
+    }
+}
+
+void DiskCache::addEntry(const Key& _key, Entry _entry) {
+    auto it = m_index.find(_key);
+    if (it != m_index.end()) {
+        m_liveSize -= recordSize(it->second.size);
+        it->second = _entry;
+    } else {
+        m_index.emplace(_key, _entry);
+    }
+    m_liveSize += recordSize(_entry.size);
+}
+
+bool DiskCache::readIndex() {
+    FILE* file = fopen(indexPath().c_str(), "rb");
+    if (!file) { return false; }
+
+    IndexHeader header{};
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+        header.magic == INDEX_MAGIC && header.version == VERSION &&
+        header.segmentSize >= sizeof(SegmentHeader) && header.segmentSize <= m_fileSize &&
+        header.count <= header.segmentSize / sizeof(RecordHeader);
+
+    std::vector<IndexRecord> records;
+    uint32_t checksum = 0;
+    if (ok) {
+        records.resize(header.count);
+        ok = fread(records.data(), sizeof(IndexRecord), records.size(), file) == records.size() &&
+            fread(&checksum, sizeof(checksum), 1, file) == 1;
+    }
+    fclose(file);
+
+    if (ok) {
+        uint32_t crc = zlib::crc32(0, reinterpret_cast<const char*>(&header), sizeof(header));
+        crc = zlib::crc32(crc, reinterpret_cast<const char*>(records.data()),
+                          records.size() * sizeof(IndexRecord));
+        ok = crc == checksum;
+    }
+    if (!ok) {
+        LOGW("Disk cache: ignoring invalid index for '%s'", m_path.c_str());
+        return false;
+    }
+
+    for (const auto& r : records) {
+        if (r.offset + recordSize(r.size) > header.segmentSize) { return false; }
+        addEntry(Key(r.x, r.y, r.z, r.tag), { r.offset, r.size, r.stamp });
+    }
+    m_clock = header.clock;
+    m_indexedSize = header.segmentSize;
+    return true;
+}
+
+void DiskCache::writeIndex() {
+    std::vector<IndexRecord> records;
+    IndexHeader header{};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        records.reserve(m_index.size());
+        for (const auto& entry : m_index) {
+            const auto& key = entry.first;
+            const auto& e = entry.second;
+            records.push_back({ key.x, key.y, key.z, key.tag, e.size, 0, e.offset, e.stamp });
+        }
+        header = { INDEX_MAGIC, VERSION, m_fileSize, m_clock, records.size() };
+    }
+
+    // The index must not refer to records which are not on disk yet
+    if (!syncData(m_fd)) {
+        LOGE("Disk cache: sync of '%s' failed: %s", m_path.c_str(), strerror(errno));
+        return;
+    }
+
+    uint32_t crc = zlib::crc32(0, reinterpret_cast<const char*>(&header), sizeof(header));
+    crc = zlib::crc32(crc, reinterpret_cast<const char*>(records.data()),
+                      records.size() * sizeof(IndexRecord));
+
+    std::string tmpPath = indexPath() + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        LOGE("Disk cache: cannot write index '%s'", tmpPath.c_str());
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(records.data(), sizeof(IndexRecord), records.size(), file) == records.size() &&
+        fwrite(&crc, sizeof(crc), 1, file) == 1 &&
+        fflush(file) == 0 && fsync(fileno(file)) == 0;
+    fclose(file);
+
+    if (!ok || rename(tmpPath.c_str(), indexPath().c_str()) != 0) {
+        LOGE("Disk cache: cannot write index '%s'", indexPath().c_str());
+        remove(tmpPath.c_str());
+        return;
+    }
+    m_indexedSize = header.segmentSize;
+}
+
+bool DiskCache::get(const Key& _key, std::vector<char>& _data) {
+    return read(_key, [&](const char* _record, size_t _size) {
+        _data.assign(_record, _record + _size);
+        return true;
+    });
+}
+
+bool DiskCache::read(const Key& _key, const std::function<bool(const char*, size_t)>& _reader) {
+    std::shared_ptr<SegmentMapping> mapping;
+    std::shared_ptr<std::vector<char>> pendingData;
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto pending = m_pending.find(_key);
+        if (pending != m_pending.end()) {
+            pendingData = pending->second;
+        } else {
+            auto it = m_index.find(_key);
+            if (it == m_index.end()) { return false; }
+
+            it->second.stamp = ++m_clock;
+            entry = it->second;
+
+            if (!m_mapping || entry.offset + recordSize(entry.size) > m_mapping->size) {
+                m_mapping = std::make_shared<SegmentMapping>(m_fd, m_fileSize);
+            }
+            mapping = m_mapping;
+        }
+    }
+
+    if (pendingData) {
+        return _reader(pendingData->data(), pendingData->size());
+    }
+
+    if (!mapping->data || entry.offset + recordSize(entry.size) > mapping->size) {
+        return false;
+    }
+
+    RecordHeader header;
+    const char* record = mapping->data + entry.offset;
+    memcpy(&header, record, sizeof(header));
+
+    // Also check that the record belongs to @_key, an index which is out of
+    // sync with the segment may point to the record of another tile
+    if (header.magic != RECORD_MAGIC || header.size != entry.size ||
+        Key(header.x, header.y, header.z, header.tag) != _key ||
+        recordChecksum(header, record + sizeof(header)) != header.checksum) {
+        LOGW("Disk cache: corrupt record for tile %d/%d/%d", _key.x, _key.y, _key.z);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(_key);
+        if (it != m_index.end() && it->second.offset == entry.offset) {
+            m_liveSize -= recordSize(it->second.size);
+            m_index.erase(it);
+        }
+        return false;
+    }
+
+    // The mapping is kept alive until the reader is done
+    return _reader(record + sizeof(header), header.size);
+}
+
+void DiskCache::put(const Key& _key, std::shared_ptr<std::vector<char>> _data) {
+    if (!m_writer) { return; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_pending[_key] = std::move(_data);
+
+    // Tiles arriving until the writer runs are written in one batch
+    if (!m_flushQueued) {
+        m_flushQueued = true;
+        m_writer->enqueue([this]() { writeBatch(); });
+    }
+}
+
+// Append pending tiles to the segment. Only called from the writer thread.
+void DiskCache::writeBatch() {
+    std::vector<std::pair<Key, std::shared_ptr<std::vector<char>>>> batch;
+    uint64_t offset;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_flushQueued = false;
+        batch.assign(m_pending.begin(), m_pending.end());
+        offset = m_fileSize;
+    }
+    if (batch.empty()) { return; }
+
+    std::vector<char> buffer;
+    std::vector<Entry> entries;
+    entries.reserve(batch.size());
+
+    for (const auto& tile : batch) {
+        const auto& data = *tile.second;
+        const auto& key = tile.first;
+        RecordHeader header{ RECORD_MAGIC, 0, key.x, key.y, key.z, key.tag, uint32_t(data.size()) };
+        header.checksum = recordChecksum(header, data.data());
+
+        entries.push_back({ offset + buffer.size(), header.size, 0 });
+
+        const char* h = reinterpret_cast<const char*>(&header);
+        buffer.insert(buffer.end(), h, h + sizeof(header));
+        buffer.insert(buffer.end(), data.begin(), data.end());
+    }
+
+    bool written = writeAll(m_fd, buffer.data(), buffer.size(), offset);
+    if (!written) {
+        LOGE("Disk cache: write failed: %s", strerror(errno));
+        // Drop a partially written batch
+        if (ftruncate(m_fd, offset) != 0) {
+            LOGE("Disk cache: truncate failed: %s", strerror(errno));
+        }
+    }
+
+    bool needsCompaction;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (written) {
+            m_fileSize = offset + buffer.size();
+            for (size_t i = 0; i < batch.size(); i++) {
+                entries[i].stamp = ++m_clock;
+                addEntry(batch[i].first, entries[i]);
+            }
+        }
+        // Keep tiles which were received again in the meantime
+        for (const auto& tile : batch) {
+            auto it = m_pending.find(tile.first);
+            if (it != m_pending.end() && it->second == tile.second) {
+                m_pending.erase(it);
+            }
+        }
+        needsCompaction = m_fileSize > m_maxSize;
+    }
+
+    if (needsCompaction) {
+        compact();
+    }
+    if (m_fileSize - m_indexedSize > INDEX_INTERVAL) {
+        writeIndex();
+    }
+}
+
+// Rewrite the most recently used tiles into a new segment and replace the
+// current one. Only called from the writer thread.
+void DiskCache::compact() {
+    using IndexEntry = std::pair<Key, Entry>;
+
+    std::vector<IndexEntry> entries;
+    std::shared_ptr<SegmentMapping> mapping;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries.assign(m_index.begin(), m_index.end());
+        if (!m_mapping || m_mapping->size < m_fileSize) {
+            m_mapping = std::make_shared<SegmentMapping>(m_fd, m_fileSize);
+        }
+        mapping = m_mapping;
+    }
+    if (!mapping->data) { return; }
+
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.second.stamp > b.second.stamp;
+    });
+
+    uint64_t budget;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        budget = m_maxSize * COMPACT_RATIO;
+    }
+    uint64_t size = sizeof(SegmentHeader);
+    size_t keep = 0;
+    for (; keep < entries.size(); keep++) {
+        uint64_t next = size + recordSize(entries[keep].second.size);
+        if (next > budget) { break; }
+        size = next;
+    }
+    entries.erase(entries.begin() + keep, entries.end());
+
+    // Write live records in segment order for sequential reads
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.second.offset < b.second.offset;
+    });
+
+    std::string tmpPath = m_path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 || flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        LOGE("Disk cache: cannot create '%s'", tmpPath.c_str());
+        if (fd >= 0) { ::close(fd); }
+        return;
+    }
+
+    std::vector<char> buffer;
+    SegmentHeader segmentHeader{ SEGMENT_MAGIC, VERSION };
+    const char* h = reinterpret_cast<const char*>(&segmentHeader);
+    buffer.insert(buffer.end(), h, h + sizeof(segmentHeader));
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve(entries.size());
+
+    uint64_t written = 0;
+    bool ok = true;
+    for (const auto& entry : entries) {
+        const char* record = mapping->data + entry.second.offset;
+        offsets.push_back(written + buffer.size());
+        buffer.insert(buffer.end(), record, record + recordSize(entry.second.size));
+
+        if (buffer.size() >= INDEX_INTERVAL) {
+            ok = writeAll(fd, buffer.data(), buffer.size(), written);
+            written += buffer.size();
+            buffer.clear();
+            if (!ok) { break; }
+        }
+    }
+    if (ok) {
+        ok = writeAll(fd, buffer.data(), buffer.size(), written) && syncData(fd);
+        written += buffer.size();
+    }
+
+    // The index refers to offsets in the current segment. Drop it before
+    // replacing the segment, a crash in between would leave an index that
+    // still matches the size of the new segment.
+    if (ok) {
+        ok = (remove(indexPath().c_str()) == 0 || errno == ENOENT);
+    }
+
+    if (!ok || rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+        LOGE("Disk cache: compaction of '%s' failed", m_path.c_str());
+        ::close(fd);
+        remove(tmpPath.c_str());
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Keep access stamps of reads during compaction
+        std::unordered_map<Key, Entry, KeyHash> index;
+        index.reserve(entries.size());
+        m_liveSize = 0;
+        for (size_t i = 0; i < entries.size(); i++) {
+            auto it = m_index.find(entries[i].first);
+            uint64_t stamp = (it != m_index.end()) ? it->second.stamp : entries[i].second.stamp;
+            index.emplace(entries[i].first, Entry{ offsets[i], entries[i].second.size, stamp });
+            m_liveSize += recordSize(entries[i].second.size);
+        }
+        m_index.swap(index);
+
+        ::close(m_fd);
+        m_fd = fd;
+        m_fileSize = written;
+        m_indexedSize = 0;
+        m_mapping = std::make_shared<SegmentMapping>(m_fd, m_fileSize);
+    }
+
+    LOG("Disk cache: compacted '%s' to %d tiles, %fMB", m_path.c_str(),
+        int(entries.size()), double(written) / (1024 * 1024));
+
+    writeIndex();
+}
+
+void DiskCache::flush() {
+    if (!m_writer) { return; }
+
+    std::promise<void> done;
+    m_writer->enqueue([&]() {
+        writeBatch();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+
+std::shared_ptr<DiskCache> DiskCache::open(const std::string& _path, size_t _maxSize) {
+    // Scene reloads create new sources while the previous ones are still
+    // alive: share one cache per segment file.
+    static std::mutex s_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<DiskCache>> s_caches;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    auto& weak = s_caches[_path];
+    if (auto cache = weak.lock()) {
+        std::lock_guard<std::mutex> cacheLock(cache->m_mutex);
+        cache->m_maxSize = _maxSize;
+        return cache;
+    }
+
+    auto cache = std::make_shared<DiskCache>(_path, _maxSize);
+    if (cache->openSegment()) {
+        cache->m_writer = std::make_unique<AsyncWorker>();
+        LOG("Disk cache: opened '%s' with %d tiles", _path.c_str(), int(cache->m_index.size()));
+    } else if (cache->m_fd >= 0) {
+        ::close(cache->m_fd);
+        cache->m_fd = -1;
+    }
+    weak = cache;
+    return cache;
+}
+
+}
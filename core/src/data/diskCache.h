@@ -0,0 +1,126 @@
+#pragma once
+
+#include "tile/tileID.h"
+#include "util/hash.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class AsyncWorker;
+struct SegmentMapping;
+
+/* Persistent store of records keyed by TileID
+ *
+ * Records are read from a memory-mapped, append-only segment file. New records
+ * are written in batches on a background thread. When the segment grows beyond
+ * the size limit, least recently used records are dropped and the live records
+ * are compacted into a new segment.
+ *
+ * Records carry a checksum, so that a segment which was cut off by a crash is
+ * truncated to its last complete record on the next start. The index is
+ * stored next to the segment and only used when it matches the segment.
+ */
+struct DiskCache {
+
+    /* Records are keyed by tile coordinates and a tag, which keeps the records
+     * of different users of one segment file apart */
+    struct Key {
+        int32_t x, y, z;
+        uint32_t tag;
+
+        Key(const TileID& _id, uint32_t _tag = 0) : x(_id.x), y(_id.y), z(_id.z), tag(_tag) {}
+        Key(int32_t _x, int32_t _y, int32_t _z, uint32_t _tag) : x(_x), y(_y), z(_z), tag(_tag) {}
+
+        bool operator==(const Key& _other) const {
+            return x == _other.x && y == _other.y && z == _other.z && tag == _other.tag;
+        }
+        bool operator!=(const Key& _other) const { return !(*this == _other); }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& _key) const {
+            std::size_t seed = 0;
+            hash_combine(seed, _key.x);
+            hash_combine(seed, _key.y);
+            hash_combine(seed, _key.z);
+            hash_combine(seed, _key.tag);
+            return seed;
+        }
+    };
+
+    struct Entry {
+        uint64_t offset;
+        uint32_t size;
+        uint64_t stamp;
+    };
+
+    // Guards all members below, except m_fd and m_writer which are only
+    // used by the writer thread after construction.
+    std::mutex m_mutex;
+
+    std::string m_path;
+    int m_fd = -1;
+    size_t m_maxSize = 0;
+
+    std::unordered_map<Key, Entry, KeyHash> m_index;
+    // Records received but not yet written
+    std::unordered_map<Key, std::shared_ptr<std::vector<char>>, KeyHash> m_pending;
+    std::shared_ptr<SegmentMapping> m_mapping;
+
+    uint64_t m_fileSize = 0;
+    uint64_t m_liveSize = 0;
+    uint64_t m_indexedSize = 0;
+    uint64_t m_clock = 0;
+    bool m_flushQueued = false;
+
+    std::unique_ptr<AsyncWorker> m_writer;
+
+    /* Returns the cache of the segment file @_path, which is shared by all
+     * users of the same path. The index is stored at @_path.idx */
+    static std::shared_ptr<DiskCache> open(const std::string& _path, size_t _maxSize);
+
+    DiskCache(const std::string& _path, size_t _maxSize);
+
+    ~DiskCache();
+
+    bool isOpen() const { return m_fd >= 0; }
+
+    /* Copy the record of @_key into @_data, returns false when there is none */
+    bool get(const Key& _key, std::vector<char>& _data);
+
+    /* Pass the record of @_key to @_reader while it is mapped, returns false
+     * when there is none or @_reader returns false */
+    bool read(const Key& _key, const std::function<bool(const char*, size_t)>& _reader);
+
+    /* Queue @_data to be written as the record of @_key */
+    void put(const Key& _key, std::shared_ptr<std::vector<char>> _data);
+
+    /* Wait until all records received so far are written to the segment */
+    void flush();
+
+    static size_t recordSize(uint32_t _dataSize);
+
+    bool openSegment();
+
+    void scanSegment(uint64_t _offset);
+
+    void addEntry(const Key& _key, Entry _entry);
+
+    std::string indexPath() const { return m_path + ".idx"; }
+
+    bool readIndex();
+
+    void writeIndex();
+
+    void writeBatch();
+
+    void compact();
+};
+
+}
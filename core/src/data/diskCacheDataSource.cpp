@@ -0,0 +1,89 @@
+#include "data/diskCacheDataSource.h"
+
+#include "data/diskCache.h"
+#include "tile/tileTask.h"
+#include "util/asyncWorker.h"
+#include "util/zlibHelper.h"
+
+namespace Tangram {
+
+DiskCacheDataSource::DiskCacheDataSource(const std::string& _path, size_t _maxSize, const std::string& _url) :
+    m_cache(DiskCache::open(_path, _maxSize)),
+    m_tag(zlib::crc32(0, _url.data(), _url.size())),
+    m_worker(std::make_unique<AsyncWorker>()) {
+}
+
+DiskCacheDataSource::~DiskCacheDataSource() {
+    // Stop reads before releasing the cache
+    m_worker.reset();
+}
+
+bool DiskCacheDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+
+    if (!m_cache->isOpen()) {
+        if (_task->rawSource == this->level && next) {
+            _task->rawSource = next->level;
+        }
+        return next && next->loadTileData(_task, _cb);
+    }
+
+    if (_task->rawSource == this->level) {
+
+        m_worker->enqueue([this, _task, _cb]() {
+            auto& task = static_cast<BinaryTileTask&>(*_task);
+
+            if (!_task->isCanceled()) {
+                auto data = std::make_shared<std::vector<char>>();
+
+                if (m_cache->get(DiskCache::Key(_task->tileId(), m_tag), *data)) {
+                    task.rawTileData = data;
+                    task.dataFromCache = true;
+                    _cb.func(_task);
+                    return;
+                }
+            }
+
+            if (next && !_task->isCanceled()) {
+                // Don't try this source again
+                _task->rawSource = next->level;
+
+                if (loadNextSource(_task, _cb)) { return; }
+            }
+            _cb.func(_task);
+        });
+        return true;
+    }
+
+    return loadNextSource(_task, _cb);
+}
+
+bool DiskCacheDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+    if (!next) { return false; }
+
+    // Intercept TileTaskCb to store result from next source.
+    std::weak_ptr<DiskCache> weakCache = m_cache;
+    uint32_t tag = m_tag;
+
+    return next->loadTileData(_task, {[weakCache, tag, _cb](std::shared_ptr<TileTask> _task) {
+
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+
+        if (task.hasData()) {
+            if (auto cache = weakCache.lock()) {
+                cache->put(DiskCache::Key(task.tileId(), tag), task.rawTileData);
+            }
+        }
+
+        _cb.func(_task);
+    }});
+}
+
+void DiskCacheDataSource::clear() {
+    if (next) { next->clear(); }
+}
+
+void DiskCacheDataSource::flush() {
+    m_cache->flush();
+}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "data/tileSource.h"
+
+#include <string>
+
+namespace Tangram {
+
+class AsyncWorker;
+struct DiskCache;
+
+/* Persistent cache for raw tile data
+ *
+ * Sits between the in-memory cache and the network source. Tiles are read
+ * from a memory-mapped, append-only segment file. Tiles loaded by the next
+ * source are written in batches on a background thread. When the segment
+ * grows beyond the size limit, least recently used tiles are dropped and the
+ * live tiles are compacted into a new segment.
+ *
+ * Records carry a checksum, so that a segment which was cut off by a crash is
+ * truncated to its last complete record on the next start. The index is
+ * stored next to the segment and only used when it matches the segment.
+ */
+class DiskCacheDataSource : public TileSource::DataSource {
+public:
+
+    /* @_path: Segment file of the cache, the index is stored at @_path.idx
+     * @_maxSize: Size limit for the segment file in bytes
+     * @_url: URL template of the source, records are tagged with its checksum
+     * so that sources sharing a segment file don't serve each other's tiles */
+    DiskCacheDataSource(const std::string& _path, size_t _maxSize, const std::string& _url);
+
+    ~DiskCacheDataSource();
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
+
+    /* The disk cache is persistent and only forwards clear() to the next source */
+    void clear() override;
+
+    /* Wait until all tiles received so far are written to the segment */
+    void flush();
+
+private:
+
+    bool loadNextSource(std::shared_ptr<TileTask> _task, TileTaskCb _cb);
+
+    std::shared_ptr<DiskCache> m_cache;
+
+    // Tag of the records of this source
+    uint32_t m_tag = 0;
+
+    // Reads are run off the calling thread
+    std::unique_ptr<AsyncWorker> m_worker;
+};
+
+}
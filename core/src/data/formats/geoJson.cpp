@@ -1,208 +1,494 @@
 #include "data/formats/geoJson.h"
 
-#include "data/propertyItem.h"
+#include "data/propertyKeys.h"
 #include "log.h"
 #include "tile/tileTask.h"
 #include "util/geom.h"
 #include "util/mapProjection.h"
 
-#include "glm/glm.hpp"
+#include "rapidjson/error/en.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 
 namespace Tangram {
 
-bool GeoJson::isFeatureCollection(const JsonValue& _in) {
+GeoJson::TileTransform::TileTransform(const TileID& _tileId) {
+    BoundingBox tileBounds(MapProjection::tileBounds(_tileId));
+    origin = tileBounds.min;
+    inverseScale = 1.0 / tileBounds.width();
+}
 
-    // A FeatureCollection must have a "type" of "FeatureCollection"
-    // and a member named "features" that is an array.
-    // http://geojson.org/geojson-spec.html#feature-collection-objects
+Point GeoJson::TileTransform::operator()(double _lng, double _lat) const {
+    ProjectedMeters tmp = MapProjection::lngLatToProjectedMeters(LngLat(_lng, _lat));
+    return Point {
+        (tmp.x - origin.x) * inverseScale,
+        (tmp.y - origin.y) * inverseScale,
+    };
+}
 
-    auto type = _in.FindMember("type");
-    if (type == _in.MemberEnd() || !type->value.IsString() ||
-        std::strcmp(type->value.GetString(), "FeatureCollection") != 0) {
-        return false;
-    }
+GeoJson::GeometryKind GeoJson::getGeometryKind(const char* _type, size_t _length) {
 
-    auto features = _in.FindMember("features");
-    if (features == _in.MemberEnd() || !features->value.IsArray()) {
-        return false;
-    }
+    auto is = [&](const char* _name) {
+        return std::strlen(_name) == _length && std::strncmp(_type, _name, _length) == 0;
+    };
 
-    return true;
+    if (is("Point")) { return GeometryKind::point; }
+    if (is("MultiPoint")) { return GeometryKind::multiPoint; }
+    if (is("LineString")) { return GeometryKind::lineString; }
+    if (is("MultiLineString")) { return GeometryKind::multiLineString; }
+    if (is("Polygon")) { return GeometryKind::polygon; }
+    if (is("MultiPolygon")) { return GeometryKind::multiPolygon; }
 
+    return GeometryKind::unknown;
 }
 
-Point GeoJson::getPoint(const JsonValue& _in, const Transform& _proj) {
-    return _proj(LngLat(_in[0].GetDouble(), _in[1].GetDouble()));
+void GeoJson::GeometryBuffer::clear() {
+    points.clear();
+    lineEnds.clear();
+    polygonEnds.clear();
 }
 
-Line GeoJson::getLine(const JsonValue& _in, const Transform& _proj) {
+bool GeoJson::setGeometry(GeometryKind _kind, const GeometryBuffer& _buffer, Feature& _feature) {
 
-    Line line;
-    for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        line.push_back(getPoint(*itr, _proj));
-    }
-    return line;
+    const auto& points = _buffer.points;
+    const auto& lineEnds = _buffer.lineEnds;
 
-}
+    if (points.empty()) { return false; }
 
-Polygon GeoJson::getPolygon(const JsonValue& _in, const Transform& _proj) {
+    auto getLine = [&](size_t _line) {
+        uint32_t begin = _line == 0 ? 0 : lineEnds[_line - 1];
+        return Line(points.begin() + begin, points.begin() + lineEnds[_line]);
+    };
 
-    Polygon polygon;
-    for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        polygon.push_back(getLine(*itr, _proj));
+    auto getPolygon = [&](size_t _begin, size_t _end) {
+        Polygon polygon;
+        polygon.reserve(_end - _begin);
+        for (size_t i = _begin; i < _end; i++) {
+            polygon.push_back(getLine(i));
+        }
+        return polygon;
+    };
+
+    switch (_kind) {
+    case GeometryKind::point:
+    case GeometryKind::multiPoint:
+        _feature.geometryType = GeometryType::points;
+        _feature.points.assign(points.begin(), points.end());
+        return true;
+
+    case GeometryKind::lineString:
+        _feature.geometryType = GeometryType::lines;
+        _feature.lines.emplace_back(points.begin(), points.end());
+        return true;
+
+    case GeometryKind::multiLineString:
+        _feature.geometryType = GeometryType::lines;
+        _feature.lines.reserve(lineEnds.size());
+        for (size_t i = 0; i < lineEnds.size(); i++) {
+            _feature.lines.push_back(getLine(i));
+        }
+        return true;
+
+    case GeometryKind::polygon:
+        _feature.geometryType = GeometryType::polygons;
+        _feature.polygons.push_back(getPolygon(0, lineEnds.size()));
+        return true;
+
+    case GeometryKind::multiPolygon: {
+        _feature.geometryType = GeometryType::polygons;
+        _feature.polygons.reserve(_buffer.polygonEnds.size());
+        size_t begin = 0;
+        for (auto end : _buffer.polygonEnds) {
+            _feature.polygons.push_back(getPolygon(begin, end));
+            begin = end;
+        }
+        return true;
+    }
+    case GeometryKind::unknown:
+        break;
     }
-    return polygon;
 
+    return false;
 }
 
-Properties GeoJson::getProperties(const JsonValue& _in, int32_t _sourceId) {
+void GeoJson::PropertyBuffer::setKey(const char* _key, size_t _length) {
 
-    std::vector<PropertyItem> items;
-    items.reserve(_in.MemberCount());
+    key.assign(_key, _length);
 
-    for (auto it = _in.MemberBegin(); it != _in.MemberEnd(); ++it) {
-
-        const auto& name = it->name.GetString();
-        const auto& value = it->value;
-        if (value.IsNumber()) {
-            items.emplace_back(name, value.GetDouble());
-        } else if (it->value.IsString()) {
-            items.emplace_back(name, value.GetString());
-        } else if (it->value.IsBool()) {
-            items.emplace_back(name, double(value.GetBool()));
-        }
+    auto it = keyIds.find(key);
+    if (it == keyIds.end()) {
+        it = keyIds.emplace(key, PropertyKeys::intern(key)).first;
     }
+    keyId = it->second;
+}
+
+void GeoJson::PropertyBuffer::add(Value _value) {
+    items.emplace_back(key, std::move(_value), keyId);
+}
 
-    Properties properties;
-    properties.sourceId = _sourceId;
-    properties.setSorted(std::move(items));
-    properties.sort();
+void GeoJson::PropertyBuffer::finish(Properties& _properties) {
 
-    return properties;
+    // Allocate exactly and keep the capacity of 'items' for the next feature
+    std::vector<PropertyItem> properties(std::make_move_iterator(items.begin()),
+                                         std::make_move_iterator(items.end()));
+    items.clear();
 
+    _properties.setSorted(std::move(properties));
+    _properties.sort();
 }
 
-Feature GeoJson::getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId) {
+namespace {
+
+using namespace GeoJson;
+
+/*
+ * SAX handler building the TileData of a GeoJSON tile
+ *
+ * The document is either one FeatureCollection, which becomes an unnamed
+ * layer, or an object of named FeatureCollections. Members may appear in any
+ * order, so coordinates are collected in a GeometryBuffer until the geometry
+ * object ends and its type is known.
+ */
+class Handler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler> {
+
+    enum class State : uint8_t {
+        root,
+        collection,
+        features,
+        feature,
+        properties,
+        geometry,
+        coordinates,
+    };
 
-    Feature feature;
+    enum class Member : uint8_t {
+        other,
+        type,
+        features,
+        properties,
+        geometry,
+        coordinates,
+    };
 
-    // Copy properties into tile data
-    auto properties = _in.FindMember("properties");
-    if (properties != _in.MemberEnd()) {
-        feature.props = getProperties(properties->value, _sourceId);
+public:
+
+    void reset(TileData& _tileData, int32_t _sourceId, const TileID& _tileId,
+               const std::vector<std::string>& _collections) {
+        m_tileData = &_tileData;
+        m_sourceId = _sourceId;
+        m_transform = TileTransform(_tileId);
+        m_collections = &_collections;
+
+        m_states.clear();
+        m_member = Member::other;
+        m_skipDepth = 0;
     }
 
-    // Copy geometry into tile data
-    const JsonValue& geometry = _in["geometry"];
-    const JsonValue& coords = geometry["coordinates"];
-    const std::string& geometryType = geometry["type"].GetString();
+    bool Null() { return true; }
 
-    if (geometryType.compare("Point") == 0) {
+    bool Bool(bool _value) {
+        if (m_skipDepth == 0 && !m_states.empty() && state() == State::properties) {
+            m_properties.add(double(_value));
+        }
+        return true;
+    }
 
-        feature.geometryType = GeometryType::points;
-        feature.points.push_back(getPoint(coords, _proj));
+    bool Int(int _value) { return number(_value); }
+    bool Uint(unsigned _value) { return number(_value); }
+    bool Int64(int64_t _value) { return number(_value); }
+    bool Uint64(uint64_t _value) { return number(_value); }
+    bool Double(double _value) { return number(_value); }
+
+    bool String(const char* _str, rapidjson::SizeType _length, bool) {
+        if (m_skipDepth > 0 || m_states.empty()) { return true; }
+
+        switch (state()) {
+        case State::root:
+        case State::collection:
+            if (m_member == Member::type) {
+                bool isCollection = _length == 17 && std::strncmp(_str, "FeatureCollection", 17) == 0;
+                if (state() == State::root) {
+                    m_rootIsCollection = isCollection;
+                } else {
+                    m_isCollection = isCollection;
+                }
+            }
+            break;
+        case State::properties:
+            m_properties.add(std::string(_str, _length));
+            break;
+        case State::geometry:
+            if (m_member == Member::type) {
+                m_kind = getGeometryKind(_str, _length);
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
 
-    } else if (geometryType.compare("MultiPoint") == 0) {
+    bool Key(const char* _str, rapidjson::SizeType _length, bool) {
+        if (m_skipDepth > 0) { return true; }
 
-        feature.geometryType = GeometryType::points;
-        for (auto pointCoords = coords.Begin(); pointCoords != coords.End(); ++pointCoords) {
-            feature.points.push_back(getPoint(*pointCoords, _proj));
+        if (state() == State::properties) {
+            m_properties.setKey(_str, _length);
+            return true;
         }
 
-    } else if (geometryType.compare("LineString") == 0) {
+        auto is = [&](const char* _name, size_t _size) {
+            return _length == _size && std::strncmp(_str, _name, _size) == 0;
+        };
 
-        feature.geometryType = GeometryType::lines;
-        feature.lines.push_back(getLine(coords, _proj));
+        if (is("type", 4)) { m_member = Member::type; }
+        else if (is("features", 8)) { m_member = Member::features; }
+        else if (is("properties", 10)) { m_member = Member::properties; }
+        else if (is("geometry", 8)) { m_member = Member::geometry; }
+        else if (is("coordinates", 11)) { m_member = Member::coordinates; }
+        else { m_member = Member::other; }
 
-    } else if (geometryType.compare("MultiLineString") == 0) {
+        if (state() == State::root) { m_name.assign(_str, _length); }
 
-        feature.geometryType = GeometryType::lines;
-        for (auto lineCoords = coords.Begin(); lineCoords != coords.End(); ++lineCoords) {
-            feature.lines.push_back(getLine(*lineCoords, _proj));
+        return true;
+    }
+
+    bool StartObject() {
+        if (m_skipDepth > 0) { m_skipDepth++; return true; }
+
+        if (m_states.empty()) {
+            // Unnamed layer of a top-level FeatureCollection
+            m_tileData->layers.emplace_back("");
+            m_rootIsCollection = false;
+            m_states.push_back(State::root);
+            return true;
         }
 
-    } else if (geometryType.compare("Polygon") == 0) {
+        switch (state()) {
+        case State::root:
+            if (m_member != Member::type && m_member != Member::features && isUsed(m_name)) {
+                m_tileData->layers.emplace_back(m_name);
+                m_isCollection = false;
+                m_states.push_back(State::collection);
+                return true;
+            }
+            break;
+        case State::features:
+            layer().features.emplace_back(m_sourceId);
+            m_hasGeometry = false;
+            m_states.push_back(State::feature);
+            return true;
+        case State::feature:
+            if (m_member == Member::properties) {
+                m_properties.items.clear();
+                m_states.push_back(State::properties);
+                return true;
+            }
+            if (m_member == Member::geometry) {
+                m_kind = GeometryKind::unknown;
+                m_geometry.clear();
+                m_positionDepth = 0;
+                m_states.push_back(State::geometry);
+                return true;
+            }
+            break;
+        default:
+            break;
+        }
+
+        m_skipDepth = 1;
+        return true;
+    }
 
-        feature.geometryType = GeometryType::polygons;
-        feature.polygons.push_back(getPolygon(coords, _proj));
+    bool EndObject(rapidjson::SizeType) {
+        if (m_skipDepth > 0) { m_skipDepth--; return true; }
 
-    } else if (geometryType.compare("MultiPolygon") == 0) {
+        auto& layers = m_tileData->layers;
 
-        feature.geometryType = GeometryType::polygons;
-        for (auto polyCoords = coords.Begin(); polyCoords != coords.End(); ++polyCoords) {
-            feature.polygons.push_back(getPolygon(*polyCoords, _proj));
+        switch (state()) {
+        case State::root:
+            // Either the document is a FeatureCollection or its members are
+            if (m_rootIsCollection) {
+                layers.erase(layers.begin() + 1, layers.end());
+            } else {
+                layers.erase(layers.begin());
+            }
+            break;
+        case State::collection:
+            if (!m_isCollection) { layers.pop_back(); }
+            break;
+        case State::feature:
+            if (!m_hasGeometry) { layer().features.pop_back(); }
+            break;
+        case State::properties:
+            m_properties.finish(layer().features.back().props);
+            break;
+        case State::geometry:
+            m_hasGeometry = m_positionDepth == positionDepth(m_kind) &&
+                setGeometry(m_kind, m_geometry, layer().features.back());
+            break;
+        default:
+            break;
         }
 
+        m_states.pop_back();
+        return true;
     }
 
-    return feature;
+    bool StartArray() {
+        if (m_skipDepth > 0) { m_skipDepth++; return true; }
+
+        if (!m_states.empty()) {
+            switch (state()) {
+            case State::root:
+            case State::collection:
+                if (m_member == Member::features) {
+                    m_layer = state() == State::root ? 0 : m_tileData->layers.size() - 1;
+                    m_states.push_back(State::features);
+                    return true;
+                }
+                break;
+            case State::geometry:
+                if (m_member == Member::coordinates) {
+                    m_depth = 1;
+                    m_positionSize = 0;
+                    m_states.push_back(State::coordinates);
+                    return true;
+                }
+                break;
+            case State::coordinates:
+                m_depth++;
+                m_positionSize = 0;
+                return true;
+            default:
+                break;
+            }
+        }
 
-}
+        m_skipDepth = 1;
+        return true;
+    }
 
-Layer GeoJson::getLayer(const JsonValue& _in, const Transform& _proj, int32_t _sourceId) {
+    bool EndArray(rapidjson::SizeType) {
+        if (m_skipDepth > 0) { m_skipDepth--; return true; }
+
+        if (state() == State::coordinates) {
+            if (m_positionDepth == 0) {
+                // No position read yet
+            } else if (m_depth == m_positionDepth) {
+                if (m_positionSize >= 2) {
+                    m_geometry.points.push_back(m_transform(m_position.x, m_position.y));
+                }
+            } else if (m_depth + 1 == m_positionDepth) {
+                m_geometry.lineEnds.push_back(m_geometry.points.size());
+            } else if (m_depth + 2 == m_positionDepth) {
+                m_geometry.polygonEnds.push_back(m_geometry.lineEnds.size());
+            }
+            if (--m_depth > 0) { return true; }
+        }
+
+        m_states.pop_back();
+        return true;
+    }
 
-    Layer layer("");
+private:
 
-    auto features = _in.FindMember("features");
+    State state() const { return m_states.back(); }
 
-    if (features == _in.MemberEnd()) {
-        LOGE("GeoJSON missing 'features' member");
-        return layer;
+    Layer& layer() { return m_tileData->layers[m_layer]; }
+
+    bool isUsed(const std::string& _name) const {
+        return m_collections->empty() ||
+            std::find(m_collections->begin(), m_collections->end(), _name) != m_collections->end();
     }
 
-    for (auto featureIt = features->value.Begin(); featureIt != features->value.End(); ++featureIt) {
-        layer.features.push_back(getFeature(*featureIt, _proj, _sourceId));
+    // Nesting depth of positions in the coordinates of @_kind
+    static int positionDepth(GeometryKind _kind) {
+        switch (_kind) {
+        case GeometryKind::point: return 1;
+        case GeometryKind::multiPoint:
+        case GeometryKind::lineString: return 2;
+        case GeometryKind::multiLineString:
+        case GeometryKind::polygon: return 3;
+        case GeometryKind::multiPolygon: return 4;
+        default: return -1;
+        }
     }
 
-    return layer;
+    bool number(double _value) {
+        if (m_skipDepth > 0 || m_states.empty()) { return true; }
+
+        if (state() == State::coordinates) {
+            // Positions are the innermost arrays, altitudes are ignored
+            if (m_positionDepth == 0) { m_positionDepth = m_depth; }
+            if (m_depth == m_positionDepth && m_positionSize < 2) {
+                m_position[m_positionSize] = _value;
+            }
+            m_positionSize++;
+        } else if (state() == State::properties) {
+            m_properties.add(_value);
+        }
+        return true;
+    }
+
+    TileData* m_tileData = nullptr;
+    int32_t m_sourceId = 0;
+    TileTransform m_transform;
+    const std::vector<std::string>* m_collections = nullptr;
+
+    std::vector<State> m_states;
+    Member m_member = Member::other;
+    // Nesting depth of the value that is skipped, zero when not skipping
+    int m_skipDepth = 0;
+
+    // Name of the current member of the document
+    std::string m_name;
+    bool m_rootIsCollection = false;
+    bool m_isCollection = false;
+
+    // Index of the layer receiving features
+    size_t m_layer = 0;
+
+    bool m_hasGeometry = false;
+    GeometryKind m_kind = GeometryKind::unknown;
+    GeometryBuffer m_geometry;
+    PropertyBuffer m_properties;
+
+    // Nesting depth in the coordinates array and of its positions
+    int m_depth = 0;
+    int m_positionDepth = 0;
+    glm::dvec2 m_position;
+    int m_positionSize = 0;
+};
 
 }
 
-std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, int32_t _sourceId) {
+std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, int32_t _sourceId,
+                                             const std::vector<std::string>& _collections) {
 
     auto& task = static_cast<const BinaryTileTask&>(_task);
 
     std::shared_ptr<TileData> tileData = std::make_shared<TileData>();
 
-    // Parse data into a JSON document
-    const char* error;
-    size_t offset;
-    auto document = JsonParseBytes(task.rawTileData->data(), task.rawTileData->size(), &error, &offset);
+    // Parser state of this worker, reused for all its tiles
+    thread_local rapidjson::Reader reader;
+    thread_local Handler handler;
 
-    if (error) {
-        LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(), error, offset);
-        return tileData;
-    }
+    handler.reset(*tileData, _sourceId, task.tileId(), _collections);
 
-    BoundingBox tileBounds(MapProjection::tileBounds(task.tileId()));
-    glm::dvec2 tileOrigin = tileBounds.min;
-    double tileInverseScale = 1.0 / tileBounds.width();
+    rapidjson::MemoryStream stream(task.rawTileData->data(), task.rawTileData->size());
+    reader.Parse(stream, handler);
 
-    const auto projFn = [&](LngLat _lngLat){
-        ProjectedMeters tmp = MapProjection::lngLatToProjectedMeters(_lngLat);
-        return Point {
-            (tmp.x - tileOrigin.x) * tileInverseScale,
-            (tmp.y - tileOrigin.y) * tileInverseScale,
-        };
-    };
-
-    // Transform JSON data into TileData using GeoJson functions
-    if (GeoJson::isFeatureCollection(document)) {
-        tileData->layers.push_back(GeoJson::getLayer(document, projFn, _sourceId));
-    } else {
-        for (auto layer = document.MemberBegin(); layer != document.MemberEnd(); ++layer) {
-            if (GeoJson::isFeatureCollection(layer->value)) {
-                tileData->layers.push_back(GeoJson::getLayer(layer->value, projFn, _sourceId));
-                tileData->layers.back().name = layer->name.GetString();
-            }
-        }
+    if (reader.HasParseError()) {
+        LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(),
+             rapidjson::GetParseError_En(reader.GetParseErrorCode()), reader.GetErrorOffset());
+        tileData->layers.clear();
     }
 
-
-    // Discard original JSON object and return TileData
-
     return tileData;
-
 }
 
 }
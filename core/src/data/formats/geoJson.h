@@ -1,34 +1,92 @@
 #pragma once
 
+#include "data/propertyItem.h"
 #include "data/tileData.h"
-#include "util/json.h"
-#include "util/types.h"
-#include <functional>
+#include "tile/tileID.h"
+
+#include "glm/vec2.hpp"
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Tangram {
 
 class TileTask;
 
+/*
+ * GeoJson - Streaming parser for GeoJSON tiles
+ *
+ * Tiles are read with the SAX interface of rapidjson: features are emitted into
+ * the TileData as soon as they are complete and no JSON document is built.
+ * The parser state lives per worker thread, so its buffers are reused for all
+ * tiles a worker parses. Collections that no scene layer uses are skipped
+ * without reading their values.
+ */
 namespace GeoJson {
 
-using Transform = std::function<Point(LngLat _lngLat)>;
+/* Projects longitude and latitude into the coordinates of a tile */
+struct TileTransform {
+    TileTransform() {}
+    explicit TileTransform(const TileID& _tileId);
+
+    Point operator()(double _lng, double _lat) const;
+
+    glm::dvec2 origin;
+    double inverseScale = 1.0;
+};
+
+/* Geometry types of GeoJSON and TopoJSON geometry objects */
+enum class GeometryKind : uint8_t {
+    unknown,
+    point,
+    multiPoint,
+    lineString,
+    multiLineString,
+    polygon,
+    multiPolygon,
+};
+
+GeometryKind getGeometryKind(const char* _type, size_t _length);
 
-bool isFeatureCollection(const JsonValue& _in);
+/* Geometry of one feature as read from nested coordinate arrays: all points,
+ * the end of each line in 'points' and the end of each polygon in 'lineEnds' */
+struct GeometryBuffer {
+    std::vector<Point> points;
+    std::vector<uint32_t> lineEnds;
+    std::vector<uint32_t> polygonEnds;
 
-Point getPoint(const JsonValue& _in, const Transform& _proj);
+    void clear();
+};
 
-Line getLine(const JsonValue& _in, const Transform& _proj);
+/* Copy the geometry of @_buffer into @_feature as @_kind. Returns false when
+ * there is no geometry to copy. */
+bool setGeometry(GeometryKind _kind, const GeometryBuffer& _buffer, Feature& _feature);
 
-Polygon getPolygon(const JsonValue& _in, const Transform& _proj);
+/* Collects the properties of one feature
+ *
+ * Keys are interned once per worker and then looked up in a local cache,
+ * so that features do not contend for the PropertyKeys lock.
+ */
+struct PropertyBuffer {
+    void setKey(const char* _key, size_t _length);
 
-Properties getProperties(const JsonValue& _in, int32_t _sourceId);
+    /* Add @_value for the last key set */
+    void add(Value _value);
 
-Feature getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId);
+    /* Move the collected properties into @_properties */
+    void finish(Properties& _properties);
 
-Layer getLayer(const JsonValue& _in, const Transform& _proj, int32_t _sourceId);
+    std::string key;
+    int32_t keyId = -1;
+    std::vector<PropertyItem> items;
+    std::unordered_map<std::string, int32_t> keyIds;
+};
 
-std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId);
+/* Parse tile into layers. When @_collections is not empty, named collections
+ * that are not in it are skipped. */
+std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId,
+                                    const std::vector<std::string>& _collections = {});
 
 } // namespace GeoJson
 
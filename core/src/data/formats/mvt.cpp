@@ -1,5 +1,6 @@
 #include "data/formats/mvt.h"
 #include "data/propertyItem.h"
+#include "data/propertyKeys.h"
 #include "tile/tile.h"
 #include "tile/tileTask.h"
 #include "log.h"
@@ -24,14 +25,53 @@
 
 namespace Tangram {
 
-Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
+// Keep the storage of the lines and polygons of @_feature for the next
+// decoded feature
+static void recycleGeometry(DecodeBuffers& _buffers, Feature& _feature) {
+    for (auto& line : _feature.lines) {
+        _buffers.spareLines.push_back(std::move(line));
+    }
+    for (auto& polygon : _feature.polygons) {
+        for (auto& line : polygon) {
+            _buffers.spareLines.push_back(std::move(line));
+        }
+        polygon.clear();
+        _buffers.sparePolygons.push_back(std::move(polygon));
+    }
+    _feature.points.clear();
+    _feature.lines.clear();
+    _feature.polygons.clear();
+}
+
+static Line takeLine(DecodeBuffers& _buffers) {
+    if (_buffers.spareLines.empty()) { return Line(); }
+
+    Line line = std::move(_buffers.spareLines.back());
+    _buffers.spareLines.pop_back();
+    line.clear();
+    return line;
+}
+
+static Polygon takePolygon(DecodeBuffers& _buffers) {
+    if (_buffers.sparePolygons.empty()) { return Polygon(); }
+
+    Polygon polygon = std::move(_buffers.sparePolygons.back());
+    _buffers.sparePolygons.pop_back();
+    return polygon;
+}
+
+void Mvt::getGeometry(const LayerContext& _layer, DecodeBuffers& _buffers, protobuf::message _geomIn) {
 
-    Geometry geometry;
+    // Reuse buffers of the previous feature
+    auto& coordinates = _buffers.coordinates;
+    auto& sizes = _buffers.sizes;
+    coordinates.clear();
+    sizes.clear();
 
     GeomCmd cmd = GeomCmd::moveTo;
     uint32_t cmdRepeat = 0;
 
-    double invTileExtent = (1.0/(_ctx.tileExtent-1.0));
+    double invTileExtent = (1.0/(_layer.tileExtent-1.0));
 
     int64_t x = 0;
     int64_t y = 0;
@@ -49,8 +89,8 @@ Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
         if(cmd == GeomCmd::moveTo || cmd == GeomCmd::lineTo) { // get parameters/points
             // if cmd is move then move to a new line/set of points and save this line
             if(cmd == GeomCmd::moveTo) {
-                if (geometry.coordinates.size() > 0) {
-                    geometry.sizes.push_back(numCoordinates);
+                if (coordinates.size() > 0) {
+                    sizes.push_back(numCoordinates);
                 }
                 numCoordinates = 0;
             }
@@ -61,16 +101,16 @@ Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
             // bring the points in 0 to 1 space
             Point p;
             p.x = invTileExtent * (double)x;
-            p.y = invTileExtent * (double)(_ctx.tileExtent - y);
+            p.y = invTileExtent * (double)(_layer.tileExtent - y);
 
-            if (numCoordinates == 0 || geometry.coordinates.back() != p) {
-                geometry.coordinates.push_back(p);
+            if (numCoordinates == 0 || coordinates.back() != p) {
+                coordinates.push_back(p);
                 numCoordinates++;
             }
         } else if(cmd == GeomCmd::closePath) {
             // end of a polygon, push first point in this line as last and push line to poly
-            geometry.coordinates.push_back(geometry.coordinates[geometry.coordinates.size() - numCoordinates]);
-            geometry.sizes.push_back(numCoordinates + 1);
+            coordinates.push_back(coordinates[coordinates.size() - numCoordinates]);
+            sizes.push_back(numCoordinates + 1);
             numCoordinates = 0;
         }
 
@@ -79,19 +119,15 @@ Mvt::Geometry Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
 
     // Enter the last line
     if (numCoordinates > 0) {
-        geometry.sizes.push_back(numCoordinates);
+        sizes.push_back(numCoordinates);
     }
-
-    return geometry;
 }
 
-Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
-
-    Feature feature(_ctx.sourceId);
-
-    _ctx.featureTags.clear();
-    _ctx.featureTags.assign(_ctx.keys.size(), -1);
+bool Mvt::getFeatureTags(const LayerContext& _layer, DecodeBuffers& _buffers, protobuf::message _featureIn,
+                         Feature& _feature, protobuf::message& _geometry) {
 
+    _buffers.tags.clear();
+    _buffers.tags.assign(_layer.keys.size(), -1);
 
     while(_featureIn.next()) {
         switch(_featureIn.tag) {
@@ -106,33 +142,33 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
                 while(tagsMsg) {
                     auto tagKey = tagsMsg.varint();
 
-                    if(_ctx.keys.size() <= tagKey) {
+                    if(_layer.keys.size() <= tagKey) {
                         LOGE("accessing out of bound key");
-                        return feature;
+                        return false;
                     }
 
                     if(!tagsMsg) {
                         LOGE("uneven number of feature tag ids");
-                        return feature;
+                        return false;
                     }
 
                     auto valueKey = tagsMsg.varint();
 
-                    if( _ctx.values.size() <= valueKey ) {
+                    if( _layer.values.size() <= valueKey ) {
                         LOGE("accessing out of bound values");
-                        return feature;
+                        return false;
                     }
 
-                    _ctx.featureTags[tagKey] = valueKey;
+                    _buffers.tags[tagKey] = valueKey;
                 }
                 break;
             }
             case FEATURE_TYPE:
-                feature.geometryType = (GeometryType)_featureIn.varint();
+                _feature.geometryType = (GeometryType)_featureIn.varint();
                 break;
             // Actual geometry data
             case FEATURE_GEOM:
-                _ctx.geometry = getGeometry(_ctx, _featureIn.getMessage());
+                _geometry = _featureIn.getMessage();
                 break;
 
             default:
@@ -141,42 +177,69 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
         }
     }
 
-    std::vector<Properties::Item> properties;
-    properties.reserve(_ctx.featureTags.size());
+    return true;
+}
+
+void Mvt::getProperties(const LayerContext& _layer, const DecodeBuffers& _buffers, Feature& _feature) {
 
-    for (int tagKey : _ctx.orderedKeys) {
-        int tagValue = _ctx.featureTags[tagKey];
-        if (tagValue >= 0) {
-            properties.emplace_back(_ctx.keys[tagKey], _ctx.values[tagValue]);
+    // Assign to the items of the previous feature, so that keys and string
+    // values keep their storage
+    std::vector<Properties::Item> properties = _feature.props.takeItems();
+    properties.reserve(_buffers.tags.size());
+    size_t count = 0;
+
+    for (int tagKey : _layer.orderedKeys) {
+        int tagValue = _buffers.tags[tagKey];
+        if (tagValue < 0) { continue; }
+
+        const Value& value = _layer.values[tagValue];
+
+        if (count == properties.size()) {
+            properties.emplace_back(_layer.keys[tagKey], value, _layer.keyIds[tagKey]);
+        } else {
+            auto& item = properties[count];
+            item.key = _layer.keys[tagKey];
+            item.keyId = _layer.keyIds[tagKey];
+            if (item.value.is<std::string>() && value.is<std::string>()) {
+                item.value.get<std::string>() = value.get<std::string>();
+            } else {
+                item.value = value;
+            }
         }
+        count++;
     }
-    feature.props.setSorted(std::move(properties));
+    properties.erase(properties.begin() + count, properties.end());
 
-    switch(feature.geometryType) {
+    _feature.props.setSorted(std::move(properties));
+}
+
+void Mvt::buildGeometry(const LayerContext& _layer, DecodeBuffers& _buffers, Feature& _feature) {
+
+    const auto& coordinates = _buffers.coordinates;
+
+    switch(_feature.geometryType) {
         case GeometryType::points:
-            feature.points.insert(feature.points.begin(),
-                                  _ctx.geometry.coordinates.begin(),
-                                  _ctx.geometry.coordinates.end());
+            _feature.points.insert(_feature.points.begin(),
+                                   coordinates.begin(), coordinates.end());
             break;
 
         case GeometryType::lines:
         {
-            auto pos = _ctx.geometry.coordinates.begin();
-            for (int length : _ctx.geometry.sizes) {
+            auto pos = coordinates.begin();
+            for (int length : _buffers.sizes) {
                 if (length == 0) { continue; }
-                Line line;
-                line.reserve(length);
+                Line line = takeLine(_buffers);
                 line.insert(line.begin(), pos, pos + length);
                 pos += length;
-                feature.lines.emplace_back(std::move(line));
+                _feature.lines.emplace_back(std::move(line));
             }
             break;
         }
         case GeometryType::polygons:
         {
-            auto pos = _ctx.geometry.coordinates.begin();
-            auto rpos = _ctx.geometry.coordinates.rend();
-            for (int length : _ctx.geometry.sizes) {
+            auto pos = coordinates.begin();
+            auto rpos = coordinates.rend();
+            for (int length : _buffers.sizes) {
                 if (length == 0) { continue; }
                 float area = signedArea(pos, pos + length);
                 if (area == 0) {
@@ -185,24 +248,20 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
                     continue;
                 }
                 int winding = area > 0 ? 1 : -1;
-                // Determine exterior winding from first polygon.
-                if (_ctx.winding == 0) {
-                    _ctx.winding = winding;
-                }
-                Line line;
+                Line line = takeLine(_buffers);
                 line.reserve(length);
-                if (_ctx.winding > 0) {
+                if (_layer.winding > 0) {
                     line.insert(line.end(), pos, pos + length);
                 } else {
                     line.insert(line.end(), rpos - length, rpos);
                 }
                 pos += length;
                 rpos -= length;
-                if (winding == _ctx.winding || feature.polygons.empty()) {
+                if (winding == _layer.winding || _feature.polygons.empty()) {
                     // This is an exterior polygon.
-                    feature.polygons.emplace_back();
+                    _feature.polygons.push_back(takePolygon(_buffers));
                 }
-                feature.polygons.back().push_back(std::move(line));
+                _feature.polygons.back().push_back(std::move(line));
             }
             break;
         }
@@ -211,41 +270,78 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
         default:
             break;
     }
+}
+
+Feature Mvt::getFeature(const LayerContext& _layer, DecodeBuffers& _buffers, protobuf::message _featureIn) {
+
+    Feature feature(_layer.sourceId);
+
+    protobuf::message geometryMsg;
+    if (!getFeatureTags(_layer, _buffers, _featureIn, feature, geometryMsg)) {
+        return feature;
+    }
+
+    getProperties(_layer, _buffers, feature);
+
+    if (geometryMsg) {
+        getGeometry(_layer, _buffers, geometryMsg);
+        buildGeometry(_layer, _buffers, feature);
+    }
 
     return feature;
 }
 
-Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
+int Mvt::getWinding(const LayerContext& _layer, DecodeBuffers& _buffers) {
 
-    Layer layer("");
+    for (protobuf::message featureIn : _layer.featureMsgs) {
+
+        GeometryType type = GeometryType::polygons;
+        protobuf::message geometryMsg;
+
+        while (featureIn.next()) {
+            if (featureIn.tag == FEATURE_TYPE) {
+                type = (GeometryType)featureIn.varint();
+            } else if (featureIn.tag == FEATURE_GEOM) {
+                geometryMsg = featureIn.getMessage();
+            } else {
+                featureIn.skip();
+            }
+        }
 
-    _ctx.keys.clear();
-    _ctx.values.clear();
-    _ctx.featureMsgs.clear();
+        if (type != GeometryType::polygons || !geometryMsg) { continue; }
 
-    bool lastWasFeature = false;
-    size_t numFeatures = 0;
-    protobuf::message featureItr;
+        getGeometry(_layer, _buffers, geometryMsg);
+
+        auto pos = _buffers.coordinates.begin();
+        for (int length : _buffers.sizes) {
+            float area = signedArea(pos, pos + length);
+            if (area != 0) { return area > 0 ? 1 : -1; }
+            pos += length;
+        }
+    }
+    return 0;
+}
+
+void Mvt::getLayerHeader(LayerContext& _layer, protobuf::message _layerIn, std::string& _name) {
+
+    _layer.keys.clear();
+    _layer.values.clear();
+    _layer.featureMsgs.clear();
 
     // Iterate layer to populate featureMsgs, keys and values
     while(_layerIn.next()) {
 
         switch(_layerIn.tag) {
             case LAYER_NAME: {
-                layer.name = _layerIn.string();
+                _name = _layerIn.string();
                 break;
             }
             case LAYER_FEATURE: {
-                numFeatures++;
-                if (!lastWasFeature) {
-                    _ctx.featureMsgs.push_back(_layerIn);
-                    lastWasFeature = true;
-                }
-                _layerIn.skip();
-                continue;
+                _layer.featureMsgs.push_back(_layerIn.getMessage());
+                break;
             }
             case LAYER_KEY: {
-                _ctx.keys.push_back(_layerIn.string());
+                _layer.keys.push_back(_layerIn.string());
                 break;
             }
             case LAYER_VALUE: {
@@ -254,28 +350,28 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
                 while (valueItr.next()) {
                     switch (valueItr.tag) {
                         case 1: // string value
-                            _ctx.values.push_back(valueItr.string());
+                            _layer.values.push_back(valueItr.string());
                             break;
                         case 2: // float value
-                            _ctx.values.push_back(valueItr.float32());
+                            _layer.values.push_back(valueItr.float32());
                             break;
                         case 3: // double value
-                            _ctx.values.push_back(valueItr.float64());
+                            _layer.values.push_back(valueItr.float64());
                             break;
                         case 4: // int value
-                            _ctx.values.push_back(valueItr.int64());
+                            _layer.values.push_back(valueItr.int64());
                             break;
                         case 5: // uint value
-                            _ctx.values.push_back(valueItr.varint());
+                            _layer.values.push_back(valueItr.varint());
                             break;
                         case 6: // sint value
-                            _ctx.values.push_back(valueItr.int64());
+                            _layer.values.push_back(valueItr.int64());
                             break;
                         case 7: // bool value
-                            _ctx.values.push_back(valueItr.boolean());
+                            _layer.values.push_back(valueItr.boolean());
                             break;
                         default:
-                            _ctx.values.push_back(none_type{});
+                            _layer.values.push_back(none_type{});
                             valueItr.skip();
                             break;
                     }
@@ -283,57 +379,141 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
                 break;
             }
             case LAYER_TILE_EXTENT:
-                _ctx.tileExtent = static_cast<int>(_layerIn.int64());
+                _layer.tileExtent = static_cast<int>(_layerIn.int64());
                 break;
 
             default: // skip
                 _layerIn.skip();
                 break;
         }
-        lastWasFeature = false;
     }
 
-    if (_ctx.featureMsgs.empty()) { return layer; }
+    if (_layer.featureMsgs.empty()) { return; }
+
+    // Resolve key ids once per layer for the compiled filters
+    PropertyKeys::intern(_layer.keys, _layer.keyIds);
 
     //// Assign ordering to keys for faster sorting
-    _ctx.orderedKeys.clear();
-    _ctx.orderedKeys.reserve(_ctx.keys.size());
+    _layer.orderedKeys.clear();
+    _layer.orderedKeys.reserve(_layer.keys.size());
     // assign key ids
-    for (int i = 0, n = _ctx.keys.size(); i < n; i++) {
-        _ctx.orderedKeys.push_back(i);
+    for (int i = 0, n = _layer.keys.size(); i < n; i++) {
+        _layer.orderedKeys.push_back(i);
     }
     // sort by Property key ordering
-    std::sort(_ctx.orderedKeys.begin(), _ctx.orderedKeys.end(),
+    std::sort(_layer.orderedKeys.begin(), _layer.orderedKeys.end(),
               [&](int a, int b) {
-                  return Properties::keyComparator(_ctx.keys[a], _ctx.keys[b]);
+                  return Properties::keyComparator(_layer.keys[a], _layer.keys[b]);
               });
+}
 
-    layer.features.reserve(numFeatures);
-    for (auto& featureItr : _ctx.featureMsgs) {
-        do {
-            auto featureMsg = featureItr.getMessage();
+Layer Mvt::getLayer(LayerContext& _layer, DecodeBuffers& _buffers, protobuf::message _layerIn) {
 
-            layer.features.push_back(getFeature(_ctx, featureMsg));
+    Layer layer("");
+
+    getLayerHeader(_layer, _layerIn, layer.name);
+
+    _layer.winding = getWinding(_layer, _buffers);
 
-        } while (featureItr.next() && featureItr.tag == LAYER_FEATURE);
+    layer.features.reserve(_layer.featureMsgs.size());
+    for (auto& featureMsg : _layer.featureMsgs) {
+        layer.features.push_back(getFeature(_layer, _buffers, featureMsg));
     }
 
     return layer;
 }
 
-std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, int32_t _sourceId) {
+Mvt::LayerDecoder::LayerDecoder(std::shared_ptr<std::vector<char>> _data, LayerContext&& _layer)
+    : m_data(std::move(_data)), m_layer(std::move(_layer)) {}
+
+bool Mvt::LayerDecoder::decodeFeature(size_t _index, Feature& _feature, DecodeBuffers& _buffers) const {
+
+    _feature.props.sourceId = m_layer.sourceId;
+    _feature.geometryType = GeometryType::polygons;
+    recycleGeometry(_buffers, _feature);
+
+    try {
+        protobuf::message geometryMsg;
+        if (!getFeatureTags(m_layer, _buffers, m_layer.featureMsgs[_index], _feature, geometryMsg)) {
+            return false;
+        }
+
+        getProperties(m_layer, _buffers, _feature);
+
+        return true;
+
+    } catch(const std::exception& e) {
+        LOGE("Cannot decode feature: %s", e.what());
+    }
+    return false;
+}
+
+bool Mvt::LayerDecoder::decodeGeometry(size_t _index, Feature& _feature, DecodeBuffers& _buffers) const {
+
+    try {
+        if (_feature.geometryType == GeometryType::polygons) {
+            // Take the winding from the first polygon of the layer, not from
+            // the first one decoded, so that it does not depend on which
+            // features a thread decodes first
+            std::call_once(m_windingFlag, [&]() {
+                m_layer.winding = getWinding(m_layer, _buffers);
+            });
+        }
+
+        // Find the geometry message of the feature
+        protobuf::message featureIn = m_layer.featureMsgs[_index];
+        while (featureIn.next()) {
+            if (featureIn.tag == FEATURE_GEOM) {
+                getGeometry(m_layer, _buffers, featureIn.getMessage());
+                buildGeometry(m_layer, _buffers, _feature);
+                return true;
+            }
+            featureIn.skip();
+        }
+    } catch(const std::exception& e) {
+        LOGE("Cannot decode feature geometry: %s", e.what());
+    }
+    return false;
+}
+
+std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, int32_t _sourceId,
+                                         const std::vector<std::string>& _collections) {
 
     auto tileData = std::make_shared<TileData>();
 
     auto& task = static_cast<const BinaryTileTask&>(_task);
 
     protobuf::message item(task.rawTileData->data(), task.rawTileData->size());
-    ParserContext ctx(_sourceId);
 
     try {
         while(item.next()) {
             if(item.tag == LAYER) {
-                tileData->layers.push_back(getLayer(ctx, item.getMessage()));
+                auto layerMsg = item.getMessage();
+
+                if (!_collections.empty()) {
+                    // Skip layers that are not used by any scene layer
+                    std::string name;
+                    auto nameItr = layerMsg;
+                    while (nameItr.next()) {
+                        if (nameItr.tag == LAYER_NAME) {
+                            name = nameItr.string();
+                            break;
+                        }
+                        nameItr.skip();
+                    }
+                    if (std::find(_collections.begin(), _collections.end(), name) == _collections.end()) {
+                        continue;
+                    }
+                }
+
+                LayerContext ctx(_sourceId);
+                Layer layer("");
+                getLayerHeader(ctx, layerMsg, layer.name);
+
+                if (!ctx.featureMsgs.empty()) {
+                    layer.decoder = std::make_unique<LayerDecoder>(task.rawTileData, std::move(ctx));
+                }
+                tileData->layers.push_back(std::move(layer));
             } else {
                 item.skip();
             }
@@ -5,6 +5,7 @@
 #include "util/variant.h"
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -16,25 +17,22 @@ class MapProjection;
 
 namespace Mvt {
 
-    struct Geometry {
-        std::vector<Point> coordinates;
-        std::vector<int> sizes;
-    };
-
-    struct ParserContext {
-        ParserContext(int32_t _sourceId) : sourceId(_sourceId){}
+    /* Data of a layer that is shared by all threads decoding its features */
+    struct LayerContext {
+        LayerContext(int32_t _sourceId) : sourceId(_sourceId){}
 
         int32_t sourceId;
         std::vector<std::string> keys;
+        // Interned ids of keys, see PropertyKeys
+        std::vector<int32_t> keyIds;
         std::vector<Value> values;
+        // One message per feature of the layer
         std::vector<protobuf::message> featureMsgs;
-        Geometry geometry;
-        // Map Key ID -> Tag values
-        std::vector<int> featureTags;
         // Key IDs sorted by Property key ordering
         std::vector<int> orderedKeys;
 
         int tileExtent = 0;
+        // Winding of exterior polygon rings, see getWinding()
         int winding = 0;
     };
 
@@ -44,13 +42,59 @@ namespace Mvt {
         closePath = 7
     };
 
-    Geometry getGeometry(ParserContext& _ctx, protobuf::message _geomIn);
+    /* Decodes the features of one layer on demand from the raw tile data
+     *
+     * Only keys, values and feature offsets of the layer are read up front.
+     * Properties are decoded per feature, geometry only when requested.
+     * Polygon winding is determined once, when the geometry of the first
+     * polygon feature is requested.
+     */
+    class LayerDecoder : public FeatureDecoder {
+    public:
+        LayerDecoder(std::shared_ptr<std::vector<char>> _data, LayerContext&& _layer);
+
+        size_t featureCount() const override { return m_layer.featureMsgs.size(); }
+
+        bool decodeFeature(size_t _index, Feature& _feature, DecodeBuffers& _buffers) const override;
+
+        bool decodeGeometry(size_t _index, Feature& _feature, DecodeBuffers& _buffers) const override;
+
+    private:
+        // Keeps the buffer referenced by the feature messages alive
+        std::shared_ptr<std::vector<char>> m_data;
+
+        // Only written once, by the first thread that decodes a geometry
+        mutable LayerContext m_layer;
+        mutable std::once_flag m_windingFlag;
+    };
+
+    /* Decode @_geomIn into _buffers.coordinates and _buffers.sizes */
+    void getGeometry(const LayerContext& _layer, DecodeBuffers& _buffers, protobuf::message _geomIn);
+
+    /* Read tags of @_featureIn into _buffers.tags, geometry type into
+     * @_feature and the geometry message into @_geometry. */
+    bool getFeatureTags(const LayerContext& _layer, DecodeBuffers& _buffers, protobuf::message _featureIn,
+                        Feature& _feature, protobuf::message& _geometry);
+
+    void getProperties(const LayerContext& _layer, const DecodeBuffers& _buffers, Feature& _feature);
+
+    void buildGeometry(const LayerContext& _layer, DecodeBuffers& _buffers, Feature& _feature);
+
+    Feature getFeature(const LayerContext& _layer, DecodeBuffers& _buffers, protobuf::message _featureIn);
+
+    /* Winding of the first polygon ring of the layer, which is taken as the
+     * winding of exterior rings. Returns 0 when the layer has no polygons. */
+    int getWinding(const LayerContext& _layer, DecodeBuffers& _buffers);
 
-    Feature getFeature(ParserContext& _ctx, protobuf::message _featureIn);
+    /* Read name, keys, values, extent and feature offsets of a layer into @_layer */
+    void getLayerHeader(LayerContext& _layer, protobuf::message _layerIn, std::string& _name);
 
-    Layer getLayer(ParserContext& _ctx, protobuf::message _layerIn);
+    Layer getLayer(LayerContext& _layer, DecodeBuffers& _buffers, protobuf::message _layerIn);
 
-    std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId);
+    /* Parse tile into layers with lazily decoded features. When @_collections
+     * is not empty, layers not contained in it are skipped without parsing. */
+    std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId,
+                                        const std::vector<std::string>& _collections = {});
 
 } // namespace Mvt
 
@@ -1,293 +1,570 @@
 #include "data/formats/topoJson.h"
+
 #include "data/formats/geoJson.h"
-#include "data/propertyItem.h"
-#include "tile/tileTask.h"
-#include "util/geom.h"
-#include "util/mapProjection.h"
 #include "log.h"
+#include "tile/tileTask.h"
 
-namespace Tangram {
-
-TopoJson::Topology TopoJson::getTopology(const JsonDocument& _document, const Transform& _proj) {
-
-    Topology topo;
+#include "rapidjson/error/en.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
 
-    topo.proj = _proj;
+#include <algorithm>
+#include <cstring>
 
-    auto transform = _document.FindMember("transform");
-    if (transform != _document.MemberEnd()) {
-        auto scale = transform->value.FindMember("scale");
-        if (scale != transform->value.MemberEnd() && scale->value.Size() == 2) {
-            topo.scale = { scale->value[0].GetDouble(), scale->value[1].GetDouble() };
-        }
-        auto translate = transform->value.FindMember("translate");
-        if (translate != transform->value.MemberEnd() && translate->value.Size() == 2) {
-            topo.translate = { translate->value[0].GetDouble(), translate->value[1].GetDouble() };
-        }
-    }
+namespace Tangram {
 
-    // Quantized, delta-encoded 'arcs' in Json
-    auto jsonArcList = _document.FindMember("arcs");
+namespace {
+
+using namespace GeoJson;
+
+/*
+ * SAX handler building the TileData of a TopoJSON tile
+ *
+ * Arcs and transform are kept as read. Each geometry object becomes a feature
+ * right away, its arc indices and point coordinates are stored as a pending
+ * geometry. resolve() decodes the arcs and sets the pending geometries once
+ * the document was read.
+ */
+class Handler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler> {
+
+    enum class State : uint8_t {
+        root,
+        transform,
+        vector,
+        arcs,
+        objects,
+        object,
+        geometries,
+        geometry,
+        properties,
+        arcIndices,
+        coordinates,
+    };
 
-    if (jsonArcList == _document.MemberEnd()) {
-        return topo;
-    }
+    enum class Member : uint8_t {
+        other,
+        type,
+        transform,
+        scale,
+        translate,
+        arcs,
+        objects,
+        geometries,
+        properties,
+        coordinates,
+    };
 
-    const auto& jsonArcs = jsonArcList->value;
+    // Geometry of a feature that references arcs or quantized points
+    struct PendingGeometry {
+        uint32_t layer;
+        uint32_t feature;
+        GeometryKind kind;
+        int depth;
+        uint32_t indexBegin;
+        uint32_t lineBegin, lineEnd;
+        uint32_t polygonBegin, polygonEnd;
+        uint32_t positionBegin, positionEnd;
+    };
 
-    if (!jsonArcs.IsArray()) {
-        return topo;
+public:
+
+    void reset(TileData& _tileData, int32_t _sourceId, const TileID& _tileId,
+               const std::vector<std::string>& _collections) {
+        m_tileData = &_tileData;
+        m_sourceId = _sourceId;
+        m_transform = TileTransform(_tileId);
+        m_collections = &_collections;
+
+        m_states.clear();
+        m_member = Member::other;
+        m_skipDepth = 0;
+
+        m_quantized = false;
+        m_scale = { 1., 1. };
+        m_translate = { 0., 0. };
+
+        m_arcPositions.clear();
+        m_arcEnds.clear();
+        m_indices.clear();
+        m_indexLineEnds.clear();
+        m_indexPolygonEnds.clear();
+        m_positions.clear();
+        m_pending.clear();
     }
 
-    topo.arcs.reserve(jsonArcs.Size());
-
-    // Decode and transform the points that make up 'arcs'
-    for (auto jsonArcsIt = jsonArcs.Begin(); jsonArcsIt != jsonArcs.End(); ++jsonArcsIt) {
-
-        const auto& jsonArc = *jsonArcsIt;
-
-        if (!jsonArc.IsArray()) { // According to spec, jsonArc.Size() >= 2 should also hold
-            continue;
+    /* Set the geometry of all features from the arcs that were read */
+    void resolve() {
+
+        // Decode and transform the points that make up the arcs. Arcs of a
+        // quantized topology are delta-encoded.
+        m_arcPoints.clear();
+        m_arcPoints.reserve(m_arcPositions.size());
+
+        size_t arcBegin = 0;
+        for (auto arcEnd : m_arcEnds) {
+            glm::dvec2 cursor;
+            for (size_t i = arcBegin; i < arcEnd; i++) {
+                if (m_quantized) {
+                    cursor += m_arcPositions[i];
+                    m_arcPoints.push_back(project(cursor));
+                } else {
+                    m_arcPoints.push_back(project(m_arcPositions[i]));
+                }
+            }
+            arcBegin = arcEnd;
         }
 
-        Line arc;
-        arc.reserve(jsonArc.Size());
-
-        // Quantized position
-        glm::ivec2 q;
-
-        for (auto jsonCoordsIt = jsonArc.Begin(); jsonCoordsIt != jsonArc.End(); ++jsonCoordsIt) {
-
-            const auto& jsonCoords = *jsonCoordsIt;
+        for (auto& pending : m_pending) {
+            auto& feature = m_tileData->layers[pending.layer].features[pending.feature];
+
+            m_geometry.clear();
+
+            if (pending.kind == GeometryKind::point || pending.kind == GeometryKind::multiPoint) {
+                // Point positions are quantized but not delta-encoded
+                for (size_t i = pending.positionBegin; i < pending.positionEnd; i++) {
+                    m_geometry.points.push_back(project(m_positions[i]));
+                }
+            } else {
+                uint32_t begin = pending.indexBegin;
+                for (size_t line = pending.lineBegin; line < pending.lineEnd; line++) {
+                    addLine(begin, m_indexLineEnds[line]);
+                    m_geometry.lineEnds.push_back(m_geometry.points.size());
+                    begin = m_indexLineEnds[line];
+                }
+                for (size_t polygon = pending.polygonBegin; polygon < pending.polygonEnd; polygon++) {
+                    m_geometry.polygonEnds.push_back(m_indexPolygonEnds[polygon] - pending.lineBegin);
+                }
+            }
 
-            arc.push_back(getPoint(jsonCoords, topo, q));
+            setGeometry(pending.kind, m_geometry, feature);
         }
-
-        topo.arcs.push_back(arc);
     }
 
-    return topo;
-}
-
-Point TopoJson::getPoint(const JsonValue& _coordinates, const Topology& _topology, glm::ivec2& _cursor) {
+    bool Null() { return true; }
 
-    if (!_coordinates.IsArray() || _coordinates.Size() < 2) {
-        return Point();
+    bool Bool(bool _value) {
+        if (m_skipDepth == 0 && !m_states.empty() && state() == State::properties) {
+            m_properties.add(double(_value));
+        }
+        return true;
     }
 
-    _cursor.x += _coordinates[0].GetInt();
-    _cursor.y += _coordinates[1].GetInt();
-
-    auto tmp = glm::dvec2(_cursor) * _topology.scale + _topology.translate;
-    return _topology.proj(LngLat(tmp.x, tmp.y));
-
-}
-
-Line TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology) {
+    bool Int(int _value) { return number(_value); }
+    bool Uint(unsigned _value) { return number(_value); }
+    bool Int64(int64_t _value) { return number(_value); }
+    bool Uint64(uint64_t _value) { return number(_value); }
+    bool Double(double _value) { return number(_value); }
 
-    Line line;
+    bool String(const char* _str, rapidjson::SizeType _length, bool) {
+        if (m_skipDepth > 0 || m_states.empty()) { return true; }
 
-    if (!_arcs.IsArray()) {
-        return line;
+        switch (state()) {
+        case State::object:
+            if (m_member == Member::type) {
+                m_isCollection = _length == 18 && std::strncmp(_str, "GeometryCollection", 18) == 0;
+            }
+            break;
+        case State::geometry:
+            if (m_member == Member::type) {
+                m_kind = getGeometryKind(_str, _length);
+            }
+            break;
+        case State::properties:
+            m_properties.add(std::string(_str, _length));
+            break;
+        default:
+            break;
+        }
+        return true;
     }
 
-    for (auto arcIt = _arcs.Begin(); arcIt != _arcs.End(); ++arcIt) {
+    bool Key(const char* _str, rapidjson::SizeType _length, bool) {
+        if (m_skipDepth > 0) { return true; }
 
-        auto index = arcIt->GetInt();
-        bool reverse = false;
-        if (index < 0) {
-            reverse = true;
-            index = -1 - index;
+        if (state() == State::properties) {
+            m_properties.setKey(_str, _length);
+            return true;
         }
-
-        if (index < 0 || (std::vector<Line>::size_type)index >= _topology.arcs.size()) {
-            continue;
+        if (state() == State::objects) {
+            m_name.assign(_str, _length);
+            return true;
         }
 
-        const auto& arc = _topology.arcs[index];
+        auto is = [&](const char* _name, size_t _size) {
+            return _length == _size && std::strncmp(_str, _name, _size) == 0;
+        };
+
+        if (is("type", 4)) { m_member = Member::type; }
+        else if (is("transform", 9)) { m_member = Member::transform; }
+        else if (is("scale", 5)) { m_member = Member::scale; }
+        else if (is("translate", 9)) { m_member = Member::translate; }
+        else if (is("arcs", 4)) { m_member = Member::arcs; }
+        else if (is("objects", 7)) { m_member = Member::objects; }
+        else if (is("geometries", 10)) { m_member = Member::geometries; }
+        else if (is("properties", 10)) { m_member = Member::properties; }
+        else if (is("coordinates", 11)) { m_member = Member::coordinates; }
+        else { m_member = Member::other; }
+
+        return true;
+    }
 
-        auto begin = arc.begin();
-        auto end = arc.end();
-        size_t inc = 1;
-        if (reverse) {
-            begin = arc.end() - 1;
-            end = arc.begin() - 1;
-            inc = -inc;
-        }
+    bool StartObject() {
+        if (m_skipDepth > 0) { m_skipDepth++; return true; }
 
-        // If a line is made from multiple arcs, the first position of an arc must
-        // be equal to the last position of the previous arc. So when reconstructing
-        // the geometry, the first position of each arc except the first may be dropped
-        if (arcIt != _arcs.Begin()) {
-            begin = begin + inc;
+        if (m_states.empty()) {
+            m_states.push_back(State::root);
+            return true;
         }
 
-        for (auto pointIt = begin; pointIt != end; pointIt += inc) {
-            line.push_back(*pointIt);
+        switch (state()) {
+        case State::root:
+            if (m_member == Member::transform) {
+                m_quantized = true;
+                m_states.push_back(State::transform);
+                return true;
+            }
+            if (m_member == Member::objects) {
+                m_states.push_back(State::objects);
+                return true;
+            }
+            break;
+        case State::objects:
+            if (isUsed(m_name)) {
+                m_tileData->layers.emplace_back(m_name);
+                m_isCollection = false;
+                m_states.push_back(State::object);
+                return true;
+            }
+            break;
+        case State::geometries:
+            layer().features.emplace_back(m_sourceId);
+            m_kind = GeometryKind::unknown;
+            m_depth = 0;
+            m_valueDepth = 0;
+            m_pending.push_back({});
+            m_pending.back().indexBegin = m_indices.size();
+            m_pending.back().lineBegin = m_indexLineEnds.size();
+            m_pending.back().polygonBegin = m_indexPolygonEnds.size();
+            m_pending.back().positionBegin = m_positions.size();
+            m_states.push_back(State::geometry);
+            return true;
+        case State::geometry:
+            if (m_member == Member::properties) {
+                m_properties.items.clear();
+                m_states.push_back(State::properties);
+                return true;
+            }
+            break;
+        default:
+            break;
         }
 
+        m_skipDepth = 1;
+        return true;
     }
 
-    return line;
-
-}
+    bool EndObject(rapidjson::SizeType) {
+        if (m_skipDepth > 0) { m_skipDepth--; return true; }
+
+        switch (state()) {
+        case State::object:
+            if (!m_isCollection) {
+                // Drop the layer with the geometries read so far
+                auto index = m_tileData->layers.size() - 1;
+                while (!m_pending.empty() && m_pending.back().layer == index) {
+                    m_pending.pop_back();
+                }
+                m_tileData->layers.pop_back();
+            }
+            break;
+        case State::geometry:
+            endGeometry();
+            break;
+        case State::properties:
+            m_properties.finish(layer().features.back().props);
+            break;
+        default:
+            break;
+        }
 
-Polygon TopoJson::getPolygon(const JsonValue& _arcSets, const Topology& _topology) {
+        m_states.pop_back();
+        return true;
+    }
 
-    Polygon polygon;
+    bool StartArray() {
+        if (m_skipDepth > 0) { m_skipDepth++; return true; }
+
+        if (!m_states.empty()) {
+            switch (state()) {
+            case State::root:
+                if (m_member == Member::arcs) {
+                    m_depth = 1;
+                    m_states.push_back(State::arcs);
+                    return true;
+                }
+                break;
+            case State::transform:
+                if (m_member == Member::scale || m_member == Member::translate) {
+                    m_positionSize = 0;
+                    m_states.push_back(State::vector);
+                    return true;
+                }
+                break;
+            case State::object:
+                if (m_member == Member::geometries) {
+                    m_states.push_back(State::geometries);
+                    return true;
+                }
+                break;
+            case State::geometry:
+                if (m_member == Member::arcs || m_member == Member::coordinates) {
+                    m_depth = 1;
+                    m_valueDepth = 0;
+                    m_positionSize = 0;
+                    m_states.push_back(m_member == Member::arcs ? State::arcIndices : State::coordinates);
+                    return true;
+                }
+                break;
+            case State::arcs:
+            case State::arcIndices:
+            case State::coordinates:
+                m_depth++;
+                m_positionSize = 0;
+                return true;
+            default:
+                break;
+            }
+        }
 
-    if (!_arcSets.IsArray()) {
-        return polygon;
+        m_skipDepth = 1;
+        return true;
     }
 
-    for (auto arcSetIt = _arcSets.Begin(); arcSetIt != _arcSets.End(); ++arcSetIt) {
+    bool EndArray(rapidjson::SizeType) {
+        if (m_skipDepth > 0) { m_skipDepth--; return true; }
 
-        auto ring = getLine(*arcSetIt, _topology);
-        polygon.push_back(ring);
+        switch (state()) {
+        case State::vector:
+            if (m_positionSize >= 2) {
+                (m_member == Member::scale ? m_scale : m_translate) = m_position;
+            }
+            break;
+        case State::arcs:
+            // Depth 1 is the list of arcs, 2 an arc and 3 a position
+            if (m_depth == 3 && m_positionSize >= 2) {
+                m_arcPositions.push_back(m_position);
+            } else if (m_depth == 2) {
+                m_arcEnds.push_back(m_arcPositions.size());
+            }
+            if (--m_depth > 0) { return true; }
+            break;
+        case State::arcIndices:
+            if (m_valueDepth == 0) {
+                // No arc index read yet
+            } else if (m_depth == m_valueDepth) {
+                m_indexLineEnds.push_back(m_indices.size());
+            } else if (m_depth + 1 == m_valueDepth) {
+                m_indexPolygonEnds.push_back(m_indexLineEnds.size());
+            }
+            if (--m_depth > 0) { return true; }
+            break;
+        case State::coordinates:
+            if (m_depth == m_valueDepth && m_positionSize >= 2) {
+                m_positions.push_back(m_position);
+            }
+            if (--m_depth > 0) { return true; }
+            break;
+        default:
+            break;
+        }
 
+        m_states.pop_back();
+        return true;
     }
 
-    return polygon;
-
-}
-
-Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _source) {
+private:
 
-    static const JsonValue keyProperties("properties");
-    static const JsonValue keyType("type");
-    static const JsonValue keyCoordinates("coordinates");
-    static const JsonValue keyArcs("arcs");
+    State state() const { return m_states.back(); }
 
-    Feature feature;
+    Layer& layer() { return m_tileData->layers.back(); }
 
-    auto propertiesIt = _geometry.FindMember(keyProperties);
-    if (propertiesIt != _geometry.MemberEnd() && propertiesIt->value.IsObject()) {
-        feature.props = GeoJson::getProperties(propertiesIt->value, _source);
+    bool isUsed(const std::string& _name) const {
+        return m_collections->empty() ||
+            std::find(m_collections->begin(), m_collections->end(), _name) != m_collections->end();
     }
 
-    std::string type;
-    auto typeIt = _geometry.FindMember(keyType);
-    if (typeIt != _geometry.MemberEnd() && typeIt->value.IsString()) {
-        type = typeIt->value.GetString();
+    Point project(glm::dvec2 _position) const {
+        if (m_quantized) { _position = _position * m_scale + m_translate; }
+        return m_transform(_position.x, _position.y);
     }
 
-    if (type == "Point") {
-        feature.geometryType = GeometryType::points;
-        auto coordinatesIt = _geometry.FindMember(keyCoordinates);
-        if (coordinatesIt != _geometry.MemberEnd()) {
-            glm::ivec2 cursor;
-            feature.points.push_back(getPoint(coordinatesIt->value, _topology, cursor));
-        }
-    } else if (type == "MultiPoint") {
-        feature.geometryType = GeometryType::points;
-        auto coordinatesIt = _geometry.FindMember(keyCoordinates);
-        if (coordinatesIt != _geometry.MemberEnd() && coordinatesIt->value.IsArray()) {
-            auto& coordinates = coordinatesIt->value;
-            for (auto point = coordinates.Begin(); point != coordinates.End(); ++point) {
-                glm::ivec2 cursor;
-                feature.points.push_back(getPoint(*point, _topology, cursor));
-            }
-        }
-    } else if (type == "LineString") {
-        feature.geometryType = GeometryType::lines;
-        auto arcsIt = _geometry.FindMember(keyArcs);
-        if (arcsIt != _geometry.MemberEnd()) {
-            feature.lines.push_back(getLine(arcsIt->value, _topology));
+    // Nesting depth of arc indices or point positions in a geometry of @_kind
+    static int valueDepth(GeometryKind _kind) {
+        switch (_kind) {
+        case GeometryKind::point:
+        case GeometryKind::lineString: return 1;
+        case GeometryKind::multiPoint:
+        case GeometryKind::multiLineString:
+        case GeometryKind::polygon: return 2;
+        case GeometryKind::multiPolygon: return 3;
+        default: return -1;
         }
-    } else if (type == "MultiLineString") {
-        feature.geometryType = GeometryType::lines;
-        auto arcsIt = _geometry.FindMember(keyArcs);
-        if (arcsIt != _geometry.MemberEnd() && arcsIt->value.IsArray()) {
-            auto& arcs = arcsIt->value;
-            for (auto arcList = arcs.Begin(); arcList != arcs.End(); ++arcList) {
-                feature.lines.push_back(getLine(*arcList, _topology));
-            }
-        }
-    } else if (type == "Polygon") {
-        feature.geometryType = GeometryType::polygons;
-        auto arcsIt = _geometry.FindMember(keyArcs);
-        if (arcsIt != _geometry.MemberEnd()) {
-            feature.polygons.push_back(getPolygon(arcsIt->value, _topology));
-        }
-    } else if (type == "MultiPolygon") {
-        feature.geometryType = GeometryType::polygons;
-        auto arcsIt = _geometry.FindMember(keyArcs);
-        if (arcsIt != _geometry.MemberEnd() && arcsIt->value.IsArray()) {
-            auto& arcs = arcsIt->value;
-            for (auto arcList = arcs.Begin(); arcList != arcs.End(); ++arcList) {
-                feature.polygons.push_back(getPolygon(*arcList, _topology));
-            }
-        }
-    } else if (type == "GeometryCollection") {
-        // Not handled
     }
 
-    return feature;
+    void endGeometry() {
+        auto& pending = m_pending.back();
+
+        if (m_valueDepth != valueDepth(m_kind)) {
+            // Unknown type or nesting, e.g. a nested GeometryCollection
+            m_indices.resize(pending.indexBegin);
+            m_indexLineEnds.resize(pending.lineBegin);
+            m_indexPolygonEnds.resize(pending.polygonBegin);
+            m_positions.resize(pending.positionBegin);
+            m_pending.pop_back();
+            layer().features.pop_back();
+            return;
+        }
 
-}
+        pending.layer = m_tileData->layers.size() - 1;
+        pending.feature = layer().features.size() - 1;
+        pending.kind = m_kind;
+        pending.lineEnd = m_indexLineEnds.size();
+        pending.polygonEnd = m_indexPolygonEnds.size();
+        pending.positionEnd = m_positions.size();
+    }
 
-Layer TopoJson::getLayer(JsonValue::MemberIterator& _objectIt, const Topology& _topology, int32_t _source) {
+    // Append the points of the arcs m_indices[_begin, _end) to m_geometry
+    void addLine(uint32_t _begin, uint32_t _end) {
+        auto& points = m_geometry.points;
+
+        for (uint32_t i = _begin; i < _end; i++) {
+            int32_t index = m_indices[i];
+            bool reverse = index < 0;
+            if (reverse) { index = -1 - index; }
+
+            if (index < 0 || size_t(index) >= m_arcEnds.size()) { continue; }
+
+            uint32_t arcBegin = index == 0 ? 0 : m_arcEnds[index - 1];
+            uint32_t arcEnd = m_arcEnds[index];
+            if (arcBegin == arcEnd) { continue; }
+
+            // If a line is made from multiple arcs, the first position of an arc
+            // must be equal to the last position of the previous arc. So when
+            // reconstructing the geometry, the first position of each arc except
+            // the first may be dropped
+            bool skipFirst = i != _begin;
+
+            if (reverse) {
+                auto it = m_arcPoints.rend() - arcEnd;
+                auto end = m_arcPoints.rend() - arcBegin;
+                points.insert(points.end(), skipFirst ? it + 1 : it, end);
+            } else {
+                auto it = m_arcPoints.begin() + arcBegin;
+                auto end = m_arcPoints.begin() + arcEnd;
+                points.insert(points.end(), skipFirst ? it + 1 : it, end);
+            }
+        }
+    }
 
-    Layer layer(_objectIt->name.GetString());
+    bool number(double _value) {
+        if (m_skipDepth > 0 || m_states.empty()) { return true; }
 
-    JsonValue& object = _objectIt->value;
-    auto type = object.FindMember("type");
-    if (type != object.MemberEnd() && strcmp("GeometryCollection", type->value.GetString()) == 0) {
-        auto geometries = object.FindMember("geometries");
-        if (geometries != object.MemberEnd() && geometries->value.IsArray()) {
-            for (auto it = geometries->value.Begin(); it != geometries->value.End(); ++it) {
-                layer.features.push_back(getFeature(*it, _topology, _source));
+        switch (state()) {
+        case State::vector:
+        case State::arcs:
+        case State::coordinates:
+            if (state() == State::coordinates) {
+                if (m_valueDepth == 0) { m_valueDepth = m_depth; }
+                if (m_depth != m_valueDepth) { break; }
             }
+            if (m_positionSize < 2) { m_position[m_positionSize] = _value; }
+            m_positionSize++;
+            break;
+        case State::arcIndices:
+            if (m_valueDepth == 0) { m_valueDepth = m_depth; }
+            if (m_depth == m_valueDepth) { m_indices.push_back(int32_t(_value)); }
+            break;
+        case State::properties:
+            m_properties.add(_value);
+            break;
+        default:
+            break;
         }
+        return true;
     }
 
-    return layer;
+    TileData* m_tileData = nullptr;
+    int32_t m_sourceId = 0;
+    TileTransform m_transform;
+    const std::vector<std::string>* m_collections = nullptr;
+
+    std::vector<State> m_states;
+    Member m_member = Member::other;
+    // Nesting depth of the value that is skipped, zero when not skipping
+    int m_skipDepth = 0;
+
+    // Name of the current member of 'objects'
+    std::string m_name;
+    bool m_isCollection = false;
+
+    bool m_quantized = false;
+    glm::dvec2 m_scale;
+    glm::dvec2 m_translate;
+
+    // Arcs as read, the end of each arc in m_arcPositions and the decoded arcs
+    std::vector<glm::dvec2> m_arcPositions;
+    std::vector<uint32_t> m_arcEnds;
+    std::vector<Point> m_arcPoints;
+
+    // Arc indices of all geometries, the end of each line in m_indices and
+    // the end of each polygon in m_indexLineEnds
+    std::vector<int32_t> m_indices;
+    std::vector<uint32_t> m_indexLineEnds;
+    std::vector<uint32_t> m_indexPolygonEnds;
+    // Positions of point geometries
+    std::vector<glm::dvec2> m_positions;
+
+    std::vector<PendingGeometry> m_pending;
+
+    GeometryKind m_kind = GeometryKind::unknown;
+    GeometryBuffer m_geometry;
+    PropertyBuffer m_properties;
+
+    // Nesting depth in the current array and of the values it holds
+    int m_depth = 0;
+    int m_valueDepth = 0;
+    glm::dvec2 m_position;
+    int m_positionSize = 0;
+};
 
 }
 
-std::shared_ptr<TileData> TopoJson::parseTile(const TileTask& _task, int32_t _source) {
+std::shared_ptr<TileData> TopoJson::parseTile(const TileTask& _task, int32_t _sourceId,
+                                              const std::vector<std::string>& _collections) {
 
     auto& task = static_cast<const BinaryTileTask&>(_task);
 
     std::shared_ptr<TileData> tileData = std::make_shared<TileData>();
 
-    // Parse data into a JSON document
-    const char* error;
-    size_t offset;
-    auto document = JsonParseBytes(task.rawTileData->data(), task.rawTileData->size(), &error, &offset);
-
-    if (error) {
-        LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(), error, offset);
-        return tileData;
-    }
-
-    // Transform JSON data into a TileData using TopoJson functions
-    BoundingBox tileBounds(MapProjection::tileBounds(task.tileId()));
-    glm::dvec2 tileOrigin = tileBounds.min;
-    double tileInverseScale = 1.0 / tileBounds.width();
+    // Parser state of this worker, reused for all its tiles
+    thread_local rapidjson::Reader reader;
+    thread_local Handler handler;
 
-    const auto projFn = [&](LngLat _lngLat){
-        ProjectedMeters tmp = MapProjection::lngLatToProjectedMeters(_lngLat);
-        return Point {
-            (tmp.x - tileOrigin.x) * tileInverseScale,
-            (tmp.y - tileOrigin.y) * tileInverseScale,
-        };
-    };
+    handler.reset(*tileData, _sourceId, task.tileId(), _collections);
 
-    // Parse topology and transform
-    auto topology = TopoJson::getTopology(document, projFn);
+    rapidjson::MemoryStream stream(task.rawTileData->data(), task.rawTileData->size());
+    reader.Parse(stream, handler);
 
-    // Parse each TopoJson object as a data layer
-    auto objectsIt = document.FindMember("objects");
-    if (objectsIt == document.MemberEnd()) { return tileData; }
-    auto& objects = objectsIt->value;
-    for (auto layer = objects.MemberBegin(); layer != objects.MemberEnd(); ++layer) {
-        tileData->layers.push_back(TopoJson::getLayer(layer, topology, _source));
+    if (reader.HasParseError()) {
+        LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(),
+             rapidjson::GetParseError_En(reader.GetParseErrorCode()), reader.GetErrorOffset());
+        tileData->layers.clear();
+        return tileData;
     }
 
-    // Discard JSON object and return TileData
-    return tileData;
+    handler.resolve();
 
+    return tileData;
 }
 
 } // namespace Tangram
@@ -3,6 +3,8 @@
 #include "log.h"
 #include "platform.h"
 
+#include <limits>
+
 namespace Tangram {
 
 NetworkDataSource::NetworkDataSource(std::shared_ptr<Platform> _platform, const std::string& _urlTemplate,
@@ -84,6 +86,10 @@ bool NetworkDataSource::loadTileData(std::shared_ptr<TileTask> task, TileTaskCb
     dlTask.urlRequestHandle = m_platform->startUrlRequest(url, onRequestFinish);
     dlTask.urlRequestStarted = true;
 
+    // Fetch tiles closer to the view center first, prefetched tiles last
+    float priority = task->isPrefetch() ? std::numeric_limits<float>::max() : task->getPriority();
+    m_platform->setUrlRequestPriority(dlTask.urlRequestHandle, priority);
+
     return true;
 }
 
@@ -22,11 +22,20 @@ Properties::~Properties() {}
 Properties& Properties::operator=(Properties&& _other) {
     props = std::move(_other.props);
     sourceId = _other.sourceId;
+    m_hasKeyIds = _other.m_hasKeyIds;
     return *this;
 }
 
 void Properties::setSorted(std::vector<Item>&& _items) {
     props = std::move(_items);
+    m_hasKeyIds = std::all_of(props.begin(), props.end(),
+                              [](const auto& item) { return item.keyId >= 0; });
+}
+
+std::vector<Properties::Item> Properties::takeItems() {
+    std::vector<Item> items = std::move(props);
+    clear();
+    return items;
 }
 
 const Value& Properties::get(const std::string& key) const {
@@ -50,7 +59,20 @@ const Value& Properties::get(const std::string& key) const {
     return it->value;
 }
 
-void Properties::clear() { props.clear(); }
+const Value& Properties::get(int32_t keyId, const std::string& key) const {
+
+    if (!m_hasKeyIds) { return get(key); }
+
+    for (const auto& item : props) {
+        if (item.keyId == keyId) { return item.value; }
+    }
+    return NOT_A_VALUE;
+}
+
+void Properties::clear() {
+    props.clear();
+    m_hasKeyIds = true;
+}
 
 bool Properties::contains(const std::string& key) const {
     return !get(key).is<none_type>();
@@ -134,6 +156,7 @@ void Properties::set(std::string key, std::string value) {
 
     if (it == props.end() || it->key != key) {
         props.emplace(it, std::move(key), std::move(value));
+        m_hasKeyIds = false;
     } else {
         it->value = std::move(value);
     }
@@ -148,6 +171,7 @@ void Properties::set(std::string key, double value) {
 
     if (it == props.end() || it->key != key) {
         props.emplace(it, std::move(key), value);
+        m_hasKeyIds = false;
     } else {
         it->value = value;
     }
@@ -0,0 +1,35 @@
+#include "data/propertyKeys.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace Tangram {
+
+static std::mutex s_mutex;
+static std::unordered_map<std::string, int32_t> s_keys;
+
+static int32_t internLocked(const std::string& _key) {
+    auto it = s_keys.find(_key);
+    if (it != s_keys.end()) { return it->second; }
+
+    int32_t id = static_cast<int32_t>(s_keys.size());
+    s_keys.emplace(_key, id);
+    return id;
+}
+
+int32_t PropertyKeys::intern(const std::string& _key) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return internLocked(_key);
+}
+
+void PropertyKeys::intern(const std::vector<std::string>& _keys, std::vector<int32_t>& _ids) {
+    _ids.clear();
+    _ids.reserve(_keys.size());
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (const auto& key : _keys) {
+        _ids.push_back(internLocked(key));
+    }
+}
+
+}
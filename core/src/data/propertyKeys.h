@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+/* Process-wide table of interned property keys
+ *
+ * Filters and data parsers map property key strings to the same integer id,
+ * so that compiled filters can look up feature properties by integer compare.
+ * Ids are never released; the table is bounded by the set of distinct key
+ * names in the loaded scenes and tile schemas.
+ */
+class PropertyKeys {
+public:
+    /* Returns the id of @_key, adding it to the table when not yet known */
+    static int32_t intern(const std::string& _key);
+
+    /* Resolves the ids of all @_keys into @_ids with a single lock */
+    static void intern(const std::vector<std::string>& _keys, std::vector<int32_t>& _ids);
+};
+
+}
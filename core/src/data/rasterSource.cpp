@@ -1,6 +1,8 @@
 #include "data/rasterSource.h"
 #include "data/propertyItem.h"
 #include "data/tileData.h"
+#include "gl/rasterTexture.h"
+#include "gl/renderState.h"
 #include "tile/tile.h"
 #include "tile/tileTask.h"
 #include "util/mapProjection.h"
@@ -31,6 +33,28 @@ public:
         }
     }
 
+    bool needsUpload() const override {
+        if (m_texture && m_texture->needsUpload()) { return true; }
+
+        return BinaryTileTask::needsUpload();
+    }
+
+    size_t upload(RenderState& _rs, size_t _maxBytes) override {
+        size_t uploaded = 0;
+
+        // Textures are uploaded as a whole
+        if (m_texture && m_texture->needsUpload()) {
+            auto texUnit = _rs.nextAvailableTextureUnit();
+            m_texture->bind(_rs, texUnit);
+            _rs.releaseTextureUnit();
+
+            uploaded = m_texture->bufferSize();
+            if (uploaded >= _maxBytes) { return uploaded; }
+        }
+
+        return uploaded + BinaryTileTask::upload(_rs, _maxBytes - uploaded);
+    }
+
     void process(TileBuilder& _tileBuilder) override {
         auto source = rasterSource();
         if (!source) { return; }
@@ -80,6 +104,8 @@ RasterSource::RasterSource(const std::string& _name, std::unique_ptr<DataSource>
     m_textures = std::make_shared<Cache>();
 
     m_emptyTexture = std::make_shared<Texture>(m_texOptions);
+
+    m_bufferPool = std::make_shared<PixelBufferPool>();
 }
 
 std::shared_ptr<Texture> RasterSource::createTexture(TileID _tile, const std::vector<char>& _rawTileData) {
@@ -90,7 +116,10 @@ std::shared_ptr<Texture> RasterSource::createTexture(TileID _tile, const std::ve
     auto data = reinterpret_cast<const uint8_t*>(_rawTileData.data());
     auto length = _rawTileData.size();
 
-    std::shared_ptr<Texture> texture(new Texture(data, length, m_texOptions),
+    auto rasterTexture = new RasterTexture(m_texOptions, m_bufferPool);
+    rasterTexture->decode(data, length);
+
+    std::shared_ptr<Texture> texture(rasterTexture,
                                      [c = std::weak_ptr<Cache>(m_textures), _tile](auto t) {
                                          if (auto cache = c.lock()) { cache->erase(_tile); }
                                          delete t;
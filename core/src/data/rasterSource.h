@@ -11,6 +11,7 @@
 
 namespace Tangram {
 
+class PixelBufferPool;
 class RasterTileTask;
 
 class RasterSource : public TileSource {
@@ -22,6 +23,9 @@ class RasterSource : public TileSource {
 
     std::shared_ptr<Texture> m_emptyTexture;
 
+    // Decoded pixel data of tiles waiting for upload
+    std::shared_ptr<PixelBufferPool> m_bufferPool;
+
 protected:
 
     std::shared_ptr<TileData> parse(const TileTask& _task) const override;
@@ -3,6 +3,7 @@
 #include "glm/vec2.hpp"
 #include "data/properties.h"
 
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -39,6 +40,9 @@ Data heirarchy:
   one collection each of <Point>s, <Line>s, and <Polygon>s. Only the geometry
   collection corresponding to the feature's geometryType should contain data.
 
+  A <Layer> may instead provide a <FeatureDecoder> which decodes its features
+  one at a time, on demand, from the raw tile data (see Mvt::LayerDecoder).
+
   A <Properties> contains a sorted vector of key-value pairs storing the
   properties of a <Feature>
 
@@ -79,6 +83,47 @@ struct Feature {
     Properties props;
 };
 
+/* Scratch buffers of a thread that decodes features with <FeatureDecoder>s
+ *
+ * Decoders only read the data of their layer, all state that changes from
+ * feature to feature is kept here. Each thread owns its DecodeBuffers, so that
+ * several threads can decode the features of one layer at the same time.
+ */
+struct DecodeBuffers {
+    // Value index per key of the layer for the current feature, or -1
+    std::vector<int> tags;
+    // Points of the current geometry and the number of points per line
+    std::vector<Point> coordinates;
+    std::vector<int> sizes;
+    // Storage of the lines and polygons of previously decoded features
+    std::vector<Line> spareLines;
+    std::vector<Polygon> sparePolygons;
+};
+
+/* Decodes the features of a <Layer> on demand
+ *
+ * Features are decoded into a caller-owned <Feature> that can be reused for
+ * all features of a tile. decodeFeature() sets properties and geometry type,
+ * which is all that is needed for filter evaluation. decodeGeometry() is only
+ * called for features that matched a draw rule.
+ *
+ * Decoding is thread-safe as long as each thread passes its own @_buffers.
+ */
+struct FeatureDecoder {
+
+    virtual ~FeatureDecoder() {}
+
+    virtual size_t featureCount() const = 0;
+
+    /* Decode properties and geometry type of feature @_index into @_feature.
+     * Clears the geometry of @_feature. Returns false on invalid data. */
+    virtual bool decodeFeature(size_t _index, Feature& _feature, DecodeBuffers& _buffers) const = 0;
+
+    /* Decode the geometry of feature @_index into @_feature. */
+    virtual bool decodeGeometry(size_t _index, Feature& _feature, DecodeBuffers& _buffers) const = 0;
+
+};
+
 struct Layer {
 
     Layer(const std::string& _name) : name(_name) {}
@@ -87,6 +132,9 @@ struct Layer {
 
     std::vector<Feature> features;
 
+    /* Lazily decoded features, in addition to 'features' */
+    std::unique_ptr<FeatureDecoder> decoder;
+
 };
 
 struct TileData {
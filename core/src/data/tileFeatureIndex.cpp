@@ -0,0 +1,183 @@
+#include "data/tileFeatureIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tangram {
+
+constexpr int TileFeatureIndex::MAX_ZOOM;
+
+// Latitude limit of the web mercator projection
+static const double MAX_LATITUDE = 85.0511287798;
+
+TileFeatureIndex::TileRange TileFeatureIndex::tileRange(const BoundingBox& _bounds, int _zoom) {
+
+    int32_t n = 1 << _zoom;
+
+    auto tileX = [&](double _lng) {
+        auto x = int32_t(std::floor((_lng + 180.0) / 360.0 * n));
+        return std::min(std::max(x, 0), n - 1);
+    };
+    auto tileY = [&](double _lat) {
+        double lat = std::min(std::max(_lat, -MAX_LATITUDE), MAX_LATITUDE) * PI / 180.0;
+        auto y = int32_t(std::floor((1.0 - std::log(std::tan(lat) + 1.0 / std::cos(lat)) / PI) * 0.5 * n));
+        return std::min(std::max(y, 0), n - 1);
+    };
+
+    // Tile rows count from the north
+    return { tileX(_bounds.min.x), tileY(_bounds.max.y), tileX(_bounds.max.x), tileY(_bounds.min.y), _zoom };
+}
+
+TileID TileFeatureIndex::key(const TileID& _tile) {
+    if (_tile.z <= MAX_ZOOM) { return TileID(_tile.x, _tile.y, _tile.z); }
+
+    int over = _tile.z - MAX_ZOOM;
+    return TileID(_tile.x >> over, _tile.y >> over, MAX_ZOOM);
+}
+
+void TileFeatureIndex::clear(int64_t _generation) {
+    m_features.clear();
+    m_nodes.clear();
+    m_baseGeneration = _generation;
+}
+
+void TileFeatureIndex::add(uint64_t _id, const TileRange& _range) {
+    for (int z = _range.zoom; z >= 0; z--) {
+        int shift = _range.zoom - z;
+        for (int32_t x = _range.minX >> shift; x <= _range.maxX >> shift; x++) {
+            for (int32_t y = _range.minY >> shift; y <= _range.maxY >> shift; y++) {
+                auto& node = m_nodes[TileID(x, y, z)];
+                (z == _range.zoom ? node.own : node.deeper).insert(_id);
+            }
+        }
+    }
+}
+
+void TileFeatureIndex::erase(uint64_t _id, const TileRange& _range) {
+    // Children are visited before their parents, so that a dropped tile can
+    // pass its last change on to its parent
+    for (int z = _range.zoom; z >= 0; z--) {
+        int shift = _range.zoom - z;
+        for (int32_t x = _range.minX >> shift; x <= _range.maxX >> shift; x++) {
+            for (int32_t y = _range.minY >> shift; y <= _range.maxY >> shift; y++) {
+                auto it = m_nodes.find(TileID(x, y, z));
+                if (it == m_nodes.end()) { continue; }
+
+                auto& node = it->second;
+                (z == _range.zoom ? node.own : node.deeper).erase(_id);
+
+                if (!node.own.empty() || !node.deeper.empty()) { continue; }
+
+                int64_t generation = node.subtree;
+                for (int64_t dropped : node.dropped) { generation = std::max(generation, dropped); }
+
+                if (z > 0) {
+                    auto& parent = m_nodes[TileID(x >> 1, y >> 1, z - 1)];
+                    auto& dropped = parent.dropped[quarter(it->first)];
+                    dropped = std::max(dropped, generation);
+                } else {
+                    m_baseGeneration = std::max(m_baseGeneration, generation);
+                }
+                m_nodes.erase(it);
+            }
+        }
+    }
+}
+
+void TileFeatureIndex::mark(const TileRange& _range, int64_t _generation) {
+    for (int z = _range.zoom; z >= 0; z--) {
+        int shift = _range.zoom - z;
+        for (int32_t x = _range.minX >> shift; x <= _range.maxX >> shift; x++) {
+            for (int32_t y = _range.minY >> shift; y <= _range.maxY >> shift; y++) {
+                auto& node = m_nodes[TileID(x, y, z)];
+                node.subtree = _generation;
+                if (z == _range.zoom) { node.covered = _generation; }
+            }
+        }
+    }
+}
+
+void TileFeatureIndex::insert(uint64_t _id, const BoundingBox& _bounds, int64_t _generation) {
+
+    TileRange range;
+    for (int z = MAX_ZOOM; z >= 0; z--) {
+        range = tileRange(_bounds, z);
+        if ((range.maxX - range.minX + 1) * (range.maxY - range.minY + 1) <= 4) { break; }
+    }
+
+    auto it = m_features.find(_id);
+    if (it != m_features.end()) {
+        mark(it->second, _generation);
+        erase(_id, it->second);
+        it->second = range;
+    } else {
+        m_features.emplace(_id, range);
+    }
+
+    add(_id, range);
+    mark(range, _generation);
+}
+
+bool TileFeatureIndex::remove(uint64_t _id, int64_t _generation) {
+
+    auto it = m_features.find(_id);
+    if (it == m_features.end()) { return false; }
+
+    mark(it->second, _generation);
+    erase(_id, it->second);
+    m_features.erase(it);
+
+    return true;
+}
+
+void TileFeatureIndex::touch(uint64_t _id, int64_t _generation) {
+
+    auto it = m_features.find(_id);
+    if (it != m_features.end()) { mark(it->second, _generation); }
+}
+
+void TileFeatureIndex::query(const TileID& _tile, std::vector<uint64_t>& _ids) const {
+
+    TileID tile = key(_tile);
+
+    auto it = m_nodes.find(tile);
+    if (it != m_nodes.end()) {
+        _ids.insert(_ids.end(), it->second.own.begin(), it->second.own.end());
+        _ids.insert(_ids.end(), it->second.deeper.begin(), it->second.deeper.end());
+    }
+
+    // Features of a lower level that cover this tile
+    while (tile.z > 0) {
+        tile = TileID(tile.x >> 1, tile.y >> 1, tile.z - 1);
+        it = m_nodes.find(tile);
+        if (it != m_nodes.end()) {
+            _ids.insert(_ids.end(), it->second.own.begin(), it->second.own.end());
+        }
+    }
+}
+
+int64_t TileFeatureIndex::generation(const TileID& _tile) const {
+
+    int64_t generation = m_baseGeneration;
+
+    TileID tile = key(_tile);
+
+    auto it = m_nodes.find(tile);
+    if (it != m_nodes.end()) {
+        generation = std::max(generation, it->second.subtree);
+    }
+
+    while (tile.z > 0) {
+        int q = quarter(tile);
+        tile = TileID(tile.x >> 1, tile.y >> 1, tile.z - 1);
+        it = m_nodes.find(tile);
+        if (it != m_nodes.end()) {
+            // Changes of dropped tiles on the way to this one
+            generation = std::max({ generation, it->second.covered, it->second.dropped[q] });
+        }
+    }
+
+    return generation;
+}
+
+}
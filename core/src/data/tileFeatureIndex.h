@@ -0,0 +1,101 @@
+#pragma once
+
+#include "tile/tileHash.h"
+#include "tile/tileID.h"
+#include "util/geom.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * TileFeatureIndex - Incremental spatial index of features over the tile pyramid
+ *
+ * Each feature gets a level: the highest zoom up to MAX_ZOOM at which its
+ * bounds span at most 2x2 tiles. It is registered in the tiles covering its
+ * bounds at that level and at all lower zooms. Inserting, moving or removing a
+ * feature thus touches only a few tiles per zoom and never the other features.
+ *
+ * Every change is marked with a generation on the tiles at the feature level
+ * and on their parents. generation() returns the last generation in which the
+ * data of a tile may have changed, so that only the affected tiles need to be
+ * rebuilt. Tiles above MAX_ZOOM share the state of their parent at MAX_ZOOM.
+ *
+ * Tiles without features are dropped, their last change is kept by the parent
+ * for the quarter of it that they covered. A tile below a dropped one may thus
+ * report a change that it was not affected by, which only costs a rebuild.
+ */
+class TileFeatureIndex {
+
+public:
+
+    static constexpr int MAX_ZOOM = 14;
+
+    /* Set all tiles to @_generation and remove all features */
+    void clear(int64_t _generation);
+
+    /* Add feature @_id with @_bounds in longitude and latitude, or move it
+     * when it already exists */
+    void insert(uint64_t _id, const BoundingBox& _bounds, int64_t _generation);
+
+    /* Remove feature @_id, returns false when it does not exist */
+    bool remove(uint64_t _id, int64_t _generation);
+
+    /* Mark feature @_id changed without moving it */
+    void touch(uint64_t _id, int64_t _generation);
+
+    /* Append the ids of all features that may intersect @_tile to @_ids */
+    void query(const TileID& _tile, std::vector<uint64_t>& _ids) const;
+
+    /* Last generation in which features intersecting @_tile changed */
+    int64_t generation(const TileID& _tile) const;
+
+    size_t size() const { return m_features.size(); }
+
+    /* Number of tiles that hold features */
+    size_t tileCount() const { return m_nodes.size(); }
+
+private:
+
+    struct Node {
+        // Features of this level
+        std::unordered_set<uint64_t> own;
+        // Features of a higher level
+        std::unordered_set<uint64_t> deeper;
+        // Last change of any feature below or at this tile
+        int64_t subtree = 0;
+        // Last change of a feature covering this whole tile
+        int64_t covered = 0;
+        // Last change in the dropped children of each quarter of this tile
+        int64_t dropped[4] = { 0, 0, 0, 0 };
+    };
+
+    // Tiles covering the bounds of a feature at its level
+    struct TileRange {
+        int32_t minX, minY, maxX, maxY;
+        int zoom;
+    };
+
+    static TileRange tileRange(const BoundingBox& _bounds, int _zoom);
+
+    static TileID key(const TileID& _tile);
+
+    // Quarter of its parent that @_tile covers
+    static int quarter(const TileID& _tile) { return (_tile.x & 1) | ((_tile.y & 1) << 1); }
+
+    void add(uint64_t _id, const TileRange& _range);
+    void erase(uint64_t _id, const TileRange& _range);
+    void mark(const TileRange& _range, int64_t _generation);
+
+    std::unordered_map<uint64_t, TileRange> m_features;
+    std::unordered_map<TileID, Node> m_nodes;
+
+    // Generation of the last clear() or of the last change when the root tile
+    // was dropped
+    int64_t m_baseGeneration = 0;
+};
+
+}
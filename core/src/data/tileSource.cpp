@@ -11,6 +11,7 @@
 #include "log.h"
 #include "util/geom.h"
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
 
@@ -104,9 +105,9 @@ void TileSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
 
 std::shared_ptr<TileData> TileSource::parse(const TileTask& _task) const {
     switch (m_format) {
-    case Format::TopoJson: return TopoJson::parseTile(_task, m_id);
-    case Format::GeoJson: return GeoJson::parseTile(_task, m_id);
-    case Format::Mvt: return Mvt::parseTile(_task, m_id);
+    case Format::TopoJson: return TopoJson::parseTile(_task, m_id, m_collections);
+    case Format::GeoJson: return GeoJson::parseTile(_task, m_id, m_collections);
+    case Format::Mvt: return Mvt::parseTile(_task, m_id, m_collections);
     }
     assert(false);
     return nullptr;
@@ -121,6 +122,14 @@ void TileSource::cancelLoadingTile(TileTask& _task) {
     }
 }
 
+void TileSource::addCollections(const std::vector<std::string>& _collections) {
+    for (const auto& collection : _collections) {
+        if (std::find(m_collections.begin(), m_collections.end(), collection) == m_collections.end()) {
+            m_collections.push_back(collection);
+        }
+    }
+}
+
 void TileSource::addRasterSource(std::shared_ptr<TileSource> _rasterSource) {
     /*
      * We limit the parent source by any attached raster source's min/max.
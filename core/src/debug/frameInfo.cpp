@@ -4,12 +4,15 @@
 #include "gl.h"
 #include "gl/glError.h"
 #include "gl/primitives.h"
+#include "gl/renderState.h"
 #include "map.h"
 #include "tile/tileManager.h"
 #include "tile/tile.h"
 #include "tile/tileCache.h"
+#include "tile/uploadScheduler.h"
 #include "view/view.h"
 
+#include <algorithm>
 #include <deque>
 #include <ctime>
 
@@ -52,7 +55,8 @@ void FrameInfo::beginFrame() {
 }
 
 
-void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManager) {
+void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManager,
+                     const UploadScheduler& _uploads) {
 
     if (getDebugFlag(DebugFlags::tangram_infos) || getDebugFlag(DebugFlags::tangram_stats)) {
         static int cpt = 0;
@@ -64,7 +68,14 @@ void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManag
         static float timeCpu[60] = { 0 };
         static float timeUpdate[60] = { 0 };
         static float timeRender[60] = { 0 };
+        static float timeUpload[60] = { 0 };
+        static size_t bytesUpload[60] = { 0 };
         timeCpu[cpt] = TIME_TO_MS(s_startFrameTime, endCpu);
+        timeUpload[cpt] = _uploads.stats().time;
+
+        // Counted before the debug infos are drawn
+        auto frameStats = rs.frameStats();
+        bytesUpload[cpt] = _uploads.stats().bytes;
 
         if (updatetime.size() >= DEBUG_STATS_MAX_SIZE) {
             updatetime.pop_front();
@@ -88,6 +99,8 @@ void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManag
         float avgTimeRender = 0.f;
         float avgTimeCpu = 0.f;
         float avgTimeUpdate = 0.f;
+        float maxTimeUpload = 0.f;
+        size_t maxBytesUpload = 0;
 
         timeUpdate[cpt] = s_lastUpdateTime;
 
@@ -95,6 +108,8 @@ void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManag
             avgTimeRender += timeRender[i];
             avgTimeCpu += timeCpu[i];
             avgTimeUpdate += timeUpdate[i];
+            maxTimeUpload = std::max(maxTimeUpload, timeUpload[i]);
+            maxBytesUpload = std::max(maxBytesUpload, bytesUpload[i]);
         }
         avgTimeRender /= 60;
         avgTimeCpu /= 60;
@@ -114,12 +129,32 @@ void FrameInfo::draw(RenderState& rs, const View& _view, TileManager& _tileManag
                                  + std::to_string(_tileManager.getVisibleTiles().size()));
             debuginfos.push_back("selectable features:"
                                  + std::to_string(features));
+            const auto& cacheStats = _tileManager.getTileCache()->stats();
             debuginfos.push_back("tile cache size:"
-                                 + std::to_string(_tileManager.getTileCache()->getMemoryUsage() / 1024) + "kb");
+                                 + std::to_string(_tileManager.getTileCache()->getMemoryUsage() / 1024) + "kb/"
+                                 + std::to_string(cacheStats.maxBytes / 1024) + "kb");
+            debuginfos.push_back("tile cache gpu/cpu:"
+                                 + std::to_string(cacheStats.gpuBytes / 1024) + "kb/"
+                                 + std::to_string(cacheStats.cpuBytes / 1024) + "kb");
+            debuginfos.push_back("tile cache hit/miss/evict:"
+                                 + std::to_string(cacheStats.hits) + "/"
+                                 + std::to_string(cacheStats.misses) + "/"
+                                 + std::to_string(cacheStats.evictions));
             debuginfos.push_back("tile size:" + std::to_string(memused / 1024) + "kb");
             debuginfos.push_back("avg frame cpu time:" + to_string_with_precision(avgTimeCpu, 2) + "ms");
             debuginfos.push_back("avg frame render time:" + to_string_with_precision(avgTimeRender, 2) + "ms");
             debuginfos.push_back("avg frame update time:" + to_string_with_precision(avgTimeUpdate, 2) + "ms");
+            const auto& uploadStats = _uploads.stats();
+            debuginfos.push_back("frame upload:"
+                                 + std::to_string(uploadStats.bytes / 1024) + "kb/"
+                                 + to_string_with_precision(uploadStats.time, 2) + "ms, pending tiles:"
+                                 + std::to_string(uploadStats.pendingTiles));
+            debuginfos.push_back("max frame upload:"
+                                 + std::to_string(maxBytesUpload / 1024) + "kb/"
+                                 + to_string_with_precision(maxTimeUpload, 2) + "ms");
+            debuginfos.push_back("frame draw calls/state changes:"
+                                 + std::to_string(frameStats.drawCalls) + "/"
+                                 + std::to_string(frameStats.stateChanges));
             debuginfos.push_back("zoom:" + std::to_string(_view.getZoom()));
             debuginfos.push_back("pos:" + std::to_string(_view.getPosition().x) + "/"
                                  + std::to_string(_view.getPosition().y));
@@ -4,6 +4,7 @@ namespace Tangram {
 
 class RenderState;
 class TileManager;
+class UploadScheduler;
 class View;
 
 struct FrameInfo {
@@ -13,7 +14,8 @@ struct FrameInfo {
 
     static void endUpdate();
 
-    static void draw(RenderState& rs, const View& _view, TileManager& _tileManager);
+    static void draw(RenderState& rs, const View& _view, TileManager& _tileManager,
+                     const UploadScheduler& _uploads);
 };
 
 }
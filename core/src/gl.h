@@ -268,6 +268,11 @@ typedef char            GLchar;
 #define GL_LINK_STATUS                  0x8B82
 #define GL_INFO_LOG_LENGTH              0x8B84
 
+// get_program_binary
+#define GL_PROGRAM_BINARY_LENGTH        0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS   0x87FE
+#define GL_PROGRAM_BINARY_FORMATS       0x87FF
+
 // mapbuffer
 #define GL_READ_ONLY                    0x88B8
 #define GL_WRITE_ONLY                   0x88B9
@@ -318,6 +323,9 @@ struct GL {
     static GLint getAttribLocation(GLuint program, const GLchar *name);
     static void getProgramiv(GLuint program, GLenum pname, GLint *params);
     static void getShaderiv(GLuint shader, GLenum pname, GLint *params);
+    static void getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                                 GLenum *binaryFormat, void *binary);
+    static void programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
 
     // Buffers
     static void bindBuffer(GLenum target, GLuint buffer);
@@ -31,6 +31,8 @@ public:
         return MeshBase::bufferSize();
     }
 
+    bool isUploaded() const override { return m_isUploaded; }
+
     void clear() {
         // Clear vertices for next frame
         m_nVertices = 0;
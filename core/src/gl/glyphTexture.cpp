@@ -3,6 +3,9 @@
 #include "gl/renderState.h"
 #include "log.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace Tangram {
 
 GlyphTexture::GlyphTexture() : Texture(textureOptions()) {
@@ -14,7 +17,7 @@ GlyphTexture::GlyphTexture() : Texture(textureOptions()) {
 
 bool GlyphTexture::bind(RenderState& _rs, GLuint _textureUnit) {
 
-    if (!m_shouldResize && m_dirtyRows.empty()) {
+    if (!m_shouldResize && m_dirtyRects.empty()) {
         if (m_glHandle == 0) { return false; }
 
         _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
@@ -23,7 +26,7 @@ bool GlyphTexture::bind(RenderState& _rs, GLuint _textureUnit) {
 
     if (m_shouldResize) {
         m_shouldResize = false;
-        m_dirtyRows.clear();
+        m_dirtyRects.clear();
         return upload(_rs, _textureUnit);
     }
 
@@ -35,55 +38,63 @@ bool GlyphTexture::bind(RenderState& _rs, GLuint _textureUnit) {
     _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
 
     auto format = static_cast<GLenum>(m_options.pixelFormat);
-    for (auto& range : m_dirtyRows) {
-        auto rows = range.max - range.min;
-        auto offset = m_buffer.get() + (range.min * m_width * bpp());
-        GL::texSubImage2D(GL_TEXTURE_2D, 0, 0, range.min, m_width, rows, format,
-                          GL_UNSIGNED_BYTE, offset);
+    for (auto& rect : m_dirtyRects) {
+        int width = rect.x1 - rect.x0;
+        int rows = rect.y1 - rect.y0;
+        auto offset = m_buffer.get() + (rect.y0 * m_width + rect.x0) * bpp();
+
+        if (width == m_width) {
+            GL::texSubImage2D(GL_TEXTURE_2D, 0, 0, rect.y0, m_width, rows, format,
+                              GL_UNSIGNED_BYTE, offset);
+            continue;
+        }
+
+        // Copy the rows of the rectangle into a contiguous buffer
+        size_t rowBytes = width * bpp();
+        m_uploadBuffer.resize(rowBytes * rows);
+        for (int y = 0; y < rows; y++) {
+            std::memcpy(&m_uploadBuffer[y * rowBytes], offset + y * m_width * bpp(), rowBytes);
+        }
+        GL::texSubImage2D(GL_TEXTURE_2D, 0, rect.x0, rect.y0, width, rows, format,
+                          GL_UNSIGNED_BYTE, m_uploadBuffer.data());
     }
-    m_dirtyRows.clear();
+    m_dirtyRects.clear();
     return true;
 }
 
-void GlyphTexture::setRowsDirty(int start, int count) {
-    // FIXME: check that dirty range is valid for texture size!
-    int max = start + count;
-    int min = start;
-
-    if (m_dirtyRows.empty()) {
-        m_dirtyRows.push_back({min, max});
-        return;
-    }
-
-    auto n = m_dirtyRows.begin();
-
-    // Find first overlap
-    while (n != m_dirtyRows.end()) {
-        if (min > n->max) {
-            // this range is after current
-            ++n;
+void GlyphTexture::setDirty(int _x, int _y, int _width, int _height) {
+
+    // Align columns to the default unpack alignment of 4 bytes
+    DirtyRect rect{ _x & ~3, _y, std::min((_x + _width + 3) & ~3, m_width),
+                    std::min(_y + _height, m_height) };
+
+    // Merge with all overlapping or touching rectangles
+    for (auto it = m_dirtyRects.begin(); it != m_dirtyRects.end();) {
+        if (rect.x0 <= it->x1 && it->x0 <= rect.x1 &&
+            rect.y0 <= it->y1 && it->y0 <= rect.y1) {
+            rect.x0 = std::min(rect.x0, it->x0);
+            rect.y0 = std::min(rect.y0, it->y0);
+            rect.x1 = std::max(rect.x1, it->x1);
+            rect.y1 = std::max(rect.y1, it->y1);
+            m_dirtyRects.erase(it);
+            // The grown rectangle may overlap ones that were checked before
+            it = m_dirtyRects.begin();
             continue;
         }
-        if (max < n->min) {
-            // this range is before current
-            m_dirtyRows.insert(n, {min, max});
-            return;
-        }
-        // Combine with overlapping range
-        n->min = std::min(n->min, min);
-        n->max = std::max(n->max, max);
-        break;
-    }
-    if (n == m_dirtyRows.end()) {
-        m_dirtyRows.push_back({min, max});
-        return;
+        ++it;
     }
 
-    // Merge up to last overlap
-    auto it = n+1;
-    while (it != m_dirtyRows.end() && max >= it->min) {
-        n->max = std::max(it->max, max);
-        it = m_dirtyRows.erase(it);
+    if (m_dirtyRects.size() == maxDirtyRects) {
+        for (auto& r : m_dirtyRects) {
+            rect.x0 = std::min(rect.x0, r.x0);
+            rect.y0 = std::min(rect.y0, r.y0);
+            rect.x1 = std::max(rect.x1, r.x1);
+            rect.y1 = std::max(rect.y1, r.y1);
+        }
+        m_dirtyRects.clear();
     }
+
+    m_dirtyRects.push_back(rect);
 }
+
 }
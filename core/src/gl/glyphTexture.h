@@ -11,23 +11,29 @@ class GlyphTexture : public Texture {
         return options;
     }
 public:
-    static constexpr int size = 256;
+    static constexpr int size = 512;
 
     GlyphTexture();
 
     bool bind(RenderState& rs, GLuint _unit) override;
 
-    void setRowsDirty(int start, int count);
+    // Mark a rectangle of the buffer to be uploaded on the next bind()
+    void setDirty(int x, int y, int width, int height);
 
     GLubyte* buffer() { return m_buffer.get(); }
 
 protected:
-    struct DirtyRowRange {
-        int min;
-        int max;
+    struct DirtyRect {
+        int x0, y0, x1, y1;
     };
 
-    std::vector<DirtyRowRange> m_dirtyRows;
+    // Beyond this number of rectangles all are merged into their bounds
+    static constexpr size_t maxDirtyRects = 32;
+
+    std::vector<DirtyRect> m_dirtyRects;
+
+    // Rows of dirty rectangles that are narrower than the texture
+    std::vector<GLubyte> m_uploadBuffer;
 };
 
 }
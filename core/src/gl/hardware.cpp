@@ -16,6 +16,8 @@ bool supportsMapBuffer = false;
 bool supportsVAOs = false;
 bool supportsTextureNPOT = false;
 bool supportsGLRGBA8OES = false;
+bool supportsProgramBinary = false;
+bool supportsElementIndexUint = false;
 
 uint32_t maxTextureSize = 0;
 uint32_t maxCombinedTextureUnits = 0;
@@ -56,14 +58,29 @@ void loadExtensions() {
     supportsVAOs = isAvailable("vertex_array_object");
     supportsTextureNPOT = isAvailable("texture_non_power_of_two");
     supportsGLRGBA8OES = isAvailable("rgb8_rgba8");
+    supportsProgramBinary = isAvailable("get_program_binary");
+
+    // GL_UNSIGNED_INT indices are core in desktop GL and GLES 3
+    auto version = (const char*) GL::getString(GL_VERSION);
+    bool gles2 = version && strstr(version, "OpenGL ES") && !strstr(version, "OpenGL ES 3");
+    supportsElementIndexUint = !gles2 || isAvailable("element_index_uint");
+
+    // find extension symbols if needed
+    initGLExtensions();
+
+    // Some drivers have the extension without any binary format
+    if (supportsProgramBinary) {
+        GLint formats = 0;
+        GL::getIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        supportsProgramBinary = formats > 0;
+    }
 
     LOG("Driver supports map buffer: %d", supportsMapBuffer);
     LOG("Driver supports vaos: %d", supportsVAOs);
     LOG("Driver supports rgb8_rgba8: %d", supportsGLRGBA8OES);
     LOG("Driver supports NPOT texture: %d", supportsTextureNPOT);
-
-    // find extension symbols if needed
-    initGLExtensions();
+    LOG("Driver supports program binary: %d", supportsProgramBinary);
+    LOG("Driver supports 32 bit indices: %d", supportsElementIndexUint);
 }
 
 void loadCapabilities() {
@@ -6,6 +6,8 @@
 #include "platform.h"
 #include "log.h"
 
+#include <limits>
+
 namespace Tangram {
 
 
@@ -34,6 +36,10 @@ MeshBase::MeshBase(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode
 }
 
 MeshBase::~MeshBase() {
+    if (m_arenaPool) {
+        for (auto& range : m_arenaRanges) { m_arenaPool->remove(range); }
+    }
+
     if (m_rs) {
         if (m_glVertexBuffer || m_glIndexBuffer) {
             GLuint buffers[] = { m_glVertexBuffer, m_glIndexBuffer };
@@ -55,6 +61,10 @@ void MeshBase::setVertexLayout(std::shared_ptr<VertexLayout> _vertexLayout) {
     m_vertexLayout = _vertexLayout;
 }
 
+void MeshBase::setArenaPool(std::shared_ptr<MeshArenaPool> _pool) {
+    m_arenaPool = std::move(_pool);
+}
+
 void MeshBase::setDrawMode(GLenum _drawMode) {
     switch (_drawMode) {
         case GL_POINTS:
@@ -109,6 +119,11 @@ void MeshBase::subDataUpload(RenderState& rs, GLbyte* _data) {
 
 void MeshBase::upload(RenderState& rs) {
 
+    if (m_arenaPool) {
+        uploadToArenas(rs, std::numeric_limits<size_t>::max());
+        return;
+    }
+
     // Generate vertex buffer, if needed
     if (m_glVertexBuffer == 0) {
         GL::genBuffers(1, &m_glVertexBuffer);
@@ -132,7 +147,7 @@ void MeshBase::upload(RenderState& rs) {
         // Buffer element index data
         rs.indexBuffer(m_glIndexBuffer);
 
-        GL::bufferData(GL_ELEMENT_ARRAY_BUFFER, m_nIndices * sizeof(GLushort), m_glIndexData, m_hint);
+        GL::bufferData(GL_ELEMENT_ARRAY_BUFFER, m_nIndices * indexSize(), m_glIndexData, m_hint);
 
         delete[] m_glIndexData;
         m_glIndexData = nullptr;
@@ -140,15 +155,165 @@ void MeshBase::upload(RenderState& rs) {
 
     m_rs = &rs;
 
+    m_uploadedBytes = 0;
     m_isUploaded = true;
 }
 
+size_t MeshBase::upload(RenderState& rs, size_t _maxBytes) {
+
+    if (!needsUpload()) { return 0; }
+
+    size_t vertexBytes = m_nVertices * m_vertexLayout->getStride();
+    size_t indexBytes = m_glIndexData ? m_nIndices * indexSize() : 0;
+
+    if (m_arenaPool) { return uploadToArenas(rs, _maxBytes); }
+
+    // Small meshes go in one piece
+    if (m_uploadedBytes == 0 && vertexBytes + indexBytes <= _maxBytes) {
+        upload(rs);
+        return vertexBytes + indexBytes;
+    }
+
+    // Delete the buffers when the mesh is dropped before it is complete
+    m_rs = &rs;
+
+    size_t uploaded = 0;
+
+    if (m_uploadedBytes < vertexBytes) {
+        if (m_glVertexBuffer == 0) {
+            GL::genBuffers(1, &m_glVertexBuffer);
+        }
+        rs.vertexBuffer(m_glVertexBuffer);
+
+        if (m_uploadedBytes == 0) {
+            GL::bufferData(GL_ARRAY_BUFFER, vertexBytes, NULL, m_hint);
+        }
+
+        size_t bytes = std::min(_maxBytes, vertexBytes - m_uploadedBytes);
+        GL::bufferSubData(GL_ARRAY_BUFFER, m_uploadedBytes, bytes,
+                          m_glVertexData + m_uploadedBytes);
+
+        m_uploadedBytes += bytes;
+        uploaded += bytes;
+    }
+
+    if (m_uploadedBytes >= vertexBytes && uploaded < _maxBytes && indexBytes > 0) {
+        size_t offset = m_uploadedBytes - vertexBytes;
+
+        if (m_glIndexBuffer == 0) {
+            GL::genBuffers(1, &m_glIndexBuffer);
+        }
+        rs.indexBuffer(m_glIndexBuffer);
+
+        if (offset == 0) {
+            GL::bufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, NULL, m_hint);
+        }
+
+        size_t bytes = std::min(_maxBytes - uploaded, indexBytes - offset);
+        GL::bufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, bytes, m_glIndexData + offset);
+
+        m_uploadedBytes += bytes;
+        uploaded += bytes;
+    }
+
+    if (m_uploadedBytes == vertexBytes + indexBytes) {
+        delete[] m_glVertexData;
+        m_glVertexData = nullptr;
+
+        delete[] m_glIndexData;
+        m_glIndexData = nullptr;
+
+        m_uploadedBytes = 0;
+        m_isUploaded = true;
+    }
+
+    return uploaded;
+}
+
+size_t MeshBase::uploadToArenas(RenderState& rs, size_t _maxBytes) {
+
+    int stride = m_vertexLayout->getStride();
+
+    // Meshes without indices are not split into batches
+    auto batches = m_vertexOffsets;
+    if (batches.empty()) { batches.emplace_back(0, m_nVertices); }
+
+    size_t vertexOffset = 0;
+    size_t indexOffset = 0;
+    for (size_t i = 0; i < m_uploadedBatches; i++) {
+        vertexOffset += batches[i].second;
+        indexOffset += batches[i].first;
+    }
+
+    m_rs = &rs;
+
+    size_t uploaded = 0;
+
+    // Each batch of the mesh has its own indices starting at zero
+    for (; m_uploadedBatches < batches.size(); m_uploadedBatches++) {
+        uint32_t nIndices = batches[m_uploadedBatches].first;
+        uint32_t nVertices = batches[m_uploadedBatches].second;
+
+        // Batches are placed in one piece
+        size_t bytes = nVertices * stride + nIndices * sizeof(GLushort);
+        if (uploaded + bytes > _maxBytes && (uploaded > 0 || _maxBytes == 0)) { break; }
+
+        const GLushort* indices = nullptr;
+
+        std::vector<GLushort> sequence;
+        if (nIndices > 0) {
+            // Meshes placed in arenas always have GLushort indices
+            indices = reinterpret_cast<const GLushort*>(m_glIndexData) + indexOffset;
+        } else {
+            sequence.resize(nVertices);
+            for (size_t i = 0; i < nVertices; i++) { sequence[i] = i; }
+            indices = sequence.data();
+            nIndices = nVertices;
+        }
+
+        auto range = m_arenaPool->add(rs, m_glVertexData + vertexOffset * stride, nVertices,
+                                      indices, nIndices);
+        if (!range.arena) {
+            LOGD("Mesh batch of %d vertices does not fit into an arena, drawing it on its own", nVertices);
+
+            for (auto& placed : m_arenaRanges) { m_arenaPool->remove(placed); }
+            m_arenaRanges.clear();
+            m_arenaPool.reset();
+            m_uploadedBatches = 0;
+
+            upload(rs);
+            return uploaded + m_nVertices * stride + m_nIndices * indexSize();
+        }
+        m_arenaRanges.push_back(range);
+        uploaded += bytes;
+
+        vertexOffset += batches[m_uploadedBatches].second;
+        indexOffset += batches[m_uploadedBatches].first;
+    }
+
+    if (m_uploadedBatches < batches.size()) { return uploaded; }
+
+    delete[] m_glVertexData;
+    m_glVertexData = nullptr;
+
+    delete[] m_glIndexData;
+    m_glIndexData = nullptr;
+
+    m_uploadedBatches = 0;
+    m_isUploaded = true;
+
+    return uploaded;
+}
+
 bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
     bool useVao = _useVao && Hardware::supportsVAOs;
 
     if (!m_isCompiled) { return false; }
     if (m_nVertices == 0) { return false; }
 
+    // Drawn in batches by the style
+    if (m_arenaPool) { return false; }
+
     // Enable shader program
     if (!_shader.use(rs)) {
         return false;
@@ -191,14 +356,16 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
             // Bind the corresponding vao relative to the current offset
             m_vaos.bind(i);
         }
+        rs.countStateChange();
 
         // Draw as elements or arrays
         if (nIndices > 0) {
-            GL::drawElements(m_drawMode, nIndices, GL_UNSIGNED_SHORT,
-                             (void*)(indiceOffset * sizeof(GLushort)));
+            GL::drawElements(m_drawMode, nIndices, m_indexType,
+                             (void*)(indiceOffset * indexSize()));
         } else if (nVertices > 0) {
             GL::drawArrays(m_drawMode, 0, nVertices);
         }
+        rs.countDrawCall();
 
         vertexOffset += nVertices;
         indiceOffset += nIndices;
@@ -212,45 +379,168 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
 }
 
 size_t MeshBase::bufferSize() const {
-    return m_nVertices * m_vertexLayout->getStride() + m_nIndices * sizeof(GLushort);
+    return m_nVertices * m_vertexLayout->getStride() + m_nIndices * indexSize();
 }
 
-// Add indices by collecting them into batches to draw as much as
-// possible in one draw call.  The indices must be shifted by the
-// number of vertices that are present in the current batch.
-size_t MeshBase::compileIndices(const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
-                                const std::vector<uint16_t>& _indices, size_t _offset) {
+// Followed by the draw batches, vertices and indices
+struct SerializedMesh {
+    uint32_t stride;
+    uint32_t indexType;
+    uint64_t nVertices;
+    uint64_t nIndices;
+    uint64_t nBatches;
+};
+
+bool MeshBase::serialize(std::vector<char>& _out) const {
+
+    if (!m_isCompiled || !m_glVertexData) { return false; }
+
+    SerializedMesh header{ uint32_t(m_vertexLayout->getStride()), m_indexType,
+                           m_nVertices, m_nIndices, m_vertexOffsets.size() };
+
+    size_t batchBytes = header.nBatches * sizeof(m_vertexOffsets[0]);
+    size_t vertexBytes = m_nVertices * header.stride;
+    size_t indexBytes = m_glIndexData ? m_nIndices * indexSize() : 0;
+
+    size_t pos = _out.size();
+    _out.resize(pos + sizeof(header) + batchBytes + vertexBytes + indexBytes);
+
+    char* dst = _out.data() + pos;
+    std::memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+    std::memcpy(dst, m_vertexOffsets.data(), batchBytes);
+    dst += batchBytes;
+    std::memcpy(dst, m_glVertexData, vertexBytes);
+    dst += vertexBytes;
+    if (indexBytes > 0) {
+        std::memcpy(dst, m_glIndexData, indexBytes);
+    }
+
+    return true;
+}
+
+bool MeshBase::restore(const char* _data, size_t _size,
+                       const std::unordered_map<uint32_t, uint32_t>& _selectionColors) {
+
+    SerializedMesh header;
+    if (m_isCompiled || _size < sizeof(header)) { return false; }
+    std::memcpy(&header, _data, sizeof(header));
+
+    if (header.stride != size_t(m_vertexLayout->getStride())) { return false; }
+
+    if (header.indexType == GL_UNSIGNED_INT) {
+        // Meshes in arenas share the GLushort index buffers of the arenas
+        if (m_arenaPool || !Hardware::supportsElementIndexUint) { return false; }
+    } else if (header.indexType != GL_UNSIGNED_SHORT) {
+        return false;
+    }
+    m_indexType = header.indexType;
+
+    size_t batchBytes = header.nBatches * sizeof(m_vertexOffsets[0]);
+    size_t vertexBytes = header.nVertices * header.stride;
+    size_t indexBytes = header.nIndices * indexSize();
+
+    if (_size != sizeof(header) + batchBytes + vertexBytes + indexBytes) { return false; }
+
+    const char* src = _data + sizeof(header);
+    m_vertexOffsets.resize(header.nBatches);
+    std::memcpy(m_vertexOffsets.data(), src, batchBytes);
+    src += batchBytes;
+
+    m_nVertices = header.nVertices;
+    m_glVertexData = new GLbyte[vertexBytes];
+    std::memcpy(m_glVertexData, src, vertexBytes);
+    src += vertexBytes;
+
+    m_nIndices = header.nIndices;
+    if (m_nIndices > 0) {
+        m_glIndexData = new GLbyte[indexBytes];
+        std::memcpy(m_glIndexData, src, indexBytes);
+    }
+
+    // Selection colors are handed out per scene, replace those of the
+    // serialized mesh with the ones of its restored features
+    if (!_selectionColors.empty()) {
+        for (const auto& attrib : m_vertexLayout->getAttribs()) {
+            if (attrib.name != "a_selection_color") { continue; }
+
+            for (size_t offset = attrib.offset; offset < vertexBytes; offset += header.stride) {
+                GLuint color;
+                std::memcpy(&color, m_glVertexData + offset, sizeof(color));
+                auto it = _selectionColors.find(color);
+                if (it != _selectionColors.end()) {
+                    std::memcpy(m_glVertexData + offset, &it->second, sizeof(color));
+                }
+            }
+        }
+    }
+
+    m_isCompiled = true;
+
+    return true;
+}
+
+void MeshBase::allocateIndices() {
 
+    // Meshes in arenas share the GLushort index buffers of the arenas
+    bool largeIndices = m_nVertices > MAX_INDEX_VALUE && !m_arenaPool &&
+        Hardware::supportsElementIndexUint;
 
-    GLushort* dst = m_glIndexData + _offset;
+    m_indexType = largeIndices ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    m_glIndexData = new GLbyte[m_nIndices * indexSize()];
+}
+
+template<typename I>
+static size_t compileIndicesAs(std::vector<std::pair<uint32_t, uint32_t>>& _vertexOffsets,
+                               I* _dst, const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
+                               const std::vector<uint16_t>& _indices, size_t _maxIndexValue) {
     size_t curVertices = 0;
     size_t src = 0;
 
-    if (m_vertexOffsets.empty()) {
-        m_vertexOffsets.emplace_back(0, 0);
+    if (_vertexOffsets.empty()) {
+        _vertexOffsets.emplace_back(0, 0);
     } else {
-        curVertices = m_vertexOffsets.back().second;
+        curVertices = _vertexOffsets.back().second;
     }
 
     for (auto& p : _offsets) {
         size_t nIndices = p.first;
         size_t nVertices = p.second;
 
-        if (curVertices + nVertices > MAX_INDEX_VALUE) {
-            m_vertexOffsets.emplace_back(0, 0);
+        if (curVertices + nVertices > _maxIndexValue) {
+            _vertexOffsets.emplace_back(0, 0);
             curVertices = 0;
         }
-        for (size_t i = 0; i < nIndices; i++, dst++) {
-            *dst = _indices[src++] + curVertices;
+        for (size_t i = 0; i < nIndices; i++, _dst++) {
+            *_dst = _indices[src++] + curVertices;
         }
 
-        auto& offset = m_vertexOffsets.back();
+        auto& offset = _vertexOffsets.back();
         offset.first += nIndices;
         offset.second += nVertices;
 
         curVertices += nVertices;
     }
 
+    return src;
+}
+
+// Add indices by collecting them into batches to draw as much as
+// possible in one draw call.  The indices must be shifted by the
+// number of vertices that are present in the current batch.
+size_t MeshBase::compileIndices(const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
+                                const std::vector<uint16_t>& _indices, size_t _offset) {
+
+    size_t src = 0;
+
+    if (m_indexType == GL_UNSIGNED_INT) {
+        GLuint* dst = reinterpret_cast<GLuint*>(m_glIndexData) + _offset;
+        src = compileIndicesAs(m_vertexOffsets, dst, _offsets, _indices, UINT32_MAX);
+    } else {
+        GLushort* dst = reinterpret_cast<GLushort*>(m_glIndexData) + _offset;
+        src = compileIndicesAs(m_vertexOffsets, dst, _offsets, _indices, MAX_INDEX_VALUE);
+    }
+
     return _offset + src;
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gl.h"
+#include "gl/meshArena.h"
 #include "gl/vertexLayout.h"
 #include "gl/vao.h"
 #include "style/style.h"
@@ -8,6 +9,7 @@
 #include "platform.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 #include <cstring> // for memcpy
@@ -60,6 +62,20 @@ public:
      */
     virtual void upload(RenderState& rs);
 
+    /*
+     * Copies up to _maxBytes of the compiled vertices and indices into the
+     * OpenGL buffer objects, continuing where the previous call stopped.
+     * Buffer storage is allocated on the first call and filled with
+     * glBufferSubData so that large meshes can be spread over several frames.
+     * Returns the number of bytes uploaded
+     */
+    size_t upload(RenderState& rs, size_t _maxBytes);
+
+    /*
+     * Whether compiled geometry is waiting to be uploaded
+     */
+    bool needsUpload() const { return m_isCompiled && m_nVertices > 0 && !m_isUploaded; }
+
     /*
      * Sub data upload of the mesh, returns true if this results in a buffer binding
      */
@@ -73,6 +89,27 @@ public:
 
     size_t bufferSize() const;
 
+    /*
+     * Append the compiled vertices, indices and draw batches to _out; returns
+     * false when there is no compiled geometry in client memory
+     */
+    bool serialize(std::vector<char>& _out) const;
+
+    /*
+     * Take the compiled geometry written by serialize(). Vertex selection
+     * colors are replaced by their entry in _selectionColors. Returns false
+     * when the data does not match the vertex layout of this mesh
+     */
+    bool restore(const char* _data, size_t _size,
+                 const std::unordered_map<uint32_t, uint32_t>& _selectionColors);
+
+    /*
+     * Place the geometry in the shared buffers of _pool on upload instead of
+     * buffers of its own. The mesh is then drawn by its style in batches with
+     * other meshes of the pool, see <MeshArena>.
+     */
+    void setArenaPool(std::shared_ptr<MeshArenaPool> _pool);
+
 protected:
 
     // Used in draw for legth and offsets: sumIndices, sumVertices
@@ -91,8 +128,12 @@ protected:
 
     size_t m_nIndices;
     GLuint m_glIndexBuffer;
-    // Compiled  indices for upload
-    GLushort* m_glIndexData = nullptr;
+    // Compiled  indices for upload, of m_indexType
+    GLbyte* m_glIndexData = nullptr;
+
+    // GL_UNSIGNED_INT for meshes with more vertices than GLushort indices
+    // can address, when the driver supports it; GL_UNSIGNED_SHORT otherwise
+    GLenum m_indexType = GL_UNSIGNED_SHORT;
 
     GLenum m_drawMode;
     GLenum m_hint;
@@ -101,11 +142,31 @@ protected:
     bool m_isCompiled;
     bool m_dirty;
 
+    // Bytes of vertices and indices already uploaded by upload(rs, _maxBytes)
+    size_t m_uploadedBytes = 0;
+
     RenderState* m_rs = nullptr;
 
+    std::shared_ptr<MeshArenaPool> m_arenaPool;
+    std::vector<ArenaRange> m_arenaRanges;
+    // Batches already placed in arenas by upload(rs, _maxBytes)
+    size_t m_uploadedBatches = 0;
+
+    /* Place the batches of the mesh in arenas within @_maxBytes, at least one
+     * batch unless @_maxBytes is zero. Falls back to buffers of its own when
+     * a batch does not fit into an arena. */
+    size_t uploadToArenas(RenderState& rs, size_t _maxBytes);
+
     GLsizei m_dirtySize;
     GLintptr m_dirtyOffset;
 
+    /* Select the index type for m_nVertices and allocate m_nIndices indices */
+    void allocateIndices();
+
+    size_t indexSize() const {
+        return m_indexType == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+    }
+
     size_t compileIndices(const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
                           const std::vector<uint16_t>& _indices, size_t _offset);
 
@@ -131,6 +192,12 @@ struct MeshData {
         indices.clear();
         vertices.clear();
     }
+
+    void append(const MeshData<T>& _other) {
+        indices.insert(indices.end(), _other.indices.begin(), _other.indices.end());
+        vertices.insert(vertices.end(), _other.vertices.begin(), _other.vertices.end());
+        offsets.insert(offsets.end(), _other.offsets.begin(), _other.offsets.end());
+    }
 };
 
 template<class T>
@@ -147,10 +214,35 @@ public:
         return MeshBase::bufferSize();
     }
 
+    bool isUploaded() const override { return m_isUploaded; }
+
+    bool needsUpload() const override { return MeshBase::needsUpload(); }
+
+    size_t upload(RenderState& rs, size_t _maxBytes) override {
+        return MeshBase::upload(rs, _maxBytes);
+    }
+
     bool draw(RenderState& rs, ShaderProgram& shader, bool useVao = true) override {
         return MeshBase::draw(rs, shader, useVao);
     }
 
+    const std::vector<ArenaRange>* arenaRanges() const override {
+        return m_arenaPool ? &m_arenaRanges : nullptr;
+    }
+
+    bool serialize(std::vector<char>& _out) const override {
+        return MeshBase::serialize(_out);
+    }
+
+    bool restore(const char* _data, size_t _size,
+                 const std::unordered_map<uint32_t, uint32_t>& _selectionColors) {
+        return MeshBase::restore(_data, _size, _selectionColors);
+    }
+
+    void setArenaPool(std::shared_ptr<MeshArenaPool> _pool) {
+        MeshBase::setArenaPool(std::move(_pool));
+    }
+
     void compile(const std::vector<MeshData<T>>& _meshes);
 
     void compile(const MeshData<T>& _mesh);
@@ -199,7 +291,7 @@ void Mesh<T>::compile(const std::vector<MeshData<T>>& _meshes) {
     assert(offset == m_nVertices * stride);
 
     if (m_nIndices > 0) {
-        m_glIndexData = new GLushort[m_nIndices];
+        allocateIndices();
 
         size_t offset = 0;
         for (auto& m : _meshes) {
@@ -225,7 +317,7 @@ void Mesh<T>::compile(const MeshData<T>& _mesh) {
                 m_nVertices * stride);
 
     if (m_nIndices > 0) {
-        m_glIndexData = new GLushort[m_nIndices];
+        allocateIndices();
         compileIndices(_mesh.offsets, _mesh.indices, 0);
     }
 
@@ -0,0 +1,231 @@
+#include "gl/meshArena.h"
+
+#include "gl/glError.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+#include "gl/vertexLayout.h"
+#include "log.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Tangram {
+
+constexpr size_t MeshArena::MAX_SLOTS;
+constexpr uint32_t MeshArena::MAX_VERTICES;
+constexpr uint32_t MeshArena::DEFAULT_INDICES;
+
+bool MeshArena::FreeList::allocate(uint32_t _size, uint32_t& _offset) {
+
+    for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+        if (it->second < _size) { continue; }
+
+        _offset = it->first;
+        uint32_t rest = it->second - _size;
+
+        blocks.erase(it);
+        if (rest > 0) { blocks.emplace(_offset + _size, rest); }
+
+        return true;
+    }
+    return false;
+}
+
+void MeshArena::FreeList::release(uint32_t _offset, uint32_t _size) {
+
+    auto next = blocks.lower_bound(_offset);
+
+    // Join with the following block
+    if (next != blocks.end() && _offset + _size == next->first) {
+        _size += next->second;
+        next = blocks.erase(next);
+    }
+
+    // Join with the preceding block
+    if (next != blocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == _offset) {
+            prev->second += _size;
+            return;
+        }
+    }
+
+    blocks.emplace(_offset, _size);
+}
+
+MeshArena::MeshArena(RenderState& rs, GLsizei _stride, uint32_t _indexCapacity)
+    : m_rs(rs), m_stride(_stride), m_indexCapacity(_indexCapacity) {
+
+    m_freeVertices.blocks.emplace(0, MAX_VERTICES);
+    m_freeIndices.blocks.emplace(0, m_indexCapacity);
+
+    GL::genBuffers(1, &m_glVertexBuffer);
+    rs.vertexBuffer(m_glVertexBuffer);
+    GL::bufferData(GL_ARRAY_BUFFER, MAX_VERTICES * m_stride, NULL, GL_STATIC_DRAW);
+
+    GL::genBuffers(1, &m_glSlotBuffer);
+    rs.vertexBuffer(m_glSlotBuffer);
+    GL::bufferData(GL_ARRAY_BUFFER, MAX_VERTICES, NULL, GL_STATIC_DRAW);
+
+    GL::genBuffers(1, &m_glIndexBuffer);
+    rs.indexBuffer(m_glIndexBuffer);
+    GL::bufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCapacity * sizeof(GLushort), NULL, GL_STATIC_DRAW);
+
+    // A previously deleted arena may have had the same buffer handle
+    rs.meshArenaUnset();
+}
+
+MeshArena::~MeshArena() {
+    if (isAbandoned()) { return; }
+
+    GLuint buffers[] = { m_glVertexBuffer, m_glIndexBuffer, m_glSlotBuffer };
+    m_rs.queueBufferDeletion(3, buffers);
+}
+
+bool MeshArena::allocate(uint32_t _nVertices, uint32_t _nIndices, ArenaRange& _range) {
+
+    if (isAbandoned()) { return false; }
+
+    if (m_usedSlots == (1u << MAX_SLOTS) - 1) { return false; }
+
+    uint32_t vertexOffset, indexOffset;
+    if (!m_freeVertices.allocate(_nVertices, vertexOffset)) { return false; }
+
+    if (!m_freeIndices.allocate(_nIndices, indexOffset)) {
+        m_freeVertices.release(vertexOffset, _nVertices);
+        return false;
+    }
+
+    uint8_t slot = 0;
+    while (m_usedSlots & (1u << slot)) { slot++; }
+    m_usedSlots |= (1u << slot);
+
+    _range.arena = this;
+    _range.vertexOffset = vertexOffset;
+    _range.nVertices = _nVertices;
+    _range.indexOffset = indexOffset;
+    _range.nIndices = _nIndices;
+    _range.slot = slot;
+
+    return true;
+}
+
+void MeshArena::upload(RenderState& rs, const ArenaRange& _range, const GLbyte* _vertices,
+                       const GLushort* _indices) {
+
+    rs.vertexBuffer(m_glVertexBuffer);
+    GL::bufferSubData(GL_ARRAY_BUFFER, _range.vertexOffset * m_stride,
+                      _range.nVertices * m_stride, _vertices);
+
+    std::vector<GLubyte> slots(_range.nVertices, _range.slot);
+    rs.vertexBuffer(m_glSlotBuffer);
+    GL::bufferSubData(GL_ARRAY_BUFFER, _range.vertexOffset, slots.size(), slots.data());
+
+    // Make the indices relative to the start of the arena
+    std::vector<GLushort> indices(_indices, _indices + _range.nIndices);
+    for (auto& index : indices) { index += _range.vertexOffset; }
+
+    rs.indexBuffer(m_glIndexBuffer);
+    GL::bufferSubData(GL_ELEMENT_ARRAY_BUFFER, _range.indexOffset * sizeof(GLushort),
+                      indices.size() * sizeof(GLushort), indices.data());
+}
+
+void MeshArena::release(const ArenaRange& _range) {
+    m_freeVertices.release(_range.vertexOffset, _range.nVertices);
+    m_freeIndices.release(_range.indexOffset, _range.nIndices);
+    m_usedSlots &= ~(1u << _range.slot);
+}
+
+void MeshArena::abandon() {
+    m_abandoned = true;
+}
+
+void MeshArena::bind(RenderState& rs, ShaderProgram& _program, VertexLayout& _layout) {
+
+    if (rs.meshArena(m_glVertexBuffer, _program.getGlProgram())) {
+        return;
+    }
+
+    rs.vertexBuffer(m_glVertexBuffer);
+    _layout.enable(rs, _program, 0);
+
+    GLint location = _program.getAttribLocation("a_tile_slot");
+    if (location >= 0) {
+        auto& boundProgram = rs.attributeBindings[location];
+        if (boundProgram != _program.getGlProgram()) {
+            GL::enableVertexAttribArray(location);
+            boundProgram = _program.getGlProgram();
+        }
+        rs.vertexBuffer(m_glSlotBuffer);
+        GL::vertexAttribPointer(location, 1, GL_UNSIGNED_BYTE, GL_FALSE, 0, 0);
+    }
+
+    rs.indexBuffer(m_glIndexBuffer);
+
+    // VertexLayout::enable resets the arena binding
+    rs.meshArena(m_glVertexBuffer, _program.getGlProgram());
+}
+
+MeshArenaPool::MeshArenaPool(std::shared_ptr<VertexLayout> _vertexLayout)
+    : m_vertexLayout(std::move(_vertexLayout)) {}
+
+MeshArenaPool::~MeshArenaPool() {}
+
+ArenaRange MeshArenaPool::add(RenderState& rs, const GLbyte* _vertices, uint32_t _nVertices,
+                              const GLushort* _indices, uint32_t _nIndices) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ArenaRange range;
+
+    auto it = std::find_if(m_arenas.begin(), m_arenas.end(), [&](auto& arena) {
+        return arena->allocate(_nVertices, _nIndices, range);
+    });
+
+    if (it == m_arenas.end()) {
+        auto indexCapacity = std::max(_nIndices, MeshArena::DEFAULT_INDICES);
+        m_arenas.push_back(std::make_unique<MeshArena>(rs, m_vertexLayout->getStride(), indexCapacity));
+
+        // The mesh is then drawn on its own
+        if (!m_arenas.back()->allocate(_nVertices, _nIndices, range)) {
+            m_arenas.pop_back();
+            return ArenaRange{};
+        }
+    }
+
+    range.arena->upload(rs, range, _vertices, _indices);
+
+    return range;
+}
+
+void MeshArenaPool::remove(const ArenaRange& _range) {
+    if (!_range.arena) { return; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto* arena = _range.arena;
+    arena->release(_range);
+
+    if (arena->empty()) {
+        m_arenas.erase(std::remove_if(m_arenas.begin(), m_arenas.end(),
+                                      [&](auto& a) { return a.get() == arena; }),
+                       m_arenas.end());
+    }
+}
+
+void MeshArenaPool::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& arena : m_arenas) { arena->abandon(); }
+
+    m_arenas.erase(std::remove_if(m_arenas.begin(), m_arenas.end(),
+                                  [](auto& a) { return a->empty(); }),
+                   m_arenas.end());
+}
+
+size_t MeshArenaPool::arenaCount() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_arenas.size();
+}
+
+}
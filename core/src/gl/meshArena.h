@@ -0,0 +1,136 @@
+#pragma once
+
+#include "gl.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+class MeshArena;
+class RenderState;
+class ShaderProgram;
+class VertexLayout;
+
+/* Part of a mesh placed in a <MeshArena> */
+struct ArenaRange {
+    MeshArena* arena = nullptr;
+    uint32_t vertexOffset = 0;
+    uint32_t nVertices = 0;
+    uint32_t indexOffset = 0;
+    uint32_t nIndices = 0;
+    uint8_t slot = 0;
+};
+
+/*
+ * MeshArena - Vertex and index buffers shared by the meshes of one style
+ *
+ * Meshes placed in an arena can be drawn together with a single draw call as
+ * long as their index ranges are adjacent. Each range gets one of MAX_SLOTS
+ * slots, stored per vertex in a separate buffer, by which the vertex shader
+ * picks the transform of its tile from a uniform array.
+ */
+class MeshArena {
+
+public:
+
+    static constexpr size_t MAX_SLOTS = 16;
+
+    // Indices are 16 bit and relative to the start of the arena
+    static constexpr uint32_t MAX_VERTICES = 65535;
+
+    // Index capacity of an arena, unless a range needs more
+    static constexpr uint32_t DEFAULT_INDICES = 2 * MAX_VERTICES;
+
+    MeshArena(RenderState& rs, GLsizei _stride, uint32_t _indexCapacity);
+
+    ~MeshArena();
+
+    /* Reserve room for a range, returns false when the arena is too full */
+    bool allocate(uint32_t _nVertices, uint32_t _nIndices, ArenaRange& _range);
+
+    /* Upload the vertices and indices of @_range, @_indices are relative to
+     * the first vertex */
+    void upload(RenderState& rs, const ArenaRange& _range, const GLbyte* _vertices,
+                const GLushort* _indices);
+
+    void release(const ArenaRange& _range);
+
+    /* Whether all ranges were released */
+    bool empty() const { return m_usedSlots == 0; }
+
+    /* Forget the GL buffers after the GL context was lost. An abandoned
+     * arena takes no new ranges and does not delete its buffers. */
+    void abandon();
+
+    bool isAbandoned() const { return m_abandoned; }
+
+    /* Bind the buffers and set up the vertex attributes for drawing with
+     * @_program, unless the arena is already bound for it */
+    void bind(RenderState& rs, ShaderProgram& _program, VertexLayout& _layout);
+
+private:
+
+    // First fit allocator over offsets of a buffer
+    struct FreeList {
+        std::map<uint32_t, uint32_t> blocks;
+
+        bool allocate(uint32_t _size, uint32_t& _offset);
+        void release(uint32_t _offset, uint32_t _size);
+    };
+
+    RenderState& m_rs;
+
+    GLsizei m_stride;
+    uint32_t m_indexCapacity;
+
+    GLuint m_glVertexBuffer = 0;
+    GLuint m_glIndexBuffer = 0;
+    GLuint m_glSlotBuffer = 0;
+
+    FreeList m_freeVertices;
+    FreeList m_freeIndices;
+    uint32_t m_usedSlots = 0;
+    bool m_abandoned = false;
+};
+
+/*
+ * MeshArenaPool - The arenas of one style, grows as meshes are added
+ */
+class MeshArenaPool {
+
+public:
+
+    MeshArenaPool(std::shared_ptr<VertexLayout> _vertexLayout);
+
+    ~MeshArenaPool();
+
+    /* Place a batch of at most MeshArena::MAX_VERTICES vertices in the first
+     * arena that has room for it. Returns a range without arena when the
+     * batch is too large. */
+    ArenaRange add(RenderState& rs, const GLbyte* _vertices, uint32_t _nVertices,
+                   const GLushort* _indices, uint32_t _nIndices);
+
+    /* Free the room of @_range, may be called from any thread. Arenas are
+     * deleted once all of their ranges are removed. */
+    void remove(const ArenaRange& _range);
+
+    /* Abandon all arenas after the GL context was lost, see MeshArena::abandon().
+     * They are deleted as their meshes go away. */
+    void reset();
+
+    VertexLayout& vertexLayout() { return *m_vertexLayout; }
+
+    size_t arenaCount();
+
+private:
+
+    std::shared_ptr<VertexLayout> m_vertexLayout;
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<MeshArena>> m_arenas;
+};
+
+}
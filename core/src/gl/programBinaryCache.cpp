@@ -0,0 +1,226 @@
+#include "gl/programBinaryCache.h"
+
+#include "gl/hardware.h"
+#include "log.h"
+#include "util/zlibHelper.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace Tangram {
+
+static constexpr uint32_t FILE_MAGIC = 0x42504754; // 'TGPB'
+static constexpr uint32_t VERSION = 1;
+
+// Limit for binaries read from disk, to not allocate for corrupt headers
+static constexpr uint32_t MAX_BINARY_SIZE = 16 * 1024 * 1024;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+    uint32_t crc;
+    uint32_t reserved;
+};
+
+static uint64_t fnv1a(uint64_t _hash, const char* _data, size_t _length) {
+    for (size_t i = 0; i < _length; i++) {
+        _hash ^= static_cast<uint8_t>(_data[i]);
+        _hash *= 0x100000001b3ULL;
+    }
+    return _hash;
+}
+
+static std::string glString(GLenum _name) {
+    auto str = GL::getString(_name);
+    return str ? reinterpret_cast<const char*>(str) : "";
+}
+
+ProgramBinaryCache::ProgramBinaryCache(std::string _directory)
+    : m_directory(std::move(_directory)) {
+
+    if (!m_directory.empty() && m_directory.back() != '/') {
+        m_directory += '/';
+    }
+}
+
+void ProgramBinaryCache::setDriver(std::string _driver) {
+    m_driver = std::move(_driver);
+}
+
+const std::string& ProgramBinaryCache::driver() {
+    if (m_driver.empty()) {
+        m_driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+    }
+    return m_driver;
+}
+
+uint64_t ProgramBinaryCache::key(const std::string& _vertSrc, const std::string& _fragSrc) {
+    const auto& drv = driver();
+
+    // Include the terminators so that moving text between the parts changes the key
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = fnv1a(hash, drv.c_str(), drv.size() + 1);
+    hash = fnv1a(hash, _vertSrc.c_str(), _vertSrc.size() + 1);
+    hash = fnv1a(hash, _fragSrc.c_str(), _fragSrc.size() + 1);
+    return hash;
+}
+
+bool ProgramBinaryCache::get(uint64_t _key, Entry& _entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_entries.find(_key);
+    if (it != m_entries.end()) {
+        _entry = it->second;
+        return true;
+    }
+
+    if (!m_directory.empty() && readFile(_key, _entry)) {
+        m_entries.emplace(_key, _entry);
+        return true;
+    }
+    return false;
+}
+
+void ProgramBinaryCache::put(uint64_t _key, Entry _entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_directory.empty()) {
+        writeFile(_key, _entry);
+    }
+    m_entries[_key] = std::move(_entry);
+}
+
+void ProgramBinaryCache::remove(uint64_t _key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_entries.erase(_key);
+
+    if (!m_directory.empty()) {
+        std::remove(filePath(_key).c_str());
+    }
+}
+
+GLuint ProgramBinaryCache::loadProgram(const std::string& _vertSrc, const std::string& _fragSrc) {
+    if (!Hardware::supportsProgramBinary) { return 0; }
+
+    uint64_t programKey = key(_vertSrc, _fragSrc);
+
+    Entry entry;
+    if (!get(programKey, entry)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.misses++;
+        return 0;
+    }
+
+    GLuint program = GL::createProgram();
+    GL::programBinary(program, entry.format, entry.data.data(), static_cast<GLsizei>(entry.data.size()));
+
+    GLint isLinked = GL_FALSE;
+    GL::getProgramiv(program, GL_LINK_STATUS, &isLinked);
+
+    if (program == 0 || isLinked == GL_FALSE) {
+        LOGW("Program binary %016" PRIx64 " was rejected by the driver", programKey);
+        if (program != 0) { GL::deleteProgram(program); }
+        remove(programKey);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.rejected++;
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.hits++;
+    return program;
+}
+
+void ProgramBinaryCache::storeProgram(GLuint _program, const std::string& _vertSrc,
+                                      const std::string& _fragSrc) {
+    if (!Hardware::supportsProgramBinary || _program == 0) { return; }
+
+    GLint length = 0;
+    GL::getProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || uint32_t(length) > MAX_BINARY_SIZE) { return; }
+
+    Entry entry;
+    entry.data.resize(length);
+
+    GLsizei written = 0;
+    GL::getProgramBinary(_program, length, &written, &entry.format, entry.data.data());
+    if (written <= 0) { return; }
+    entry.data.resize(written);
+
+    put(key(_vertSrc, _fragSrc), std::move(entry));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.stores++;
+}
+
+ProgramBinaryCache::Stats ProgramBinaryCache::stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::string ProgramBinaryCache::filePath(uint64_t _key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "program-%016" PRIx64 ".bin", _key);
+    return m_directory + name;
+}
+
+bool ProgramBinaryCache::readFile(uint64_t _key, Entry& _entry) {
+    std::string path = filePath(_key);
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) { return false; }
+
+    FileHeader header{};
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+        header.magic == FILE_MAGIC && header.version == VERSION &&
+        header.key == _key && header.length > 0 && header.length <= MAX_BINARY_SIZE;
+
+    if (ok) {
+        _entry.format = header.format;
+        _entry.data.resize(header.length);
+        ok = fread(_entry.data.data(), 1, header.length, file) == header.length &&
+            zlib::crc32(0, _entry.data.data(), header.length) == header.crc;
+    }
+    fclose(file);
+
+    if (!ok) {
+        LOGW("Ignoring invalid program binary '%s'", path.c_str());
+        std::remove(path.c_str());
+        _entry = Entry();
+    }
+    return ok;
+}
+
+void ProgramBinaryCache::writeFile(uint64_t _key, const Entry& _entry) {
+    std::string path = filePath(_key);
+    std::string tmpPath = path + ".tmp";
+
+    FileHeader header{};
+    header.magic = FILE_MAGIC;
+    header.version = VERSION;
+    header.key = _key;
+    header.format = _entry.format;
+    header.length = static_cast<uint32_t>(_entry.data.size());
+    header.crc = zlib::crc32(0, _entry.data.data(), _entry.data.size());
+
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        LOGE("Cannot write program binary '%s'", tmpPath.c_str());
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(_entry.data.data(), 1, _entry.data.size(), file) == _entry.data.size();
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        LOGE("Cannot write program binary '%s'", path.c_str());
+        std::remove(tmpPath.c_str());
+    }
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "gl.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+/* Cache of linked program binaries
+ *
+ * Programs are keyed by a hash of the final vertex and fragment source and of
+ * the driver description, so that binaries are never given to another driver
+ * version. Binaries are kept in memory and, when a directory is set, in one
+ * file per program so that they survive restarts of the app.
+ *
+ * Drivers may reject a binary at any time, e.g. after an update. In that case
+ * the entry is dropped and the program is compiled from source again.
+ */
+class ProgramBinaryCache {
+
+public:
+
+    struct Entry {
+        GLenum format = 0;
+        std::vector<char> data;
+    };
+
+    struct Stats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t stores = 0;
+        uint32_t rejected = 0;
+    };
+
+    // Binaries are written to @_directory, when empty only kept in memory
+    explicit ProgramBinaryCache(std::string _directory = "");
+
+    // Set the driver description, by default GL_VENDOR, GL_RENDERER and
+    // GL_VERSION are queried on first use
+    void setDriver(std::string _driver);
+
+    const std::string& driver();
+
+    uint64_t key(const std::string& _vertSrc, const std::string& _fragSrc);
+
+    // Get the binary for @_key from memory or disk, returns false when there is none
+    bool get(uint64_t _key, Entry& _entry);
+
+    void put(uint64_t _key, Entry _entry);
+
+    void remove(uint64_t _key);
+
+    // Create a program from a cached binary, returns 0 when there is no binary
+    // or the driver rejected it. Must be called on the GL thread.
+    GLuint loadProgram(const std::string& _vertSrc, const std::string& _fragSrc);
+
+    // Retrieve and store the binary of the linked @_program. Must be called on
+    // the GL thread.
+    void storeProgram(GLuint _program, const std::string& _vertSrc, const std::string& _fragSrc);
+
+    Stats stats();
+
+private:
+
+    std::string filePath(uint64_t _key) const;
+
+    bool readFile(uint64_t _key, Entry& _entry);
+    void writeFile(uint64_t _key, const Entry& _entry);
+
+    std::mutex m_mutex;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::string m_directory;
+    std::string m_driver;
+    Stats m_stats;
+};
+
+}
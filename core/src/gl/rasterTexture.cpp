@@ -0,0 +1,225 @@
+#include "gl/rasterTexture.h"
+
+#include "gl/glError.h"
+#include "gl/hardware.h"
+#include "log.h"
+#include "util/geom.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace Tangram {
+
+PixelBufferPool::~PixelBufferPool() {
+    for (auto& entry : m_buffers) {
+        std::free(entry.second);
+    }
+}
+
+GLubyte* PixelBufferPool::acquire(size_t _size) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it) {
+            if (it->first == _size) {
+                GLubyte* buffer = it->second;
+                m_buffers.erase(it);
+                return buffer;
+            }
+        }
+    }
+    return reinterpret_cast<GLubyte*>(std::malloc(_size));
+}
+
+void PixelBufferPool::release(GLubyte* _buffer, size_t _size) {
+    if (!_buffer) { return; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_buffers.size() >= m_maxBuffers) {
+        // Drop the oldest, the size of raster tiles may have changed
+        std::free(m_buffers.front().second);
+        m_buffers.erase(m_buffers.begin());
+    }
+    m_buffers.emplace_back(_size, _buffer);
+}
+
+size_t PixelBufferPool::size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_buffers.size();
+}
+
+RasterTexture::RasterTexture(TextureOptions _options, std::shared_ptr<PixelBufferPool> _pool)
+    : Texture(_options), m_pool(_pool) {}
+
+RasterTexture::~RasterTexture() {
+    disposeBuffer();
+
+    if (m_rs && m_glHandle != 0) {
+        m_rs->releaseTexture(m_glHandle, textureKey());
+        m_rs = nullptr;
+    }
+}
+
+bool RasterTexture::decode(const uint8_t* _data, size_t _length) {
+    // Same orientation as in Texture::loadImageFromMemory()
+    stbi_set_flip_vertically_on_load(true);
+
+    int width = 0, height = 0;
+    int channelsInFile = 0;
+    int channels = bpp();
+
+    std::unique_ptr<stbi_uc, void(*)(void*)> pixels(
+        stbi_load_from_memory(_data, static_cast<int>(_length),
+                              &width, &height, &channelsInFile, channels),
+        stbi_image_free);
+
+    if (!pixels) {
+        LOGE("Could not load raster data: bpp:%d/%d", channelsInFile, channels);
+
+        GLubyte pixel[4] = { 0, 0, 0, 255 };
+        setPixelData(1, 1, bpp(), pixel, bpp());
+        return false;
+    }
+
+    // May disable mipmaps for NPOT textures
+    resize(width, height);
+
+    // Build mip levels here instead of glGenerateMipmap on the render thread.
+    // Other sizes fall back to glGenerateMipmap.
+    m_levels = 1;
+    if (m_options.generateMipmaps && isPowerOfTwo(width) && isPowerOfTwo(height)) {
+        while ((width >> m_levels) > 0 || (height >> m_levels) > 0) { m_levels++; }
+    }
+
+    size_t size = 0;
+    for (int level = 0; level < m_levels; level++) {
+        size += std::max(width >> level, 1) * std::max(height >> level, 1) * channels;
+    }
+
+    disposeBuffer();
+
+    GLubyte* buffer = m_pool->acquire(size);
+    if (!buffer) {
+        LOGE("Could not allocate texture: Out of memory!");
+        m_shouldResize = false;
+        return false;
+    }
+
+    std::memcpy(buffer, pixels.get(), width * height * channels);
+    pixels.reset();
+
+    GLubyte* level = buffer;
+    for (int i = 1; i < m_levels; i++) {
+        int w = std::max(width >> (i - 1), 1);
+        int h = std::max(height >> (i - 1), 1);
+        GLubyte* next = level + w * h * channels;
+        downsample(level, w, h, channels, next);
+        level = next;
+    }
+
+    setBufferData(buffer, size);
+    m_bufferSize = size;
+    m_pooledBuffer = true;
+
+    return true;
+}
+
+void RasterTexture::downsample(const GLubyte* _src, int _width, int _height, int _bpp, GLubyte* _dst) {
+    int width = std::max(_width / 2, 1);
+    int height = std::max(_height / 2, 1);
+
+    for (int y = 0; y < height; y++) {
+        const GLubyte* row0 = _src + std::min(y * 2, _height - 1) * _width * _bpp;
+        const GLubyte* row1 = _src + std::min(y * 2 + 1, _height - 1) * _width * _bpp;
+
+        for (int x = 0; x < width; x++) {
+            int x0 = std::min(x * 2, _width - 1) * _bpp;
+            int x1 = std::min(x * 2 + 1, _width - 1) * _bpp;
+
+            for (int c = 0; c < _bpp; c++) {
+                int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                *_dst++ = static_cast<GLubyte>((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+bool RasterTexture::upload(RenderState& _rs, GLuint _textureUnit) {
+    m_shouldResize = false;
+
+    if (Hardware::maxTextureSize < m_width ||
+        Hardware::maxTextureSize < m_height) {
+        LOGW("Texture larger than Hardware maximum texture size");
+        if (m_disposeBuffer) { disposeBuffer(); }
+        return false;
+    }
+
+    if (m_glHandle == 0) {
+        // Texture objects from the pool have parameters and storage set up
+        m_glHandle = _rs.acquireTexture(textureKey());
+
+        if (m_glHandle != 0) {
+            _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
+            m_rs = &_rs;
+            m_hasStorage = true;
+        } else {
+            generate(_rs, _textureUnit);
+            m_hasStorage = false;
+        }
+    } else {
+        _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
+    }
+
+    auto format = static_cast<GLenum>(m_options.pixelFormat);
+    const GLubyte* data = m_buffer.get();
+
+    for (int level = 0; level < m_levels; level++) {
+        int width = std::max(m_width >> level, 1);
+        int height = std::max(m_height >> level, 1);
+
+        if (m_hasStorage && data) {
+            GL::texSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, format,
+                              GL_UNSIGNED_BYTE, data);
+        } else {
+            GL::texImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format,
+                           GL_UNSIGNED_BYTE, data);
+        }
+        if (data) { data += width * height * bpp(); }
+    }
+    m_hasStorage = true;
+
+    if (m_buffer && m_options.generateMipmaps && m_levels == 1) {
+        GL::generateMipmap(GL_TEXTURE_2D);
+    }
+    return true;
+}
+
+void RasterTexture::disposeBuffer() {
+    if (m_pooledBuffer) {
+        m_pool->release(m_buffer.release(), m_bufferSize);
+        m_pooledBuffer = false;
+    } else {
+        m_buffer.reset();
+    }
+}
+
+RenderState::TextureKey RasterTexture::textureKey() const {
+    RenderState::TextureKey key;
+    key.width = m_width;
+    key.height = m_height;
+    key.format = static_cast<GLenum>(m_options.pixelFormat);
+    // Mipmapped textures have storage for all levels, whether they were
+    // built here or by glGenerateMipmap
+    key.mipmaps = m_options.generateMipmaps;
+    key.minFilter = static_cast<GLenum>(m_options.minFilter);
+    key.magFilter = static_cast<GLenum>(m_options.magFilter);
+    key.wrapS = static_cast<GLenum>(m_options.wrapS);
+    key.wrapT = static_cast<GLenum>(m_options.wrapT);
+    return key;
+}
+
+}
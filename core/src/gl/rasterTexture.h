@@ -0,0 +1,87 @@
+#pragma once
+
+#include "gl/renderState.h"
+#include "gl/texture.h"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Tangram {
+
+/* Bounded pool of pixel buffers for decoded raster tiles
+ *
+ * Raster tiles of a source usually have the same size, so buffers are reused
+ * for requests of exactly the same size. Buffers are taken by tile workers and
+ * given back on the render thread after upload.
+ */
+class PixelBufferPool {
+
+public:
+
+    explicit PixelBufferPool(size_t _maxBuffers = 16) : m_maxBuffers(_maxBuffers) {}
+
+    ~PixelBufferPool();
+
+    // Get a buffer of @_size bytes, allocated with malloc when none is pooled
+    GLubyte* acquire(size_t _size);
+
+    // Give back a buffer from acquire(), frees it when the pool is full
+    void release(GLubyte* _buffer, size_t _size);
+
+    // Number of pooled buffers
+    size_t size();
+
+private:
+
+    std::mutex m_mutex;
+    std::vector<std::pair<size_t, GLubyte*>> m_buffers;
+    size_t m_maxBuffers;
+};
+
+/* Texture of a raster tile
+ *
+ * Image data is decoded on the tile worker into a buffer of the sources
+ * <PixelBufferPool>, including the mip levels when mipmaps are requested, so
+ * that the render thread only has to upload. The GL texture object is given
+ * to the texture pool of the <RenderState> on destruction and reused with
+ * glTexSubImage2D by the next texture of the same size.
+ */
+class RasterTexture : public Texture {
+
+public:
+
+    RasterTexture(TextureOptions _options, std::shared_ptr<PixelBufferPool> _pool);
+
+    ~RasterTexture() override;
+
+    // Decode PNG or JPEG @_data into a pooled buffer
+    bool decode(const uint8_t* _data, size_t _length);
+
+    // Number of mip levels held in the pixel buffer
+    int levels() const { return m_levels; }
+
+    // Downsample an image of @_width * @_height pixels by two with a box filter
+    static void downsample(const GLubyte* _src, int _width, int _height, int _bpp, GLubyte* _dst);
+
+protected:
+
+    bool upload(RenderState& _rs, GLuint _textureUnit) override;
+
+    void disposeBuffer() override;
+
+    RenderState::TextureKey textureKey() const;
+
+    std::shared_ptr<PixelBufferPool> m_pool;
+
+    // Whether m_buffer was taken from m_pool
+    bool m_pooledBuffer = false;
+
+    // Whether the texture object already has storage for all levels
+    bool m_hasStorage = false;
+
+    int m_levels = 1;
+};
+
+}
@@ -7,6 +7,7 @@
 #include "log.h"
 #include "platform.h"
 
+#include <iterator>
 #include <limits>
 
 namespace Tangram {
@@ -34,6 +35,7 @@ RenderState::RenderState() {
     m_textureUnit = { 0, false };
     m_framebuffer = { 0, false };
     m_viewport = { 0, 0, 0, 0, false };
+    m_meshArena = { 0, 0, false };
 
 }
 
@@ -79,6 +81,37 @@ void RenderState::queueTextureDeletion(GLuint texture) {
     m_textureDeletionList.push_back(texture);
 }
 
+GLuint RenderState::acquireTexture(const TextureKey& _key) {
+    std::lock_guard<std::mutex> guard(m_deletionListMutex);
+
+    // Take the most recently released one
+    for (auto it = m_texturePool.rbegin(); it != m_texturePool.rend(); ++it) {
+        if (it->first == _key) {
+            GLuint texture = it->second;
+            m_texturePool.erase(std::next(it).base());
+            return texture;
+        }
+    }
+    return 0;
+}
+
+void RenderState::releaseTexture(GLuint _texture, const TextureKey& _key) {
+    if (_texture == 0) { return; }
+
+    std::lock_guard<std::mutex> guard(m_deletionListMutex);
+
+    if (m_texturePool.size() >= MAX_POOLED_TEXTURES) {
+        m_textureDeletionList.push_back(m_texturePool.front().second);
+        m_texturePool.erase(m_texturePool.begin());
+    }
+    m_texturePool.emplace_back(_key, _texture);
+}
+
+size_t RenderState::pooledTextures() {
+    std::lock_guard<std::mutex> guard(m_deletionListMutex);
+    return m_texturePool.size();
+}
+
 void RenderState::queueVAODeletion(size_t count, GLuint* vao) {
     std::lock_guard<std::mutex> guard(m_deletionListMutex);
     m_VAODeletionList.insert(m_VAODeletionList.end(), vao, vao + count);
@@ -96,6 +129,12 @@ GLuint RenderState::getTextureUnit(GLuint _unit) {
 RenderState::~RenderState() {
 
     deleteQuadIndexBuffer();
+
+    for (auto& entry : m_texturePool) {
+        m_textureDeletionList.push_back(entry.second);
+    }
+    m_texturePool.clear();
+
     flushResourceDeletion();
 
     for (auto& s : vertexShaders) {
@@ -133,6 +172,7 @@ void RenderState::invalidateStates() {
     m_textureUnit.set = false;
     m_viewport.set = false;
     m_framebuffer.set = false;
+    m_meshArena.set = false;
 
     attributeBindings.fill(0);
 
@@ -153,6 +193,7 @@ void RenderState::invalidateHandles() {
         std::lock_guard<std::mutex> guard(m_deletionListMutex);
         m_VAODeletionList.clear();
         m_textureDeletionList.clear();
+        m_texturePool.clear();
         m_bufferDeletionList.clear();
         m_framebufferDeletionList.clear();
         m_programDeletionList.clear();
@@ -196,6 +237,7 @@ inline void setGlFlag(GLenum flag, GLboolean enable) {
 bool RenderState::blending(GLboolean enable) {
     if (!m_blending.set || m_blending.enabled != enable) {
         m_blending = { enable, true };
+        m_frameStats.stateChanges++;
         setGlFlag(GL_BLEND, enable);
         return false;
     }
@@ -205,6 +247,7 @@ bool RenderState::blending(GLboolean enable) {
 bool RenderState::blendingFunc(GLenum sfactor, GLenum dfactor) {
     if (!m_blendingFunc.set || m_blendingFunc.sfactor != sfactor || m_blendingFunc.dfactor != dfactor) {
         m_blendingFunc = { sfactor, dfactor, true };
+        m_frameStats.stateChanges++;
         GL::blendFunc(sfactor, dfactor);
         return false;
     }
@@ -228,6 +271,7 @@ void RenderState::defaultOpaqueClearColor(GLclampf r, GLclampf g, GLclampf b) {
 bool RenderState::clearColor(GLclampf r, GLclampf g, GLclampf b, GLclampf a) {
     if (!m_clearColor.set || m_clearColor.r != r || m_clearColor.g != g || m_clearColor.b != b || m_clearColor.a != a) {
         m_clearColor = { r, g, b, a, true };
+        m_frameStats.stateChanges++;
         GL::clearColor(r, g, b, a);
         return false;
     }
@@ -237,6 +281,7 @@ bool RenderState::clearColor(GLclampf r, GLclampf g, GLclampf b, GLclampf a) {
 bool RenderState::colorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a) {
     if (!m_colorMask.set || m_colorMask.r != r || m_colorMask.g != g || m_colorMask.b != b || m_colorMask.a != a) {
         m_colorMask = { r, g, b, a, true };
+        m_frameStats.stateChanges++;
         GL::colorMask(r, g, b, a);
         return false;
     }
@@ -246,6 +291,7 @@ bool RenderState::colorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
 bool RenderState::cullFace(GLenum face) {
     if (!m_cullFace.set || m_cullFace.face != face) {
         m_cullFace = { face, true };
+        m_frameStats.stateChanges++;
         GL::cullFace(face);
         return false;
     }
@@ -255,6 +301,7 @@ bool RenderState::cullFace(GLenum face) {
 bool RenderState::culling(GLboolean enable) {
     if (!m_culling.set || m_culling.enabled != enable) {
         m_culling = { enable, true };
+        m_frameStats.stateChanges++;
         setGlFlag(GL_CULL_FACE, enable);
         return false;
     }
@@ -264,6 +311,7 @@ bool RenderState::culling(GLboolean enable) {
 bool RenderState::depthTest(GLboolean enable) {
     if (!m_depthTest.set || m_depthTest.enabled != enable) {
         m_depthTest = { enable, true };
+        m_frameStats.stateChanges++;
         setGlFlag(GL_DEPTH_TEST, enable);
         return false;
     }
@@ -273,6 +321,7 @@ bool RenderState::depthTest(GLboolean enable) {
 bool RenderState::depthMask(GLboolean enable) {
     if (!m_depthMask.set || m_depthMask.enabled != enable) {
         m_depthMask = { enable, true };
+        m_frameStats.stateChanges++;
         GL::depthMask(enable);
         return false;
     }
@@ -282,6 +331,7 @@ bool RenderState::depthMask(GLboolean enable) {
 bool RenderState::frontFace(GLenum face) {
     if (!m_frontFace.set || m_frontFace.face != face) {
         m_frontFace = { face, true };
+        m_frameStats.stateChanges++;
         GL::frontFace(face);
         return false;
     }
@@ -291,6 +341,7 @@ bool RenderState::frontFace(GLenum face) {
 bool RenderState::stencilMask(GLuint mask) {
     if (!m_stencilMask.set || m_stencilMask.mask != mask) {
         m_stencilMask = { mask, true };
+        m_frameStats.stateChanges++;
         GL::stencilMask(mask);
         return false;
     }
@@ -300,6 +351,7 @@ bool RenderState::stencilMask(GLuint mask) {
 bool RenderState::stencilFunc(GLenum func, GLint ref, GLuint mask) {
     if (!m_stencilFunc.set || m_stencilFunc.func != func || m_stencilFunc.ref != ref || m_stencilFunc.mask != mask) {
         m_stencilFunc = { func, ref, mask, true };
+        m_frameStats.stateChanges++;
         GL::stencilFunc(func, ref, mask);
         return false;
     }
@@ -309,6 +361,7 @@ bool RenderState::stencilFunc(GLenum func, GLint ref, GLuint mask) {
 bool RenderState::stencilOp(GLenum sfail, GLenum spassdfail, GLenum spassdpass) {
     if (!m_stencilOp.set || m_stencilOp.sfail != sfail || m_stencilOp.spassdfail != spassdfail || m_stencilOp.spassdpass != spassdpass) {
         m_stencilOp = { sfail, spassdfail, spassdpass, true };
+        m_frameStats.stateChanges++;
         GL::stencilOp(sfail, spassdfail, spassdpass);
         return false;
     }
@@ -318,6 +371,7 @@ bool RenderState::stencilOp(GLenum sfail, GLenum spassdfail, GLenum spassdpass)
 bool RenderState::stencilTest(GLboolean enable) {
     if (!m_stencilTest.set || m_stencilTest.enabled != enable) {
         m_stencilTest = { enable, true };
+        m_frameStats.stateChanges++;
         setGlFlag(GL_STENCIL_TEST, enable);
         return false;
     }
@@ -327,6 +381,7 @@ bool RenderState::stencilTest(GLboolean enable) {
 bool RenderState::shaderProgram(GLuint program) {
     if (!m_program.set || m_program.program != program) {
         m_program = { program, true };
+        m_frameStats.stateChanges++;
         GL::useProgram(program);
         return false;
     }
@@ -336,12 +391,14 @@ bool RenderState::shaderProgram(GLuint program) {
 void RenderState::texture(GLuint handle, GLuint unit, GLenum target) {
     if (!m_textureUnit.set || m_textureUnit.unit != unit) {
         m_textureUnit = { unit, true };
+        m_frameStats.stateChanges++;
         // Our cached texture handle is irrelevant on the new unit, so unset it.
         m_texture.set = false;
         GL::activeTexture(getTextureUnit(unit));
     }
     if (!m_texture.set || m_texture.target != target || m_texture.handle != handle) {
         m_texture = { target, handle, true };
+        m_frameStats.stateChanges++;
         GL::bindTexture(target, handle);
     }
 }
@@ -349,6 +406,7 @@ void RenderState::texture(GLuint handle, GLuint unit, GLenum target) {
 bool RenderState::vertexBuffer(GLuint handle) {
     if (!m_vertexBuffer.set || m_vertexBuffer.handle != handle) {
         m_vertexBuffer = { handle, true };
+        m_frameStats.stateChanges++;
         GL::bindBuffer(GL_ARRAY_BUFFER, handle);
         return false;
     }
@@ -358,6 +416,7 @@ bool RenderState::vertexBuffer(GLuint handle) {
 bool RenderState::indexBuffer(GLuint handle) {
     if (!m_indexBuffer.set || m_indexBuffer.handle != handle) {
         m_indexBuffer = { handle, true };
+        m_frameStats.stateChanges++;
         GL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle);
         return false;
     }
@@ -407,6 +466,7 @@ void RenderState::generateQuadIndexBuffer() {
 bool RenderState::framebuffer(GLuint handle) {
     if (!m_framebuffer.set || m_framebuffer.handle != handle) {
         m_framebuffer = { handle, true };
+        m_frameStats.stateChanges++;
         GL::bindFramebuffer(GL_FRAMEBUFFER, handle);
         return false;
     }
@@ -417,12 +477,25 @@ bool RenderState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
     if (!m_viewport.set || m_viewport.x != x || m_viewport.y != y
       || m_viewport.width != width || m_viewport.height != height) {
         m_viewport = { x, y, width, height, true };
+        m_frameStats.stateChanges++;
         GL::viewport(x, y, width, height);
         return false;
     }
     return true;
 }
 
+bool RenderState::meshArena(GLuint handle, GLuint program) {
+    if (!m_meshArena.set || m_meshArena.handle != handle || m_meshArena.program != program) {
+        m_meshArena = { handle, program, true };
+        return false;
+    }
+    return true;
+}
+
+void RenderState::meshArenaUnset() {
+    m_meshArena.set = false;
+}
+
 GLuint RenderState::defaultFrameBuffer() const {
     return (GLuint)m_defaultFramebuffer;
 }
@@ -2,6 +2,8 @@
 
 #include "gl.h"
 #include <array>
+#include <limits>
+#include <memory>
 #include <string>
 #include <mutex>
 #include <vector>
@@ -10,6 +12,7 @@
 namespace Tangram {
 
 class Disposer;
+class ProgramBinaryCache;
 class Texture;
 
 class RenderState {
@@ -20,6 +23,37 @@ public:
 
     static constexpr size_t MAX_QUAD_VERTICES = 16384;
 
+    // Maximum number of released texture objects kept for reuse
+    static constexpr size_t MAX_POOLED_TEXTURES = 32;
+
+    // Size, format and sampling options of a texture object.
+    // Pooled texture objects are only reused for textures with equal keys.
+    struct TextureKey {
+        GLsizei width = 0;
+        GLsizei height = 0;
+        GLenum format = 0;
+        bool mipmaps = false;
+        GLenum minFilter = 0;
+        GLenum magFilter = 0;
+        GLenum wrapS = 0;
+        GLenum wrapT = 0;
+
+        bool operator==(const TextureKey& _other) const {
+            return width == _other.width && height == _other.height &&
+                format == _other.format && mipmaps == _other.mipmaps &&
+                minFilter == _other.minFilter && magFilter == _other.magFilter &&
+                wrapS == _other.wrapS && wrapT == _other.wrapT;
+        }
+    };
+
+    struct FrameStats {
+        uint32_t drawCalls = 0;
+        // GL state and uniform changes
+        uint32_t stateChanges = 0;
+        // Meshes left incomplete for lack of upload budget
+        uint32_t pendingUploads = 0;
+    };
+
     RenderState();
     ~RenderState();
 
@@ -96,6 +130,12 @@ public:
 
     bool framebuffer(GLuint handle);
 
+    // Track the <MeshArena> whose vertex attributes are set up for a program,
+    // returns true when they already are.
+    bool meshArena(GLuint handle, GLuint program);
+
+    void meshArenaUnset();
+
     bool viewport(GLint x, GLint y, GLsizei width, GLsizei height);
 
     void indexBufferUnset(GLuint handle);
@@ -118,11 +158,40 @@ public:
 
     void queueProgramDeletion(GLuint program);
 
+    // Take a released texture object with storage and parameters matching @_key,
+    // returns 0 when none is pooled.
+    GLuint acquireTexture(const TextureKey& _key);
+
+    // Keep a texture object for reuse by a texture with the same key. When the
+    // pool is full the oldest texture object is deleted. Thread-safe.
+    void releaseTexture(GLuint _texture, const TextureKey& _key);
+
+    size_t pooledTextures();
+
+    // Count a draw call in the statistics of the current frame.
+    void countDrawCall() { m_frameStats.drawCalls++; }
+
+    // Count a GL state change done outside of the RenderState.
+    void countStateChange() { m_frameStats.stateChanges++; }
+
+    void countPendingUpload() { m_frameStats.pendingUploads++; }
+
+    const FrameStats& frameStats() const { return m_frameStats; }
+
+    void resetFrameStats() { m_frameStats = FrameStats(); }
+
     std::array<GLuint, MAX_ATTRIBUTES> attributeBindings = { { 0 } };
 
+    // Bytes left for uploading meshes while drawing this frame, the rest of
+    // the frame budget of the UploadScheduler
+    size_t uploadBudget = std::numeric_limits<size_t>::max();
+
     std::unordered_map<std::string, GLuint> fragmentShaders;
     std::unordered_map<std::string, GLuint> vertexShaders;
 
+    // Optional cache of linked programs, used by ShaderProgram::build()
+    std::shared_ptr<ProgramBinaryCache> programBinaryCache;
+
 private:
 
     std::mutex m_deletionListMutex;
@@ -133,6 +202,9 @@ private:
     std::vector<GLuint> m_shaderDeletionList;
     std::vector<GLuint> m_framebufferDeletionList;
 
+    // Released texture objects, oldest first. Guarded by m_deletionListMutex.
+    std::vector<std::pair<TextureKey, GLuint>> m_texturePool;
+
     uint32_t m_nextTextureUnit = 0;
 
     GLuint m_quadIndexBuffer = 0;
@@ -207,6 +279,12 @@ private:
         bool set;
     } m_textureUnit;
 
+    struct {
+        GLuint handle;
+        GLuint program;
+        bool set;
+    } m_meshArena;
+
     struct FrameBufferState {
         GLuint handle;
         bool set;
@@ -222,6 +300,8 @@ private:
 
     GLint m_defaultFramebuffer = 0;
 
+    FrameStats m_frameStats;
+
 };
 
 }
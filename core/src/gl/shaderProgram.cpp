@@ -1,6 +1,7 @@
 #include "gl/shaderProgram.h"
 
 #include "gl/glError.h"
+#include "gl/programBinaryCache.h"
 #include "gl/renderState.h"
 #include "glm/gtc/type_ptr.hpp"
 #include "scene/light.h"
@@ -86,6 +87,17 @@ bool ShaderProgram::build(RenderState& rs) {
     auto& vertSrc = m_vertexShaderSource;
     auto& fragSrc = m_fragmentShaderSource;
 
+    // Skip compiling when the driver accepts a binary of an earlier build
+    if (rs.programBinaryCache) {
+        GLuint program = rs.programBinaryCache->loadProgram(vertSrc, fragSrc);
+        if (program != 0) {
+            m_glProgram = program;
+            m_attribMap.clear();
+            m_rs = &rs;
+            return true;
+        }
+    }
+
     // Compile vertex and fragment shaders
     GLint vertexShader = makeCompiledShader(rs, vertSrc, GL_VERTEX_SHADER);
     if (vertexShader == 0) {
@@ -110,6 +122,10 @@ bool ShaderProgram::build(RenderState& rs) {
     m_glFragmentShader = fragmentShader;
     m_glVertexShader = vertexShader;
 
+    if (rs.programBinaryCache) {
+        rs.programBinaryCache->storeProgram(program, vertSrc, fragSrc);
+    }
+
     // Clear any cached shader locations
     m_attribMap.clear();
     m_rs = &rs;
@@ -350,6 +366,15 @@ void ShaderProgram::setUniformf(RenderState& rs, const UniformLocation& _loc, co
     }
 }
 
+void ShaderProgram::setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray4f& _value) {
+    if (!use(rs)) { return; }
+    GLint location = getUniformLocation(_loc);
+    if (location >= 0) {
+        bool cached = getFromCache(location, _value);
+        if (!cached) { GL::uniform4fv(location, _value.size(), (float*)_value.data()); }
+    }
+}
+
 void ShaderProgram::setUniformi(RenderState& rs, const UniformLocation& _loc, const UniformTextureArray& _value) {
     if (!use(rs)) { return; }
     GLint location = getUniformLocation(_loc);
@@ -74,6 +74,7 @@ public:
     void setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray1f& _value);
     void setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray2f& _value);
     void setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray3f& _value);
+    void setUniformf(RenderState& rs, const UniformLocation& _loc, const UniformArray4f& _value);
     void setUniformi(RenderState& rs, const UniformLocation& _loc, const UniformTextureArray& _value);
 
     // Ensure the program is bound and then set the named uniform to the values
@@ -87,8 +88,8 @@ public:
     static GLuint makeLinkedShaderProgram(GLint _fragShader, GLint _vertShader);
     static GLuint makeCompiledShader(RenderState& rs, const std::string& _src, GLenum _type);
 
-    const std::string& vertexShaderSource() { return m_vertexShaderSource; }
-    const std::string& fragmentShaderSource() { return m_fragmentShaderSource; }
+    const std::string& vertexShaderSource() const { return m_vertexShaderSource; }
+    const std::string& fragmentShaderSource() const { return m_fragmentShaderSource; }
 
 private:
 
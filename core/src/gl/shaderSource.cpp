@@ -137,7 +137,8 @@ void ShaderSource::addExtensionDeclaration(const std::string& _extension) {
 }
 
 std::string ShaderSource::buildSelectionFragmentSource() const {
-    return selection_fs;
+    // Only the 'defines' pragma is used, for the vertex format of the style
+    return applySourceBlocks(selection_fs, true, true);
 }
 
 }
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "gl/mesh.h"
+#include "gl/glError.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+/* Quads which are uploaded once and drawn group by group
+ *
+ * Quads are added in increasing group order and drawn with the shared quad
+ * index buffer of RenderState. A draw covers a range of consecutive groups,
+ * between two draws the caller can change uniforms which apply to the quads
+ * of the next range, e.g. the screen positions of the label slots in
+ * TextLabels' static meshes.
+ */
+template<class T>
+class StaticQuadMesh : protected MeshBase {
+
+public:
+
+    StaticQuadMesh(std::shared_ptr<VertexLayout> _vertexLayout)
+        : MeshBase(_vertexLayout, GL_TRIANGLES, GL_STATIC_DRAW) {}
+
+    // Reserves space for one quad of @_group and returns pointer
+    // into m_vertices to write into 4 vertices.
+    T* pushQuad(size_t _group) {
+        assert(m_groupStart.size() <= _group + 2);
+
+        if (m_groupStart.empty()) { m_groupStart.push_back(0); }
+
+        // Close the groups before @_group
+        while (m_groupStart.size() < _group + 2) {
+            m_groupStart.push_back(m_vertices.size());
+        }
+
+        m_vertices.insert(m_vertices.end(), 4, {});
+        m_groupStart.back() = m_vertices.size();
+
+        return &m_vertices[m_vertices.size() - 4];
+    }
+
+    // Hand the vertices over for upload, no quads can be added afterwards
+    void compile() {
+        m_nVertices = m_vertices.size();
+
+        size_t bytes = m_nVertices * m_vertexLayout->getStride();
+        m_glVertexData = new GLbyte[bytes];
+        std::memcpy(m_glVertexData, m_vertices.data(), bytes);
+
+        m_vertices.clear();
+        m_vertices.shrink_to_fit();
+
+        m_isCompiled = true;
+    }
+
+    size_t groupCount() const {
+        return m_groupStart.empty() ? 0 : m_groupStart.size() - 1;
+    }
+
+    // Number of vertices in the groups from @_first up to @_end
+    size_t vertexCount(size_t _first, size_t _end) const {
+        _end = std::min(_end, groupCount());
+        if (_first >= _end) { return 0; }
+        return m_groupStart[_end] - m_groupStart[_first];
+    }
+
+    bool hasQuads(size_t _first, size_t _end) const { return vertexCount(_first, _end) > 0; }
+
+    // Draw the quads of the groups from @_first up to @_end
+    bool drawGroups(RenderState& rs, ShaderProgram& _shader, size_t _first, size_t _end);
+
+    bool needsUpload() const { return MeshBase::needsUpload(); }
+
+    bool isUploaded() const { return m_isUploaded; }
+
+    size_t upload(RenderState& rs, size_t _maxBytes) { return MeshBase::upload(rs, _maxBytes); }
+
+    size_t bufferSize() const { return MeshBase::bufferSize(); }
+
+private:
+
+    std::vector<T> m_vertices;
+
+    // First vertex of each group, followed by the number of vertices
+    std::vector<size_t> m_groupStart;
+};
+
+template<class T>
+bool StaticQuadMesh<T>::drawGroups(RenderState& rs, ShaderProgram& _shader, size_t _first, size_t _end) {
+
+    if (!hasQuads(_first, _end)) { return false; }
+
+    if (!m_isUploaded) {
+        if (!m_isCompiled) { return false; }
+        MeshBase::upload(rs);
+    }
+
+    // Enable shader program
+    if (!_shader.use(rs)) { return false; }
+
+    const size_t verticesIndexed = RenderState::MAX_QUAD_VERTICES;
+    size_t vertexPos = m_groupStart[_first];
+    const size_t vertexRangeEnd = vertexPos + vertexCount(_first, _end);
+
+    rs.vertexBuffer(m_glVertexBuffer);
+    rs.indexBuffer(rs.getQuadIndexBuffer());
+
+    // Draw vertices in batches until the end of the group range.
+    while (vertexPos < vertexRangeEnd) {
+
+        // Determine the largest batch of vertices we can draw at once,
+        // limited by the max index value.
+        size_t verticesInBatch = std::min(vertexRangeEnd - vertexPos, verticesIndexed);
+
+        size_t byteOffset = vertexPos * m_vertexLayout->getStride();
+        m_vertexLayout->enable(rs, _shader, byteOffset);
+
+        size_t elementsInBatch = verticesInBatch * 6 / 4;
+        GL::drawElements(m_drawMode, elementsInBatch, GL_UNSIGNED_SHORT, 0);
+
+        // Update counters.
+        vertexPos += verticesInBatch;
+    }
+
+    return true;
+}
+
+}
@@ -117,7 +117,7 @@ bool Texture::upload(RenderState& _rs, GLuint _textureUnit) {
     if (Hardware::maxTextureSize < m_width ||
         Hardware::maxTextureSize < m_height) {
         LOGW("Texture larger than Hardware maximum texture size");
-        if (m_disposeBuffer) { m_buffer.reset(); }
+        if (m_disposeBuffer) { disposeBuffer(); }
         return false;
     }
     if (m_glHandle == 0) {
@@ -147,7 +147,7 @@ bool Texture::bind(RenderState& _rs, GLuint _textureUnit) {
 
     bool ok = upload(_rs, _textureUnit);
 
-    if (m_disposeBuffer) { m_buffer.reset(); }
+    if (m_disposeBuffer) { disposeBuffer(); }
 
     return ok;
 }
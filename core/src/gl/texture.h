@@ -75,6 +75,18 @@ public:
     // Size of texture data in bytes
     size_t bufferSize() const { return m_bufferSize; }
 
+    // Whether texture data was uploaded to GPU memory
+    bool isUploaded() const { return m_glHandle != 0; }
+
+    // Whether texture data is waiting to be uploaded on the next bind
+    bool needsUpload() const { return m_shouldResize; }
+
+    // Whether texture data is held in client memory
+    bool hasBufferData() const { return bool(m_buffer); }
+
+    // Pixel data held in client memory, null once it was released
+    const GLubyte* bufferData() const { return m_buffer.get(); }
+
     float displayScale() const { return m_options.displayScale; }
 
     const auto& spriteAtlas() const { return m_spriteAtlas; }
@@ -90,7 +102,10 @@ protected:
 
     void generate(RenderState& rs, GLuint _textureUnit);
 
-    bool upload(RenderState& rs, GLuint _textureUnit);
+    virtual bool upload(RenderState& rs, GLuint _textureUnit);
+
+    // Release the client side pixel data
+    virtual void disposeBuffer() { m_buffer.reset(); }
 
     bool sanityCheck(size_t _width, size_t _height, size_t _bytesPerPixel, size_t _length) const;
 
@@ -74,6 +74,9 @@ void VertexLayout::enable(RenderState& rs, ShaderProgram& _program, size_t _byte
 
     GLuint glProgram = _program.getGlProgram();
 
+    // Attributes of the currently set up mesh arena are replaced
+    rs.meshArenaUnset();
+
     // Enable all attributes for this layout
     for (auto& attrib : m_attribs) {
 
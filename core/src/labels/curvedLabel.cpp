@@ -1,6 +1,7 @@
 #include "labels/curvedLabel.h"
 
 #include "gl/dynamicQuadMesh.h"
+#include "labels/labelProjection.h"
 #include "labels/obbBuffer.h"
 #include "labels/screenTransform.h"
 #include "log.h"
@@ -36,9 +37,37 @@ void CurvedLabel::applyAnchor(LabelProperty::Anchor _anchor) {
     m_anchor = LabelProperty::anchorDirection(_anchor) * offset * 0.5f;
 }
 
+bool CurvedLabel::anchors(LabelAnchors& _anchors) const {
+    for (auto& p : m_modelTransform) {
+        _anchors.push_back(p);
+    }
+    return true;
+}
+
 bool CurvedLabel::updateScreenTransform(const glm::mat4& _mvp, const ViewState& _viewState,
                                         const AABB* _bounds, ScreenTransform& _transform) {
 
+    return updateCurve([&](size_t _point, bool& _clipped) {
+            return worldToScreenSpace(_mvp, glm::vec4(m_modelTransform[_point], 0.0, 1.0),
+                                      _viewState.viewportSize, _clipped);
+        }, _viewState, _transform);
+}
+
+bool CurvedLabel::updateProjectedTransform(const AnchorProjection& _projection, const ViewState& _viewState,
+                                           const AABB* _bounds, ScreenTransform& _transform) {
+
+    return updateCurve([&](size_t _point, bool& _clipped) {
+            if (_projection.clipped(_point)) {
+                _clipped = true;
+                return glm::vec2{};
+            }
+            return _projection.position(_point);
+        }, _viewState, _transform);
+}
+
+template<typename Project>
+bool CurvedLabel::updateCurve(Project _project, const ViewState& _viewState, ScreenTransform& _transform) {
+
     glm::vec2 min(-m_dim.y);
     glm::vec2 max(_viewState.viewportSize + m_dim.y);
 
@@ -47,9 +76,8 @@ bool CurvedLabel::updateScreenTransform(const glm::mat4& _mvp, const ViewState&
 
     LineSampler<ScreenTransform> sampler { _transform };
 
-    for (auto& p : m_modelTransform) {
-        glm::vec2 sp = worldToScreenSpace(_mvp, glm::vec4(p, 0.0, 1.0),
-                                          _viewState.viewportSize, clipped);
+    for (size_t i = 0; i < m_modelTransform.size(); i++) {
+        glm::vec2 sp = _project(i, clipped);
 
         if (clipped) { return false; }
 
@@ -207,9 +235,9 @@ void CurvedLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
         uint16_t(m_fontAttrib.fontScale),
     };
 
-    auto it = m_textLabels.quads.begin() + m_textRanges[m_textRangeIndex].start;
+    auto it = m_textLabels->quads.begin() + m_textRanges[m_textRangeIndex].start;
     auto end = it + m_textRanges[m_textRangeIndex].length;
-    auto& style = m_textLabels.style;
+    auto& style = m_textLabels->style;
 
     auto& meshes = style.getMeshes();
 
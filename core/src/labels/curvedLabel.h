@@ -41,6 +41,11 @@ public:
     bool updateScreenTransform(const glm::mat4& _mvp, const ViewState& _viewState,
                                const AABB* _bounds, ScreenTransform& _transform) override;
 
+    bool anchors(LabelAnchors& _anchors) const override;
+
+    bool updateProjectedTransform(const AnchorProjection& _projection, const ViewState& _viewState,
+                                  const AABB* _bounds, ScreenTransform& _transform) override;
+
     void obbs(ScreenTransform& _transform, OBBBuffer& _obbs) override;
 
     void addVerticesToMesh(ScreenTransform& _transform, const glm::vec2& _screenSize) override;
@@ -57,6 +62,10 @@ public:
 
 protected:
 
+    // Compute the screen transform from points given by @_project(index, clipped)
+    template<typename Project>
+    bool updateCurve(Project _project, const ViewState& _viewState, ScreenTransform& _transform);
+
     const std::vector<glm::vec2> m_modelTransform;
 
     const size_t m_anchorPoint;
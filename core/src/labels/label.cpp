@@ -128,8 +128,7 @@ bool Label::setAnchorIndex(int _index) {
 bool Label::update(const glm::mat4& _mvp, const ViewState& _viewState,
                    const AABB* _bounds, ScreenTransform& _transform) {
 
-    m_occludedLastFrame = m_occluded;
-    m_occluded = false;
+    resetOcclusion();
 
     bool valid = updateScreenTransform(_mvp, _viewState, _bounds, _transform);
     if (!valid) {
@@ -140,6 +139,20 @@ bool Label::update(const glm::mat4& _mvp, const ViewState& _viewState,
     return true;
 }
 
+bool Label::update(const AnchorProjection& _projection, const ViewState& _viewState,
+                   const AABB* _bounds, ScreenTransform& _transform) {
+
+    resetOcclusion();
+
+    bool valid = updateProjectedTransform(_projection, _viewState, _bounds, _transform);
+    if (!valid) {
+        enterState(State::sleep, 0.0);
+        return false;
+    }
+
+    return true;
+}
+
 bool Label::evalState(float _dt) {
 
 #ifdef DEBUG
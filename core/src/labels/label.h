@@ -18,6 +18,8 @@
 
 namespace Tangram {
 
+struct AnchorProjection;
+struct LabelAnchors;
 struct ScreenTransform;
 struct ViewState;
 struct OBBBuffer;
@@ -96,10 +98,28 @@ public:
 
     bool evalState(float _dt);
 
+    // Begin a new placement, keeping the screen transform of the last update()
+    void resetOcclusion() {
+        m_occludedLastFrame = m_occluded;
+        m_occluded = false;
+    }
+
     // Update the screen position of the label
     virtual bool updateScreenTransform(const glm::mat4& _mvp, const ViewState& _viewState,
                                        const AABB* _bounds, ScreenTransform& _transform) = 0;
 
+    /* Add the world positions from which the screen position is derived to @_anchors,
+     * so that they can be projected in a batch with the anchors of other labels.
+     * Returns false when the label only supports updateScreenTransform(). */
+    virtual bool anchors(LabelAnchors& _anchors) const { return false; }
+
+    // Update the screen position of the label from its projected anchors
+    virtual bool updateProjectedTransform(const AnchorProjection& _projection, const ViewState& _viewState,
+                                          const AABB* _bounds, ScreenTransform& _transform) { return false; }
+
+    bool update(const AnchorProjection& _projection, const ViewState& _viewState,
+                const AABB* _bounds, ScreenTransform& _transform);
+
     // Current screen position of the label anchor
     glm::vec2 screenCenter() const { return m_screenCenter; }
 
@@ -0,0 +1,84 @@
+#include "labels/labelProjection.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define LABEL_PROJECTION_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define LABEL_PROJECTION_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Tangram {
+
+void projectAnchorsScalar(const glm::mat4& _mvp, const glm::vec2& _screenSize,
+                          const LabelAnchors& _anchors, ProjectedAnchors& _projected,
+                          size_t _start, size_t _end) {
+
+    for (size_t i = _start; i < _end; i++) {
+        projectAnchor(_mvp, _screenSize, { _anchors.x[i], _anchors.y[i] },
+                      _projected.x[i], _projected.y[i], _projected.w[i]);
+    }
+}
+
+void projectAnchors(const glm::mat4& _mvp, const glm::vec2& _screenSize,
+                    const LabelAnchors& _anchors, ProjectedAnchors& _projected) {
+
+    size_t count = _anchors.size();
+    _projected.resize(count);
+
+    size_t i = 0;
+
+    // Four anchors per iteration. Operations are done in the same order as
+    // in projectAnchor() so that results do not depend on the code path.
+#if defined(LABEL_PROJECTION_SSE)
+    const __m128 m00 = _mm_set1_ps(_mvp[0][0]), m10 = _mm_set1_ps(_mvp[1][0]), m30 = _mm_set1_ps(_mvp[3][0]);
+    const __m128 m01 = _mm_set1_ps(_mvp[0][1]), m11 = _mm_set1_ps(_mvp[1][1]), m31 = _mm_set1_ps(_mvp[3][1]);
+    const __m128 m03 = _mm_set1_ps(_mvp[0][3]), m13 = _mm_set1_ps(_mvp[1][3]), m33 = _mm_set1_ps(_mvp[3][3]);
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 halfX = _mm_set1_ps(_screenSize.x * 0.5f);
+    const __m128 halfY = _mm_set1_ps(_screenSize.y * 0.5f);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(&_anchors.x[i]);
+        __m128 y = _mm_loadu_ps(&_anchors.y[i]);
+
+        __m128 cx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m10, y)), m30);
+        __m128 cy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, x), _mm_mul_ps(m11, y)), m31);
+        __m128 cw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m03, x), _mm_mul_ps(m13, y)), m33);
+
+        __m128 sx = _mm_mul_ps(_mm_add_ps(_mm_div_ps(cx, cw), one), halfX);
+        __m128 sy = _mm_mul_ps(_mm_sub_ps(one, _mm_div_ps(cy, cw)), halfY);
+
+        _mm_storeu_ps(&_projected.x[i], sx);
+        _mm_storeu_ps(&_projected.y[i], sy);
+        _mm_storeu_ps(&_projected.w[i], cw);
+    }
+#elif defined(LABEL_PROJECTION_NEON)
+    const float32x4_t m00 = vdupq_n_f32(_mvp[0][0]), m10 = vdupq_n_f32(_mvp[1][0]), m30 = vdupq_n_f32(_mvp[3][0]);
+    const float32x4_t m01 = vdupq_n_f32(_mvp[0][1]), m11 = vdupq_n_f32(_mvp[1][1]), m31 = vdupq_n_f32(_mvp[3][1]);
+    const float32x4_t m03 = vdupq_n_f32(_mvp[0][3]), m13 = vdupq_n_f32(_mvp[1][3]), m33 = vdupq_n_f32(_mvp[3][3]);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t halfX = vdupq_n_f32(_screenSize.x * 0.5f);
+    const float32x4_t halfY = vdupq_n_f32(_screenSize.y * 0.5f);
+
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vld1q_f32(&_anchors.x[i]);
+        float32x4_t y = vld1q_f32(&_anchors.y[i]);
+
+        float32x4_t cx = vaddq_f32(vaddq_f32(vmulq_f32(m00, x), vmulq_f32(m10, y)), m30);
+        float32x4_t cy = vaddq_f32(vaddq_f32(vmulq_f32(m01, x), vmulq_f32(m11, y)), m31);
+        float32x4_t cw = vaddq_f32(vaddq_f32(vmulq_f32(m03, x), vmulq_f32(m13, y)), m33);
+
+        float32x4_t sx = vmulq_f32(vaddq_f32(vdivq_f32(cx, cw), one), halfX);
+        float32x4_t sy = vmulq_f32(vsubq_f32(one, vdivq_f32(cy, cw)), halfY);
+
+        vst1q_f32(&_projected.x[i], sx);
+        vst1q_f32(&_projected.y[i], sy);
+        vst1q_f32(&_projected.w[i], cw);
+    }
+#endif
+
+    projectAnchorsScalar(_mvp, _screenSize, _anchors, _projected, i, count);
+}
+
+}
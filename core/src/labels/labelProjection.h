@@ -0,0 +1,92 @@
+#pragma once
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec2.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+/* World positions of label anchors in structure-of-arrays layout
+ *
+ * Labels add the positions from which their screen transform is derived,
+ * so that the anchors of all labels of a LabelSet can be projected in one
+ * batch instead of one matrix product per label.
+ */
+struct LabelAnchors {
+    std::vector<float> x;
+    std::vector<float> y;
+
+    // First anchor of each label, -1 for labels that project themselves
+    std::vector<int32_t> offsets;
+
+    void push_back(const glm::vec2& _position) {
+        x.push_back(_position.x);
+        y.push_back(_position.y);
+    }
+
+    size_t size() const { return x.size(); }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        offsets.clear();
+    }
+};
+
+/* Screen positions of projected anchors and the w coordinate of their clip
+ * space position. Anchors with w <= 0 are behind the camera. */
+struct ProjectedAnchors {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> w;
+
+    void resize(size_t _size) {
+        x.resize(_size);
+        y.resize(_size);
+        w.resize(_size);
+    }
+};
+
+/* View on the projected anchors of one label */
+struct AnchorProjection {
+    const float* x;
+    const float* y;
+    const float* w;
+
+    AnchorProjection(const float* _x, const float* _y, const float* _w)
+        : x(_x), y(_y), w(_w) {}
+
+    AnchorProjection(const ProjectedAnchors& _projected, size_t _offset)
+        : x(&_projected.x[_offset]), y(&_projected.y[_offset]), w(&_projected.w[_offset]) {}
+
+    glm::vec2 position(size_t _i) const { return { x[_i], y[_i] }; }
+
+    bool clipped(size_t _i) const { return w[_i] <= 0.f; }
+};
+
+/* Project a single anchor at z = 0 by @_mvp to screen coordinates of @_screenSize.
+ * Gives the same result as worldToScreenSpace(). */
+inline void projectAnchor(const glm::mat4& _mvp, const glm::vec2& _screenSize, const glm::vec2& _position,
+                          float& _x, float& _y, float& _w) {
+
+    float cx = _mvp[0][0] * _position.x + _mvp[1][0] * _position.y + _mvp[3][0];
+    float cy = _mvp[0][1] * _position.x + _mvp[1][1] * _position.y + _mvp[3][1];
+    float cw = _mvp[0][3] * _position.x + _mvp[1][3] * _position.y + _mvp[3][3];
+
+    _x = (cx / cw + 1.f) * (_screenSize.x * 0.5f);
+    _y = (1.f - cy / cw) * (_screenSize.y * 0.5f);
+    _w = cw;
+}
+
+/* Project all @_anchors, using SSE or NEON when available */
+void projectAnchors(const glm::mat4& _mvp, const glm::vec2& _screenSize,
+                    const LabelAnchors& _anchors, ProjectedAnchors& _projected);
+
+/* Project anchors [@_start, @_end) one at a time */
+void projectAnchorsScalar(const glm::mat4& _mvp, const glm::vec2& _screenSize,
+                          const LabelAnchors& _anchors, ProjectedAnchors& _projected,
+                          size_t _start, size_t _end);
+
+}
@@ -18,6 +18,23 @@ void LabelSet::setLabels(std::vector<std::unique_ptr<Label>>& _labels) {
                     std::move_iterator<iter_t>(_labels.end()));
 
     _labels.clear();
+
+    m_anchors.clear();
+    m_hasAnchors = false;
+}
+
+const LabelAnchors& LabelSet::anchors() const {
+    if (m_hasAnchors) { return m_anchors; }
+
+    m_anchors.offsets.reserve(m_labels.size());
+
+    for (auto& label : m_labels) {
+        int32_t offset = m_anchors.size();
+        m_anchors.offsets.push_back(label->anchors(m_anchors) ? offset : -1);
+    }
+    m_hasAnchors = true;
+
+    return m_anchors;
 }
 
 }
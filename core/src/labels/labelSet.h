@@ -1,6 +1,7 @@
 #pragma once
 
 #include "labels/label.h"
+#include "labels/labelProjection.h"
 #include "style/style.h"
 
 #include <vector>
@@ -24,8 +25,15 @@ public:
 
     void reset();
 
+    /* Anchors of all labels for batch projection, built on first use.
+     * Labels must not be added afterwards. */
+    const LabelAnchors& anchors() const;
+
 protected:
     std::vector<std::unique_ptr<Label>> m_labels;
+
+    mutable LabelAnchors m_anchors;
+    mutable bool m_hasAnchors = false;
 };
 
 }
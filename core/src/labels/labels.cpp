@@ -17,6 +17,7 @@
 #include "tile/tile.h"
 #include "tile/tileCache.h"
 #include "tile/tileManager.h"
+#include "util/asyncWorker.h"
 #include "view/view.h"
 
 #include "glm/glm.hpp"
@@ -24,10 +25,62 @@
 #include "glm/gtx/rotate_vector.hpp"
 #include "glm/gtx/norm.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <thread>
 
 namespace Tangram {
 
+// Number of labels from which screen transforms are computed in parallel
+static const size_t PARALLEL_TRANSFORMS_MIN_LABELS = 512;
+
+// Threads helping the main thread to compute screen transforms
+static const size_t MAX_TRANSFORM_WORKERS = 3;
+
+// Distance in pixels by which a label may move relative to the other labels
+// before it is tested for occlusion again
+static const float PLACEMENT_MOVE_THRESHOLD = 1.f;
+
+// Bounds within which labels are updated
+struct LabelBounds {
+    Label::AABB screen;
+    Label::AABB extended;
+
+    // TODO appropriate buffer to filter out-of-screen labels
+    static constexpr float border = 256.0f;
+
+    explicit LabelBounds(const ViewState& _viewState) :
+        screen(0, 0, _viewState.viewportSize.x, _viewState.viewportSize.y),
+        extended(-border, -border, _viewState.viewportSize.x + border,
+                 _viewState.viewportSize.y + border) {}
+
+    // Use extended bounds when labels take part in collision detection
+    Label::AABB get(const Label& _label, bool _onlyRender) const {
+        return (_onlyRender || !_label.canOcclude()) ? screen : extended;
+    }
+};
+
+// Extent of the obbs in @_range, or the screen center of @_label without obbs
+static Label::AABB labelExtent(const Label& _label, const std::vector<isect2d::OBB<glm::vec2>>& _obbs,
+                               Range _range) {
+    if (_range.length == 0) {
+        glm::vec2 center = _label.screenCenter();
+        return { center.x, center.y, center.x, center.y };
+    }
+    auto aabb = _obbs[_range.start].getExtent();
+    for (int i = _range.start + 1; i < _range.end(); i++) {
+        aabb = unionAABB(aabb, _obbs[i].getExtent());
+    }
+    return aabb;
+}
+
+static Label::AABB moveAABB(Label::AABB _aabb, glm::vec2 _offset, float _margin = 0.f) {
+    _aabb.min += _offset - _margin;
+    _aabb.max += _offset + _margin;
+    return _aabb;
+}
+
 Labels::Labels()
     : m_needUpdate(false),
       m_lastZoom(0.0f) {}
@@ -38,15 +91,7 @@ void Labels::processLabelUpdate(const ViewState& _viewState, const LabelSet* _la
                                 const Tile* _tile, const Marker* _marker, const glm::mat4& _mvp,
                                 float _dt, bool _drawAll, bool _onlyRender, bool _isProxy) {
 
-    // TODO appropriate buffer to filter out-of-screen labels
-    float border = 256.0f;
-    AABB extendedBounds(-border, -border,
-                        _viewState.viewportSize.x + border,
-                        _viewState.viewportSize.y + border);
-
-    AABB screenBounds(0, 0,
-                      _viewState.viewportSize.x,
-                      _viewState.viewportSize.y);
+    LabelBounds labelBounds(_viewState);
 
     for (auto& label : _labelSet->getLabels()) {
         if (!_drawAll && (label->state() == Label::State::dead) ) {
@@ -56,10 +101,7 @@ void Labels::processLabelUpdate(const ViewState& _viewState, const LabelSet* _la
         Range transformRange;
         ScreenTransform transform { m_transforms, transformRange };
 
-        // Use extendedBounds when labels take part in collision detection.
-        auto bounds = (_onlyRender || !label->canOcclude())
-            ? screenBounds
-            : extendedBounds;
+        auto bounds = labelBounds.get(*label, _onlyRender);
 
         if (!label->update(_mvp, _viewState, &bounds, transform)) {
             continue;
@@ -310,8 +352,10 @@ bool Labels::zOrderComparator(const LabelEntry& _a, const LabelEntry& _b) {
         return _a.marker->id() < _b.marker->id();
     }
 
-    // Just keep tile label order consistent
+    // Just keep tile label order consistent, labels of a tile one after
+    // another so that TextStyle can draw their static slots at once
     if (_a.tile && _b.tile) {
+        if (_a.tile != _b.tile) { return _a.tile < _b.tile; }
         return _a.label < _b.label;
     }
 
@@ -319,13 +363,28 @@ bool Labels::zOrderComparator(const LabelEntry& _a, const LabelEntry& _b) {
     return bool(_a.tile);
 }
 
-void Labels::handleOcclusions(const ViewState& _viewState) {
+void Labels::handleOcclusions(const ViewState& _viewState, size_t _placed) {
 
     m_isect2d.clear();
     m_repeatGroups.clear();
 
     using iterator = decltype(m_labels)::const_iterator;
 
+    // Add a visible label to the ISect2D grid and its repeat group
+    auto addLabel = [this](LabelEntry& entry) {
+        int obbPos = entry.obbsRange.start;
+        for (auto& obb : OBBBuffer{ m_obbs, entry.obbsRange }) {
+            auto aabb = obb.getExtent();
+            aabb.m_userData = reinterpret_cast<void*>(obbPos++);
+            m_isect2d.insert(aabb);
+        }
+
+        auto* l = entry.label;
+        if (l->options().repeatDistance > 0.f) {
+            m_repeatGroups[l->options().repeatGroup].push_back(l);
+        }
+    };
+
     // Find the label to which the obb belongs
     auto findLabel = [](iterator begin, iterator end, int obb) {
         for (auto it = begin; it != end; it++) {
@@ -337,7 +396,16 @@ void Labels::handleOcclusions(const ViewState& _viewState) {
         return static_cast<Label*>(nullptr);
     };
 
-    for (auto it = m_labels.begin(); it != m_labels.end(); ++it) {
+    // Labels which keep their placement occlude the others as before,
+    // their obbs were added by reusePlacements()
+    for (size_t i = 0; i < _placed; i++) {
+        auto& entry = m_labels[i];
+
+        entry.label->occlude(entry.placement->occluded);
+        if (!entry.label->isOccluded()) { addLabel(entry); }
+    }
+
+    for (auto it = m_labels.begin() + _placed; it != m_labels.end(); ++it) {
         auto& entry = *it;
         auto* l = entry.label;
 
@@ -414,17 +482,7 @@ void Labels::handleOcclusions(const ViewState& _viewState) {
                 l->relative()->occlude();
             }
         } else {
-            // Insert into ISect2D grid
-            int obbPos = entry.obbsRange.start;
-            for (auto& obb : obbs) {
-                auto aabb = obb.getExtent();
-                aabb.m_userData = reinterpret_cast<void*>(obbPos++);
-                m_isect2d.insert(aabb);
-            }
-
-            if (l->options().repeatDistance > 0.f) {
-                m_repeatGroups[l->options().repeatGroup].push_back(l);
-            }
+            addLabel(entry);
         }
     }
 }
@@ -444,6 +502,303 @@ bool Labels::withinRepeatDistance(Label *_label) {
     return false;
 }
 
+Labels::LabelSetTransforms& Labels::labelSetTransforms(const LabelSet* _labelSet, Style* _style,
+                                                       const std::shared_ptr<Tile>& _tile,
+                                                       const Marker* _marker, const glm::mat4& _mvp,
+                                                       bool _viewChanged) {
+
+    auto& set = m_labelSets[_labelSet];
+
+    // Tiles do not change their meshes, so labels of a tile keep their transforms
+    // as long as the tile and the view are the same. Marker meshes are replaced
+    // in place and always updated.
+    set.reused = (!_viewChanged && _tile && set.tileRef.lock() == _tile && set.mvp == _mvp &&
+                  set.lastUpdate + 1 == m_updateCount);
+
+    // Labels of a tile that became or stopped being a proxy change their priority
+    bool proxy = _tile && _tile->isProxy();
+    size_t numLabels = _labelSet->getLabels().size();
+    if (set.placements.size() != numLabels || set.proxy != proxy) {
+        set.placements.assign(numLabels, Placement{});
+    }
+
+    set.labelSet = _labelSet;
+    set.style = _style;
+    set.tile = _tile.get();
+    set.tileRef = _tile;
+    set.marker = _marker;
+    set.mvp = _mvp;
+    set.proxy = proxy;
+    set.lastUpdate = m_updateCount;
+
+    return set;
+}
+
+void Labels::updateScreenTransforms(LabelSetTransforms& _set, const ViewState& _viewState,
+                                    bool _drawAll) {
+
+    LabelBounds labelBounds(_viewState);
+
+    _set.transforms.clear();
+    _set.labels.clear();
+
+    // Project the anchors of all labels at once
+    auto& anchors = _set.labelSet->anchors();
+    projectAnchors(_set.mvp, _viewState.viewportSize, anchors, _set.projected);
+
+    auto& labels = _set.labelSet->getLabels();
+
+    for (size_t i = 0; i < labels.size(); i++) {
+        auto& label = labels[i];
+
+        if (!_drawAll && (label->state() == Label::State::dead) ) {
+            continue;
+        }
+
+        Range transformRange;
+        ScreenTransform transform { _set.transforms, transformRange };
+
+        auto bounds = labelBounds.get(*label, false);
+
+        bool valid;
+        if (anchors.offsets[i] < 0) {
+            valid = label->update(_set.mvp, _viewState, &bounds, transform);
+        } else {
+            AnchorProjection projection(_set.projected, anchors.offsets[i]);
+            valid = label->update(projection, _viewState, &bounds, transform);
+        }
+        if (!valid) { continue; }
+
+        _set.labels.push_back({ label.get(), transformRange, uint32_t(i) });
+    }
+}
+
+void Labels::updateScreenTransforms(const ViewState& _viewState, bool _drawAll) {
+
+    std::vector<LabelSetTransforms*> pending;
+    size_t numLabels = 0;
+
+    for (auto* set : m_activeLabelSets) {
+        if (set->reused) { continue; }
+        pending.push_back(set);
+        numLabels += set->labelSet->getLabels().size();
+    }
+
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            updateScreenTransforms(*pending[i], _viewState, _drawAll);
+        }
+    };
+
+    if (numLabels < PARALLEL_TRANSFORMS_MIN_LABELS || pending.size() < 2) {
+        work();
+        return;
+    }
+
+    if (m_workers.empty()) {
+        size_t cores = std::thread::hardware_concurrency();
+        size_t numWorkers = std::min(cores > 1 ? cores - 1 : 0, MAX_TRANSFORM_WORKERS);
+        for (size_t i = 0; i < numWorkers; i++) {
+            m_workers.push_back(std::make_unique<AsyncWorker>());
+        }
+    }
+
+    // Labels only modify their own state in update(), each label set
+    // has its own transform buffer.
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t running = m_workers.size();
+
+    for (auto& worker : m_workers) {
+        worker->enqueue([&]() {
+            work();
+            std::lock_guard<std::mutex> lock(mutex);
+            running--;
+            finished.notify_one();
+        });
+    }
+
+    work();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&]() { return running == 0; });
+}
+
+size_t Labels::reusePlacements(const ViewState& _viewState, bool _reset) {
+
+    uint64_t lastUpdate = m_updateCount - 1;
+
+    // Labels move together when the map is panned, take their median move as
+    // the move of the map
+    std::vector<float> movesX, movesY;
+    size_t numKept = 0;
+    bool markers = false;
+
+    for (auto& entry : m_labels) {
+        auto& placement = *entry.placement;
+        if (placement.label == entry.label && placement.lastUpdate == lastUpdate) {
+            glm::vec2 move = entry.label->screenCenter() - placement.center;
+            movesX.push_back(move.x);
+            movesY.push_back(move.y);
+            numKept++;
+        }
+        markers |= bool(entry.marker);
+    }
+    if (numKept > 0) {
+        auto median = [](std::vector<float>& _values) {
+            auto it = _values.begin() + _values.size() / 2;
+            std::nth_element(_values.begin(), it, _values.end());
+            return *it;
+        };
+        m_placementShift += glm::vec2(median(movesX), median(movesY));
+    }
+
+    // Markers may change their draw order
+    m_sameCandidates = (!markers && numKept == m_labels.size() && numKept == m_lastCandidates);
+    m_lastCandidates = m_labels.size();
+
+    size_t numPlaced = 0;
+
+    for (auto& entry : m_labels) {
+        auto* label = entry.label;
+        auto& placement = *entry.placement;
+
+        ScreenTransform transform { m_transforms, entry.transformRange };
+        OBBBuffer obbs { m_obbs, entry.obbsRange };
+        label->obbs(transform, obbs);
+
+        if (placement.label != label) {
+            placement = Placement{};
+            placement.label = label;
+        }
+        bool kept = placement.lastUpdate == lastUpdate && placement.testUpdate != 0;
+
+        placement.lastUpdate = m_updateCount;
+        placement.center = label->screenCenter();
+
+        auto aabb = moveAABB(labelExtent(*label, m_obbs, entry.obbsRange), -m_placementShift);
+
+        entry.placed = (kept && !_reset && !placement.changed &&
+                        glm::all(glm::lessThanEqual(glm::abs(aabb.min - placement.aabb.min),
+                                                    glm::vec2(PLACEMENT_MOVE_THRESHOLD))) &&
+                        glm::all(glm::lessThanEqual(glm::abs(aabb.max - placement.aabb.max),
+                                                    glm::vec2(PLACEMENT_MOVE_THRESHOLD))));
+
+        if (entry.placed) {
+            numPlaced++;
+            continue;
+        }
+        if (_reset) { continue; }
+
+        // Labels near the old and the new place of a moved label are tested again
+        if (kept && !placement.occluded) {
+            m_dirtyRegions.push_back(moveAABB(placement.aabb, glm::vec2(0.f), placement.repeatDistance));
+        }
+        m_dirtyRegions.push_back(moveAABB(aabb, glm::vec2(0.f), label->options().repeatDistance));
+    }
+
+    if (numPlaced == 0) {
+        // All labels are tested again, their obbs are added for their anchor
+        m_obbs.clear();
+        for (auto& entry : m_labels) { entry.obbsRange = Range{}; }
+        return 0;
+    }
+
+    // Visible labels that are no candidates anymore may have occluded others
+    for (auto* set : m_activeLabelSets) {
+        for (auto& placement : set->placements) {
+            if (placement.lastUpdate == lastUpdate && placement.testUpdate != 0 && !placement.occluded) {
+                m_dirtyRegions.push_back(moveAABB(placement.aabb, glm::vec2(0.f), placement.repeatDistance));
+            }
+        }
+    }
+
+    if (!m_dirtyRegions.empty()) {
+        LabelBounds labelBounds(_viewState);
+
+        m_isect2d.clear();
+        for (auto& region : m_dirtyRegions) {
+            auto aabb = moveAABB(region, m_placementShift);
+            if (aabb.intersect(labelBounds.extended)) { m_isect2d.insert(aabb); }
+        }
+
+        for (auto& entry : m_labels) {
+            if (!entry.placed) { continue; }
+
+            auto& placement = *entry.placement;
+            auto aabb = moveAABB(placement.aabb, m_placementShift, placement.repeatDistance);
+
+            m_isect2d.intersect(aabb, [&](auto& a, auto& b) {
+                    entry.placed = false;
+                    return false;
+                }, false);
+        }
+        m_isect2d.clear();
+    }
+
+    // Labels and their relatives are tested together
+    std::vector<const Label*> relatives;
+    for (auto& entry : m_labels) {
+        if (!entry.placed && entry.label->relative()) {
+            relatives.push_back(entry.label);
+            relatives.push_back(entry.label->relative());
+        }
+    }
+    std::sort(relatives.begin(), relatives.end());
+
+    auto end = std::partition(m_labels.begin(), m_labels.end(), [&](LabelEntry& entry) {
+        if (entry.placed && !relatives.empty()) {
+            auto* relative = entry.label->relative();
+            entry.placed = !(std::binary_search(relatives.begin(), relatives.end(), entry.label) ||
+                             (relative && std::binary_search(relatives.begin(), relatives.end(), relative)));
+        }
+        // Obbs of tested labels are added again for their anchor
+        if (!entry.placed) { entry.obbsRange = Range{}; }
+        return entry.placed;
+    });
+
+    return end - m_labels.begin();
+}
+
+void Labels::storePlacements(size_t _placed) {
+
+    for (size_t i = _placed; i < m_labels.size(); i++) {
+        auto& entry = m_labels[i];
+        auto* label = entry.label;
+        auto& placement = *entry.placement;
+
+        bool occluded = label->isOccluded();
+        int anchorIndex = label->anchorIndex();
+
+        placement.changed = (placement.testUpdate != 0 &&
+                             (placement.occluded != occluded || placement.anchorIndex != anchorIndex));
+        placement.occluded = occluded;
+        placement.anchorIndex = anchorIndex;
+        placement.aabb = moveAABB(labelExtent(*label, m_obbs, entry.obbsRange), -m_placementShift);
+        placement.repeatDistance = label->options().repeatDistance;
+        placement.testUpdate = m_updateCount;
+    }
+}
+
+void Labels::sortZOrder() {
+
+    if (m_sameCandidates && !m_labels.empty()) {
+        // The z-order only depends on the labels, restore the one of the last update
+        m_sortedLabels.assign(m_labels.size(), m_labels.front());
+        for (auto& entry : m_labels) {
+            m_sortedLabels[entry.placement->zIndex] = entry;
+        }
+        std::swap(m_labels, m_sortedLabels);
+    } else {
+        std::sort(m_labels.begin(), m_labels.end(), Labels::zOrderComparator);
+    }
+
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        if (m_labels[i].placement) { m_labels[i].placement->zIndex = i; }
+    }
+}
+
 void Labels::updateLabelSet(const ViewState& _viewState, float _dt,
                             const std::shared_ptr<Scene>& _scene,
                             const std::vector<std::shared_ptr<Tile>>& _tiles,
@@ -452,11 +807,129 @@ void Labels::updateLabelSet(const ViewState& _viewState, float _dt,
 
     m_transforms.clear();
     m_obbs.clear();
+    m_labels.clear();
+    m_selectionLabels.clear();
+    m_dirtyRegions.clear();
+    m_needUpdate = false;
+
+    bool drawAllLabels = Tangram::getDebugFlag(DebugFlags::draw_all_labels);
+
+    // Label extents depend on the viewport and pixel scale
+    bool resetPlacements = (m_transformViewport != _viewState.viewportSize ||
+                            m_transformTileSize != _viewState.tileSize ||
+                            m_transformDrawAll != drawAllLabels);
+
+    bool viewChanged = (m_transformViewport != _viewState.viewportSize ||
+                        m_transformZoom != _viewState.zoom ||
+                        m_transformTileSize != _viewState.tileSize ||
+                        m_transformDrawAll != drawAllLabels);
+
+    m_transformViewport = _viewState.viewportSize;
+    m_transformZoom = _viewState.zoom;
+    m_transformTileSize = _viewState.tileSize;
+    m_transformDrawAll = drawAllLabels;
+
+    m_updateCount++;
+    m_activeLabelSets.clear();
+
+    /// Collect label sets from visible tiles and markers
+    const auto& styles = _scene->styles();
+
+    for (const auto& tile : _tiles) {
+        for (const auto& style : styles) {
+            const auto& mesh = tile->getMesh(*style);
+            auto labels = dynamic_cast<const LabelSet*>(mesh.get());
+            if (!labels) { continue; }
+
+            m_activeLabelSets.push_back(&labelSetTransforms(labels, style.get(), tile, nullptr,
+                                                            tile->mvp(), viewChanged));
+        }
+    }
+
+    for (const auto& marker : _markers) {
+
+        if (!marker->isVisible() || !marker->mesh()) { continue; }
+
+        for (const auto& style : styles) {
+
+            if (marker->styleId() != style->getID()) { continue; }
+
+            auto labels = dynamic_cast<const LabelSet*>(marker->mesh());
+            if (!labels) { continue; }
+
+            m_activeLabelSets.push_back(&labelSetTransforms(labels, style.get(), nullptr, marker.get(),
+                                                            marker->modelViewProjectionMatrix(),
+                                                            viewChanged));
+        }
+    }
+
+    // Drop label sets of tiles and markers that are gone
+    for (auto it = m_labelSets.begin(); it != m_labelSets.end();) {
+        if (it->second.lastUpdate != m_updateCount) {
+            // Labels of the removed set may have occluded others
+            for (auto& placement : it->second.placements) {
+                if (placement.lastUpdate + 1 == m_updateCount && placement.testUpdate != 0 &&
+                    !placement.occluded) {
+                    m_dirtyRegions.push_back(moveAABB(placement.aabb, glm::vec2(0.f),
+                                                      placement.repeatDistance));
+                }
+            }
+            it = m_labelSets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    /// Update screen transforms of labels whose tile or view changed
+    updateScreenTransforms(_viewState, drawAllLabels);
+
+    for (auto* set : m_activeLabelSets) {
+
+        const Tile* tile = set->tile;
+        int offset = m_transforms.points.size();
+
+        m_transforms.points.insert(m_transforms.points.end(),
+                                   set->transforms.points.begin(),
+                                   set->transforms.points.end());
+
+        for (auto& item : set->labels) {
+            Label* label = item.label;
+
+            if (set->reused) {
+                // Label died since the transforms were computed
+                if (!drawAllLabels && label->state() == Label::State::dead) { continue; }
+
+                label->resetOcclusion();
+            }
+
+            Range transformRange(item.transformRange.start + offset, item.transformRange.length);
+
+            if (label->canOcclude()) {
+                m_labels.emplace_back(label, set->style, tile, set->marker, set->proxy, transformRange);
+                m_labels.back().placement = &set->placements[item.index];
+            } else {
+                ScreenTransform transform { m_transforms, transformRange };
+                m_needUpdate |= label->evalState(_dt);
+                label->addVerticesToMesh(transform, _viewState.viewportSize);
+            }
+            if (label->selectionColor()) {
+                m_selectionLabels.emplace_back(label, set->style, tile, set->marker, set->proxy,
+                                               transformRange);
+            }
+        }
+    }
+
+    if (m_isect2dViewport != _viewState.viewportSize) {
+        m_isect2d.resize({_viewState.viewportSize.x / 256, _viewState.viewportSize.y / 256},
+                         {_viewState.viewportSize.x, _viewState.viewportSize.y});
+        m_isect2dViewport = _viewState.viewportSize;
+    }
+
+    /// Keep the occlusion of labels that did not move relative to the others
 
-    /// Collect and update labels from visible tiles
-    updateLabels(_viewState, _dt, _scene->styles(), _tiles, _markers, false);
+    size_t placed = reusePlacements(_viewState, resetPlacements);
 
-    std::sort(m_labels.begin(), m_labels.end(), Labels::priorityComparator);
+    std::sort(m_labels.begin() + placed, m_labels.end(), Labels::priorityComparator);
 
     /// Mark labels to skip transitions
 
@@ -465,17 +938,16 @@ void Labels::updateLabelSet(const ViewState& _viewState, float _dt,
         m_lastZoom = _viewState.zoom;
     }
 
-    m_isect2d.resize({_viewState.viewportSize.x / 256, _viewState.viewportSize.y / 256},
-                     {_viewState.viewportSize.x, _viewState.viewportSize.y});
+    handleOcclusions(_viewState, placed);
 
-    handleOcclusions(_viewState);
+    storePlacements(placed);
 
     // Update label state
     for (auto& entry : m_labels) {
         m_needUpdate |= entry.label->evalState(_dt);
     }
 
-    std::sort(m_labels.begin(), m_labels.end(), Labels::zOrderComparator);
+    sortZOrder();
 
     Label::AABB screenBounds{0, 0, _viewState.viewportSize.x, _viewState.viewportSize.y};
 
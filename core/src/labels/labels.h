@@ -18,6 +18,7 @@
 
 namespace Tangram {
 
+class AsyncWorker;
 class FontContext;
 class LabelSet;
 class Marker;
@@ -35,6 +36,12 @@ public:
 
     void drawDebug(RenderState& rs, const View& _view);
 
+    /* Place labels of all visible tiles and markers. Screen transforms of label sets
+     * whose tile and view did not change since the last call are reused, the others
+     * are computed in parallel before the occlusion pass. Labels that kept their
+     * position relative to the other labels keep their occlusion from the last call,
+     * only the others are sorted and tested for occlusion again.
+     */
     void updateLabelSet(const ViewState& _viewState, float _dt,
                         const std::shared_ptr<Scene>& _scene,
                         const std::vector<std::shared_ptr<Tile>>& _tiles,
@@ -67,7 +74,9 @@ protected:
 
     void skipTransitions(const std::vector<const Style*>& _styles, Tile& _tile, Tile& _proxy) const;
 
-    void handleOcclusions(const ViewState& _viewState);
+    /* Test the labels from index @_placed on for occlusion, in m_labels order.
+     * Labels before @_placed keep the occlusion of their Placement. */
+    void handleOcclusions(const ViewState& _viewState, size_t _placed = 0);
 
     bool withinRepeatDistance(Label *_label);
 
@@ -75,6 +84,68 @@ protected:
                             const Tile* _tile, const Marker *_marker, const glm::mat4& _mvp,
                             float _dt, bool _drawAll, bool _onlyRender, bool _isProxy);
 
+    // Occlusion of a label from the last time it was tested
+    struct Placement {
+        // Label at this index of the label set
+        const Label* label = nullptr;
+        // Update in which the label was last a candidate for occlusion
+        uint64_t lastUpdate = 0;
+        // Update in which the label was last tested, 0 if never
+        uint64_t testUpdate = 0;
+        // Extent of the tested label, relative to m_placementShift
+        AABB aabb;
+        float repeatDistance = 0;
+        // Screen center in the last update
+        glm::vec2 center;
+        int anchorIndex = 0;
+        bool occluded = false;
+        // The last test had another result than the one before
+        bool changed = false;
+        // Index in z-order in the last update
+        size_t zIndex = 0;
+    };
+
+    // Labels of one LabelSet that are within the extended screen bounds
+    struct LabelSetTransforms {
+        const LabelSet* labelSet = nullptr;
+        Style* style = nullptr;
+        const Tile* tile = nullptr;
+        // Identifies the tile across updates
+        std::weak_ptr<Tile> tileRef;
+        const Marker* marker = nullptr;
+        glm::mat4 mvp;
+        bool proxy = false;
+        // Whether transforms of the previous update were kept
+        bool reused = false;
+        // Update in which this label set was last visible
+        uint64_t lastUpdate = 0;
+
+        ProjectedAnchors projected;
+        ScreenTransform::Buffer transforms;
+
+        struct Item {
+            Label* label;
+            Range transformRange;
+            uint32_t index;
+        };
+        std::vector<Item> labels;
+
+        // Placements of the labels, by their index in the label set
+        std::vector<Placement> placements;
+    };
+
+    LabelSetTransforms& labelSetTransforms(const LabelSet* _labelSet, Style* _style,
+                                           const std::shared_ptr<Tile>& _tile,
+                                           const Marker* _marker, const glm::mat4& _mvp,
+                                           bool _viewChanged);
+
+    static void updateScreenTransforms(LabelSetTransforms& _set, const ViewState& _viewState,
+                                       bool _drawAll);
+
+    // Compute transforms of all label sets that were not reused, in parallel when
+    // there are many labels
+    void updateScreenTransforms(const ViewState& _viewState, bool _drawAll);
+
     bool m_needUpdate;
 
     isect2d::ISect2D<glm::vec2> m_isect2d;
@@ -100,8 +171,25 @@ protected:
 
         Range transformRange;
         Range obbsRange;
+
+        // Placement of the label, when placed by updateLabelSet()
+        Placement* placement = nullptr;
+        // Keeps the occlusion of its placement
+        bool placed = false;
     };
 
+    /* Reuse the placements of labels which were candidates in the last update and did
+     * not move relative to the others. Labels near a moved, new or removed label are
+     * tested again. Moves those labels to the front of m_labels and returns their number.
+     * @_reset: Test all labels again */
+    size_t reusePlacements(const ViewState& _viewState, bool _reset);
+
+    // Record the occlusion of the labels which were tested in this update
+    void storePlacements(size_t _placed);
+
+    // Sort m_labels by z-order, in linear time when the candidates did not change
+    void sortZOrder();
+
     static bool priorityComparator(const LabelEntry& _a, const LabelEntry& _b);
 
     static bool zOrderComparator(const LabelEntry& _a, const LabelEntry& _b);
@@ -111,10 +199,35 @@ protected:
 
     std::vector<LabelEntry> m_labels;
     std::vector<LabelEntry> m_selectionLabels;
+    std::vector<LabelEntry> m_sortedLabels;
 
     std::unordered_map<size_t, std::vector<Label*>> m_repeatGroups;
 
     float m_lastZoom;
+
+    // Label sets of the last updateLabelSet() with their screen transforms
+    std::unordered_map<const LabelSet*, LabelSetTransforms> m_labelSets;
+    // Label sets of the current update, in tile and marker order
+    std::vector<LabelSetTransforms*> m_activeLabelSets;
+    uint64_t m_updateCount = 0;
+
+    // View state for which transforms in m_labelSets were computed
+    glm::vec2 m_transformViewport{0};
+    float m_transformZoom = -1;
+    float m_transformTileSize = 0;
+    bool m_transformDrawAll = false;
+
+    glm::vec2 m_isect2dViewport{0};
+
+    // Sum of the moves of all labels, to which placement extents are relative
+    glm::vec2 m_placementShift{0};
+    // Extents relative to m_placementShift of removed, moved or new labels
+    std::vector<AABB> m_dirtyRegions;
+    size_t m_lastCandidates = 0;
+    // Candidates for occlusion are the same as in the last update
+    bool m_sameCandidates = false;
+
+    std::vector<std::unique_ptr<AsyncWorker>> m_workers;
 };
 
 }
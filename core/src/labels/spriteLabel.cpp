@@ -60,7 +60,7 @@ SpriteLabel::SpriteLabel(Coordinates _coordinates, glm::vec2 _size, Label::Optio
                          SpriteLabels& _labels, size_t _labelsPos)
     : Label(_size, Label::Type::point, _options),
       m_coordinates(_coordinates),
-      m_labels(_labels),
+      m_labels(&_labels),
       m_labelsPos(_labelsPos),
       m_texture(_texture),
       m_vertexAttrib(_attrib) {
@@ -68,6 +68,11 @@ SpriteLabel::SpriteLabel(Coordinates _coordinates, glm::vec2 _size, Label::Optio
     applyAnchor(m_options.anchors[0]);
 }
 
+void SpriteLabel::relocate(const SpriteLabels& _labels, size_t _quadOffset) {
+    m_labels = &_labels;
+    m_labelsPos += _quadOffset;
+}
+
 void SpriteLabel::applyAnchor(LabelProperty::Anchor _anchor) {
 
     m_anchor = LabelProperty::anchorDirection(_anchor) * m_dim * 0.5f;
@@ -225,7 +230,7 @@ void SpriteLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
     //     vertex_pos.xy += clamp(dz, 0.0, 1.0) * UNPACK_EXTRUDE(a_extrude.xy);
     // }
 
-    auto& quad = m_labels.quads[m_labelsPos];
+    auto& quad = m_labels->quads[m_labelsPos];
 
     SpriteVertex::State state {
         m_vertexAttrib.selectionColor,
@@ -235,7 +240,7 @@ void SpriteLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
         uint16_t(m_alpha * SpriteVertex::alpha_scale),
     };
 
-    auto* quadVertices = m_labels.m_style.pushQuad(m_texture);
+    auto* quadVertices = m_labels->m_style.pushQuad(m_texture);
 
     if (m_options.flat) {
         FlatTransform transform(_transform);
@@ -64,13 +64,17 @@ public:
 
     const Texture* texture() const override { return m_texture; }
 
+    /* Move this label to the container @_labels, where its quad is found
+     * @_quadOffset entries later */
+    void relocate(const SpriteLabels& _labels, size_t _quadOffset);
+
 private:
 
     const Coordinates m_coordinates;
 
     // Back-pointer to owning container and position
-    const SpriteLabels& m_labels;
-    const size_t m_labelsPos;
+    const SpriteLabels* m_labels;
+    size_t m_labelsPos;
 
     // Non-owning reference to a texture that is specific to this label.
     // If non-null, this indicates a custom texture for a marker.
@@ -1,6 +1,7 @@
 #include "labels/textLabel.h"
 
 #include "gl/dynamicQuadMesh.h"
+#include "labels/labelProjection.h"
 #include "labels/obbBuffer.h"
 #include "labels/textLabels.h"
 #include "labels/screenTransform.h"
@@ -12,6 +13,8 @@
 
 #include "glm/gtx/norm.hpp"
 
+#include <algorithm>
+
 namespace Tangram {
 
 using namespace LabelProperty;
@@ -41,7 +44,7 @@ TextLabel::TextLabel(Coordinates _coordinates, Type _type, Label::Options _optio
                      TextLabels& _labels, TextRange _textRanges, Align _preferedAlignment)
     : Label(_dim, _type, _options),
       m_coordinates(_coordinates),
-      m_textLabels(_labels),
+      m_textLabels(&_labels),
       m_textRanges(_textRanges),
       m_fontAttrib(_attrib),
       m_preferedAlignment(_preferedAlignment) {
@@ -49,6 +52,14 @@ TextLabel::TextLabel(Coordinates _coordinates, Type _type, Label::Options _optio
     applyAnchor(m_options.anchors[0]);
 }
 
+void TextLabel::relocate(const TextLabels& _labels, int _quadOffset) {
+    m_textLabels = &_labels;
+
+    for (auto& textRange : m_textRanges) {
+        textRange.start += _quadOffset;
+    }
+}
+
 void TextLabel::applyAnchor(Anchor _anchor) {
 
     if (m_preferedAlignment == Align::none) {
@@ -68,19 +79,56 @@ void TextLabel::applyAnchor(Anchor _anchor) {
     m_anchor = LabelProperty::anchorDirection(_anchor) * offset * 0.5f;
 }
 
+bool TextLabel::anchors(LabelAnchors& _anchors) const {
+
+    switch(m_type) {
+        case Type::debug:
+        case Type::point:
+            _anchors.push_back(m_coordinates[0]);
+            return true;
+        case Type::line:
+            _anchors.push_back(m_coordinates[0]);
+            _anchors.push_back(m_coordinates[1]);
+            _anchors.push_back(glm::vec2(m_coordinates[1] + m_coordinates[0]) * 0.5f);
+            return true;
+        default:
+            return false;
+    }
+}
+
 bool TextLabel::updateScreenTransform(const glm::mat4& _mvp, const ViewState& _viewState,
                                       const AABB* _bounds, ScreenTransform& _transform) {
 
+    return updateTransform([&](size_t _anchor, bool& _clipped) {
+            glm::vec2 p = (_anchor == 2) ? glm::vec2(m_coordinates[1] + m_coordinates[0]) * 0.5f
+                                         : m_coordinates[_anchor];
+            return worldToScreenSpace(_mvp, glm::vec4(p, 0.0, 1.0), _viewState.viewportSize, _clipped);
+        }, _viewState, _bounds, _transform);
+}
+
+bool TextLabel::updateProjectedTransform(const AnchorProjection& _projection, const ViewState& _viewState,
+                                         const AABB* _bounds, ScreenTransform& _transform) {
+
+    return updateTransform([&](size_t _anchor, bool& _clipped) {
+            if (_projection.clipped(_anchor)) {
+                _clipped = true;
+                return glm::vec2{};
+            }
+            return _projection.position(_anchor);
+        }, _viewState, _bounds, _transform);
+}
+
+template<typename Project>
+bool TextLabel::updateTransform(Project _project, const ViewState& _viewState,
+                                const AABB* _bounds, ScreenTransform& _transform) {
+
     bool clipped = false;
 
     switch(m_type) {
         case Type::debug:
         case Type::point: {
 
-            glm::vec2 p0 = m_coordinates[0];
-
-            glm::vec2 screenPosition = worldToScreenSpace(_mvp, glm::vec4(p0, 0.0, 1.0),
-                                                          _viewState.viewportSize, clipped);
+            glm::vec2 screenPosition = _project(0, clipped);
 
             if (clipped) { return false; }
 
@@ -103,13 +151,8 @@ bool TextLabel::updateScreenTransform(const glm::mat4& _mvp, const ViewState& _v
 
             // project label position from mercator world space to screen
             // coordinates
-            glm::vec2 p0 = m_coordinates[0];
-            glm::vec2 p2 = m_coordinates[1];
-
-            glm::vec2 ap0 = worldToScreenSpace(_mvp, glm::vec4(p0, 0.0, 1.0),
-                                               _viewState.viewportSize, clipped);
-            glm::vec2 ap2 = worldToScreenSpace(_mvp, glm::vec4(p2, 0.0, 1.0),
-                                               _viewState.viewportSize, clipped);
+            glm::vec2 ap0 = _project(0, clipped);
+            glm::vec2 ap2 = _project(1, clipped);
 
             // check whether the label is behind the camera using the
             // perspective division factor
@@ -129,11 +172,8 @@ bool TextLabel::updateScreenTransform(const glm::mat4& _mvp, const ViewState& _v
 
             if (length < minLength) { return false; }
 
-            glm::vec2 p1 = glm::vec2(p2 + p0) * 0.5f;
-
             // Keep screen position center at world center (less sliding in tilted view)
-            glm::vec2 screenPosition = worldToScreenSpace(_mvp, glm::vec4(p1, 0.0, 1.0),
-                                                          _viewState.viewportSize, clipped);
+            glm::vec2 screenPosition = _project(2, clipped);
 
             auto offset = m_options.offset;
 
@@ -192,9 +232,58 @@ void TextLabel::obbs(ScreenTransform& _transform, OBBBuffer& _obbs) {
 
 }
 
+uint32_t TextLabel::addStaticQuads(TextLabels& _labels, uint32_t _slot) {
+    if (m_type != Type::point && m_type != Type::debug) { return 0; }
+
+    m_slot = _slot;
+
+    for (auto& range : m_textRanges) {
+        if (range.length == 0) { continue; }
+
+        auto it = _labels.quads.begin() + range.start;
+        auto end = it + range.length;
+
+        for (; it != end; ++it) {
+            auto* quadVertices = _labels.pushStaticQuad(it->atlas, _slot);
+
+            for (int i = 0; i < 4; i++) {
+                StaticTextVertex& v = quadVertices[i];
+                v.pos = it->quad[i].pos;
+                v.uv = it->quad[i].uv;
+                v.selection = m_fontAttrib.selectionColor;
+                v.color = m_fontAttrib.fill;
+                v.stroke = m_fontAttrib.stroke;
+                v.slot = _slot % TextStyle::LABEL_SLOTS_PER_BATCH;
+                v.scale = m_fontAttrib.fontScale;
+            }
+        }
+        _slot++;
+    }
+
+    return _slot - m_slot;
+}
+
 void TextLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2& _screenSize) {
     if (!visibleState()) { return; }
 
+    if (m_slot >= 0 && m_textLabels->style.staticLabels()) {
+        // The glyphs are already on the GPU, only pass the placement of the
+        // current TextRange. Positions are rounded like the dynamic vertices.
+        int slot = m_slot;
+        for (int i = 0; i < m_textRangeIndex; i++) {
+            if (m_textRanges[i].length > 0) { slot++; }
+        }
+
+        glm::vec2 screenPosition = PointTransform(_transform).position() + m_anchor;
+        glm::vec2 sp = glm::vec2(glm::i16vec2(screenPosition * TextVertex::position_scale));
+
+        m_textLabels->setSlot(slot, sp * TextVertex::position_inv_scale, m_alpha);
+        return;
+    }
+
+    // The quads of static labels are gone once their meshes were uploaded
+    if (m_slot >= 0 && m_textLabels->staticQuadsReleased()) { return; }
+
     TextVertex::State state {
         m_fontAttrib.selectionColor,
         m_fontAttrib.fill,
@@ -203,9 +292,9 @@ void TextLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2&
         uint16_t(m_fontAttrib.fontScale),
     };
 
-    auto it = m_textLabels.quads.begin() + m_textRanges[m_textRangeIndex].start;
+    auto it = m_textLabels->quads.begin() + m_textRanges[m_textRangeIndex].start;
     auto end = it + m_textRanges[m_textRangeIndex].length;
-    auto& style = m_textLabels.style;
+    auto& style = m_textLabels->style;
 
     auto& meshes = style.getMeshes();
 
@@ -262,6 +351,8 @@ void TextLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2&
 }
 
 TextLabels::~TextLabels() {
+    if (m_frame == style.frame()) { style.removeStaticLabels(*this); }
+
     style.context()->releaseAtlas(m_atlasRefs);
 }
 
@@ -269,6 +360,154 @@ void TextLabels::setQuads(std::vector<GlyphQuad>&& _quads, std::bitset<FontConte
     quads = std::move(_quads);
     m_atlasRefs = _atlasRefs;
 
+    if (style.staticLabels()) { buildStaticMeshes(); }
+}
+
+void TextLabels::buildStaticMeshes() {
+
+    // Slots follow the order in which Labels draws the labels of a tile,
+    // so that labels placed one after another share a draw call.
+    std::vector<TextLabel*> labels;
+    labels.reserve(m_labels.size());
+    for (auto& label : m_labels) {
+        labels.push_back(static_cast<TextLabel*>(label.get()));
+    }
+    std::sort(labels.begin(), labels.end());
+
+    uint32_t slots = 0;
+    for (auto* label : labels) {
+        slots += label->addStaticQuads(*this, slots);
+    }
+
+    if (slots == 0) { return; }
+
+    for (auto& mesh : m_staticMeshes) {
+        if (mesh) { mesh->compile(); }
+    }
+
+    m_slots.resize((slots + TextStyle::LABEL_SLOTS_PER_BATCH - 1) / TextStyle::LABEL_SLOTS_PER_BATCH);
+}
+
+void TextLabels::releaseStaticQuads() {
+
+    // Keep the quads of labels which are drawn from the dynamic meshes,
+    // @index maps them to their new position
+    std::vector<int> index(quads.size(), -1);
+
+    for (auto& label : m_labels) {
+        auto& textLabel = static_cast<TextLabel&>(*label);
+        if (textLabel.hasStaticQuads()) { continue; }
+
+        for (auto& range : textLabel.textRanges()) {
+            std::fill(index.begin() + range.start, index.begin() + range.end(), 0);
+        }
+    }
+
+    int count = 0;
+    for (size_t i = 0; i < quads.size(); i++) {
+        if (index[i] < 0) { continue; }
+        quads[count] = quads[i];
+        index[i] = count++;
+    }
+    quads.resize(count);
+    quads.shrink_to_fit();
+
+    for (auto& label : m_labels) {
+        auto& textLabel = static_cast<TextLabel&>(*label);
+        if (textLabel.hasStaticQuads()) { continue; }
+
+        for (auto& range : textLabel.textRanges()) {
+            range.start = range.length > 0 ? index[range.start] : 0;
+        }
+    }
+
+    m_staticQuadsReleased = true;
+}
+
+StaticTextVertex* TextLabels::pushStaticQuad(size_t _atlas, uint32_t _slot) {
+    if (m_staticMeshes.size() <= _atlas) { m_staticMeshes.resize(_atlas + 1); }
+
+    auto& mesh = m_staticMeshes[_atlas];
+    if (!mesh) {
+        mesh = std::make_unique<StaticQuadMesh<StaticTextVertex>>(style.staticVertexLayout());
+    }
+
+    return mesh->pushQuad(_slot);
+}
+
+void TextLabels::setSlot(uint32_t _slot, glm::vec2 _position, float _alpha) const {
+
+    // Hide the labels which were placed in the previous frame
+    if (m_frame != style.frame()) {
+        m_frame = style.frame();
+        for (auto& batch : m_slots) { batch.clear(); }
+    }
+
+    // Only the slots up to the last placed one of a batch are uploaded,
+    // the others keep zero alpha
+    auto& batch = m_slots[_slot / TextStyle::LABEL_SLOTS_PER_BATCH];
+    size_t index = _slot % TextStyle::LABEL_SLOTS_PER_BATCH;
+    if (batch.size() <= index) { batch.resize(index + 1, glm::vec4(0.f)); }
+
+    batch[index] = { _position, _alpha, 0.f };
+
+    style.addStaticSlot(*this, _slot);
+}
+
+void TextLabels::drawStaticSlots(RenderState& rs, ShaderProgram& _program, const UniformLocation& _uLabelSlots,
+                                 uint32_t _first, uint32_t _end, GLuint _texUnit) const {
+
+    // Unchanged slot values are not uploaded again by the program
+    _program.setUniformf(rs, _uLabelSlots, m_slots[_first / TextStyle::LABEL_SLOTS_PER_BATCH]);
+
+    for (size_t atlas = 0; atlas < m_staticMeshes.size(); atlas++) {
+        auto& mesh = m_staticMeshes[atlas];
+        if (!mesh || !mesh->hasQuads(_first, _end)) { continue; }
+
+        style.context()->bindTexture(rs, atlas, _texUnit);
+        mesh->drawGroups(rs, _program, _first, _end);
+    }
+}
+
+bool TextLabels::needsUpload() const {
+    for (auto& mesh : m_staticMeshes) {
+        if (mesh && mesh->needsUpload()) { return true; }
+    }
+    return false;
+}
+
+bool TextLabels::isUploaded() const {
+    for (auto& mesh : m_staticMeshes) {
+        if (mesh && !mesh->isUploaded()) { return false; }
+    }
+    return !m_staticMeshes.empty();
+}
+
+size_t TextLabels::upload(RenderState& rs, size_t _maxBytes) {
+    size_t uploaded = 0;
+
+    for (auto& mesh : m_staticMeshes) {
+        if (uploaded >= _maxBytes) { break; }
+        if (!mesh) { continue; }
+
+        uploaded += mesh->upload(rs, _maxBytes - uploaded);
+    }
+
+    // The glyph quads of static labels are not needed anymore once their
+    // meshes are on the GPU and the style can draw them
+    if (!m_staticQuadsReleased && isUploaded() && style.staticProgramReady()) {
+        releaseStaticQuads();
+    }
+
+    return uploaded;
+}
+
+size_t TextLabels::bufferSize() const {
+    size_t size = 0;
+    for (auto& mesh : m_staticMeshes) {
+        if (mesh) { size += mesh->bufferSize(); }
+    }
+    return size;
 }
 
 }
@@ -35,6 +35,20 @@ struct TextVertex {
     const static float alpha_scale;
 };
 
+/* Vertex of the static meshes of TextLabels, placed on screen by the label
+ * slot uniforms of TextStyle instead of being rebuilt every frame */
+struct StaticTextVertex {
+    // Offset from the label position
+    glm::i16vec2 pos;
+    glm::u16vec2 uv;
+    uint32_t selection;
+    uint32_t color;
+    uint32_t stroke;
+    // Slot of the label within its batch
+    uint16_t slot;
+    uint16_t scale;
+};
+
 class TextLabel : public Label {
 
 public:
@@ -58,6 +72,11 @@ public:
     bool updateScreenTransform(const glm::mat4& _mvp, const ViewState& _viewState,
                                const AABB* _bounds, ScreenTransform& _transform) override;
 
+    bool anchors(LabelAnchors& _anchors) const override;
+
+    bool updateProjectedTransform(const AnchorProjection& _projection, const ViewState& _viewState,
+                                  const AABB* _bounds, ScreenTransform& _transform) override;
+
     void obbs(ScreenTransform& _transform, OBBBuffer& _obbs) override;
 
     void addVerticesToMesh(ScreenTransform& _transform, const glm::vec2& _screenSize) override;
@@ -68,6 +87,17 @@ public:
         return m_textRanges;
     }
 
+    /* Move this label to the container @_labels, where the quads of its
+     * TextRanges start @_quadOffset entries later */
+    void relocate(const TextLabels& _labels, int _quadOffset);
+
+    /* Add the glyph quads of all TextRanges to the static meshes of @_labels,
+     * one label slot per range starting at @_slot; returns the number of
+     * slots used. Only point labels can be drawn from static meshes. */
+    uint32_t addStaticQuads(TextLabels& _labels, uint32_t _slot);
+
+    bool hasStaticQuads() const { return m_slot >= 0; }
+
     uint32_t selectionColor() override {
         return m_fontAttrib.selectionColor;
     }
@@ -84,10 +114,15 @@ public:
 
 protected:
 
+    // Compute the screen transform from anchors given by @_project(index, clipped)
+    template<typename Project>
+    bool updateTransform(Project _project, const ViewState& _viewState,
+                         const AABB* _bounds, ScreenTransform& _transform);
+
     const Coordinates m_coordinates;
 
     // Back-pointer to owning container
-    const TextLabels& m_textLabels;
+    const TextLabels* m_textLabels;
 
     // first vertex and count in m_textLabels quads (left,right,center)
     TextRange m_textRanges;
@@ -95,6 +130,9 @@ protected:
     // TextRange currently used for drawing
     int m_textRangeIndex;
 
+    // First slot in the static meshes of m_textLabels, -1 when not in these
+    int m_slot = -1;
+
     VertexAttributes m_fontAttrib;
 
     // The text LAbel prefered alignment
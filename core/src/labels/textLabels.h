@@ -1,5 +1,7 @@
 #pragma once
 
+#include "gl/staticQuadMesh.h"
+#include "gl/uniform.h"
 #include "labels/labelSet.h"
 #include "labels/textLabel.h"
 #include "text/fontContext.h"
@@ -17,14 +19,59 @@ public:
 
     ~TextLabels() override;
 
+    /* Set the glyph quads of the labels, which must be set before. When the
+     * style draws static labels, the quads of point labels are also added to
+     * the static meshes. */
     void setQuads(std::vector<GlyphQuad>&& _quads, std::bitset<FontContext::max_textures> _atlasRefs);
 
+    /* Place the label in @_slot of the static meshes at @_position for the
+     * current frame; slots which are not set in a frame are not drawn */
+    void setSlot(uint32_t _slot, glm::vec2 _position, float _alpha) const;
+
+    StaticTextVertex* pushStaticQuad(size_t _atlas, uint32_t _slot);
+
+    /* Draw the slots from @_first up to @_end, which are in one batch, with
+     * the label positions of the current frame. The glyph textures are bound
+     * to @_texUnit */
+    void drawStaticSlots(RenderState& rs, ShaderProgram& _program, const UniformLocation& _uLabelSlots,
+                         uint32_t _first, uint32_t _end, GLuint _texUnit) const;
+
+    /* Position and alpha of the labels placed in the current frame, per batch
+     * up to the last placed slot */
+    const auto& labelSlots() const { return m_slots; }
+
+    bool staticQuadsReleased() const { return m_staticQuadsReleased; }
+
+    bool needsUpload() const override;
+
+    bool isUploaded() const override;
+
+    size_t upload(RenderState& rs, size_t _maxBytes) override;
+
+    size_t bufferSize() const override;
+
     std::vector<GlyphQuad> quads;
     const TextStyle& style;
 
 private:
 
+    void buildStaticMeshes();
+
+    // Drop the quads of labels which are drawn from the static meshes
+    void releaseStaticQuads();
+
     std::bitset<FontContext::max_textures> m_atlasRefs;
+
+    // Static meshes of point labels by glyph atlas, grouped by label slot
+    std::vector<std::unique_ptr<StaticQuadMesh<StaticTextVertex>>> m_staticMeshes;
+
+    // Position and alpha of the labels per batch of the static meshes
+    mutable std::vector<UniformArray4f> m_slots;
+
+    bool m_staticQuadsReleased = false;
+
+    // Style frame in which m_slots were last set
+    mutable uint32_t m_frame = 0;
 };
 
 }
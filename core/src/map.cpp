@@ -8,13 +8,16 @@
 #include "gl/framebuffer.h"
 #include "gl/hardware.h"
 #include "gl/primitives.h"
+#include "gl/programBinaryCache.h"
 #include "gl/renderState.h"
 #include "gl/shaderProgram.h"
 #include "labels/labels.h"
+#include "log.h"
 #include "marker/marker.h"
 #include "marker/markerManager.h"
 #include "platform.h"
 #include "scene/scene.h"
+#include "scene/sceneDiff.h"
 #include "scene/sceneLoader.h"
 #include "selection/selectionQuery.h"
 #include "style/material.h"
@@ -23,6 +26,8 @@
 #include "tile/tile.h"
 #include "tile/tileCache.h"
 #include "tile/tileManager.h"
+#include "tile/tilePrefetcher.h"
+#include "tile/uploadScheduler.h"
 #include "util/asyncWorker.h"
 #include "util/fastmap.h"
 #include "util/inputHandler.h"
@@ -57,9 +62,18 @@ public:
         inputHandler(_platform, view),
         scene(std::make_shared<Scene>(_platform, Url())),
         tileWorker(_platform, MAX_WORKERS),
-        tileManager(_platform, tileWorker) {}
+        tileManager(_platform, tileWorker) {
+        markerManager.setBatchQueue(&tileWorker);
+    }
+
+    // With @_keepTiles tiles of sources which are shared with the current scene stay loaded
+    void setScene(std::shared_ptr<Scene>& _scene, bool _keepTiles = false);
 
-    void setScene(std::shared_ptr<Scene>& _scene);
+    // Set @_scene, derived from @_base by scene updates. Styles and sources which are
+    // not affected by the changes in @_diff are taken over from the current scene, so
+    // that only tiles of affected sources are rebuilt.
+    void updateScene(std::shared_ptr<Scene>& _scene, const std::shared_ptr<Scene>& _base,
+                     const SceneDiff& _diff);
 
     void setPixelScale(float _pixelsPerPoint);
 
@@ -86,6 +100,8 @@ public:
     TileWorker tileWorker;
     TileManager tileManager;
     MarkerManager markerManager;
+    UploadScheduler uploadScheduler;
+    TilePrefetcher tilePrefetcher;
     std::unique_ptr<FrameBuffer> selectionBuffer = std::make_unique<FrameBuffer>(0, 0);
 
     bool cacheGlState = false;
@@ -130,7 +146,7 @@ Map::~Map() {
     Primitives::deinit();
 }
 
-void Map::Impl::setScene(std::shared_ptr<Scene>& _scene) {
+void Map::Impl::setScene(std::shared_ptr<Scene>& _scene, bool _keepTiles) {
 
     scene = _scene;
 
@@ -168,7 +184,7 @@ void Map::Impl::setScene(std::shared_ptr<Scene>& _scene) {
     }
 
     inputHandler.setView(view);
-    tileManager.setTileSources(_scene->tileSources());
+    tileManager.setTileSources(_scene->tileSources(), _keepTiles);
     tileWorker.setScene(_scene);
     markerManager.setScene(_scene);
 
@@ -179,6 +195,66 @@ void Map::Impl::setScene(std::shared_ptr<Scene>& _scene) {
     }
 }
 
+void Map::Impl::updateScene(std::shared_ptr<Scene>& _scene, const std::shared_ptr<Scene>& _base,
+                            const SceneDiff& _diff) {
+
+    if (scene != _base || _diff.change == SceneDiff::Change::full) {
+        setScene(_scene);
+        return;
+    }
+
+    LOG("Scene update: %s, rebuilding %d styles, %d sources, reloading %d sources",
+        _diff.change == SceneDiff::Change::partial ? "partial" : "live",
+        int(_diff.styles.size()), int(_diff.rebuildSources.size()),
+        int(_diff.reloadSources.size()));
+
+    std::vector<uint32_t> replacedStyles;
+    {
+        // SceneDiff::compare() may read the styles of the updated scene
+        std::lock_guard<std::mutex> lock(sceneMutex);
+
+        auto& styles = _scene->styles();
+        auto& currentStyles = scene->styles();
+
+        for (size_t i = 0; i < styles.size(); i++) {
+            auto& style = styles[i];
+            if (_diff.styles.count(style->getName())) {
+                replacedStyles.push_back(style->getID());
+                continue;
+            }
+            auto& current = currentStyles[i];
+            if (_diff.uniforms.count(style->getName())) {
+                // Keep the resolved uniform locations, only values changed
+                auto& uniforms = current->styleUniforms();
+                auto& values = style->styleUniforms();
+                for (size_t u = 0; u < uniforms.size() && u < values.size(); u++) {
+                    uniforms[u].second = values[u].second;
+                }
+            }
+            current->setLights(_scene->lights());
+
+            // The unused style stays with the previous scene, which may still
+            // be used by tile workers
+            std::swap(current, style);
+        }
+
+        for (auto& source : _scene->tileSources()) {
+            if (_diff.reloadSources.count(source->name())) { continue; }
+
+            if (auto current = scene->getTileSource(source->name())) {
+                source = current;
+            }
+        }
+
+        // Kept tiles refer to selection colors of the current scene
+        std::swap(_scene->featureSelection(), scene->featureSelection());
+    }
+
+    tileManager.rebuildTiles(_diff.rebuildSources, replacedStyles);
+
+    setScene(_scene, true);
+}
+
 // NB: Not thread-safe. Must be called on the main/render thread!
 // (Or externally synchronized with main/render thread)
 SceneID Map::loadScene(std::shared_ptr<Scene> scene,
@@ -320,9 +396,11 @@ SceneID Map::updateSceneAsync(const std::vector<SceneUpdate>& _sceneUpdates) {
                 return;
             }
 
+            std::shared_ptr<Scene> baseScene;
             {
                 std::lock_guard<std::mutex> lock(impl->sceneMutex);
-                nextScene->copyConfig(*impl->lastValidScene);
+                baseScene = impl->lastValidScene;
+                nextScene->copyConfig(*baseScene);
             }
 
             if (!SceneLoader::applyUpdates(platform, *nextScene, updates)) {
@@ -340,17 +418,22 @@ SceneID Map::updateSceneAsync(const std::vector<SceneUpdate>& _sceneUpdates) {
 
             bool configApplied = SceneLoader::applyConfig(platform, nextScene);
 
+            SceneDiff diff;
             {
                 std::lock_guard<std::mutex> lock(impl->sceneMutex);
+
+                // Find the tiles which must be rebuilt for the updates
+                if (configApplied) { diff = SceneDiff::compare(*baseScene, *nextScene); }
+
                 // NB: Need to set the scene on the worker thread so that waiting
                 // applyUpdates AsyncTasks can access it to copy the config.
                 if (configApplied) { impl->lastValidScene = nextScene; }
             }
-            impl->jobQueue.add([nextScene, configApplied, this]() {
+            impl->jobQueue.add([nextScene, baseScene, diff, configApplied, this]() {
 
                     if (configApplied) {
                         auto s = nextScene;
-                        impl->setScene(s);
+                        impl->updateScene(s, baseScene, diff);
                     }
                     if (impl->onSceneReady) { impl->onSceneReady(nextScene->id, nullptr); }
                 });
@@ -412,6 +495,7 @@ bool Map::update(float _dt) {
                 impl->cameraAnimationListener(true);
             }
             impl->ease.reset();
+            impl->tilePrefetcher.clearPath();
             isEasing = false;
         } else {
             isEasing = true;
@@ -432,6 +516,9 @@ bool Map::update(float _dt) {
     {
         std::lock_guard<std::mutex> lock(impl->tilesMutex);
 
+        // Predict the tiles of the next frames while the camera moves
+        impl->tilePrefetcher.update(impl->view, _dt);
+        impl->tileManager.setPrefetchTiles(impl->tilePrefetcher.tiles());
         impl->tileManager.updateTileSets(impl->view);
 
         auto& tiles = impl->tileManager.getVisibleTiles();
@@ -511,9 +598,23 @@ bool Map::render() {
         impl->renderState.invalidateStates();
     }
 
+    impl->renderState.resetFrameStats();
+
     // Delete batch of gl resources
     impl->renderState.flushResourceDeletion();
 
+    // Upload meshes of newly built tiles within the frame budget. The tiles
+    // replace their proxies on the next update once all meshes are uploaded.
+    {
+        std::lock_guard<std::mutex> lock(impl->tilesMutex);
+
+        auto& uploads = impl->tileManager.getPendingUploads();
+        if (impl->uploadScheduler.upload(impl->renderState, uploads) ||
+            impl->uploadScheduler.stats().bytes > 0) {
+            platform->requestRender();
+        }
+    }
+
     for (const auto& style : impl->scene->styles()) {
         style->onBeginFrame(impl->renderState);
     }
@@ -555,7 +656,7 @@ bool Map::render() {
 
     if (drawSelectionBuffer) {
         impl->selectionBuffer->drawDebug(impl->renderState, viewport);
-        FrameInfo::draw(impl->renderState, impl->view, impl->tileManager);
+        FrameInfo::draw(impl->renderState, impl->view, impl->tileManager, impl->uploadScheduler);
         return impl->isCameraEasing;
     }
 
@@ -575,6 +676,11 @@ bool Map::render() {
         }
     }
 
+    // Meshes uploaded when drawn which were left incomplete
+    if (impl->renderState.frameStats().pendingUploads > 0) {
+        platform->requestRender();
+    }
+
     if (impl->scene->animated() != Scene::animate::no &&
         drawnAnimatedStyle != platform->isContinuousRendering()) {
 
@@ -583,7 +689,7 @@ bool Map::render() {
 
     impl->labels.drawDebug(impl->renderState, impl->view);
 
-    FrameInfo::draw(impl->renderState, impl->view, impl->tileManager);
+    FrameInfo::draw(impl->renderState, impl->view, impl->tileManager, impl->uploadScheduler);
 
     return impl->isCameraEasing;
 }
@@ -620,6 +726,7 @@ void Map::cancelCameraAnimation() {
     impl->inputHandler.cancelFling();
 
     impl->ease.reset();
+    impl->tilePrefetcher.clearPath();
     impl->isCameraEasing = false;
 
     if (impl->cameraAnimationListener) {
@@ -685,6 +792,12 @@ void Map::setCameraPositionEased(const CameraPosition& _camera, float _duration,
             impl->view.setPitch(ease(e.start.tilt, e.end.tilt, t, _e));
         });
 
+    impl->tilePrefetcher.setPath([=](float t) {
+            return glm::dvec3(ease(e.start.pos.x, e.end.pos.x, t, _e),
+                              ease(e.start.pos.y, e.end.pos.y, t, _e),
+                              ease(e.start.zoom, e.end.zoom, t, _e));
+        }, _duration);
+
     platform->requestRender();
 }
 
@@ -874,6 +987,7 @@ void Map::flyTo(const CameraPosition& _camera, float _duration, float _speed) {
     cancelCameraAnimation();
 
     impl->ease = std::make_unique<Ease>(duration, cb);
+    impl->tilePrefetcher.setPath(fn, duration);
 
     platform->requestRender();
 }
@@ -1028,6 +1142,31 @@ void Map::markerRemoveAll() {
     platform->requestRender();
 }
 
+bool Map::markerAddPoints(const LngLat* _lngLats, int _count, const char* _styling, bool _isPath,
+                          MarkerID* _markers) {
+    bool success = impl->markerManager.addPoints(_lngLats, _count, _styling, _isPath, _markers);
+    platform->requestRender();
+    return success;
+}
+
+int Map::markerSetPoints(const MarkerID* _markers, const LngLat* _lngLats, int _count) {
+    int updated = impl->markerManager.setPoints(_markers, _lngLats, _count);
+    platform->requestRender();
+    return updated;
+}
+
+bool Map::markerSetStyling(const MarkerID* _markers, int _count, const char* _styling, bool _isPath) {
+    bool success = impl->markerManager.setStyling(_markers, _count, _styling, _isPath);
+    platform->requestRender();
+    return success;
+}
+
+int Map::markerRemove(const MarkerID* _markers, int _count) {
+    int removed = impl->markerManager.remove(_markers, _count);
+    platform->requestRender();
+    return removed;
+}
+
 void Map::handleTapGesture(float _posX, float _posY) {
     cancelCameraAnimation();
     impl->inputHandler.handleTapGesture(_posX, _posY);
@@ -1071,6 +1210,13 @@ void Map::setupGL() {
 
     impl->tileManager.clearTileSets();
 
+    // Buffers of the mesh arenas were lost with the context
+    if (impl->scene) {
+        for (const auto& style : impl->scene->styles()) {
+            style->resetMeshArenas();
+        }
+    }
+
     impl->markerManager.rebuildAll();
 
     if (impl->selectionBuffer->valid()) {
@@ -1088,6 +1234,19 @@ void Map::setupGL() {
     // Hardware::printAvailableExtensions();
 }
 
+void Map::setShaderCachePath(const std::string& _path) {
+    impl->renderState.programBinaryCache = std::make_shared<ProgramBinaryCache>(_path);
+}
+
+int Map::warmShaderPrograms() {
+    int built = 0;
+
+    for (const auto& style : impl->scene->styles()) {
+        built += style->buildShaderPrograms(impl->renderState);
+    }
+    return built;
+}
+
 void Map::useCachedGlState(bool _useCache) {
     impl->cacheGlState = _useCache;
 }
@@ -1107,6 +1266,36 @@ void Map::onMemoryWarning() {
     }
 }
 
+TileCacheStats Map::getTileCacheStats() {
+    return impl->tileManager.getTileCache()->stats();
+}
+
+TextCacheStats Map::getTextCacheStats() {
+    TextCacheStats stats;
+
+    if (impl->scene && impl->scene->fontContext()) {
+        auto cacheStats = impl->scene->fontContext()->shapedTextCacheStats();
+        stats.hits = cacheStats.hits;
+        stats.misses = cacheStats.misses;
+        stats.evictions = cacheStats.evictions;
+        stats.entries = cacheStats.entries;
+    }
+    return stats;
+}
+
+void Map::setTilePrefetchBudget(uint32_t _maxTiles, uint64_t _maxBytes) {
+    std::lock_guard<std::mutex> lock(impl->tilesMutex);
+
+    impl->tileManager.setPrefetchBudget(_maxTiles, _maxBytes);
+    impl->tilePrefetcher.setEnabled(_maxTiles > 0);
+}
+
+TilePrefetchStats Map::getTilePrefetchStats() {
+    std::lock_guard<std::mutex> lock(impl->tilesMutex);
+
+    return impl->tileManager.prefetchStats();
+}
+
 void Map::setDefaultBackgroundColor(float r, float g, float b) {
     impl->renderState.defaultOpaqueClearColor(r, g, b);
 }
@@ -1,5 +1,6 @@
 #include "marker/marker.h"
 
+#include "data/propertyItem.h"
 #include "data/tileData.h"
 #include "gl/texture.h"
 #include "scene/dataLayer.h"
@@ -34,15 +35,21 @@ void Marker::setStyling(std::string styling, bool isPath) {
     m_styling.isPath = isPath;
 }
 
-bool Marker::evaluateRuleForContext(StyleContext& ctx) {
-    return m_drawRuleSet->evaluateRuleForContext(*drawRule(), ctx);
-}
-
-void Marker::setDrawRuleData(std::unique_ptr<DrawRuleData> drawRuleData) {
+void Marker::setDrawRuleData(std::shared_ptr<DrawRuleData> drawRuleData) {
     m_drawRuleData = std::move(drawRuleData);
     m_drawRule = std::make_unique<DrawRule>(*m_drawRuleData, "", 0);
 }
 
+void Marker::setStylingFrom(const Marker& other) {
+    m_styling = other.m_styling;
+    m_drawRuleData = other.m_drawRuleData;
+    if (other.m_drawRule) {
+        m_drawRule = std::make_unique<DrawRule>(*other.m_drawRule);
+    } else {
+        m_drawRule.reset();
+    }
+}
+
 void Marker::mergeRules(const SceneLayer& layer) {
     m_drawRuleSet->mergeRules(layer);
 }
@@ -58,7 +65,7 @@ bool Marker::finalizeRuleMergingForName(const std::string& name) {
     }
     if (found) {
         // Clear leftover data (outside the loop so we don't invalidate iterators).
-        m_drawRuleData.reset(nullptr);
+        m_drawRuleData.reset();
         m_drawRuleSet->matchedRules().clear();
     }
     return found;
@@ -80,6 +87,26 @@ void Marker::setMesh(uint32_t styleId, uint32_t zoom, std::unique_ptr<StyledMesh
 
 void Marker::clearMesh() {
     m_mesh.reset();
+    m_pendingBatch = 0;
+}
+
+std::unique_ptr<StyledMesh> Marker::releaseMesh() {
+    return std::move(m_mesh);
+}
+
+void Marker::setPendingBuild(uint32_t batch, int zoom) {
+    m_pendingBatch = batch;
+    m_pendingZoom = zoom;
+}
+
+std::unique_ptr<Marker> Marker::copyForBuild() const {
+    auto copy = std::make_unique<Marker>(m_id);
+    copy->setBounds(m_bounds);
+    if (m_feature) { copy->m_feature = std::make_unique<Feature>(*m_feature); }
+    if (m_drawRule) { copy->m_drawRule = std::make_unique<DrawRule>(*m_drawRule); }
+    copy->m_drawRuleData = m_drawRuleData;
+    copy->m_texture = m_texture;
+    return copy;
 }
 
 void Marker::setTexture(std::unique_ptr<Texture> texture) {
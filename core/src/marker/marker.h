@@ -50,7 +50,10 @@ public:
     void setStyling(std::string styling, bool isPath);
 
     // Set the new draw rule data that will be used to build the marker.
-    void setDrawRuleData(std::unique_ptr<DrawRuleData> drawRuleData);
+    void setDrawRuleData(std::shared_ptr<DrawRuleData> drawRuleData);
+
+    // Use the styling and draw rule of another marker; draw rule data is shared, not copied.
+    void setStylingFrom(const Marker& other);
 
     // Merge draw rules from the given layer into the internal draw rule set.
     void mergeRules(const SceneLayer& layer);
@@ -63,8 +66,16 @@ public:
     // Set the styled mesh for this marker with the associated style id and zoom level.
     void setMesh(uint32_t styleId, uint32_t zoom, std::unique_ptr<StyledMesh> mesh);
 
+    // Remove the mesh and discard any mesh that is being built for this marker.
     void clearMesh();
 
+    // Take the mesh of this marker, leaving it without one.
+    std::unique_ptr<StyledMesh> releaseMesh();
+
+    // Set the batch that is building a mesh at the given zoom level on a worker thread; a batch of 0
+    // means that no mesh is pending.
+    void setPendingBuild(uint32_t batch, int zoom);
+
     void setTexture(std::unique_ptr<Texture> texture);
 
     // Set an ease for the origin of this marker in Mercator meters.
@@ -75,6 +86,10 @@ public:
     // Set the model matrix for the marker using the current view and update any eases.
     void update(float dt, const View& view);
 
+    // Create a copy of the feature, bounds, draw rule and texture of this marker from which its mesh
+    // can be built on another thread.
+    std::unique_ptr<Marker> copyForBuild() const;
+
     // Set whether this marker should be visible.
     void setVisible(bool visible);
 
@@ -121,7 +136,9 @@ public:
 
     const Styling& styling() const { return m_styling; }
 
-    bool evaluateRuleForContext(StyleContext& ctx);
+    uint32_t pendingBatch() const { return m_pendingBatch; }
+
+    int pendingZoom() const { return m_pendingZoom; }
 
     bool isEasing() const;
 
@@ -135,9 +152,10 @@ protected:
 
     std::unique_ptr<Feature> m_feature;
     std::unique_ptr<StyledMesh> m_mesh;
-    std::unique_ptr<Texture> m_texture;
+    // Shared with copies that are built on other threads
+    std::shared_ptr<Texture> m_texture;
     std::unique_ptr<DrawRuleMergeSet> m_drawRuleSet;
-    std::unique_ptr<DrawRuleData> m_drawRuleData;
+    std::shared_ptr<DrawRuleData> m_drawRuleData;
     std::unique_ptr<DrawRule> m_drawRule;
 
     Styling m_styling;
@@ -148,6 +166,10 @@ protected:
 
     int m_builtZoomLevel = 0;
 
+    uint32_t m_pendingBatch = 0;
+
+    int m_pendingZoom = 0;
+
     uint32_t m_selectionColor = 0;
 
     int m_drawOrder = 0;
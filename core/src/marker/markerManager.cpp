@@ -13,9 +13,13 @@
 #include "selection/featureSelection.h"
 
 #include <algorithm>
+#include <unordered_map>
 
 namespace Tangram {
 
+// Number of markers per Batch, so that several workers can share large updates
+static const size_t BATCH_SIZE = 256;
+
 MarkerManager::MarkerManager() {}
 
 MarkerManager::~MarkerManager() {}
@@ -42,6 +46,7 @@ MarkerID MarkerManager::add() {
     // Add a new empty marker object to the list of markers.
     auto id = ++m_idCounter;
     m_markers.push_back(std::make_unique<Marker>(id));
+    m_markersById[id] = m_markers.back().get();
 
     // Sort the marker list by draw order.
     std::stable_sort(m_markers.begin(), m_markers.end(), Marker::compareByDrawOrder);
@@ -54,6 +59,8 @@ MarkerID MarkerManager::add() {
 bool MarkerManager::remove(MarkerID markerID) {
     m_dirty = true;
 
+    if (m_markersById.erase(markerID) == 0) { return false; }
+
     for (auto it = m_markers.begin(), end = m_markers.end(); it != end; ++it) {
         if (it->get()->id() == markerID) {
             m_markers.erase(it);
@@ -63,6 +70,124 @@ bool MarkerManager::remove(MarkerID markerID) {
     return false;
 }
 
+int MarkerManager::remove(const MarkerID* markerIDs, int count) {
+    m_dirty = true;
+
+    int removed = 0;
+    for (int i = 0; i < count; ++i) {
+        removed += m_markersById.erase(markerIDs[i]);
+    }
+    if (removed == 0) { return 0; }
+
+    // Erase all removed markers in one pass.
+    m_markers.erase(std::remove_if(m_markers.begin(), m_markers.end(), [this](auto& marker) {
+                return m_markersById.find(marker->id()) == m_markersById.end();
+            }), m_markers.end());
+
+    return removed;
+}
+
+bool MarkerManager::addPoints(const LngLat* lngLats, int count, const char* styling, bool isPath,
+                              MarkerID* markerIDs) {
+
+    if (!m_scene || !lngLats || !styling || count < 1) { return false; }
+
+    // Build the draw rule once and share it between all new markers.
+    Marker styled(0);
+    styled.setStyling(std::string(styling), isPath);
+    if (!buildStyling(styled)) { return false; }
+
+    m_dirty = true;
+
+    m_markers.reserve(m_markers.size() + count);
+
+    for (int i = 0; i < count; ++i) {
+        auto id = ++m_idCounter;
+        auto marker = std::make_unique<Marker>(id);
+
+        marker->setStylingFrom(styled);
+        setPointFeature(*marker, lngLats[i]);
+        queueMesh(*marker);
+
+        m_markersById[id] = marker.get();
+        m_markers.push_back(std::move(marker));
+
+        if (markerIDs) { markerIDs[i] = id; }
+    }
+
+    // Sort the marker list by draw order.
+    std::stable_sort(m_markers.begin(), m_markers.end(), Marker::compareByDrawOrder);
+
+    flushBatches();
+
+    return true;
+}
+
+bool MarkerManager::setStyling(const MarkerID* markerIDs, int count, const char* styling, bool isPath) {
+
+    if (!m_scene || !markerIDs || !styling) { return false; }
+
+    Marker styled(0);
+    styled.setStyling(std::string(styling), isPath);
+    if (!buildStyling(styled)) { return false; }
+
+    m_dirty = true;
+
+    for (int i = 0; i < count; ++i) {
+        Marker* marker = getMarkerOrNull(markerIDs[i]);
+        if (!marker) { continue; }
+
+        marker->setStylingFrom(styled);
+        queueMesh(*marker);
+    }
+
+    flushBatches();
+
+    return true;
+}
+
+int MarkerManager::setPoints(const MarkerID* markerIDs, const LngLat* lngLats, int count) {
+
+    if (!m_scene || !markerIDs || !lngLats) { return 0; }
+
+    m_dirty = true;
+
+    int updated = 0;
+
+    for (int i = 0; i < count; ++i) {
+        Marker* marker = getMarkerOrNull(markerIDs[i]);
+        if (!marker) { continue; }
+
+        updated++;
+
+        auto feature = marker->feature();
+        if (feature && feature->geometryType == GeometryType::points &&
+            (marker->mesh() || marker->pendingBatch())) {
+            // Point meshes are built relative to the marker origin; moving them only changes the bounds.
+            auto origin = MapProjection::lngLatToProjectedMeters({lngLats[i].longitude, lngLats[i].latitude});
+            marker->setBounds({ origin, origin });
+            continue;
+        }
+
+        setPointFeature(*marker, lngLats[i]);
+        queueMesh(*marker);
+    }
+
+    flushBatches();
+
+    return updated;
+}
+
+void MarkerManager::setPointFeature(Marker& marker, LngLat lngLat) {
+    auto feature = std::make_unique<Feature>();
+    feature->geometryType = GeometryType::points;
+    feature->points.emplace_back();
+    marker.setFeature(std::move(feature));
+
+    auto origin = MapProjection::lngLatToProjectedMeters({lngLat.longitude, lngLat.latitude});
+    marker.setBounds({ origin, origin });
+}
+
 bool MarkerManager::setStyling(MarkerID markerID, const char* styling, bool isPath) {
     Marker* marker = getMarkerOrNull(markerID);
     if (!marker) { return false; }
@@ -292,22 +417,24 @@ bool MarkerManager::update(const View& _view, float _dt) {
 
     m_zoom = _view.getZoom();
 
-    bool rebuilt = false;
+    bool rebuilt = applyBatches();
     bool easing = false;
     bool dirty = m_dirty;
     m_dirty = false;
 
     for (auto& marker : m_markers) {
 
-        if (m_zoom != marker->builtZoomLevel()) {
-            buildMesh(*marker, m_zoom);
-            rebuilt = true;
+        if (m_zoom != marker->builtZoomLevel() &&
+            !(marker->pendingBatch() && marker->pendingZoom() == m_zoom)) {
+            rebuilt |= queueMesh(*marker);
         }
 
         marker->update(_dt, _view);
         easing |= marker->isEasing();
     }
 
+    flushBatches();
+
     return rebuilt || easing || dirty;
 }
 
@@ -315,17 +442,34 @@ void MarkerManager::removeAll() {
     m_dirty = true;
 
     m_markers.clear();
+    m_markersById.clear();
+    m_queuedMarkers.clear();
+    m_batches.clear();
 
 }
 
 void MarkerManager::rebuildAll() {
     m_dirty = true;
 
+    // Markers with the same styling share one draw rule.
+    std::unordered_map<std::string, std::unique_ptr<Marker>> stylings;
+
     for (auto& entry : m_markers) {
-        buildStyling(*entry);
-        buildMesh(*entry, m_zoom);
+        const auto& styling = entry->styling();
+
+        auto& styled = stylings[(styling.isPath ? "path:" : "yaml:") + styling.string];
+        if (!styled) {
+            styled = std::make_unique<Marker>(0);
+            styled->setStyling(styling.string, styling.isPath);
+            buildStyling(*styled);
+        }
+        if (styled->drawRule()) {
+            entry->setStylingFrom(*styled);
+        }
+        queueMesh(*entry);
     }
 
+    flushBatches();
 }
 
 const std::vector<std::unique_ptr<Marker>>& MarkerManager::markers() const {
@@ -413,17 +557,27 @@ bool MarkerManager::buildStyling(Marker& marker) {
 
 bool MarkerManager::buildMesh(Marker& marker, int zoom) {
 
+    if (!m_scene) { return false; }
+
+    return buildMesh(marker, zoom, m_styleBuilders, *m_styleContext, m_ruleSet, *m_scene->featureSelection());
+}
+
+bool MarkerManager::buildMesh(Marker& marker, int zoom, StyleBuilders& styleBuilders, StyleContext& styleContext,
+                              DrawRuleMergeSet& ruleSet, FeatureSelection& featureSelection) {
+
     marker.clearMesh();
 
     auto feature = marker.feature();
-    auto rule = marker.drawRule();
-    if (!feature || !rule) { return false; }
+    if (!feature || !marker.drawRule()) { return false; }
+
+    // Evaluate a copy, the draw rule of the marker is shared with copies on other threads.
+    DrawRule rule = *marker.drawRule();
 
     StyleBuilder* styler = nullptr;
     {
-        auto name = rule->getStyleName();
-        auto it = m_styleBuilders.find(name);
-        if (it != m_styleBuilders.end()) {
+        auto name = rule.getStyleName();
+        auto it = styleBuilders.find(name);
+        if (it != styleBuilders.end()) {
             styler = it->second.get();
         } else {
             LOGN("Invalid style %s", name.c_str());
@@ -432,11 +586,11 @@ bool MarkerManager::buildMesh(Marker& marker, int zoom) {
     }
 
     // Apply defaul draw rules defined for this style
-    styler->style().applyDefaultDrawRules(*rule);
+    styler->style().applyDefaultDrawRules(rule);
 
-    m_styleContext->setKeywordZoom(zoom);
+    styleContext.setKeywordZoom(zoom);
 
-    bool valid = marker.evaluateRuleForContext(*m_styleContext);
+    bool valid = ruleSet.evaluateRuleForContext(rule, styleContext);
 
     if (!valid) { return false; }
 
@@ -444,16 +598,16 @@ bool MarkerManager::buildMesh(Marker& marker, int zoom) {
 
     uint32_t selectionColor = 0;
     bool interactive = false;
-    if (rule->get(StyleParamKey::interactive, interactive) && interactive) {
+    if (rule.get(StyleParamKey::interactive, interactive) && interactive) {
         if (selectionColor == 0) {
-            selectionColor = m_scene->featureSelection()->nextColorIdentifier();
+            selectionColor = featureSelection.nextColorIdentifier();
         }
-        rule->selectionColor = selectionColor;
+        rule.selectionColor = selectionColor;
     } else {
-        rule->selectionColor = 0;
+        rule.selectionColor = 0;
     }
 
-    if (!styler->addFeature(*feature, *rule)) { return false; }
+    if (!styler->addFeature(*feature, rule)) { return false; }
 
     marker.setSelectionColor(selectionColor);
     marker.setMesh(styler->style().getID(), zoom, styler->build());
@@ -461,6 +615,80 @@ bool MarkerManager::buildMesh(Marker& marker, int zoom) {
     return true;
 }
 
+bool MarkerManager::queueMesh(Marker& marker) {
+
+    auto rule = marker.drawRule();
+
+    // JS functions of marker stylings are only known to the StyleContext of the MarkerManager.
+    bool hasFunctions = false;
+    if (rule) {
+        for (size_t i = 0; i < StyleParamKeySize && !hasFunctions; ++i) {
+            hasFunctions = rule->active[i] && rule->params[i].param->function >= 0;
+        }
+    }
+
+    if (!m_batchQueue || !marker.feature() || !rule || hasFunctions) {
+        buildMesh(marker, m_zoom);
+        return true;
+    }
+
+    m_queuedMarkers.push_back(&marker);
+    return false;
+}
+
+void MarkerManager::flushBatches() {
+
+    for (size_t start = 0; start < m_queuedMarkers.size(); start += BATCH_SIZE) {
+        auto batch = std::make_shared<Batch>();
+
+        batch->id = ++m_batchCounter;
+        if (batch->id == 0) { batch->id = ++m_batchCounter; }
+        batch->zoom = m_zoom;
+        batch->scene = m_scene;
+
+        size_t end = std::min(start + BATCH_SIZE, m_queuedMarkers.size());
+        for (size_t i = start; i < end; ++i) {
+            auto& marker = *m_queuedMarkers[i];
+            marker.setPendingBuild(batch->id, m_zoom);
+            batch->markers.push_back(marker.copyForBuild());
+        }
+
+        m_batches.push_back(batch);
+        m_batchQueue->enqueue(std::move(batch));
+    }
+
+    m_queuedMarkers.clear();
+}
+
+bool MarkerManager::applyBatches() {
+
+    bool changed = false;
+
+    for (auto it = m_batches.begin(); it != m_batches.end();) {
+        auto& batch = **it;
+
+        if (!batch.done) {
+            ++it;
+            continue;
+        }
+
+        for (auto& built : batch.markers) {
+            // Skip markers that were removed or changed again since the batch was queued.
+            Marker* marker = getMarkerOrNull(built->id());
+            if (!marker || marker->pendingBatch() != batch.id) { continue; }
+
+            marker->setMesh(built->styleId(), batch.zoom, built->releaseMesh());
+            marker->setSelectionColor(built->selectionColor());
+            marker->setPendingBuild(0, 0);
+            changed = true;
+        }
+
+        it = m_batches.erase(it);
+    }
+
+    return changed;
+}
+
 const Marker* MarkerManager::getMarkerOrNullBySelectionColor(uint32_t selectionColor) const {
     for (const auto& marker : m_markers) {
         if (marker->isVisible() && marker->selectionColor() == selectionColor) {
@@ -473,9 +701,8 @@ const Marker* MarkerManager::getMarkerOrNullBySelectionColor(uint32_t selectionC
 
 Marker* MarkerManager::getMarkerOrNull(MarkerID markerID) {
     if (!markerID) { return nullptr; }
-    for (const auto& entry : m_markers) {
-        if (entry->id() == markerID) { return entry.get(); }
-    }
+    auto it = m_markersById.find(markerID);
+    if (it != m_markersById.end()) { return it->second; }
     return nullptr;
 }
 
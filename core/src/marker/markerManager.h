@@ -5,11 +5,15 @@
 #include "util/fastmap.h"
 #include "util/types.h"
 
+#include <atomic>
+#include <deque>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace Tangram {
 
+class FeatureSelection;
 class MapProjection;
 class Marker;
 class Scene;
@@ -21,17 +25,57 @@ class MarkerManager {
 
 public:
 
+    using StyleBuilders = fastmap<std::string, std::unique_ptr<StyleBuilder>>;
+
+    /* Copies of markers whose meshes are built on a worker thread. The meshes
+     * are swapped into the markers by the next update() */
+    struct Batch {
+        uint32_t id = 0;
+        int zoom = 0;
+        // Keeps the scene data referenced by the draw rules alive
+        std::shared_ptr<Scene> scene;
+        std::vector<std::unique_ptr<Marker>> markers;
+        std::atomic<bool> done{false};
+    };
+
+    /* Runs Batches on other threads with TileBuilder::buildMarkers() */
+    class BatchQueue {
+    public:
+        virtual ~BatchQueue() {}
+
+        virtual void enqueue(std::shared_ptr<Batch> _batch) = 0;
+    };
+
     MarkerManager();
     ~MarkerManager();
     // Set the Scene object whose styling information will be used to build markers.
     void setScene(std::shared_ptr<Scene> scene);
 
+    // Build meshes of markers changed in bulk on the threads of this queue; without a queue
+    // all meshes are built synchronously.
+    void setBatchQueue(BatchQueue* queue) { m_batchQueue = queue; }
+
     // Create a new, empty marker and return its ID. An ID of 0 indicates an invalid marker.
     MarkerID add();
 
     // Try to remove the marker with the given ID; returns true if the marker was found and removed.
     bool remove(MarkerID markerID);
 
+    // Add point markers at the given positions which all use the same styling, either a YAML string
+    // or a scene path; the IDs of the new markers are written to markerIDs. Returns false and adds no
+    // markers if the styling is invalid.
+    bool addPoints(const LngLat* lngLats, int count, const char* styling, bool isPath, MarkerID* markerIDs);
+
+    // Remove the markers with the given IDs; returns the number of markers that were found and removed.
+    int remove(const MarkerID* markerIDs, int count);
+
+    // Set the same styling for the markers with the given IDs; returns false if the styling is invalid.
+    bool setStyling(const MarkerID* markerIDs, int count, const char* styling, bool isPath);
+
+    // Move the markers with the given IDs to point features at the given positions; returns the number
+    // of markers that were found and updated.
+    int setPoints(const MarkerID* markerIDs, const LngLat* lngLats, int count);
+
     // Set the styling for a marker using a YAML string; returns true if the marker was found and updated.
     bool setStylingFromString(MarkerID markerID, const char* styling) {
         return setStyling(markerID, styling, false);
@@ -75,6 +119,11 @@ public:
     // Rebuild all markers.
     void rebuildAll();
 
+    // Build the mesh of a marker at the given zoom level with the given StyleBuilders; this is used on
+    // the render thread and by TileBuilders for Batches.
+    static bool buildMesh(Marker& marker, int zoom, StyleBuilders& styleBuilders, StyleContext& styleContext,
+                          DrawRuleMergeSet& ruleSet, FeatureSelection& featureSelection);
+
     const std::vector<std::unique_ptr<Marker>>& markers() const;
 
     const Marker* getMarkerOrNullBySelectionColor(uint32_t selectionColor) const;
@@ -87,11 +136,33 @@ private:
     bool buildStyling(Marker& marker);
     bool buildMesh(Marker& marker, int zoom);
 
+    // Add the marker to the next Batch, or build its mesh right away when it can not be built on
+    // a worker thread.
+    // Returns true when the mesh was built right away.
+    bool queueMesh(Marker& marker);
+
+    // Enqueue the markers added by queueMesh() in Batches.
+    void flushBatches();
+
+    // Swap in the meshes of finished Batches; returns true when any marker changed.
+    bool applyBatches();
+
+    void setPointFeature(Marker& marker, LngLat lngLat);
+
     std::unique_ptr<StyleContext> m_styleContext;
     std::shared_ptr<Scene> m_scene;
     std::vector<std::unique_ptr<Marker>> m_markers;
+    std::unordered_map<MarkerID, Marker*> m_markersById;
     std::vector<std::string> m_jsFnList;
-    fastmap<std::string, std::unique_ptr<StyleBuilder>> m_styleBuilders;
+    StyleBuilders m_styleBuilders;
+    DrawRuleMergeSet m_ruleSet;
+
+    BatchQueue* m_batchQueue = nullptr;
+    // Markers to be built in the next Batches
+    std::vector<Marker*> m_queuedMarkers;
+    // Batches in flight
+    std::deque<std::shared_ptr<Batch>> m_batches;
+    uint32_t m_batchCounter = 0;
 
     uint32_t m_idCounter = 0;
     int m_zoom = 0;
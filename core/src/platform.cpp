@@ -36,6 +36,10 @@ bool Platform::bytesFromFileSystem(const char* _path, std::function<char*(size_t
     return true;
 }
 
+void Platform::setUrlRequestPriority(UrlRequestHandle _request, float _priority) {
+    // No-op by default
+}
+
 FontSourceHandle Platform::systemFont(const std::string& _name, const std::string& _weight, const std::string& _face) const {
     // No-op by default
     return FontSourceHandle();
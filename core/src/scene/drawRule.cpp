@@ -125,7 +125,7 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
     }
 
     // If the first filter doesn't match, return immediately
-    if (!_layer.filter().eval(_feature, _ctx)) { return false; }
+    if (!_layer.filterProgram().eval(_feature, _ctx)) { return false; }
 
     m_queuedLayers.push_back(&_layer);
 
@@ -146,7 +146,7 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
                 continue;
             }
 
-            if (sublayer.filter().eval(_feature, _ctx)) {
+            if (sublayer.filterProgram().eval(_feature, _ctx)) {
                 m_queuedLayers.push_back(&sublayer);
             }
         }
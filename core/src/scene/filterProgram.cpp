@@ -0,0 +1,285 @@
+#include "scene/filterProgram.h"
+
+#include "data/propertyKeys.h"
+#include "data/tileData.h"
+#include "scene/styleContext.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace Tangram {
+
+static constexpr size_t LINEAR_SET_SIZE = 8;
+
+static bool equalNumber(double _a, double _b) {
+    if (_a == _b) { return true; }
+    return std::fabs(_a - _b) <= std::numeric_limits<double>::epsilon();
+}
+
+FilterProgram::FilterProgram(const Filter& _filter) {
+    // An invalid filter matches everything: leave the program empty
+    if (!_filter.isValid()) { return; }
+
+    compile(_filter);
+    threadJumps();
+}
+
+size_t FilterProgram::emit(Instruction _instruction) {
+    m_code.push_back(_instruction);
+    return m_code.size() - 1;
+}
+
+uint32_t FilterProgram::addKey(const std::string& _key) {
+    auto it = std::find(m_keys.begin(), m_keys.end(), _key);
+    if (it != m_keys.end()) {
+        return std::distance(m_keys.begin(), it);
+    }
+    m_keys.push_back(_key);
+    return m_keys.size() - 1;
+}
+
+void FilterProgram::compileOperator(const std::vector<Filter>& _operands, Branch _shortCircuit, Op _empty) {
+    if (_operands.empty()) {
+        Instruction ins;
+        ins.op = _empty;
+        emit(ins);
+        return;
+    }
+
+    std::vector<size_t> jumps;
+    for (size_t i = 0; i < _operands.size(); i++) {
+        compile(_operands[i]);
+
+        if (i + 1 < _operands.size()) {
+            // Attach the jump to the operand's last test, unless a jump of a
+            // nested operator lands right after it.
+            auto& last = m_code.back();
+            if (last.branch == Branch::none && m_lastTarget != m_code.size()) {
+                last.branch = _shortCircuit;
+                jumps.push_back(m_code.size() - 1);
+            } else {
+                Instruction ins;
+                ins.branch = _shortCircuit;
+                jumps.push_back(emit(ins));
+            }
+        }
+    }
+    // Leave the operator with the result of the last evaluated operand
+    for (size_t jump : jumps) {
+        m_code[jump].target = m_code.size();
+    }
+    if (!jumps.empty()) {
+        m_lastTarget = m_code.size();
+    }
+}
+
+void FilterProgram::compile(const Filter& _filter) {
+    using Data = Filter::Data;
+
+    const auto& data = _filter.data;
+    Instruction ins;
+
+    auto setKey = [&](const std::string& _key, FilterKeyword _keyword) {
+        ins.keyword = _keyword;
+        if (_keyword == FilterKeyword::undefined) {
+            ins.key = addKey(_key);
+            ins.keyId = PropertyKeys::intern(_key);
+        }
+    };
+
+    switch (data.which()) {
+    case Data::type<Filter::OperatorAll>::value:
+        compileOperator(data.get<Filter::OperatorAll>().operands, Branch::if_false, Op::pass);
+        return;
+
+    case Data::type<Filter::OperatorAny>::value:
+        compileOperator(data.get<Filter::OperatorAny>().operands, Branch::if_true, Op::fail);
+        return;
+
+    case Data::type<Filter::OperatorNone>::value:
+        compileOperator(data.get<Filter::OperatorNone>().operands, Branch::if_true, Op::fail);
+        ins.op = Op::negate;
+        break;
+
+    case Data::type<Filter::Existence>::value: {
+        auto& f = data.get<Filter::Existence>();
+        ins.op = Op::existence;
+        ins.flag = f.exists;
+        // Existence is always tested on feature properties
+        setKey(f.key, FilterKeyword::undefined);
+        break;
+    }
+    case Data::type<Filter::Equality>::value: {
+        auto& f = data.get<Filter::Equality>();
+        setKey(f.key, f.keyword);
+        if (f.value.is<double>()) {
+            ins.op = Op::equal_number;
+            ins.number = f.value.get<double>();
+        } else if (f.value.is<std::string>()) {
+            ins.op = Op::equal_string;
+            ins.arg = m_strings.size();
+            m_strings.push_back(f.value.get<std::string>());
+        } else {
+            ins.op = Op::fail;
+        }
+        break;
+    }
+    case Data::type<Filter::EqualitySet>::value: {
+        auto& f = data.get<Filter::EqualitySet>();
+        setKey(f.key, f.keyword);
+
+        ValueSet set;
+        for (const auto& value : f.values) {
+            if (value.is<double>()) {
+                set.numbers.push_back(value.get<double>());
+            } else if (value.is<std::string>()) {
+                const auto& str = value.get<std::string>();
+                set.strings.emplace_back(std::hash<std::string>{}(str), m_strings.size());
+                m_strings.push_back(str);
+            }
+        }
+        std::sort(set.strings.begin(), set.strings.end());
+
+        ins.op = Op::equal_set;
+        ins.arg = m_sets.size();
+        m_sets.push_back(std::move(set));
+        break;
+    }
+    case Data::type<Filter::Range>::value: {
+        auto& f = data.get<Filter::Range>();
+        setKey(f.key, f.keyword);
+        ins.op = Op::range;
+        ins.flag = f.hasPixelArea;
+        ins.min = f.min;
+        ins.max = f.max;
+        break;
+    }
+    case Data::type<Filter::Function>::value:
+        ins.op = Op::function;
+        ins.arg = data.get<Filter::Function>().id;
+        break;
+
+    default:
+        ins.op = Op::pass;
+        break;
+    }
+
+    emit(ins);
+}
+
+void FilterProgram::threadJumps() {
+    // Jumps landing on a plain jump can go straight to its outcome,
+    // the result is unchanged in between.
+    for (auto& ins : m_code) {
+        if (ins.branch == Branch::none) { continue; }
+
+        while (ins.target < m_code.size()) {
+            const auto& next = m_code[ins.target];
+            if (next.op != Op::none) { break; }
+
+            if (next.branch == ins.branch) {
+                ins.target = next.target;
+            } else {
+                ins.target++;
+            }
+        }
+    }
+}
+
+bool FilterProgram::matchSet(const ValueSet& _set, const Value& _value) const {
+    if (_value.is<double>()) {
+        double num = _value.get<double>();
+        for (double n : _set.numbers) {
+            if (equalNumber(num, n)) { return true; }
+        }
+    } else if (_value.is<std::string>()) {
+        const auto& str = _value.get<std::string>();
+
+        // Comparing a few strings is cheaper than hashing
+        if (_set.strings.size() <= LINEAR_SET_SIZE) {
+            for (const auto& entry : _set.strings) {
+                if (m_strings[entry.second] == str) { return true; }
+            }
+            return false;
+        }
+
+        size_t hash = std::hash<std::string>{}(str);
+
+        auto it = std::lower_bound(_set.strings.begin(), _set.strings.end(),
+                                   std::make_pair(hash, uint32_t(0)));
+        for (; it != _set.strings.end() && it->first == hash; ++it) {
+            if (m_strings[it->second] == str) { return true; }
+        }
+    }
+    return false;
+}
+
+bool FilterProgram::eval(const Feature& _feature, StyleContext& _ctx) const {
+    const auto& props = _feature.props;
+
+    auto value = [&](const Instruction& _ins) -> const Value& {
+        return (_ins.keyword == FilterKeyword::undefined)
+            ? props.get(_ins.keyId, m_keys[_ins.key])
+            : _ctx.getKeyword(_ins.keyword);
+    };
+
+    bool result = true;
+    size_t pc = 0;
+    const size_t end = m_code.size();
+
+    while (pc < end) {
+        const auto& ins = m_code[pc++];
+
+        switch (ins.op) {
+        case Op::none:
+            break;
+        case Op::pass:
+            result = true;
+            break;
+        case Op::fail:
+            result = false;
+            break;
+        case Op::negate:
+            result = !result;
+            break;
+        case Op::existence:
+            result = ins.flag != value(ins).is<none_type>();
+            break;
+        case Op::equal_number: {
+            auto& v = value(ins);
+            result = v.is<double>() && equalNumber(v.get<double>(), ins.number);
+            break;
+        }
+        case Op::equal_string: {
+            auto& v = value(ins);
+            result = v.is<std::string>() && v.get<std::string>() == m_strings[ins.arg];
+            break;
+        }
+        case Op::equal_set:
+            result = matchSet(m_sets[ins.arg], value(ins));
+            break;
+        case Op::range: {
+            auto& v = value(ins);
+            if (v.is<double>()) {
+                auto scale = ins.flag ? _ctx.getPixelAreaScale() : 1.f;
+                double num = v.get<double>();
+                result = num >= ins.min * scale && num < ins.max * scale;
+            } else {
+                result = false;
+            }
+            break;
+        }
+        case Op::function:
+            result = _ctx.evalFilter(ins.arg);
+            break;
+        }
+
+        if (ins.branch == Branch(result)) { pc = ins.target; }
+    }
+
+    return result;
+}
+
+}
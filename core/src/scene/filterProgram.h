@@ -0,0 +1,96 @@
+#pragma once
+
+#include "scene/filters.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Tangram {
+
+class StyleContext;
+struct Feature;
+
+/* Flat, compiled form of a Filter tree
+ *
+ * Operators are flattened into a sequence of tests with conditional jumps
+ * which short-circuit like the tree evaluation in Filter::eval. Property
+ * keys are interned at compile time, so that features with resolved key ids
+ * (see PropertyKeys) are matched by integer compares. Large string sets are
+ * matched by hash lookup, confirmed by a string compare.
+ */
+class FilterProgram {
+
+public:
+
+    FilterProgram() = default;
+
+    explicit FilterProgram(const Filter& _filter);
+
+    bool eval(const Feature& _feature, StyleContext& _ctx) const;
+
+    size_t size() const { return m_code.size(); }
+
+private:
+
+    enum class Op : uint8_t {
+        none, // Keeps the result, for plain jumps
+        pass,
+        fail,
+        negate,
+        existence,
+        equal_number,
+        equal_string,
+        equal_set,
+        range,
+        function,
+    };
+
+    // Jump taken after an instruction when the result equals the branch value
+    enum class Branch : uint8_t {
+        if_false = 0,
+        if_true = 1,
+        none = 2,
+    };
+
+    struct Instruction {
+        Op op = Op::none;
+        Branch branch = Branch::none;
+        FilterKeyword keyword = FilterKeyword::undefined;
+        // Existence: whether the key must exist, Range: scale by pixel area
+        bool flag = false;
+        // Interned property key id and index into m_keys
+        int32_t keyId = -1;
+        uint32_t key = 0;
+        uint32_t target = 0;
+        // Function id or index into m_strings or m_sets
+        uint32_t arg = 0;
+        double number = 0;
+        float min = 0;
+        float max = 0;
+    };
+
+    struct ValueSet {
+        std::vector<double> numbers;
+        // Sorted by hash, index into m_strings
+        std::vector<std::pair<size_t, uint32_t>> strings;
+    };
+
+    void compile(const Filter& _filter);
+    void compileOperator(const std::vector<Filter>& _operands, Branch _shortCircuit, Op _empty);
+    size_t emit(Instruction _instruction);
+    uint32_t addKey(const std::string& _key);
+    void threadJumps();
+
+    bool matchSet(const ValueSet& _set, const Value& _value) const;
+
+    std::vector<Instruction> m_code;
+    // Highest jump target patched so far
+    size_t m_lastTarget = 0;
+    std::vector<std::string> m_keys;
+    std::vector<std::string> m_strings;
+    std::vector<ValueSet> m_sets;
+};
+
+}
@@ -145,7 +145,7 @@ public:
 
     std::shared_ptr<Texture> getTexture(const std::string& name) const;
 
-    float pixelScale() { return m_pixelScale; }
+    float pixelScale() const { return m_pixelScale; }
     void setPixelScale(float _scale);
 
     std::atomic_ushort pendingTextures{0};
@@ -0,0 +1,294 @@
+#include "scene/sceneDiff.h"
+
+#include "data/tileSource.h"
+#include "gl/shaderProgram.h"
+#include "scene/scene.h"
+#include "style/style.h"
+#include "util/yamlUtil.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+// Lookups on missing nodes give invalid nodes, which throw on most accessors
+static bool isMap(const YAML::Node& _node) {
+    return _node.IsDefined() && _node.IsMap();
+}
+
+static bool isScalar(const YAML::Node& _node) {
+    return _node.IsDefined() && _node.IsScalar();
+}
+
+static std::set<std::string> mapKeys(const YAML::Node& _a, const YAML::Node& _b) {
+    std::set<std::string> keys;
+    for (const auto& node : { _a, _b }) {
+        if (!isMap(node)) { continue; }
+        for (const auto& entry : node) {
+            if (entry.first.IsScalar()) { keys.insert(entry.first.Scalar()); }
+        }
+    }
+    return keys;
+}
+
+static void layerSources(const YAML::Node& _layer, std::set<std::string>& _sources) {
+    if (!isMap(_layer)) { return; }
+
+    const YAML::Node data = _layer["data"];
+    if (!isMap(data)) { return; }
+
+    const YAML::Node source = data["source"];
+    if (isScalar(source)) {
+        _sources.insert(source.Scalar());
+    } else if (source.IsDefined() && source.IsSequence()) {
+        for (const auto& s : source) {
+            if (s.IsScalar()) { _sources.insert(s.Scalar()); }
+        }
+    }
+}
+
+// Whether the draw rules of @_layer or of its sublayers use one of @_styles
+static bool usesStyles(const YAML::Node& _layer, const std::set<std::string>& _styles) {
+    for (const auto& entry : _layer) {
+        if (!entry.first.IsScalar() || !isMap(entry.second)) { continue; }
+
+        const auto& key = entry.first.Scalar();
+        if (key == "draw") {
+            for (const auto& rule : entry.second) {
+                if (!rule.first.IsScalar()) { continue; }
+
+                // Draw rules are named after their style unless it is set explicitly
+                std::string style = rule.first.Scalar();
+                if (isMap(rule.second)) {
+                    const YAML::Node styleNode = rule.second["style"];
+                    if (isScalar(styleNode)) { style = styleNode.Scalar(); }
+                }
+                if (_styles.count(style)) { return true; }
+            }
+        } else if (key != "data" && key != "filter") {
+            if (usesStyles(entry.second, _styles)) { return true; }
+        }
+    }
+    return false;
+}
+
+static bool isRasterSource(const YAML::Node& _source) {
+    if (!isMap(_source)) { return false; }
+
+    const YAML::Node type = _source["type"];
+    return (isScalar(type) && type.Scalar() == "Raster") || _source["rasters"].IsDefined();
+}
+
+static bool usedAsRaster(const YAML::Node& _sources, const std::string& _name) {
+    if (!isMap(_sources)) { return false; }
+
+    for (const auto& source : _sources) {
+        if (!isMap(source.second)) { continue; }
+
+        const YAML::Node rasters = source.second["rasters"];
+        if (!rasters.IsDefined() || !rasters.IsSequence()) { continue; }
+
+        for (const auto& raster : rasters) {
+            if (raster.IsScalar() && raster.Scalar() == _name) { return true; }
+        }
+    }
+    return false;
+}
+
+static const TileSource* findSource(const Scene& _scene, const std::string& _name) {
+    for (const auto& source : _scene.tileSources()) {
+        if (source->name() == _name) { return source.get(); }
+    }
+    return nullptr;
+}
+
+// Whether a source which parses @_current collections provides all of @_next.
+// No collections means that all are parsed.
+static bool hasCollections(const std::vector<std::string>& _current,
+                           const std::vector<std::string>& _next) {
+    if (_current.empty()) { return true; }
+    if (_next.empty()) { return false; }
+
+    for (const auto& collection : _next) {
+        if (std::find(_current.begin(), _current.end(), collection) == _current.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether style configurations differ only in values of 'shaders: uniforms'
+static bool equalExceptUniforms(const YAML::Node& _a, const YAML::Node& _b) {
+    if (!isMap(_a) || !isMap(_b)) { return false; }
+
+    const YAML::Node a = YAML::Clone(_a);
+    const YAML::Node b = YAML::Clone(_b);
+
+    for (const auto& style : { a, b }) {
+        YAML::Node shaders = style["shaders"];
+        if (isMap(shaders)) { shaders.remove("uniforms"); }
+    }
+    return YamlUtil::equal(a, b);
+}
+
+SceneDiff SceneDiff::compare(const YAML::Node& _current, const YAML::Node& _next) {
+    SceneDiff diff;
+
+    auto full = []() {
+        SceneDiff diff;
+        diff.change = Change::full;
+        return diff;
+    };
+
+    for (const auto& key : mapKeys(_current, _next)) {
+        const YAML::Node current = _current[key];
+        const YAML::Node next = _next[key];
+
+        if (YamlUtil::equal(current, next)) { continue; }
+
+        if (key == "global") {
+            // Globals are resolved into the nodes which reference them
+            continue;
+        } else if (key == "camera" || key == "cameras" || key == "scene") {
+            diff.settings = true;
+        } else if (key == "styles") {
+            diff.compareStyles(current, next);
+        } else if (key == "layers") {
+            diff.compareLayers(current, next);
+        } else if (key == "sources") {
+            if (!diff.compareSources(current, next)) { return full(); }
+        } else {
+            // Lights, textures, fonts
+            return full();
+        }
+    }
+
+    diff.addLayerSources(_next["layers"], diff.styles);
+    diff.classify();
+
+    return diff;
+}
+
+SceneDiff SceneDiff::compare(const Scene& _current, const Scene& _next) {
+    SceneDiff diff = compare(_current.config(), _next.config());
+
+    if (diff.change == Change::full) { return diff; }
+
+    // Tiles refer to the meshes of styles by their ID, which is the index of the style
+    const auto& currentStyles = _current.styles();
+    const auto& nextStyles = _next.styles();
+
+    bool sameStyles = currentStyles.size() == nextStyles.size();
+    for (size_t i = 0; sameStyles && i < currentStyles.size(); i++) {
+        sameStyles = currentStyles[i]->getName() == nextStyles[i]->getName();
+    }
+    if (!sameStyles) {
+        diff = SceneDiff();
+        diff.change = Change::full;
+        return diff;
+    }
+
+    // Uniforms are declared in the shader source, a different type or size
+    // of a uniform value needs a new shader program
+    std::set<std::string> rebuild;
+    for (const auto& name : diff.uniforms) {
+        auto current = _current.findStyle(name);
+        auto next = _next.findStyle(name);
+
+        if (!current || !next ||
+            current->shaderProgram()->vertexShaderSource() != next->shaderProgram()->vertexShaderSource() ||
+            current->shaderProgram()->fragmentShaderSource() != next->shaderProgram()->fragmentShaderSource()) {
+            rebuild.insert(name);
+        }
+    }
+    for (const auto& name : rebuild) {
+        diff.uniforms.erase(name);
+        diff.styles.insert(name);
+    }
+
+    diff.addLayerSources(_next.config()["layers"], rebuild);
+
+    // Kept sources only parse the collections used by layers of the current
+    // scene. Reload them when layers of the updated scene use other ones.
+    for (const auto& name : diff.rebuildSources) {
+        if (diff.reloadSources.count(name)) { continue; }
+
+        auto current = findSource(_current, name);
+        auto next = findSource(_next, name);
+        if (current && next && !hasCollections(current->collections(), next->collections())) {
+            diff.reloadSources.insert(name);
+        }
+    }
+
+    diff.classify();
+
+    return diff;
+}
+
+void SceneDiff::compareStyles(const YAML::Node& _current, const YAML::Node& _next) {
+    for (const auto& name : mapKeys(_current, _next)) {
+        const YAML::Node current = isMap(_current) ? _current[name] : YAML::Node();
+        const YAML::Node next = isMap(_next) ? _next[name] : YAML::Node();
+
+        if (YamlUtil::equal(current, next)) { continue; }
+
+        if (equalExceptUniforms(current, next)) {
+            uniforms.insert(name);
+        } else {
+            styles.insert(name);
+        }
+    }
+}
+
+void SceneDiff::compareLayers(const YAML::Node& _current, const YAML::Node& _next) {
+    for (const auto& name : mapKeys(_current, _next)) {
+        const YAML::Node current = isMap(_current) ? _current[name] : YAML::Node();
+        const YAML::Node next = isMap(_next) ? _next[name] : YAML::Node();
+
+        if (YamlUtil::equal(current, next)) { continue; }
+
+        // The layer may have moved to another source
+        layerSources(current, rebuildSources);
+        layerSources(next, rebuildSources);
+    }
+}
+
+bool SceneDiff::compareSources(const YAML::Node& _current, const YAML::Node& _next) {
+    for (const auto& name : mapKeys(_current, _next)) {
+        const YAML::Node current = isMap(_current) ? _current[name] : YAML::Node();
+        const YAML::Node next = isMap(_next) ? _next[name] : YAML::Node();
+
+        if (YamlUtil::equal(current, next)) { continue; }
+
+        // Added or removed sources change the raster inputs of styles. Raster
+        // sources are shared by the sources which use them.
+        if (!current.IsDefined() || !next.IsDefined() ||
+            isRasterSource(current) || isRasterSource(next) ||
+            usedAsRaster(_current, name) || usedAsRaster(_next, name)) {
+            return false;
+        }
+        reloadSources.insert(name);
+    }
+    return true;
+}
+
+void SceneDiff::addLayerSources(const YAML::Node& _layers, const std::set<std::string>& _styles) {
+    if (_styles.empty() || !isMap(_layers)) { return; }
+
+    for (const auto& layer : _layers) {
+        if (isMap(layer.second) && usesStyles(layer.second, _styles)) {
+            layerSources(layer.second, rebuildSources);
+        }
+    }
+}
+
+void SceneDiff::classify() {
+    if (!styles.empty() || !rebuildSources.empty() || !reloadSources.empty()) {
+        change = Change::partial;
+    } else if (!uniforms.empty() || settings) {
+        change = Change::live;
+    } else {
+        change = Change::none;
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "yaml-cpp/yaml.h"
+
+#include <set>
+#include <string>
+
+namespace Tangram {
+
+class Scene;
+
+/* Differences between the resolved configurations of two scenes
+ *
+ * Scene updates usually touch a few values of the scene. SceneDiff finds what
+ * an updated scene must replace of the current one:
+ *  live    - Only the camera, the background or values of style uniforms
+ *            changed; no tiles are rebuilt.
+ *  partial - Styles, layers or sources changed; only tiles of the sources whose
+ *            layers use changed styles or changed themselves are rebuilt.
+ *  full    - Anything else, e.g. lights, textures, fonts or added styles; the
+ *            updated scene replaces the current one.
+ */
+struct SceneDiff {
+
+    enum class Change { none, live, partial, full };
+
+    Change change = Change::none;
+
+    // Styles which must be replaced by the ones of the updated scene
+    std::set<std::string> styles;
+
+    // Styles of which only uniform values changed
+    std::set<std::string> uniforms;
+
+    // Sources of which tiles must be rebuilt
+    std::set<std::string> rebuildSources;
+
+    // Sources which are replaced by the ones of the updated scene
+    std::set<std::string> reloadSources;
+
+    // Camera or 'scene' properties changed
+    bool settings = false;
+
+    // Compare the configurations and the built styles of two scenes
+    static SceneDiff compare(const Scene& _current, const Scene& _next);
+
+    // Compare two resolved scene configurations
+    static SceneDiff compare(const YAML::Node& _current, const YAML::Node& _next);
+
+private:
+
+    void compareStyles(const YAML::Node& _current, const YAML::Node& _next);
+    void compareLayers(const YAML::Node& _current, const YAML::Node& _next);
+    bool compareSources(const YAML::Node& _current, const YAML::Node& _next);
+
+    // Add the sources of layers in @_layers which draw with one of @_styles
+    void addLayerSources(const YAML::Node& _layers, const std::set<std::string>& _styles);
+
+    void classify();
+};
+
+}
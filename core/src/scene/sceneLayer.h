@@ -1,6 +1,7 @@
 #pragma once
 
 #include "scene/drawRule.h"
+#include "scene/filterProgram.h"
 #include "scene/filters.h"
 #include "scene/styleParam.h"
 
@@ -14,6 +15,8 @@ struct Feature;
 class SceneLayer {
 
     Filter m_filter;
+    // Compiled m_filter used for matching features
+    FilterProgram m_filterProgram;
     std::string m_name;
     std::vector<DrawRuleData> m_rules;
     std::vector<SceneLayer> m_sublayers;
@@ -29,6 +32,7 @@ public:
 
     const auto& name() const { return m_name; }
     const auto& filter() const { return m_filter; }
+    const auto& filterProgram() const { return m_filterProgram; }
     const auto& rules() const { return m_rules; }
     const auto& sublayers() const { return m_sublayers; }
     const auto& depth() const { return m_depth; }
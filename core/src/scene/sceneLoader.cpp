@@ -1,6 +1,7 @@
 #include "scene/sceneLoader.h"
 
 #include "data/clientGeoJsonSource.h"
+#include "data/diskCacheDataSource.h"
 #include "data/memoryCacheDataSource.h"
 #include "data/mbtilesDataSource.h"
 #include "data/networkDataSource.h"
@@ -28,6 +29,7 @@
 #include "scene/stops.h"
 #include "scene/styleMixer.h"
 #include "scene/styleParam.h"
+#include "tile/tileMeshCache.h"
 #include "util/base64.h"
 #include "util/floatFormatter.h"
 #include "util/yamlPath.h"
@@ -56,6 +58,9 @@ namespace Tangram {
 // TODO: make this configurable: 16MB default in-memory DataSource cache:
 constexpr size_t CACHE_SIZE = 16 * (1024 * 1024);
 
+// Default size limit of the on-disk tile cache of a source
+constexpr size_t DISK_CACHE_SIZE = 256 * (1024 * 1024);
+
 static const std::string GLOBAL_PREFIX = "global.";
 
 bool SceneLoader::loadScene(const std::shared_ptr<Platform>& _platform, std::shared_ptr<Scene> _scene,
@@ -802,6 +807,24 @@ void SceneLoader::loadStyleProps(const std::shared_ptr<Platform>& platform, Styl
         }
     }
 
+    if (Node compactNode = styleNode["compact_vertices"]) {
+        bool boolValue;
+        if (YamlUtil::getBool(compactNode, boolValue)) {
+            style.setCompactVertices(boolValue);
+        }
+    }
+
+    if (Node batchingNode = styleNode["batching"]) {
+        bool boolValue;
+        if (YamlUtil::getBool(batchingNode, boolValue)) {
+            if (style.type() == StyleType::polygon || style.type() == StyleType::polyline) {
+                style.setBatching(boolValue);
+            } else {
+                LOGW("Batching is not supported by style %s", style.getName().c_str());
+            }
+        }
+    }
+
     if (Node dashNode = styleNode["dash"]) {
         if (auto polylineStyle = dynamic_cast<PolylineStyle*>(&style)) {
             if (dashNode.IsSequence()) {
@@ -939,6 +962,10 @@ void SceneLoader::loadSource(const std::shared_ptr<Platform>& platform, const st
     std::string type;
     std::string url;
     std::string mbtiles;
+    std::string diskCache;
+    size_t diskCacheSize = DISK_CACHE_SIZE;
+    std::string meshCache;
+    size_t meshCacheSize = DISK_CACHE_SIZE;
     std::vector<std::string> subdomains;
 
     int32_t minDisplayZoom = -1;
@@ -962,6 +989,26 @@ void SceneLoader::loadSource(const std::shared_ptr<Platform>& platform, const st
     if (auto maxZoomNode = source["max_zoom"]) {
         YamlUtil::getInt(maxZoomNode, maxZoom);
     }
+    if (auto cacheNode = source["cache"]) {
+        diskCache = cacheNode.Scalar();
+    }
+    if (auto cacheSizeNode = source["cache_size"]) {
+        // Size limit in megabytes
+        int cacheSize = 0;
+        if (YamlUtil::getInt(cacheSizeNode, cacheSize) && cacheSize > 0) {
+            diskCacheSize = size_t(cacheSize) * (1024 * 1024);
+        }
+    }
+    if (auto meshCacheNode = source["mesh_cache"]) {
+        meshCache = meshCacheNode.Scalar();
+    }
+    if (auto meshCacheSizeNode = source["mesh_cache_size"]) {
+        // Size limit in megabytes
+        int cacheSize = 0;
+        if (YamlUtil::getInt(meshCacheSizeNode, cacheSize) && cacheSize > 0) {
+            meshCacheSize = size_t(cacheSize) * (1024 * 1024);
+        }
+    }
     if (auto tileSizeNode = source["tile_size"]) {
         int tileSize = 0;
         if (YamlUtil::getInt(tileSizeNode, tileSize)) {
@@ -1048,7 +1095,15 @@ void SceneLoader::loadSource(const std::shared_ptr<Platform>& platform, const st
         return;
 #endif
     } else if (tiled) {
-        rawSources->setNext(std::make_unique<NetworkDataSource>(platform, url, std::move(subdomains), isTms));
+        auto networkSource = std::make_unique<NetworkDataSource>(platform, url, std::move(subdomains), isTms);
+
+        if (!diskCache.empty()) {
+            // Memory -> Disk -> Network
+            rawSources->setNext(std::make_unique<DiskCacheDataSource>(diskCache, diskCacheSize, url));
+            rawSources->next->setNext(std::move(networkSource));
+        } else {
+            rawSources->setNext(std::move(networkSource));
+        }
     }
 
     std::shared_ptr<TileSource> sourcePtr;
@@ -1084,6 +1139,10 @@ void SceneLoader::loadSource(const std::shared_ptr<Platform>& platform, const st
                 "This source will be ignored.", name.c_str());
             return;
         }
+
+        if (!meshCache.empty() && tiled) {
+            sourcePtr->setMeshCache(std::make_shared<TileMeshCache>(meshCache, meshCacheSize));
+        }
     }
 
     _scene->tileSources().push_back(sourcePtr);
@@ -1804,6 +1863,11 @@ void SceneLoader::loadLayer(const std::pair<Node, Node>& layer, const std::share
         collections.push_back(name);
     }
 
+    if (sublayer.enabled()) {
+        if (auto dataSource = scene->getTileSource(source)) {
+            dataSource->addCollections(collections);
+        }
+    }
 
     scene->layers().push_back({ std::move(sublayer), source, collections });
 }
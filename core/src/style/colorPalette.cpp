@@ -0,0 +1,73 @@
+#include "style/colorPalette.h"
+
+#include "log.h"
+
+namespace Tangram {
+
+constexpr int ColorPalette::WIDTH;
+constexpr int ColorPalette::MAX_SIZE;
+constexpr size_t ColorPalette::MAX_SHORT_ENTRIES;
+constexpr size_t ColorPalette::MAX_ENTRIES;
+
+uint32_t ColorPalette::add(GLuint _abgr, GLuint _selection) {
+
+    uint64_t key = (uint64_t(_selection) << 32) | _abgr;
+
+    auto it = m_indices.find(key);
+    if (it != m_indices.end()) { return it->second; }
+
+    if (size() == MAX_ENTRIES) {
+        LOGW("Color palette is full, using its first color");
+        return 0;
+    }
+
+    uint32_t index = size();
+    m_texels.push_back(_abgr);
+    m_texels.push_back(_selection);
+    m_indices.emplace(key, index);
+
+    return index;
+}
+
+std::vector<uint32_t> ColorPalette::merge(const ColorPalette& _other) {
+    std::vector<uint32_t> indices;
+    indices.reserve(_other.size());
+
+    for (size_t i = 0; i < _other.m_texels.size(); i += 2) {
+        indices.push_back(add(_other.m_texels[i], _other.m_texels[i+1]));
+    }
+    return indices;
+}
+
+void ColorPalette::clear() {
+    m_texels.clear();
+    m_indices.clear();
+}
+
+std::shared_ptr<Texture> ColorPalette::createTexture() const {
+
+    TextureOptions options;
+    options.minFilter = TextureMinFilter::NEAREST;
+    options.magFilter = TextureMagFilter::NEAREST;
+
+    int width = std::min<int>(m_texels.size(), WIDTH);
+    int height = (m_texels.size() + WIDTH - 1) / WIDTH;
+
+    // Entries keep both texels in one row, as widths stay even
+    while (height > MAX_SIZE) {
+        width *= 2;
+        height = (m_texels.size() + width - 1) / width;
+    }
+
+    // Fill up the last row
+    std::vector<GLuint> texels(m_texels);
+    texels.resize(width * height, 0);
+
+    auto texture = std::make_shared<Texture>(options);
+    texture->setPixelData(width, height, sizeof(GLuint),
+                          reinterpret_cast<const GLubyte*>(texels.data()),
+                          texels.size() * sizeof(GLuint));
+    return texture;
+}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "gl.h"
+#include "gl/mesh.h"
+#include "gl/texture.h"
+
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+/* Table of color and selection color pairs of one mesh
+ *
+ * Compact vertex formats store an index into the palette instead of the
+ * color and selection color. The palette is drawn from a RGBA texture
+ * holding two texels per entry, the color followed by the selection color,
+ * in rows of WIDTH texels. Rows are made wider when the texture would get
+ * higher than MAX_SIZE.
+ *
+ * Most compact vertices hold a 16 bit index, a palette growing beyond
+ * MAX_SHORT_ENTRIES needs a vertex format with a 32 bit index.
+ */
+class ColorPalette {
+
+public:
+
+    static constexpr int WIDTH = 256;
+    static constexpr int MAX_SIZE = 2048;
+    static constexpr size_t MAX_SHORT_ENTRIES = 65536;
+    static constexpr size_t MAX_ENTRIES = size_t(MAX_SIZE) * MAX_SIZE / 2;
+
+    /* Returns the index of the pair, adding it when it is new. When the
+     * palette texture cannot get any larger the first entry is returned. */
+    uint32_t add(GLuint _abgr, GLuint _selection);
+
+    /* Add the entries of @_other, returns the index of each of them in this
+     * palette */
+    std::vector<uint32_t> merge(const ColorPalette& _other);
+
+    size_t size() const { return m_texels.size() / 2; }
+
+    /* Whether some index does not fit into 16 bits */
+    bool needsWideIndex() const { return size() > MAX_SHORT_ENTRIES; }
+
+    void clear();
+
+    std::shared_ptr<Texture> createTexture() const;
+
+    /* Replace the palette index of @_vertices from @_first on by its entry in
+     * @_indices, for vertex types with a 'palette' member */
+    template<class V>
+    static void remap(std::vector<V>& _vertices, size_t _first,
+                      const std::vector<uint32_t>& _indices, std::true_type) {
+        for (size_t i = _first; i < _vertices.size(); i++) {
+            _vertices[i].palette = _indices[_vertices[i].palette];
+        }
+    }
+
+    template<class V>
+    static void remap(std::vector<V>&, size_t, const std::vector<uint32_t>&, std::false_type) {}
+
+private:
+
+    std::vector<GLuint> m_texels;
+    std::unordered_map<uint64_t, uint32_t> m_indices;
+};
+
+/* Mesh of compact vertices drawn with a <ColorPalette> texture */
+template<class T>
+class PaletteMesh : public Mesh<T> {
+
+public:
+
+    PaletteMesh(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode,
+                std::shared_ptr<Texture> _palette)
+        : Mesh<T>(_vertexLayout, _drawMode),
+          m_palette(std::move(_palette)) {}
+
+    Texture* palette() const override { return m_palette.get(); }
+
+    size_t bufferSize() const override {
+        return Mesh<T>::bufferSize() + m_palette->bufferSize();
+    }
+
+private:
+
+    std::shared_ptr<Texture> m_palette;
+};
+
+}
@@ -71,6 +71,9 @@ struct DebugStyleBuilder : public StyleBuilder {
         return std::move(mesh);
     }
 
+    // The tile bounds do not depend on features
+    void merge(StyleBuilder& _part) override {}
+
     const Style& style() const override { return m_style; }
 
     DebugStyleBuilder(const DebugStyle& _style) : m_style(_style) {}
@@ -36,6 +36,10 @@ void PointStyle::build(const Scene& _scene) {
     m_mesh = std::make_unique<DynamicQuadMesh<SpriteVertex>>(m_vertexLayout, m_drawMode);
 }
 
+int PointStyle::buildShaderPrograms(RenderState& rs) {
+    return Style::buildShaderPrograms(rs) + m_textStyle->buildShaderPrograms(rs);
+}
+
 void PointStyle::constructVertexLayout() {
 
     m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
@@ -108,6 +112,12 @@ void PointStyle::onBeginDrawSelectionFrame(RenderState& rs, const View& _view, S
     m_textStyle->onBeginDrawSelectionFrame(rs, _view, _scene);
 }
 
+void PointStyle::setLights(const std::vector<std::unique_ptr<Light>>& _lights) {
+    Style::setLights(_lights);
+
+    m_textStyle->setLights(_lights);
+}
+
 std::unique_ptr<StyleBuilder> PointStyle::createBuilder() const {
     return std::make_unique<PointStyleBuilder>(*this);
 }
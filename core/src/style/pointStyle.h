@@ -50,6 +50,10 @@ public:
 
     virtual void build(const Scene& _scene) override;
 
+    virtual int buildShaderPrograms(RenderState& rs) override;
+
+    virtual void setLights(const std::vector<std::unique_ptr<Light>>& _lights) override;
+
     virtual void constructVertexLayout() override;
     virtual void constructShaderProgram() override;
 
@@ -11,6 +11,7 @@
 #include "scene/stops.h"
 #include "selection/featureSelection.h"
 #include "tile/tile.h"
+#include "util/arena.h"
 #include "util/geom.h"
 #include "util/lineSampler.h"
 #include "view/view.h"
@@ -80,6 +81,23 @@ std::unique_ptr<StyledMesh> PointStyleBuilder::build() {
     return std::move(m_iconMesh);
 }
 
+void PointStyleBuilder::merge(StyleBuilder& _part) {
+    auto& part = static_cast<PointStyleBuilder&>(_part);
+
+    size_t quadOffset = m_quads.size();
+
+    for (auto& label : part.m_labels) {
+        static_cast<SpriteLabel&>(*label).relocate(*m_spriteLabels, quadOffset);
+        m_labels.push_back(std::move(label));
+    }
+    m_quads.insert(m_quads.end(), part.m_quads.begin(), part.m_quads.end());
+
+    part.m_labels.clear();
+    part.m_quads.clear();
+
+    m_textStyleBuilder->merge(*part.m_textStyleBuilder);
+}
+
 void PointStyleBuilder::setup(const Tile& _tile) {
     m_zoom = _tile.getID().z;
     m_styleZoom = _tile.getID().s;
@@ -451,7 +469,7 @@ void PointStyleBuilder::labelPointsPlacing(const Line& _line, const glm::vec4& _
             }
             break;
         case LabelProperty::Placement::spaced: {
-            LineSampler<std::vector<glm::vec3>> sampler;
+            LineSampler<ArenaVector<glm::vec3>> sampler { ArenaVector<glm::vec3>(m_arena) };
 
             sampler.set(_line);
 
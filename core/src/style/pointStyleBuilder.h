@@ -53,8 +53,15 @@ struct PointStyleBuilder : public StyleBuilder {
 
     std::unique_ptr<StyledMesh> build() override;
 
+    void merge(StyleBuilder& _part) override;
+
     const Style& style() const override { return m_style; }
 
+    void setArena(Arena* _arena) override {
+        m_arena = _arena;
+        m_textStyleBuilder->setArena(_arena);
+    }
+
     PointStyleBuilder(const PointStyle& _style) : m_style(_style) {
         m_textStyleBuilder = m_style.textStyle().createBuilder();
     }
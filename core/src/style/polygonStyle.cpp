@@ -7,9 +7,11 @@
 #include "material.h"
 #include "platform.h"
 #include "scene/drawRule.h"
+#include "style/colorPalette.h"
 #include "tile/tile.h"
 #include "util/builders.h"
 #include "util/extrude.h"
+#include "util/geom.h"
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
@@ -28,6 +30,9 @@ namespace Tangram {
 
 struct PolygonVertexNoUVs {
 
+    static constexpr bool usePalette = false;
+    using Wide = PolygonVertexNoUVs;
+
     PolygonVertexNoUVs(glm::vec3 position, uint32_t order, glm::vec3 normal, glm::vec2 uv, GLuint abgr, GLuint selection)
         : pos(glm::i16vec4{ glm::round(position * position_scale), order }),
           norm(normal * normal_scale),
@@ -43,12 +48,84 @@ struct PolygonVertexNoUVs {
 
 struct PolygonVertex : PolygonVertexNoUVs {
 
+    using Wide = PolygonVertex;
+
     PolygonVertex(glm::vec3 position, uint32_t order, glm::vec3 normal, glm::vec2 uv, GLuint abgr, GLuint selection)
         : PolygonVertexNoUVs(position, order, normal, uv, abgr, selection), texcoord(uv * texture_scale) {}
 
     glm::u16vec2 texcoord;
 };
 
+struct PolygonVertexWideNoUVs;
+struct PolygonVertexWide;
+
+// Compact vertices hold an index into the color palette of the mesh in place
+// of the color and selection color and an octahedral encoded normal
+struct PolygonVertexCompactNoUVs {
+
+    static constexpr bool usePalette = true;
+    using Wide = PolygonVertexWideNoUVs;
+
+    PolygonVertexCompactNoUVs(glm::vec3 position, uint32_t order, glm::vec3 normal, glm::vec2 uv,
+                              GLuint paletteIndex, GLuint)
+        : pos(glm::i16vec4{ glm::round(position * position_scale), order }),
+          norm(glm::round(octEncode(normal) * normal_scale)),
+          palette(paletteIndex) {}
+
+    glm::i16vec4 pos; // pos.w contains layer (params.order)
+    glm::i8vec2 norm;
+    uint16_t palette;
+};
+
+struct PolygonVertexCompact : PolygonVertexCompactNoUVs {
+
+    using Wide = PolygonVertexWide;
+
+    PolygonVertexCompact(glm::vec3 position, uint32_t order, glm::vec3 normal, glm::vec2 uv,
+                         GLuint paletteIndex, GLuint selection)
+        : PolygonVertexCompactNoUVs(position, order, normal, uv, paletteIndex, selection),
+          texcoord(uv * texture_scale) {}
+
+    glm::u16vec2 texcoord;
+};
+
+// Compact vertices with a 32 bit palette index, used in place of the ones
+// above when the palette of a mesh outgrows 16 bit indices
+struct PolygonVertexWideNoUVs {
+
+    static constexpr bool usePalette = true;
+    using Wide = PolygonVertexWideNoUVs;
+
+    PolygonVertexWideNoUVs(glm::vec3 position, uint32_t order, glm::vec3 normal, glm::vec2 uv,
+                           GLuint paletteIndex, GLuint)
+        : pos(glm::i16vec4{ glm::round(position * position_scale), order }),
+          norm(glm::round(octEncode(normal) * normal_scale)),
+          palette(paletteIndex) {}
+
+    PolygonVertexWideNoUVs(const PolygonVertexCompactNoUVs& v)
+        : pos(v.pos), norm(v.norm), palette(v.palette) {}
+
+    glm::i16vec4 pos; // pos.w contains layer (params.order)
+    glm::i8vec2 norm;
+    uint16_t padding = 0;
+    uint32_t palette;
+};
+
+struct PolygonVertexWide : PolygonVertexWideNoUVs {
+
+    using Wide = PolygonVertexWide;
+
+    PolygonVertexWide(glm::vec3 position, uint32_t order, glm::vec3 normal, glm::vec2 uv,
+                      GLuint paletteIndex, GLuint selection)
+        : PolygonVertexWideNoUVs(position, order, normal, uv, paletteIndex, selection),
+          texcoord(uv * texture_scale) {}
+
+    PolygonVertexWide(const PolygonVertexCompact& v)
+        : PolygonVertexWideNoUVs(v), texcoord(v.texcoord) {}
+
+    glm::u16vec2 texcoord;
+};
+
 PolygonStyle::PolygonStyle(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection)
     : Style(_name, _blendMode, _drawMode, _selection) {
     m_type = StyleType::polygon;
@@ -57,7 +134,25 @@ PolygonStyle::PolygonStyle(std::string _name, Blending _blendMode, GLenum _drawM
 
 void PolygonStyle::constructVertexLayout() {
 
-    if (m_texCoordsGeneration) {
+    if (m_compactVertices) {
+        std::vector<VertexLayout::VertexAttrib> attribs = {
+            {"a_position", 4, GL_SHORT, false, 0},
+            {"a_packed_normal", 2, GL_BYTE, true, 0},
+            {"a_palette_index", 1, GL_UNSIGNED_SHORT, false, 0},
+        };
+        std::vector<VertexLayout::VertexAttrib> wideAttribs = {
+            {"a_position", 4, GL_SHORT, false, 0},
+            {"a_packed_normal", 4, GL_BYTE, true, 0}, // The 3rd and 4th byte are for padding
+            {"a_palette_index", 2, GL_UNSIGNED_SHORT, false, 0}, // Low and high 16 bits
+        };
+        if (m_texCoordsGeneration) {
+            attribs.push_back({"a_texcoord", 2, GL_UNSIGNED_SHORT, true, 0});
+            wideAttribs.push_back({"a_texcoord", 2, GL_UNSIGNED_SHORT, true, 0});
+        }
+        m_vertexLayout = std::make_shared<VertexLayout>(attribs);
+        m_wideVertexLayout = std::make_shared<VertexLayout>(wideAttribs);
+
+    } else if (m_texCoordsGeneration) {
         m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
             {"a_position", 4, GL_SHORT, false, 0},
             {"a_normal", 4, GL_BYTE, true, 0}, // The 4th byte is for padding
@@ -83,6 +178,10 @@ void PolygonStyle::constructShaderProgram() {
     if (m_texCoordsGeneration) {
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_USE_TEX_COORDS\n");
     }
+
+    if (m_compactVertices) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_COMPACT_VERTICES\n", false);
+    }
 }
 
 template <class V>
@@ -103,13 +202,13 @@ public:
     void setup(const Tile& _tile) override {
         m_tileUnitsPerMeter = _tile.getInverseScale();
         m_zoom = _tile.getID().z;
-        m_meshData.clear();
+        clear();
     }
 
     void setup(const Marker& _marker, int zoom) override {
         m_zoom = zoom;
         m_tileUnitsPerMeter = 1.f / _marker.modelScale();
-        m_meshData.clear();
+        clear();
     }
 
     bool addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) override;
@@ -118,6 +217,8 @@ public:
 
     std::unique_ptr<StyledMesh> build() override;
 
+    void merge(StyleBuilder& _part) override;
+
     PolygonStyleBuilder(const PolygonStyle& _style) : m_style(_style) {}
 
     Parameters parseRule(const DrawRule& _rule, const Properties& _props);
@@ -126,12 +227,40 @@ public:
 
 private:
 
+    using WideVertex = typename V::Wide;
+
+    template<class W>
+    void addVertices(MeshData<W>& _meshData, const Polygon& _polygon, const Parameters& _params,
+                     GLuint _abgr, GLuint _selection);
+
+    template<class W>
+    std::unique_ptr<StyledMesh> buildMesh(MeshData<W>& _meshData,
+                                          std::shared_ptr<VertexLayout> _vertexLayout);
+
+    /* Move the vertices into m_wideMeshData, once the palette needs more
+     * than 16 bit indices */
+    void widen();
+
+    void clear() {
+        m_meshData.clear();
+        m_wideMeshData.clear();
+        m_wide = false;
+        m_palette.clear();
+    }
+
     const PolygonStyle& m_style;
 
     PolygonBuilder m_builder;
 
     MeshData<V> m_meshData;
 
+    // Vertices with 32 bit palette indices, in use when m_wide is set
+    MeshData<WideVertex> m_wideMeshData;
+    bool m_wide = false;
+
+    // Colors of compact vertices
+    ColorPalette m_palette;
+
     float m_tileUnitsPerMeter = 0;
     int m_zoom = 0;
 
@@ -139,16 +268,76 @@ private:
 
 template <class V>
 std::unique_ptr<StyledMesh> PolygonStyleBuilder<V>::build() {
-    if (m_meshData.vertices.empty()) { return nullptr; }
 
-    auto mesh = std::make_unique<Mesh<V>>(m_style.vertexLayout(),
-                                                      m_style.drawMode());
-    mesh->compile(m_meshData);
-    m_meshData.clear();
+    std::unique_ptr<StyledMesh> mesh;
+    if (m_wide) {
+        mesh = buildMesh(m_wideMeshData, m_style.wideVertexLayout());
+    } else {
+        mesh = buildMesh(m_meshData, m_style.vertexLayout());
+    }
+    clear();
+
+    return mesh;
+}
+
+template <class V>
+template <class W>
+std::unique_ptr<StyledMesh> PolygonStyleBuilder<V>::buildMesh(MeshData<W>& _meshData,
+                                                              std::shared_ptr<VertexLayout> _vertexLayout) {
+    if (_meshData.vertices.empty()) { return nullptr; }
+
+    std::unique_ptr<Mesh<W>> mesh;
+    if (V::usePalette) {
+        mesh = std::make_unique<PaletteMesh<W>>(_vertexLayout, m_style.drawMode(),
+                                                m_palette.createTexture());
+    } else {
+        mesh = std::make_unique<Mesh<W>>(_vertexLayout, m_style.drawMode());
+    }
+    mesh->setArenaPool(m_style.meshArenas());
+    mesh->compile(_meshData);
 
     return std::move(mesh);
 }
 
+template <class V>
+void PolygonStyleBuilder<V>::widen() {
+    if (m_wide) { return; }
+
+    m_wideMeshData.vertices.assign(m_meshData.vertices.begin(), m_meshData.vertices.end());
+    m_wideMeshData.indices = std::move(m_meshData.indices);
+    m_wideMeshData.offsets = std::move(m_meshData.offsets);
+    m_meshData.clear();
+    m_wide = true;
+}
+
+template <class V>
+void PolygonStyleBuilder<V>::merge(StyleBuilder& _part) {
+    auto& part = static_cast<PolygonStyleBuilder<V>&>(_part);
+
+    auto indices = m_palette.merge(part.m_palette);
+    auto usePalette = std::integral_constant<bool, V::usePalette>();
+
+    if (part.m_wide || m_palette.needsWideIndex()) { widen(); }
+
+    if (!m_wide) {
+        size_t first = m_meshData.vertices.size();
+        m_meshData.append(part.m_meshData);
+        ColorPalette::remap(m_meshData.vertices, first, indices, usePalette);
+        return;
+    }
+
+    size_t first = m_wideMeshData.vertices.size();
+    if (part.m_wide) {
+        m_wideMeshData.append(part.m_wideMeshData);
+    } else {
+        auto& data = part.m_meshData;
+        m_wideMeshData.vertices.insert(m_wideMeshData.vertices.end(), data.vertices.begin(), data.vertices.end());
+        m_wideMeshData.indices.insert(m_wideMeshData.indices.end(), data.indices.begin(), data.indices.end());
+        m_wideMeshData.offsets.insert(m_wideMeshData.offsets.end(), data.offsets.begin(), data.offsets.end());
+    }
+    ColorPalette::remap(m_wideMeshData.vertices, first, indices, usePalette);
+}
+
 template <class V>
 auto PolygonStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties& _props) -> Parameters {
     Parameters p;
@@ -176,31 +365,62 @@ bool PolygonStyleBuilder<V>::addPolygon(const Polygon& _polygon, const Propertie
 
     m_builder.keepTileEdges = p.keepTileEdges;
 
-    m_builder.addVertex = [this, p](const glm::vec3& coord,
-                                 const glm::vec3& normal,
-                                 const glm::vec2& uv) {
-        m_meshData.vertices.push_back({ coord, p.order, normal, uv, p.color, p.selectionColor });
+    GLuint abgr = p.color;
+    GLuint selection = p.selectionColor;
+    if (V::usePalette) {
+        abgr = m_palette.add(p.color, p.selectionColor);
+        selection = 0;
+        if (m_palette.needsWideIndex()) { widen(); }
+    }
+
+    if (m_wide) {
+        addVertices(m_wideMeshData, _polygon, p, abgr, selection);
+    } else {
+        addVertices(m_meshData, _polygon, p, abgr, selection);
+    }
+
+    return true;
+}
+
+template <class V>
+template <class W>
+void PolygonStyleBuilder<V>::addVertices(MeshData<W>& _meshData, const Polygon& _polygon,
+                                         const Parameters& _params, GLuint _abgr, GLuint _selection) {
+
+    uint32_t order = _params.order;
+    m_builder.addVertex = [&_meshData, order, _abgr, _selection](const glm::vec3& coord,
+                                                                const glm::vec3& normal,
+                                                                const glm::vec2& uv) {
+        _meshData.vertices.push_back({ coord, order, normal, uv, _abgr, _selection });
     };
 
-    if (p.minHeight != p.height) {
-        Builders::buildPolygonExtrusion(_polygon, p.minHeight,
-                                        p.height, m_builder);
+    if (_params.minHeight != _params.height) {
+        Builders::buildPolygonExtrusion(_polygon, _params.minHeight,
+                                        _params.height, m_builder);
     }
 
-    Builders::buildPolygon(_polygon, p.height, m_builder);
+    Builders::buildPolygon(_polygon, _params.height, m_builder);
 
-    m_meshData.indices.insert(m_meshData.indices.end(),
-                              m_builder.indices.begin(),
-                              m_builder.indices.end());
+    _meshData.indices.insert(_meshData.indices.end(),
+                             m_builder.indices.begin(),
+                             m_builder.indices.end());
 
-    m_meshData.offsets.emplace_back(m_builder.indices.size(),
-                                    m_builder.numVertices);
+    _meshData.offsets.emplace_back(m_builder.indices.size(),
+                                   m_builder.numVertices);
     m_builder.clear();
-
-    return true;
 }
 
 std::unique_ptr<StyleBuilder> PolygonStyle::createBuilder() const {
+    if (m_compactVertices) {
+        if (m_texCoordsGeneration) {
+            auto builder = std::make_unique<PolygonStyleBuilder<PolygonVertexCompact>>(*this);
+            builder->polygonBuilder().useTexCoords = true;
+            return std::move(builder);
+        }
+        auto builder = std::make_unique<PolygonStyleBuilder<PolygonVertexCompactNoUVs>>(*this);
+        builder->polygonBuilder().useTexCoords = false;
+        return std::move(builder);
+    }
     if (m_texCoordsGeneration) {
         auto builder = std::make_unique<PolygonStyleBuilder<PolygonVertex>>(*this);
         builder->polygonBuilder().useTexCoords = true;
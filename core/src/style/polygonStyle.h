@@ -18,6 +18,14 @@ public:
     virtual std::unique_ptr<StyleBuilder> createBuilder() const override;
     virtual ~PolygonStyle() {}
 
+    /* Layout of compact vertices with a 32 bit palette index, for meshes with
+     * more palette entries than a 16 bit index can address */
+    const auto& wideVertexLayout() const { return m_wideVertexLayout; }
+
+protected:
+
+    std::shared_ptr<VertexLayout> m_wideVertexLayout;
+
 };
 
 }
@@ -11,6 +11,7 @@
 #include "platform.h"
 #include "scene/stops.h"
 #include "scene/drawRule.h"
+#include "style/colorPalette.h"
 #include "tile/tile.h"
 #include "util/builders.h"
 #include "util/dashArray.h"
@@ -33,6 +34,9 @@ constexpr float dash_scale = 20.f;
 namespace Tangram {
 
 struct PolylineVertexNoUVs {
+
+    static constexpr bool usePalette = false;
+
     PolylineVertexNoUVs(glm::vec2 position, glm::vec2 extrude, glm::vec2 uv,
                         glm::i16vec2 width, glm::i16vec2 height, GLuint abgr, GLuint selection)
         : pos(glm::i16vec2{ glm::round(position * position_scale)}, height),
@@ -65,6 +69,43 @@ struct PolylineVertex : PolylineVertexNoUVs {
     glm::u16vec2 texcoord;
 };
 
+// Compact vertices hold an index into the color palette of the mesh in place
+// of the color and selection color
+struct PolylineVertexCompactNoUVs {
+
+    static constexpr bool usePalette = true;
+
+    PolylineVertexCompactNoUVs(glm::vec2 position, glm::vec2 extrude, glm::vec2 uv,
+                               glm::i16vec2 width, glm::i16vec2 height, GLuint paletteIndex, GLuint)
+        : pos(glm::i16vec2{ glm::round(position * position_scale)}, height),
+          extrude(glm::i16vec2{extrude * extrusion_scale}, width),
+          palette(paletteIndex) {}
+
+    PolylineVertexCompactNoUVs(PolylineVertexCompactNoUVs v, short order, glm::i16vec2 width,
+                               GLuint paletteIndex, GLuint)
+        : pos(glm::i16vec4{glm::i16vec3{v.pos}, order}),
+          extrude(glm::i16vec4{ v.extrude.x, v.extrude.y, width }),
+          palette(paletteIndex) {}
+
+    glm::i16vec4 pos;
+    glm::i16vec4 extrude;
+    uint32_t palette;
+};
+
+struct PolylineVertexCompact : PolylineVertexCompactNoUVs {
+    PolylineVertexCompact(glm::vec2 position, glm::vec2 extrude, glm::vec2 uv,
+                          glm::i16vec2 width, glm::i16vec2 height, GLuint paletteIndex, GLuint selection)
+        : PolylineVertexCompactNoUVs(position, extrude, uv, width, height, paletteIndex, selection),
+          texcoord(uv * texture_scale) {}
+
+    PolylineVertexCompact(PolylineVertexCompact v, short order, glm::i16vec2 width,
+                          GLuint paletteIndex, GLuint selection)
+        : PolylineVertexCompactNoUVs(v, order, width, paletteIndex, selection),
+          texcoord(v.texcoord) {}
+
+    glm::u16vec2 texcoord;
+};
+
 PolylineStyle::PolylineStyle(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection)
     : Style(_name, _blendMode, _drawMode, _selection) {
     m_type = StyleType::polyline;
@@ -74,7 +115,18 @@ PolylineStyle::PolylineStyle(std::string _name, Blending _blendMode, GLenum _dra
 void PolylineStyle::constructVertexLayout() {
 
     // TODO: Ideally this would be in the same location as the struct that it basically describes
-    if (m_texCoordsGeneration) {
+    if (m_compactVertices) {
+        std::vector<VertexLayout::VertexAttrib> attribs = {
+            {"a_position", 4, GL_SHORT, false, 0},
+            {"a_extrude", 4, GL_SHORT, false, 0},
+            {"a_palette_index", 2, GL_UNSIGNED_SHORT, false, 0}, // Low and high 16 bits
+        };
+        if (m_texCoordsGeneration) {
+            attribs.push_back({"a_texcoord", 2, GL_UNSIGNED_SHORT, false, 0});
+        }
+        m_vertexLayout = std::make_shared<VertexLayout>(attribs);
+
+    } else if (m_texCoordsGeneration) {
         m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
             {"a_position", 4, GL_SHORT, false, 0},
             {"a_extrude", 4, GL_SHORT, false, 0},
@@ -148,6 +200,10 @@ void PolylineStyle::constructShaderProgram() {
     if (m_texCoordsGeneration) {
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_USE_TEX_COORDS\n");
     }
+
+    if (m_compactVertices) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_COMPACT_VERTICES\n", false);
+    }
 }
 
 template <class V>
@@ -188,6 +244,8 @@ public:
 
     std::unique_ptr<StyledMesh> build() override;
 
+    void merge(StyleBuilder& _part) override;
+
     PolylineStyleBuilder(const PolylineStyle& _style)
         : m_style(_style),
           m_meshData(2) {}
@@ -201,6 +259,9 @@ public:
 
     bool evalWidth(const StyleParam& _styleParam, float& width, float& slope);
 
+    /* Turn the colors into their palette index for compact vertices */
+    void paletteColors(GLuint& _abgr, GLuint& _selection);
+
     PolyLineBuilder& polylineBuilder() { return m_builder; }
 
 private:
@@ -210,6 +271,9 @@ private:
 
     std::vector<MeshData<V>> m_meshData;
 
+    // Colors of compact vertices
+    ColorPalette m_palette;
+
     float m_tileUnitsPerMeter = 0;
     float m_tileUnitsPerPixel = 0;
     int m_zoom = 0;
@@ -227,6 +291,8 @@ void PolylineStyleBuilder<V>::setup(const Tile& tile) {
     m_tileUnitsPerMeter = tile.getInverseScale();
     m_tileUnitsPerPixel = 1.f / MapProjection::tileSize();
 
+    m_palette.clear();
+
     // When a tile is overzoomed, we are actually styling the area of its
     // 'source' tile, which will have a larger effective pixel size at the
     // 'style' zoom level. This scaling is performed in the vertex shader to
@@ -246,6 +312,8 @@ void PolylineStyleBuilder<V>::setup(const Marker& marker, int zoom) {
     // by the ratio of the Marker's extent to the length of a tile side at this zoom.
     m_tileUnitsPerPixel = metersPerTile / (marker.extent() * 256.f);
 
+    m_palette.clear();
+
 }
 
 template <class V>
@@ -255,7 +323,14 @@ std::unique_ptr<StyledMesh> PolylineStyleBuilder<V>::build() {
         return nullptr;
     }
 
-    auto mesh = std::make_unique<Mesh<V>>(m_style.vertexLayout(), m_style.drawMode());
+    std::unique_ptr<Mesh<V>> mesh;
+    if (V::usePalette) {
+        mesh = std::make_unique<PaletteMesh<V>>(m_style.vertexLayout(), m_style.drawMode(),
+                                                m_palette.createTexture());
+        m_palette.clear();
+    } else {
+        mesh = std::make_unique<Mesh<V>>(m_style.vertexLayout(), m_style.drawMode());
+    }
 
     bool painterMode = (m_style.blendMode() == Blending::overlay ||
                         m_style.blendMode() == Blending::inlay);
@@ -263,6 +338,7 @@ std::unique_ptr<StyledMesh> PolylineStyleBuilder<V>::build() {
     // Swap draw order to draw outline first when not using depth testing
     if (painterMode) { std::swap(m_meshData[0], m_meshData[1]); }
 
+    mesh->setArenaPool(m_style.meshArenas());
     mesh->compile(m_meshData);
 
     // Swapping back since fill mesh may have more vertices than outline
@@ -273,6 +349,30 @@ std::unique_ptr<StyledMesh> PolylineStyleBuilder<V>::build() {
     return std::move(mesh);
 }
 
+template <class V>
+void PolylineStyleBuilder<V>::merge(StyleBuilder& _part) {
+    auto& part = static_cast<PolylineStyleBuilder<V>&>(_part);
+
+    size_t first[] = { m_meshData[0].vertices.size(), m_meshData[1].vertices.size() };
+
+    m_meshData[0].append(part.m_meshData[0]);
+    m_meshData[1].append(part.m_meshData[1]);
+
+    auto indices = m_palette.merge(part.m_palette);
+    for (size_t i = 0; i < 2; i++) {
+        ColorPalette::remap(m_meshData[i].vertices, first[i], indices,
+                            std::integral_constant<bool, V::usePalette>());
+    }
+}
+
+template <class V>
+void PolylineStyleBuilder<V>::paletteColors(GLuint& _abgr, GLuint& _selection) {
+    if (V::usePalette) {
+        _abgr = m_palette.add(_abgr, _selection);
+        _selection = 0;
+    }
+}
+
 template <class V>
 auto PolylineStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties& _props) -> Parameters {
     Parameters p;
@@ -432,9 +532,12 @@ void PolylineStyleBuilder<V>::buildLine(const Line& _line, const typename Parame
                                         MeshData<V>& _mesh, GLuint selection) {
 
     float zoom = m_overzoom2;
+    GLuint abgr = _att.color;
+    paletteColors(abgr, selection);
+
     m_builder.addVertex = [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
         _mesh.vertices.push_back({{ coord.x,coord.y }, normal, { uv.x, uv.y * zoom },
-                                  _att.width, _att.height, _att.color, selection});
+                                  _att.width, _att.height, abgr, selection});
     };
 
     Builders::buildPolyLine(_line, m_builder);
@@ -491,15 +594,28 @@ void PolylineStyleBuilder<V>::addMesh(const Line& _line, const Parameters& _para
 
         glm::vec2 width = _params.stroke.width;
         GLuint abgr = _params.stroke.color;
+        GLuint selection = _params.selectionColor;
         short order = _params.stroke.height[1];
 
+        paletteColors(abgr, selection);
+
         for (; vertexIt != fill.vertices.end(); ++vertexIt) {
-            stroke.vertices.emplace_back(*vertexIt, order, width, abgr, _params.selectionColor);
+            stroke.vertices.emplace_back(*vertexIt, order, width, abgr, selection);
         }
     }
 }
 
 std::unique_ptr<StyleBuilder> PolylineStyle::createBuilder() const {
+    if (m_compactVertices) {
+        if (m_texCoordsGeneration) {
+            auto builder = std::make_unique<PolylineStyleBuilder<PolylineVertexCompact>>(*this);
+            builder->polylineBuilder().useTexCoords = true;
+            return std::move(builder);
+        }
+        auto builder = std::make_unique<PolylineStyleBuilder<PolylineVertexCompactNoUVs>>(*this);
+        builder->polylineBuilder().useTexCoords = false;
+        return std::move(builder);
+    }
     if (m_texCoordsGeneration) {
         auto builder = std::make_unique<PolylineStyleBuilder<PolylineVertex>>(*this);
         builder->polylineBuilder().useTexCoords = true;
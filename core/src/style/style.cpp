@@ -4,6 +4,8 @@
 #include "gl/renderState.h"
 #include "gl/shaderProgram.h"
 #include "gl/mesh.h"
+#include "gl/meshArena.h"
+#include "gl/texture.h"
 #include "log.h"
 #include "map.h"
 #include "marker/marker.h"
@@ -17,6 +19,9 @@
 
 #include "rasters_glsl.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace Tangram {
 
 Style::Style(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection) :
@@ -41,6 +46,14 @@ void Style::build(const Scene& _scene) {
     constructVertexLayout();
     constructShaderProgram();
 
+    if (batching()) {
+        m_meshArenas = std::make_shared<MeshArenaPool>(m_vertexLayout);
+
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_TILE_BATCHING\n", false);
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_BATCH_SLOTS "
+                                       + std::to_string(MeshArena::MAX_SLOTS) + "\n", false);
+    }
+
     if (m_blend == Blending::inlay) {
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_BLEND_INLAY\n", false);
     } else if (m_blend == Blending::overlay) {
@@ -64,12 +77,8 @@ void Style::build(const Scene& _scene) {
             break;
         }
 
-        for (auto& light : _scene.lights()) {
-            auto uniforms = light->getUniforms();
-            if (uniforms) {
-                m_lights.emplace_back(light.get(), std::move(uniforms));
-            }
-        }
+        setLights(_scene.lights());
+
         for (auto& block : _scene.lightBlocks()) {
             m_shaderSource->addSourceBlock(block.first, block.second);
         }
@@ -143,15 +152,41 @@ void Style::build(const Scene& _scene) {
         }
     }
 
+    buildShaderVariants(_scene, *m_shaderSource);
+
     // Clear ShaderSource builder
     m_shaderSource.reset();
 }
 
+void Style::setLights(const std::vector<std::unique_ptr<Light>>& _lights) {
+    m_lights.clear();
+
+    if (m_lightingType == LightingType::none) { return; }
+
+    for (auto& light : _lights) {
+        auto uniforms = light->getUniforms();
+        if (uniforms) {
+            m_lights.emplace_back(light.get(), std::move(uniforms));
+        }
+    }
+}
+
+int Style::buildShaderPrograms(RenderState& rs) {
+    int built = 0;
+
+    // Programs shared with other styles are only built once
+    if (m_shaderProgram && m_shaderProgram->build(rs)) { built++; }
+    if (m_selectionProgram && m_selectionProgram->build(rs)) { built++; }
+
+    return built;
+}
+
 void Style::setLightingType(LightingType _type) {
     m_lightingType = _type;
 }
 
-void Style::setupSceneShaderUniforms(RenderState& rs, Scene& _scene, UniformBlock& _uniformBlock) {
+void Style::setupSceneShaderUniforms(RenderState& rs, ShaderProgram& _program, Scene& _scene,
+                                     UniformBlock& _uniformBlock) {
     for (auto& uniformPair : _uniformBlock.styleUniforms) {
         const auto& name = uniformPair.first;
         auto& value = uniformPair.second;
@@ -168,19 +203,19 @@ void Style::setupSceneShaderUniforms(RenderState& rs, Scene& _scene, UniformBloc
 
             texture->bind(rs, rs.nextAvailableTextureUnit());
 
-            m_shaderProgram->setUniformi(rs, name, rs.currentTextureUnit());
+            _program.setUniformi(rs, name, rs.currentTextureUnit());
         } else if (value.is<bool>()) {
-            m_shaderProgram->setUniformi(rs, name, value.get<bool>());
+            _program.setUniformi(rs, name, value.get<bool>());
         } else if(value.is<float>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<float>());
+            _program.setUniformf(rs, name, value.get<float>());
         } else if(value.is<glm::vec2>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<glm::vec2>());
+            _program.setUniformf(rs, name, value.get<glm::vec2>());
         } else if(value.is<glm::vec3>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<glm::vec3>());
+            _program.setUniformf(rs, name, value.get<glm::vec3>());
         } else if(value.is<glm::vec4>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<glm::vec4>());
+            _program.setUniformf(rs, name, value.get<glm::vec4>());
         } else if (value.is<UniformArray1f>()) {
-            m_shaderProgram->setUniformf(rs, name, value.get<UniformArray1f>());
+            _program.setUniformf(rs, name, value.get<UniformArray1f>());
         } else if (value.is<UniformTextureArray>()) {
             UniformTextureArray& textureUniformArray = value.get<UniformTextureArray>();
             textureUniformArray.slots.clear();
@@ -199,7 +234,7 @@ void Style::setupSceneShaderUniforms(RenderState& rs, Scene& _scene, UniformBloc
                 textureUniformArray.slots.push_back(rs.currentTextureUnit());
             }
 
-            m_shaderProgram->setUniformi(rs, name, textureUniformArray);
+            _program.setUniformi(rs, name, textureUniformArray);
         }
     }
 }
@@ -235,7 +270,7 @@ void Style::setupShaderUniforms(RenderState& rs, ShaderProgram& _program, const
     _program.setUniformMatrix4f(rs, _uniforms.uView, _view.getViewMatrix());
     _program.setUniformMatrix4f(rs, _uniforms.uProj, _view.getProjectionMatrix());
 
-    setupSceneShaderUniforms(rs, _scene, _uniforms);
+    setupSceneShaderUniforms(rs, _program, _scene, _uniforms);
 
 }
 
@@ -295,6 +330,10 @@ void Style::drawSelectionFrame(RenderState& rs, const View& _view, Scene& _scene
 
     for (const auto& tile : _tiles) { drawSelectionFrame(rs, *tile); }
     for (const auto& marker : _markers) { drawSelectionFrame(rs, *marker); }
+
+    if (m_selection) {
+        drawBatches(rs, *m_selectionProgram, m_selectionUniforms);
+    }
 }
 
 void Style::onBeginDrawSelectionFrame(RenderState& rs, const View& _view, Scene& _scene) {
@@ -329,6 +368,21 @@ void Style::onBeginDrawSelectionFrame(RenderState& rs, const View& _view, Scene&
     }
 }
 
+bool Style::bindPalette(RenderState& rs, ShaderProgram& _program, UniformBlock& _uniformBlock,
+                        const StyledMesh& _mesh) {
+
+    auto* palette = _mesh.palette();
+    if (!palette) { return false; }
+
+    GLuint textureUnit = rs.nextAvailableTextureUnit();
+    palette->bind(rs, textureUnit);
+
+    _program.setUniformi(rs, _uniformBlock.uPalette, textureUnit);
+    _program.setUniformf(rs, _uniformBlock.uPaletteSize, palette->width(), palette->height());
+
+    return true;
+}
+
 void Style::drawSelectionFrame(RenderState& _rs, const Marker& _marker) {
     if (!m_selection || _marker.styleId() != m_id || !_marker.isVisible()) {
         return;
@@ -338,14 +392,25 @@ void Style::drawSelectionFrame(RenderState& _rs, const Marker& _marker) {
 
     if (!mesh) { return; }
 
+    if (m_meshArenas) {
+        float zoom = _marker.builtZoomLevel();
+        addToBatch(_rs, *mesh, *m_selectionProgram, m_selectionUniforms, _marker.modelMatrix(),
+                   { _marker.origin().x, _marker.origin().y, zoom, zoom }, 0.f);
+        return;
+    }
+
     m_selectionProgram->setUniformMatrix4f(_rs, m_selectionUniforms.uModel, _marker.modelMatrix());
     m_selectionProgram->setUniformf(_rs, m_selectionUniforms.uTileOrigin,
                                     _marker.origin().x, _marker.origin().y,
                                     _marker.builtZoomLevel(), _marker.builtZoomLevel());
 
+    bool palette = bindPalette(_rs, *m_selectionProgram, m_selectionUniforms, *mesh);
+
     if (!mesh->draw(_rs, *m_selectionProgram, false)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
     }
+
+    if (palette) { _rs.releaseTextureUnit(); }
 }
 
 void Style::drawSelectionFrame(Tangram::RenderState& rs, const Tangram::Tile &_tile) {
@@ -360,6 +425,13 @@ void Style::drawSelectionFrame(Tangram::RenderState& rs, const Tangram::Tile &_t
 
     TileID tileID = _tile.getID();
 
+    if (m_meshArenas) {
+        addToBatch(rs, *styleMesh, *m_selectionProgram, m_selectionUniforms, _tile.getModelMatrix(),
+                   { _tile.getOrigin().x, _tile.getOrigin().y, tileID.s, tileID.z },
+                   _tile.isProxy() ? 1.f : 0.f);
+        return;
+    }
+
     m_selectionProgram->setUniformMatrix4f(rs, m_selectionUniforms.uModel, _tile.getModelMatrix());
     m_selectionProgram->setUniformf(rs, m_selectionUniforms.uProxyDepth, _tile.isProxy() ? 1.f : 0.f);
     m_selectionProgram->setUniformf(rs, m_selectionUniforms.uTileOrigin,
@@ -368,10 +440,14 @@ void Style::drawSelectionFrame(Tangram::RenderState& rs, const Tangram::Tile &_t
                                     tileID.s,
                                     tileID.z);
 
+    bool palette = bindPalette(rs, *m_selectionProgram, m_selectionUniforms, *styleMesh);
+
     if (!styleMesh->draw(rs, *m_selectionProgram, false)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
     }
 
+    if (palette) { rs.releaseTextureUnit(); }
+
 }
 
 bool Style::draw(RenderState& rs, const View& _view, Scene& _scene,
@@ -404,6 +480,7 @@ bool Style::draw(RenderState& rs, const View& _view, Scene& _scene,
     for (const auto& marker : _markers) {
         meshDrawn |= draw(rs, *marker);
     }
+    meshDrawn |= drawBatches(rs, *m_shaderProgram, m_mainUniforms);
 
     if (meshDrawn) {
         if (m_blend == Blending::translucent) {
@@ -417,6 +494,7 @@ bool Style::draw(RenderState& rs, const View& _view, Scene& _scene,
 
             for (const auto &tile : _tiles) { draw(rs, *tile); }
             for (const auto &marker : _markers) { draw(rs, *marker); }
+            drawBatches(rs, *m_shaderProgram, m_mainUniforms);
 
             GL::disable(GL_STENCIL_TEST);
             GL::depthFunc(GL_LESS);
@@ -438,6 +516,12 @@ bool Style::draw(RenderState& rs, const Tile& _tile) {
     bool styleMeshDrawn = true;
     TileID tileID = _tile.getID();
 
+    if (m_meshArenas) {
+        return addToBatch(rs, *styleMesh, *m_shaderProgram, m_mainUniforms, _tile.getModelMatrix(),
+                          { _tile.getOrigin().x, _tile.getOrigin().y, tileID.s, tileID.z },
+                          _tile.isProxy() ? 1.f : 0.f);
+    }
+
     if (hasRasters() && !_tile.rasters().empty()) {
         UniformTextureArray textureIndexUniform;
         UniformArray2f rasterSizeUniform;
@@ -480,11 +564,15 @@ bool Style::draw(RenderState& rs, const Tile& _tile) {
                                  tileID.s,
                                  tileID.z);
 
+    bool palette = bindPalette(rs, *m_shaderProgram, m_mainUniforms, *styleMesh);
+
     if (!styleMesh->draw(rs, *m_shaderProgram)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
         styleMeshDrawn = false;
     }
 
+    if (palette) { rs.releaseTextureUnit(); }
+
     if (hasRasters()) {
         for (auto& raster : _tile.rasters()) {
             if (raster.isValid()) {
@@ -505,19 +593,138 @@ bool Style::draw(RenderState& rs, const Marker& marker) {
     if (!mesh) { return false; }
     bool styleMeshDrawn = true;
 
+    if (m_meshArenas) {
+        float zoom = marker.builtZoomLevel();
+        return addToBatch(rs, *mesh, *m_shaderProgram, m_mainUniforms, marker.modelMatrix(),
+                          { marker.origin().x, marker.origin().y, zoom, zoom }, 0.f);
+    }
+
     m_shaderProgram->setUniformMatrix4f(rs, m_mainUniforms.uModel, marker.modelMatrix());
     m_shaderProgram->setUniformf(rs, m_mainUniforms.uTileOrigin,
                                  marker.origin().x, marker.origin().y,
                                  marker.builtZoomLevel(), marker.builtZoomLevel());
 
+    bool palette = bindPalette(rs, *m_shaderProgram, m_mainUniforms, *mesh);
+
     if (!mesh->draw(rs, *m_shaderProgram)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
         styleMeshDrawn = false;
     }
 
+    if (palette) { rs.releaseTextureUnit(); }
+
     return styleMeshDrawn;
 }
 
+bool Style::addToBatch(RenderState& rs, StyledMesh& _mesh, ShaderProgram& _program,
+                       UniformBlock& _uniformBlock, const glm::mat4& _model,
+                       const glm::vec4& _tileOrigin, float _proxyDepth) {
+
+    if (!_mesh.isUploaded()) {
+        size_t bytes = _mesh.upload(rs, rs.uploadBudget);
+        rs.uploadBudget -= std::min(bytes, rs.uploadBudget);
+
+        if (!_mesh.isUploaded()) {
+            rs.countPendingUpload();
+            return false;
+        }
+    }
+
+    // Tile and marker model matrices only scale and translate
+    glm::vec4 transform(_model[3][0], _model[3][1], _model[0][0], _proxyDepth);
+
+    auto* ranges = _mesh.arenaRanges();
+    if (!ranges) {
+        return drawUnbatched(rs, _mesh, _program, _uniformBlock, transform, _tileOrigin);
+    }
+    if (ranges->empty()) { return false; }
+
+    for (auto& range : *ranges) {
+        m_batchItems.push_back({ &range, transform, _tileOrigin });
+    }
+    return true;
+}
+
+bool Style::drawUnbatched(RenderState& rs, StyledMesh& _mesh, ShaderProgram& _program,
+                          UniformBlock& _uniformBlock, const glm::vec4& _transform,
+                          const glm::vec4& _tileOrigin) {
+
+    if (!_program.use(rs)) { return false; }
+
+    UniformArray4f batchTiles(2 * MeshArena::MAX_SLOTS);
+    batchTiles[0] = _transform;
+    batchTiles[1] = _tileOrigin;
+    _program.setUniformf(rs, _uniformBlock.uBatchTiles, batchTiles);
+
+    // Without its buffer the slot attribute keeps its default value of 0
+    GLint location = _program.getAttribLocation("a_tile_slot");
+    if (location >= 0 && rs.attributeBindings[location] != 0) {
+        GL::disableVertexAttribArray(location);
+        rs.attributeBindings[location] = 0;
+    }
+    rs.meshArenaUnset();
+
+    if (!_mesh.draw(rs, _program)) {
+        LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Style::drawBatches(RenderState& rs, ShaderProgram& _program, UniformBlock& _uniformBlock) {
+
+    if (m_batchItems.empty()) { return false; }
+
+    if (!_program.use(rs)) {
+        m_batchItems.clear();
+        return false;
+    }
+
+    // Keep the order in which tiles and markers were queued within each arena
+    std::stable_sort(m_batchItems.begin(), m_batchItems.end(), [](const auto& a, const auto& b) {
+        return a.range->arena < b.range->arena;
+    });
+
+    UniformArray4f batchTiles(2 * MeshArena::MAX_SLOTS);
+
+    auto it = m_batchItems.begin();
+    while (it != m_batchItems.end()) {
+        auto* arena = it->range->arena;
+        auto end = std::find_if(it, m_batchItems.end(),
+                                [&](const auto& item) { return item.range->arena != arena; });
+
+        for (auto item = it; item != end; ++item) {
+            batchTiles[2 * item->range->slot] = item->transform;
+            batchTiles[2 * item->range->slot + 1] = item->tileOrigin;
+        }
+        _program.setUniformf(rs, _uniformBlock.uBatchTiles, batchTiles);
+
+        arena->bind(rs, _program, m_meshArenas->vertexLayout());
+
+        // Ranges that follow each other in the index buffer are drawn at once
+        while (it != end) {
+            uint32_t first = it->range->indexOffset;
+            uint32_t last = first + it->range->nIndices;
+
+            for (++it; it != end && it->range->indexOffset == last; ++it) {
+                last += it->range->nIndices;
+            }
+
+            GL::drawElements(m_drawMode, last - first, GL_UNSIGNED_SHORT,
+                             (void*)(first * sizeof(GLushort)));
+            rs.countDrawCall();
+        }
+    }
+
+    m_batchItems.clear();
+
+    return true;
+}
+
+void Style::resetMeshArenas() {
+    if (m_meshArenas) { m_meshArenas->reset(); }
+}
+
 void Style::setDefaultDrawRule(std::unique_ptr<DrawRuleData>&& _rule) {
     m_defaultDrawRule = std::move(_rule);
 }
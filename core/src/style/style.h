@@ -12,6 +12,7 @@
 
 namespace Tangram {
 
+class Arena;
 class Label;
 class LabelCollider;
 class Light;
@@ -21,12 +22,15 @@ class Material;
 class RenderState;
 class Scene;
 class ShaderProgram;
+class MeshArenaPool;
 class ShaderSource;
 class Style;
+class Texture;
 class Tile;
 class TileSource;
 class VertexLayout;
 class View;
+struct ArenaRange;
 struct DrawRule;
 struct LightUniforms;
 struct MaterialUniforms;
@@ -67,6 +71,28 @@ struct StyledMesh {
     virtual bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) = 0;
     virtual size_t bufferSize() const = 0;
 
+    /* Whether the buffers were moved to GPU memory */
+    virtual bool isUploaded() const { return false; }
+
+    /* Whether the buffers still need to be moved to GPU memory before the
+     * mesh can be drawn without a blocking upload */
+    virtual bool needsUpload() const { return false; }
+
+    /* Moves up to _maxBytes of the buffers to GPU memory, returns the number
+     * of bytes uploaded */
+    virtual size_t upload(RenderState& rs, size_t _maxBytes) { return 0; }
+
+    /* Color palette texture of compact vertex formats, see <ColorPalette> */
+    virtual Texture* palette() const { return nullptr; }
+
+    /* Ranges of the mesh in the shared buffers of its style, when drawn in
+     * batches, see <MeshArena> */
+    virtual const std::vector<ArenaRange>* arenaRanges() const { return nullptr; }
+
+    /* Append the compiled buffers to @_out for the <TileMeshCache>; returns
+     * false for meshes that can only be built from tile data */
+    virtual bool serialize(std::vector<char>& _out) const { return false; }
+
     virtual ~StyledMesh() {}
 };
 
@@ -93,6 +119,10 @@ public:
     /* Create a new mesh object using the vertex layout corresponding to this style */
     virtual std::unique_ptr<StyledMesh> build() = 0;
 
+    /* Append the geometry and labels that @_part built for the same style and
+     * tile, as if its features had been added to this builder */
+    virtual void merge(StyleBuilder& _part) = 0;
+
     virtual bool checkRule(const DrawRule& _rule) const;
 
     virtual void addLayoutItems(LabelCollider& _layout) {}
@@ -100,6 +130,14 @@ public:
     virtual void addSelectionItems(LabelCollider& _layout) {}
 
     virtual const Style& style() const = 0;
+
+    /* Set the worker's Arena for scratch memory of addFeature(), which is
+     * released after each feature */
+    virtual void setArena(Arena* _arena) { m_arena = _arena; }
+
+protected:
+
+    Arena* m_arena = nullptr;
 };
 
 /* Means of constructing and rendering map geometry
@@ -153,6 +191,15 @@ protected:
     /* Whether the style should generate texture coordinates */
     bool m_texCoordsGeneration = false;
 
+    /* Whether meshes use compact vertices with a color palette */
+    bool m_compactVertices = false;
+
+    /* Whether tile meshes are drawn in batches from shared buffers */
+    bool m_batching = false;
+
+    /* Shared buffers of the meshes when drawn in batches */
+    std::shared_ptr<MeshArenaPool> m_meshArenas;
+
     bool m_hasColorShaderBlock = false;
 
     RasterType m_rasterType = RasterType::none;
@@ -179,17 +226,25 @@ protected:
         UniformLocation uRasters{"u_rasters"};
         UniformLocation uRasterSizes{"u_raster_sizes"};
         UniformLocation uRasterOffsets{"u_raster_offsets"};
+        UniformLocation uPalette{"u_palette"};
+        UniformLocation uPaletteSize{"u_palette_size"};
+        UniformLocation uBatchTiles{"u_batch_tiles"};
 
         std::vector<StyleUniform> styleUniforms;
     } m_mainUniforms, m_selectionUniforms;
 
     /* Set uniform values when @_updateUniforms is true,
      */
-    void setupSceneShaderUniforms(RenderState& rs, Scene& _scene, UniformBlock& _uniformBlock);
+    void setupSceneShaderUniforms(RenderState& rs, ShaderProgram& _program, Scene& _scene,
+                                  UniformBlock& _uniformBlock);
 
     void setupShaderUniforms(RenderState& rs, ShaderProgram& _program, const View& _view,
                              Scene& _scene, UniformBlock& _uniformBlock);
 
+    /* Bind the color palette of @_mesh, returns whether a texture unit was used */
+    bool bindPalette(RenderState& rs, ShaderProgram& _program, UniformBlock& _uniformBlock,
+                     const StyledMesh& _mesh);
+
     struct LightHandle {
         LightHandle(Light* _light, std::unique_ptr<LightUniforms> _uniforms);
         Light *light;
@@ -206,6 +261,33 @@ protected:
     std::vector<LightHandle> m_lights;
     MaterialHandle m_material;
 
+    struct BatchItem {
+        const ArenaRange* range;
+        // Translation, scale and proxy depth
+        glm::vec4 transform;
+        glm::vec4 tileOrigin;
+    };
+
+    std::vector<BatchItem> m_batchItems;
+
+    /* Queue the arena ranges of @_mesh to be drawn with @_program by
+     * drawBatches(), placing it into the arenas first within the upload budget
+     * when it was not yet uploaded. Meshes which do not fit into the arenas
+     * are drawn right away. */
+    bool addToBatch(RenderState& rs, StyledMesh& _mesh, ShaderProgram& _program,
+                    UniformBlock& _uniformBlock, const glm::mat4& _model,
+                    const glm::vec4& _tileOrigin, float _proxyDepth);
+
+    /* Draw @_mesh of a batching style from its own buffers, using the first
+     * batch slot for its transform */
+    bool drawUnbatched(RenderState& rs, StyledMesh& _mesh, ShaderProgram& _program,
+                       UniformBlock& _uniformBlock, const glm::vec4& _transform,
+                       const glm::vec4& _tileOrigin);
+
+    /* Draw the queued ranges with one draw call per run of adjacent ranges in
+     * an arena, returns whether any range was drawn */
+    bool drawBatches(RenderState& rs, ShaderProgram& _program, UniformBlock& _uniformBlock);
+
 public:
 
     Style(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection);
@@ -246,6 +328,16 @@ public:
     /* Make this style ready to be used (call after all needed properties are set) */
     virtual void build(const Scene& _scene);
 
+    /* Compile and link the shader programs of this style ahead of the first draw;
+     * returns the number of programs which were built
+     */
+    virtual int buildShaderPrograms(RenderState& rs);
+
+    /* Use the lights @_lights, which must have the same shader blocks as the lights
+     * this style was built with; used when the style is taken over by an updated scene
+     */
+    virtual void setLights(const std::vector<std::unique_ptr<Light>>& _lights);
+
     virtual void onBeginUpdate() {}
 
     virtual void onBeginFrame(RenderState& rs) {}
@@ -260,6 +352,11 @@ public:
      */
     virtual void constructShaderProgram() = 0;
 
+    /* Create additional shader programs from the complete @_source of this style,
+     * called from build() before the source is released
+     */
+    virtual void buildShaderVariants(const Scene& _scene, const ShaderSource& _source) {}
+
     /* Perform any setup needed before drawing each frame
      * _textUnit is the next available texture unit
      */
@@ -302,12 +399,32 @@ public:
 
     bool genTexCoords() const { return m_texCoordsGeneration; }
 
+    void setCompactVertices(bool _compactVertices) { m_compactVertices = _compactVertices; }
+
+    bool compactVertices() const { return m_compactVertices; }
+
+    void setBatching(bool _batching) { m_batching = _batching; }
+
+    /* Batching is not available for meshes with textures of their own. It is
+     * limited to opaque styles, as batches are drawn in order of their arenas
+     * rather than of their tiles. */
+    bool batching() const {
+        return m_batching && m_blend == Blending::opaque && !m_compactVertices && !hasRasters();
+    }
+
+    const auto& meshArenas() const { return m_meshArenas; }
+
+    /* Drop the mesh arenas after the GL context was lost */
+    void resetMeshArenas();
+
     void setID(uint32_t _id) { m_id = _id; }
 
     Material& getMaterial() { return *m_material.material; }
 
     ShaderSource& getShaderSource() const { return *m_shaderSource; }
 
+    const std::shared_ptr<ShaderProgram>& shaderProgram() const { return m_shaderProgram; }
+
     const std::string& getName() const { return m_name; }
     const uint32_t& getID() const { return m_id; }
 
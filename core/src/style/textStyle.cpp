@@ -7,9 +7,12 @@
 #include "gl/shaderProgram.h"
 #include "labels/textLabels.h"
 #include "log.h"
+#include "scene/scene.h"
 #include "text/fontContext.h"
 #include "view/view.h"
 
+#include <algorithm>
+
 #include "text_fs.h"
 #include "text_vs.h"
 #include "sdf_fs.h"
@@ -37,6 +40,16 @@ void TextStyle::constructVertexLayout() {
         {"a_alpha", 1, GL_UNSIGNED_SHORT, true, 0},
         {"a_scale", 1, GL_UNSIGNED_SHORT, false, 0},
     }));
+
+    m_staticVertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
+        {"a_position", 2, GL_SHORT, false, 0},
+        {"a_uv", 2, GL_UNSIGNED_SHORT, false, 0},
+        {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_stroke", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_slot", 1, GL_UNSIGNED_SHORT, false, 0},
+        {"a_scale", 1, GL_UNSIGNED_SHORT, false, 0},
+    }));
 }
 
 void TextStyle::constructShaderProgram() {
@@ -50,11 +63,70 @@ void TextStyle::constructShaderProgram() {
     m_shaderSource->addSourceBlock("defines", "#define TANGRAM_TEXT\n");
 }
 
+void TextStyle::buildShaderVariants(const Scene& _scene, const ShaderSource& _source) {
+
+    ShaderSource source(_source);
+    source.addSourceBlock("defines", "#define TANGRAM_LABEL_SLOTS "
+                          + std::to_string(LABEL_SLOTS_PER_BATCH) + "\n", false);
+
+    // Share the programs with text styles of the same source
+    auto getProgram = [&](bool _selection, const std::string& _vertSrc, const std::string& _fragSrc) {
+        for (auto& style : _scene.styles()) {
+            if (style->type() != StyleType::text) { continue; }
+
+            auto& textStyle = static_cast<TextStyle&>(*style);
+            auto& prg = _selection ? textStyle.m_staticSelection.program : textStyle.m_staticMain.program;
+            if (!prg) { continue; }
+            if (prg->vertexShaderSource() == _vertSrc &&
+                prg->fragmentShaderSource() == _fragSrc) {
+                return prg;
+            }
+        }
+        auto prg = std::make_shared<ShaderProgram>();
+        prg->setDescription(std::string(_selection ? "selection_program " : "")
+                            + "static_labels {style:" + m_name + "}");
+        prg->setShaderSource(_vertSrc, _fragSrc);
+        return prg;
+    };
+
+    // The style uniforms of the scene are set when the programs were not used
+    // yet, so the copies have no location of the dynamic meshes' program.
+    auto copyStyleUniforms = [](StaticLabelProgram& _static, const Style::UniformBlock& _uniforms) {
+        _static.styleUniforms.styleUniforms.clear();
+        for (auto& uniform : _uniforms.styleUniforms) {
+            _static.styleUniforms.styleUniforms.emplace_back(uniform.first, uniform.second);
+        }
+    };
+
+    m_staticMain.program = getProgram(false, source.buildVertexSource(),
+                                      source.buildFragmentSource());
+    copyStyleUniforms(m_staticMain, Style::m_mainUniforms);
+
+    if (m_selection) {
+        m_staticSelection.program = getProgram(true, source.buildSelectionVertexSource(),
+                                               source.buildSelectionFragmentSource());
+        copyStyleUniforms(m_staticSelection, Style::m_selectionUniforms);
+    }
+}
+
+int TextStyle::buildShaderPrograms(RenderState& rs) {
+    int built = Style::buildShaderPrograms(rs);
+
+    if (m_staticMain.program && m_staticMain.program->build(rs)) { built++; }
+    if (m_staticSelection.program && m_staticSelection.program->build(rs)) { built++; }
+
+    return built;
+}
+
 void TextStyle::onBeginUpdate() {
 
     // Clear vertices from previous frame
     for (auto& mesh : m_meshes) { mesh->clear(); }
 
+    m_staticRuns.clear();
+    m_runVertices.clear();
+    m_frame++;
+
     // Ensure that meshes are available to push to on labels::update()
     size_t s = m_context->glyphTextureCount();
     while (m_meshes.size() < s) {
@@ -70,6 +142,14 @@ void TextStyle::onBeginFrame(RenderState& rs) {
     for (auto& mesh : m_meshes) {
         mesh->upload(rs);
     }
+
+    // Fall back to dynamic meshes when the driver rejects the program variant;
+    // the static labels placed for this frame are skipped.
+    if (!m_staticRuns.empty() && !m_staticMain.program->use(rs)) {
+        LOGE("Drawing labels of style %s from dynamic meshes", m_name.c_str());
+        m_staticLabels = false;
+        m_staticRuns.clear();
+    }
 }
 
 void TextStyle::onBeginDrawFrame(RenderState& rs, const View& _view, Scene& _scene) {
@@ -86,24 +166,22 @@ void TextStyle::onBeginDrawFrame(RenderState& rs, const View& _view, Scene& _sce
     m_shaderProgram->setUniformMatrix4f(rs, m_mainUniforms.uOrtho,
                                         _view.getOrthoViewportMatrix());
 
+    bool staticRuns = !m_staticRuns.empty();
+    if (staticRuns) {
+        setupStaticProgram(rs, m_staticMain, _view, _scene, Style::m_mainUniforms, texUnit);
+    }
+
     if (m_sdf) {
         m_shaderProgram->setUniformi(rs, m_mainUniforms.uPass, 1);
+        if (staticRuns) { m_staticMain.program->setUniformi(rs, m_staticMain.uniforms.uPass, 1); }
+
+        drawLabels(rs, *m_shaderProgram, m_staticMain, texUnit, false);
 
-        for (size_t i = 0; i < m_meshes.size(); i++) {
-            if (m_meshes[i]->isReady()) {
-                m_context->bindTexture(rs, i, texUnit);
-                m_meshes[i]->draw(rs, *m_shaderProgram);
-            }
-        }
         m_shaderProgram->setUniformi(rs, m_mainUniforms.uPass, 0);
+        if (staticRuns) { m_staticMain.program->setUniformi(rs, m_staticMain.uniforms.uPass, 0); }
     }
 
-    for (size_t i = 0; i < m_meshes.size(); i++) {
-        if (m_meshes[i]->isReady()) {
-            m_context->bindTexture(rs, i, texUnit);
-            m_meshes[i]->draw(rs, *m_shaderProgram);
-        }
-    }
+    drawLabels(rs, *m_shaderProgram, m_staticMain, texUnit, false);
 }
 
 void TextStyle::onBeginDrawSelectionFrame(RenderState& rs, const View& _view, Scene& _scene) {
@@ -116,10 +194,112 @@ void TextStyle::onBeginDrawSelectionFrame(RenderState& rs, const View& _view, Sc
     m_selectionProgram->setUniformMatrix4f(rs, m_selectionUniforms.uOrtho,
                                            _view.getOrthoViewportMatrix());
 
-    for (const auto& mesh : m_meshes) {
-        if (mesh->isReady()) {
-            mesh->draw(rs, *m_selectionProgram, false);
+    if (!m_staticRuns.empty()) {
+        setupStaticProgram(rs, m_staticSelection, _view, _scene, Style::m_selectionUniforms, 0);
+    }
+
+    drawLabels(rs, *m_selectionProgram, m_staticSelection, 0, true);
+}
+
+void TextStyle::setupStaticProgram(RenderState& rs, StaticLabelProgram& _static, const View& _view,
+                                   Scene& _scene, const Style::UniformBlock& _uniforms, GLuint _texUnit) {
+
+    // Values of the style uniforms may change with the scene, their
+    // locations are those of the static program
+    auto& styleUniforms = _static.styleUniforms.styleUniforms;
+    for (size_t i = 0; i < styleUniforms.size(); i++) {
+        styleUniforms[i].second = _uniforms.styleUniforms[i].second;
+    }
+
+    auto& program = *_static.program;
+    auto& uniforms = _static.uniforms;
+
+    // Style textures are bound to the same units as for the dynamic meshes
+    setupShaderUniforms(rs, program, _view, _scene, _static.styleUniforms);
+
+    program.setUniformf(rs, uniforms.uMaxStrokeWidth, m_context->maxStrokeWidth());
+    program.setUniformf(rs, uniforms.uTexScaleFactor, glm::vec2(1.0f / GlyphTexture::size));
+    program.setUniformi(rs, uniforms.uTex, _texUnit);
+    program.setUniformMatrix4f(rs, uniforms.uOrtho, _view.getOrthoViewportMatrix());
+    program.setUniformi(rs, uniforms.uPass, 0);
+}
+
+void TextStyle::drawLabels(RenderState& rs, ShaderProgram& _program, StaticLabelProgram& _static,
+                           GLuint _texUnit, bool _selection) {
+
+    size_t meshes = m_meshes.size();
+    m_drawnVertices.assign(meshes, 0);
+
+    // Draw the dynamic quads up to @_vertices of each mesh, or all of them
+    auto drawDynamic = [&](const size_t* _vertices) {
+        for (size_t i = 0; i < meshes; i++) {
+            auto& mesh = *m_meshes[i];
+            if (!mesh.isReady()) { continue; }
+
+            size_t first = m_drawnVertices[i];
+            size_t end = _vertices ? _vertices[i] : mesh.numberOfVertices();
+            if (first >= end) { continue; }
+
+            if (!_selection) { m_context->bindTexture(rs, i, _texUnit); }
+
+            if (first == 0 && end == mesh.numberOfVertices()) {
+                mesh.draw(rs, _program, !_selection);
+            } else {
+                mesh.drawRange(rs, _program, first, end - first);
+            }
+            m_drawnVertices[i] = end;
         }
+    };
+
+    for (size_t r = 0; r < m_staticRuns.size(); r++) {
+        auto& run = m_staticRuns[r];
+        if (!run.labels) { continue; }
+
+        drawDynamic(m_runVertices.data() + r * meshes);
+
+        run.labels->drawStaticSlots(rs, *_static.program, _static.uniforms.uLabelSlots,
+                                    run.first, run.end, _texUnit);
+    }
+
+    drawDynamic(nullptr);
+}
+
+bool TextStyle::staticProgramReady() const {
+    return m_staticLabels && m_staticMain.program && m_staticMain.program->isValid();
+}
+
+void TextStyle::addStaticSlot(const TextLabels& _labels, uint32_t _slot) const {
+
+    size_t meshes = m_meshes.size();
+
+    if (!m_staticRuns.empty()) {
+        auto& run = m_staticRuns.back();
+
+        // Extend the last run while no dynamic quads were added after it
+        bool extend = (run.labels == &_labels && _slot >= run.end &&
+                       _slot / LABEL_SLOTS_PER_BATCH == run.first / LABEL_SLOTS_PER_BATCH);
+
+        const size_t* vertices = m_runVertices.data() + m_runVertices.size() - meshes;
+        for (size_t i = 0; extend && i < meshes; i++) {
+            extend = (vertices[i] == m_meshes[i]->numberOfVertices());
+        }
+
+        if (extend) {
+            run.end = _slot + 1;
+            return;
+        }
+    }
+
+    m_staticRuns.push_back({ &_labels, _slot, _slot + 1 });
+    for (auto& mesh : m_meshes) {
+        m_runVertices.push_back(mesh->numberOfVertices());
+    }
+}
+
+void TextStyle::removeStaticLabels(const TextLabels& _labels) const {
+    // Keep the dynamic quads of the runs in place
+    for (auto& run : m_staticRuns) {
+        if (run.labels == &_labels) { run.labels = nullptr; }
     }
 }
 
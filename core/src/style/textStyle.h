@@ -6,6 +6,7 @@
 #include "labels/textLabel.h"
 #include "util/hash.h"
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <string>
@@ -15,6 +16,7 @@ namespace alfons { class Font; }
 namespace Tangram {
 
 class FontContext;
+class TextLabels;
 struct Properties;
 
 class TextStyle : public Style {
@@ -23,6 +25,9 @@ public:
 
     constexpr static uint32_t DEFAULT_TEXT_WRAP_LENGTH = 15;
 
+    // Number of labels placed by one upload of the label slot uniforms
+    constexpr static uint32_t LABEL_SLOTS_PER_BATCH = 64;
+
     struct Parameters {
         std::shared_ptr<alfons::Font> font;
         std::string text = "";
@@ -61,10 +66,54 @@ protected:
         UniformLocation uOrtho{"u_ortho"};
         UniformLocation uPass{"u_pass"};
         UniformLocation uMaxStrokeWidth{"u_max_stroke_width"};
+        UniformLocation uLabelSlots{"u_label_slots"};
     } m_mainUniforms, m_selectionUniforms;
 
     mutable std::vector<std::unique_ptr<DynamicQuadMesh<TextVertex>>> m_meshes;
 
+    /* Program variant for the static meshes of TextLabels, with its own
+     * uniform locations */
+    struct StaticLabelProgram {
+        std::shared_ptr<ShaderProgram> program;
+        Style::UniformBlock styleUniforms;
+        UniformBlock uniforms;
+    } m_staticMain, m_staticSelection;
+
+    std::shared_ptr<VertexLayout> m_staticVertexLayout;
+
+    std::atomic<bool> m_staticLabels{true};
+
+    // Incremented on each update, to reset the label slots of TextLabels
+    uint32_t m_frame = 0;
+
+    /* Slots of static labels placed in the current frame, one after another
+     * in one batch of @labels. Runs are kept in the order in which Labels
+     * placed them, so that they are drawn in turn with the dynamic quads. */
+    struct StaticLabelRun {
+        const TextLabels* labels;
+        uint32_t first;
+        uint32_t end;
+    };
+    mutable std::vector<StaticLabelRun> m_staticRuns;
+
+    // Number of vertices in each of m_meshes when a run was started
+    mutable std::vector<size_t> m_runVertices;
+
+    // Vertices of each of m_meshes which were drawn in the current pass
+    std::vector<size_t> m_drawnVertices;
+
+    void buildShaderVariants(const Scene& _scene, const ShaderSource& _source) override;
+
+    /* Set the uniforms of @_static like those of the dynamic meshes' program,
+     * the glyph atlases are bound to @_texUnit */
+    void setupStaticProgram(RenderState& rs, StaticLabelProgram& _static, const View& _view,
+                            Scene& _scene, const Style::UniformBlock& _uniforms, GLuint _texUnit);
+
+    /* Draw the quads of the dynamic meshes with @_program and the static
+     * label runs with @_static, in the order in which labels were placed */
+    void drawLabels(RenderState& rs, ShaderProgram& _program, StaticLabelProgram& _static,
+                    GLuint _texUnit, bool _selection);
+
 public:
 
     TextStyle(std::string _name, std::shared_ptr<FontContext> _fontContext, bool _sdf = false,
@@ -73,6 +122,8 @@ public:
     void constructVertexLayout() override;
     void constructShaderProgram() override;
 
+    int buildShaderPrograms(RenderState& rs) override;
+
     /* Create the LabelMeshes associated with FontContext GlyphTexture<s>
      * No GL involved, called from Tangram::update()
      */
@@ -103,6 +154,23 @@ public:
 
     virtual size_t dynamicMeshSize() const override;
 
+    /* Whether point labels are drawn from static meshes, which are placed on
+     * screen by uniforms instead of being rebuilt every frame */
+    bool staticLabels() const { return m_staticLabels; }
+
+    const auto& staticVertexLayout() const { return m_staticVertexLayout; }
+
+    uint32_t frame() const { return m_frame; }
+
+    /* Whether static meshes can be drawn without the glyph quads they were
+     * built from */
+    bool staticProgramReady() const;
+
+    /* Draw @_slot of @_labels after the labels which were placed before */
+    void addStaticSlot(const TextLabels& _labels, uint32_t _slot) const;
+
+    void removeStaticLabels(const TextLabels& _labels) const;
+
     virtual ~TextStyle() override;
 
 private:
@@ -11,16 +11,12 @@
 #include "selection/featureSelection.h"
 #include "scene/drawRule.h"
 #include "tile/tile.h"
+#include "util/arena.h"
 #include "util/geom.h"
 #include "util/mapProjection.h"
 #include "util/lineSampler.h"
 #include "view/view.h"
 
-#include "unicode/unistr.h"
-#include "unicode/schriter.h"
-#include "unicode/brkiter.h"
-#include "unicode/locid.h"
-
 #include <glm/gtx/norm.hpp>
 #include <algorithm>
 #include <cmath>
@@ -33,6 +29,17 @@ const static std::string key_name("name");
 
 TextStyleBuilder::TextStyleBuilder(const TextStyle& _style) : m_style(_style) {}
 
+TextStyleBuilder::~TextStyleBuilder() {
+    releaseAtlasRefs();
+}
+
+void TextStyleBuilder::releaseAtlasRefs() {
+    if (m_atlasRefs.any()) {
+        m_style.context()->releaseAtlas(m_atlasRefs);
+        m_atlasRefs.reset();
+    }
+}
+
 void TextStyleBuilder::setup(const Tile& _tile){
     m_tileSize = MapProjection::tileSize() * m_style.pixelScale();
 
@@ -40,7 +47,7 @@ void TextStyleBuilder::setup(const Tile& _tile){
     m_tileScale = pow(2, _tile.getID().s - _tile.getID().z);
     m_tileSize *= m_tileScale;
 
-    m_atlasRefs.reset();
+    releaseAtlasRefs();
 
     m_textLabels = std::make_unique<TextLabels>(m_style);
 }
@@ -56,7 +63,7 @@ void TextStyleBuilder::setup(const Marker& marker, int zoom) {
     // (Copied from Tile setup function above, purpose unclear)
     m_tileSize *= m_style.pixelScale();
 
-    m_atlasRefs.reset();
+    releaseAtlasRefs();
 
     m_textLabels = std::make_unique<TextLabels>(m_style);
 }
@@ -158,12 +165,37 @@ std::unique_ptr<StyledMesh> TextStyleBuilder::build() {
         m_textLabels->setQuads(std::move(quads), m_atlasRefs);
     }
 
+    // TextLabels releases the atlas references from now on
+    m_atlasRefs.reset();
+
     m_labels.clear();
     m_quads.clear();
 
     return std::move(m_textLabels);
 }
 
+void TextStyleBuilder::merge(StyleBuilder& _part) {
+    auto& part = static_cast<TextStyleBuilder&>(_part);
+
+    if (part.m_quads.empty()) { return; }
+
+    int quadOffset = m_quads.size();
+
+    for (auto& label : part.m_labels) {
+        static_cast<TextLabel&>(*label).relocate(*m_textLabels, quadOffset);
+        m_labels.push_back(std::move(label));
+    }
+    m_quads.insert(m_quads.end(), part.m_quads.begin(), part.m_quads.end());
+
+    // Both builders hold a reference on the atlases they share
+    m_style.context()->releaseAtlas(m_atlasRefs & part.m_atlasRefs);
+    m_atlasRefs |= part.m_atlasRefs;
+    part.m_atlasRefs.reset();
+
+    part.m_labels.clear();
+    part.m_quads.clear();
+}
+
 bool getTextSource(const StyleParamKey _key, const DrawRule& _rule, const Properties& _props,
                    std::string& _text) {
 
@@ -401,7 +433,7 @@ void TextStyleBuilder::addCurvedTextLabels(const Line& _line, const TextStyle::P
     // cross(dir1,dir2) < sin(10)
     const float flipTolerance = 0.17;
 
-    LineSampler<std::vector<glm::vec3>> sampler;
+    LineSampler<ArenaVector<glm::vec3>> sampler { ArenaVector<glm::vec3>(m_arena) };
 
     sampler.set(_line);
 
@@ -413,7 +445,7 @@ void TextStyleBuilder::addCurvedTextLabels(const Line& _line, const TextStyle::P
         float sumAngle;
     };
 
-    std::vector<LineRange> ranges;
+    ArenaVector<LineRange> ranges(m_arena);
 
     for (size_t i = 0; i < _line.size()-1; i++) {
 
@@ -521,7 +553,7 @@ void TextStyleBuilder::addCurvedTextLabels(const Line& _line, const TextStyle::P
             selectionColor = _rule.featureSelection->nextColorIdentifier();
         }
 
-        m_labels.emplace_back(new CurvedLabel(l, _params.labelOptions, prio,
+        m_labels.emplace_back(new CurvedLabel(std::move(l), _params.labelOptions, prio,
                                                {_attributes.fill,
                                                        _attributes.stroke,
                                                        _attributes.fontScale,
@@ -732,50 +764,6 @@ TextStyle::Parameters TextStyleBuilder::applyRule(const DrawRule& _rule,
     return p;
 }
 
-void applyTextTransform(const TextStyle::Parameters& _params,
-                        icu::UnicodeString& _string) {
-
-    icu::Locale loc("en");
-
-    switch (_params.transform) {
-    case TextLabelProperty::Transform::capitalize: {
-        UErrorCode status{U_ZERO_ERROR};
-        auto *wordIterator = icu::BreakIterator::createWordInstance(loc, status);
-
-        if (U_SUCCESS(status)) { _string.toTitle(wordIterator); }
-
-        delete wordIterator;
-        break;
-    }
-    case TextLabelProperty::Transform::lowercase:
-        _string.toLower(loc);
-        break;
-    case TextLabelProperty::Transform::uppercase:
-        _string.toUpper(loc);
-        break;
-    default:
-        break;
-    }
-}
-
-bool isComplexShapingScript(const icu::UnicodeString& _text) {
-
-    // Taken from:
-    // https://github.com/tangrams/tangram/blob/labels-rebase/src/styles/text/canvas_text.js#L538-L553
-    // See also http://r12a.github.io/scripts/featurelist/
-
-    icu::StringCharacterIterator iterator(_text);
-    for (UChar c = iterator.first(); c != icu::CharacterIterator::DONE; c = iterator.next()) {
-        if (c >= u'\u0600' && c <= u'\u18AF') {
-            if ((c <= u'\u06FF') ||                   // Arabic:     "\u0600-\u06FF"
-                (c >= u'\u1800' && c <= u'\u18AF')) { // Mongolian:  "\u1800-\u18AF"
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
 bool TextStyleBuilder::prepareLabel(TextStyle::Parameters& _params, Label::Type _type,
                                     LabelAttributes& _attributes) {
 
@@ -784,14 +772,6 @@ bool TextStyleBuilder::prepareLabel(TextStyle::Parameters& _params, Label::Type
         return false;
     }
 
-    auto text = icu::UnicodeString::fromUTF8(_params.text);
-
-    applyTextTransform(_params, text);
-
-    if (_type == Label::Type::line) {
-        _params.hasComplexShaping = isComplexShapingScript(text);
-    }
-
     // Scale factor by which the texture glyphs are scaled to match fontSize
     _params.fontScale = _params.fontSize / _params.font->size();
 
@@ -813,7 +793,7 @@ bool TextStyleBuilder::prepareLabel(TextStyle::Parameters& _params, Label::Type
     _attributes.textRanges = TextRange{};
 
     glm::vec2 bbox(0);
-    if (ctx->layoutText(_params, text, m_quads, m_atlasRefs, bbox, _attributes.textRanges)) {
+    if (ctx->layoutText(_params, m_quads, m_atlasRefs, bbox, _attributes.textRanges)) {
 
         int start = _attributes.quadsStart;
         for (auto& range : _attributes.textRanges) {
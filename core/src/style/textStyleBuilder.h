@@ -28,6 +28,8 @@ public:
 
     TextStyleBuilder(const TextStyle& _style);
 
+    ~TextStyleBuilder() override;
+
     const Style& style() const override { return m_style; }
 
     bool addFeature(const Feature& _feature, const DrawRule& _rule) override;
@@ -37,6 +39,8 @@ public:
 
     std::unique_ptr<StyledMesh> build() override;
 
+    void merge(StyleBuilder& _part) override;
+
     TextStyle::Parameters applyRule(const DrawRule& _rule, const Properties& _props, bool _iconText) const;
 
     bool prepareLabel(TextStyle::Parameters& _params, Label::Type _type, LabelAttributes& _attributes);
@@ -64,6 +68,9 @@ public:
 
 protected:
 
+    // Release the atlases referenced by quads which were not handed to TextLabels
+    void releaseAtlasRefs();
+
     const TextStyle& m_style;
 
     // Result: TextLabel container
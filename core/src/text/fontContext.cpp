@@ -6,6 +6,7 @@
 #define SDF_IMPLEMENTATION
 #include "sdf.h"
 
+#include <cstring>
 #include <memory>
 #include <regex>
 
@@ -17,11 +18,31 @@ namespace Tangram {
 
 const std::vector<float> FontContext::s_fontRasterSizes = { 16, 28, 40 };
 
+std::atomic<uint64_t> FontContext::s_fontGenerations{0};
+
+struct FontContext::ShapingState {
+    uint64_t fontGeneration = 0;
+
+    // TextShaper to create <LineLayout> for a given text and Font
+    alfons::TextShaper shaper;
+    TextWrapper textWrapper;
+
+    // Fonts and faces of this thread by those of the FontContext. The faces of
+    // the FontContext are only used to draw glyphs into the atlas.
+    alfons::FontManager fonts;
+    std::unordered_map<const alfons::Font*, std::shared_ptr<alfons::Font>> fontCopies;
+    std::unordered_map<const alfons::FontFace*, std::shared_ptr<alfons::FontFace>> faceCopies;
+};
+
 FontContext::FontContext(std::shared_ptr<const Platform> _platform) :
     m_sdfRadius(SDF_WIDTH),
+    m_fontGeneration(++s_fontGenerations),
     m_atlas(*this, GlyphTexture::size, m_sdfRadius),
     m_batch(m_atlas, m_scratch),
-    m_platform(_platform) {}
+    m_platform(_platform) {
+
+    for (auto& count : m_atlasRefCount) { count = 0; }
+}
 
 void FontContext::setPixelScale(float _scale) {
     m_sdfRadius = SDF_WIDTH * _scale;
@@ -68,7 +89,7 @@ void FontContext::loadFonts() {
     }
 }
 
-// Synchronized on m_mutex in layoutText(), called on tile-worker threads
+// Synchronized on m_fontMutex in layoutText(), called on tile-worker threads
 void FontContext::addTexture(alfons::AtlasID id, uint16_t width, uint16_t height) {
 
     std::lock_guard<std::mutex> lock(m_textureMutex);
@@ -80,48 +101,75 @@ void FontContext::addTexture(alfons::AtlasID id, uint16_t width, uint16_t height
     m_textures.push_back(std::make_unique<GlyphTexture>());
 }
 
-// Synchronized on m_mutex in layoutText(), called on tile-worker threads
+// Synchronized on m_fontMutex in layoutText(), called on tile-worker threads
 void FontContext::addGlyph(alfons::AtlasID id, uint16_t gx, uint16_t gy, uint16_t gw, uint16_t gh,
                            const unsigned char* src, uint16_t pad) {
 
-    std::lock_guard<std::mutex> lock(m_textureMutex);
-
     if (id >= max_textures) { return; }
 
-    auto texData = m_textures[id]->buffer();
-    auto& texture = m_textures[id];
-
-    size_t stride = GlyphTexture::size;
-    size_t width =  GlyphTexture::size;
+    // Place the glyph into a zeroed buffer with padding for the distance field,
+    // the texture region may still contain glyphs of an evicted atlas.
+    size_t width = gw + pad * 2;
+    size_t height = gh + pad * 2;
 
-    unsigned char* dst = &texData[(gx + pad) + (gy + pad) * stride];
+    m_glyphBuffer.assign(width * height, 0);
 
+    unsigned char* dst = &m_glyphBuffer[pad + pad * width];
     for (size_t y = 0, pos = 0; y < gh; y++, pos += gw) {
-        std::memcpy(dst + (y * stride), src + pos, gw);
+        std::memcpy(dst + (y * width), src + pos, gw);
     }
 
-    dst = &texData[size_t(gx) + (size_t(gy) * width)];
-    gw += pad * 2;
-    gh += pad * 2;
-
-    size_t bytes = size_t(gw) * size_t(gh) * sizeof(float) * 3;
+    size_t bytes = width * height * sizeof(float) * 3;
     if (m_sdfBuffer.size() < bytes) {
         m_sdfBuffer.resize(bytes);
     }
 
-    sdfBuildDistanceFieldNoAlloc(dst, width, m_sdfRadius,
-                                 dst, gw, gh, width,
+    sdfBuildDistanceFieldNoAlloc(m_glyphBuffer.data(), width, m_sdfRadius,
+                                 m_glyphBuffer.data(), width, height, width,
                                  &m_sdfBuffer[0]);
 
-    texture->setRowsDirty(gy, gh);
+    std::lock_guard<std::mutex> lock(m_textureMutex);
+
+    if (id >= m_textures.size()) { return; }
+
+    auto& texture = m_textures[id];
+    size_t stride = GlyphTexture::size;
+    unsigned char* texData = &texture->buffer()[size_t(gx) + size_t(gy) * stride];
+
+    for (size_t y = 0; y < height; y++) {
+        std::memcpy(texData + y * stride, &m_glyphBuffer[y * width], width);
+    }
+
+    texture->setDirty(gx, gy, width, height);
 }
 
 void FontContext::releaseAtlas(std::bitset<max_textures> _refs) {
     if (!_refs.any()) { return; }
-    std::lock_guard<std::mutex> lock(m_textureMutex);
 
-    for (size_t i = 0; i < m_textures.size(); i++) {
-        if (_refs[i]) { m_atlasRefCount[i] -= 1; }
+    for (size_t i = 0; i < max_textures; i++) {
+        if (_refs[i] && m_atlasRefCount[i].fetch_sub(1) == 1) {
+            m_unusedAtlases.fetch_or(uint64_t(1) << i);
+        }
+    }
+}
+
+void FontContext::evictAtlas() {
+
+    uint64_t unused = m_unusedAtlases.load();
+
+    for (size_t i = 0; unused != 0 && i < max_textures; i++) {
+        uint64_t bit = uint64_t(1) << i;
+        if (!(unused & bit)) { continue; }
+
+        unused &= ~bit;
+        m_unusedAtlases.fetch_and(~bit);
+
+        // References are only added in layoutText() while holding m_fontMutex,
+        // so an atlas that is still unused here stays unused.
+        if (m_atlasRefCount[i] == 0) {
+            m_atlas.clear(i);
+            return;
+        }
     }
 }
 
@@ -137,20 +185,119 @@ void FontContext::bindTexture(RenderState& rs, alfons::AtlasID _id, GLuint _unit
     m_textures[_id]->bind(rs, _unit);
 }
 
-bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeString& _text,
-                             std::vector<GlyphQuad>& _quads, std::bitset<max_textures>& _refs,
-                             glm::vec2& _size, TextRange& _textRanges) {
+FontContext::ShapingState& FontContext::shapingState() {
+
+    thread_local std::unique_ptr<ShapingState> state;
+
+    uint64_t generation = m_fontGeneration;
+    if (!state || state->fontGeneration != generation) {
+        // Faces of the previous fonts are released with their state
+        state = std::make_unique<ShapingState>();
+        state->fontGeneration = generation;
+    }
+    return *state;
+}
+
+std::shared_ptr<alfons::Font> FontContext::threadFont(ShapingState& _state,
+                                                      const std::shared_ptr<alfons::Font>& _font) {
 
+    auto& copy = _state.fontCopies[_font.get()];
+    if (copy) { return copy; }
+
+    // Faces of the fonts are only added while holding m_fontMutex
     std::lock_guard<std::mutex> lock(m_fontMutex);
 
-    alfons::LineLayout line = m_shaper.shapeICU(_params.font, _text, MIN_LINE_WIDTH,
-                                                _params.wordWrap ? _params.maxLineWidth : 0);
+    float size = m_fontSizes[_font.get()];
+    copy = _state.fonts.getFont(std::to_string(_state.fontCopies.size()), size);
+
+    for (auto& face : _font->faces()) {
+        auto& faceCopy = _state.faceCopies[face.get()];
+        if (!faceCopy) {
+            faceCopy = _state.fonts.addFontFace(face->descriptor().source, size);
+        }
+        copy->addFace(faceCopy);
+    }
+    return copy;
+}
+
+std::shared_ptr<const ShapedText> FontContext::shapeText(const ShapedTextKey& _key) {
+
+    auto text = icu::UnicodeString::fromUTF8(_key.text);
+    applyTextTransform(_key.transform, text);
+
+    auto shaped = std::make_shared<ShapedText>();
+    shaped->complexShaping = isComplexShapingScript(text);
+
+    auto& state = shapingState();
+    auto font = threadFont(state, _key.font);
+
+    auto line = state.shaper.shapeICU(font, text, MIN_LINE_WIDTH, _key.maxLineWidth);
 
     if (line.missingGlyphs() || line.shapes().size() == 0) {
         // Nothing to do!
-        return false;
+        return nullptr;
+    }
+
+    if (_key.wordWrap) {
+        if (_key.maxLines != 0) {
+            uint32_t numLines = 0;
+            int pos = 0;
+            int max = line.shapes().size();
+
+            for (auto& shape : line.shapes()) {
+                pos++;
+                if (shape.mustBreak) {
+                    numLines++;
+                    if (numLines >= _key.maxLines && pos < max) {
+                        shape.mustBreak = false;
+                        line.removeShapes(shape.isSpace ? pos-1 : pos, max);
+
+                        auto ellipsis = state.shaper.shape(font, "…");
+                        line.addShapes(ellipsis.shapes());
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Line widths scale linearly with the font scale
+        state.textWrapper.clearWraps();
+        shaped->width = state.textWrapper.getShapeRangeWidth(line);
+        shaped->lineWraps = state.textWrapper.lineWraps();
+    }
+
+    // Glyphs are drawn from the faces of the shared font, shapes refer to the
+    // faces by their index which is the same in both fonts
+    shaped->line = alfons::LineLayout(_key.font, std::move(line.shapes()));
+    shaped->line.setMiddleLineFactor(line.middleLineFactor());
+
+    return shaped;
+}
+
+bool FontContext::layoutText(TextStyle::Parameters& _params,
+                             std::vector<GlyphQuad>& _quads, std::bitset<max_textures>& _refs,
+                             glm::vec2& _size, TextRange& _textRanges) {
+
+    ShapedTextKey key{ _params.text, _params.font, _params.transform, _params.wordWrap,
+                       _params.wordWrap ? _params.maxLineWidth : 0,
+                       _params.wordWrap ? _params.maxLines : 0 };
+
+    std::shared_ptr<const ShapedText> shaped;
+    if (!m_shapedText.get(key, shaped)) {
+        // Not cached when glyphs are missing, fonts may still be loading
+        shaped = shapeText(key);
+        if (!shaped) { return false; }
+
+        m_shapedText.put(key, shaped);
     }
 
+    _params.hasComplexShaping = shaped->complexShaping;
+
+    auto& textWrapper = shapingState().textWrapper;
+
+    std::lock_guard<std::mutex> lock(m_fontMutex);
+
+    alfons::LineLayout line = shaped->line;
     line.setScale(_params.fontScale);
 
     // m_batch.drawShapeRange() calls FontContext's TextureCallback for new glyphs
@@ -176,30 +323,8 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
     }
 
     if (_params.wordWrap) {
-        m_textWrapper.clearWraps();
-
-        if (_params.maxLines != 0) {
-            uint32_t numLines = 0;
-            int pos = 0;
-            int max = line.shapes().size();
-
-            for (auto& shape : line.shapes()) {
-                pos++;
-                if (shape.mustBreak) {
-                    numLines++;
-                    if (numLines >= _params.maxLines && pos < max) {
-                        shape.mustBreak = false;
-                        line.removeShapes(shape.isSpace ? pos-1 : pos, max);
-
-                        auto ellipsis = m_shaper.shape(_params.font, "…");
-                        line.addShapes(ellipsis.shapes());
-                        break;
-                    }
-                }
-            }
-        }
-
-        float width = m_textWrapper.getShapeRangeWidth(line);
+        textWrapper.setLineWraps(shaped->lineWraps, _params.fontScale);
+        float width = shaped->width * _params.fontScale;
 
         for (size_t i = 0; i < 3; i++) {
 
@@ -208,8 +333,8 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
                 _textRanges[i] = Range(rangeStart, 0);
                 continue;
             }
-            int numLines = m_textWrapper.draw(m_batch, width, line, TextLabelProperty::Align(i),
-                                              _params.lineSpacing, metrics);
+            int numLines = textWrapper.draw(m_batch, width, line, TextLabelProperty::Align(i),
+                                            _params.lineSpacing, metrics);
             int rangeEnd = m_scratch.quads->size();
 
             _textRanges[i] = Range(rangeStart, rangeEnd - rangeStart);
@@ -248,30 +373,23 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
     glm::vec2 offset((metrics.aabb.x + width * 0.5) * TextVertex::position_scale,
                      (metrics.aabb.y + height * 0.5) * TextVertex::position_scale);
 
-    {
-        std::lock_guard<std::mutex> lock(m_textureMutex);
-        for (; it != _quads.end(); ++it) {
+    for (; it != _quads.end(); ++it) {
 
-            if (!_refs[it->atlas]) {
-                _refs[it->atlas] = true;
-                m_atlasRefCount[it->atlas] += 1;
-            }
-
-            it->quad[0].pos -= offset;
-            it->quad[1].pos -= offset;
-            it->quad[2].pos -= offset;
-            it->quad[3].pos -= offset;
+        if (!_refs[it->atlas]) {
+            _refs[it->atlas] = true;
+            m_atlasRefCount[it->atlas] += 1;
         }
 
-        // Clear unused textures
-        for (size_t i = 0; i < m_textures.size(); i++) {
-            if (m_atlasRefCount[i] == 0) {
-                m_atlas.clear(i);
-                std::memset(m_textures[i]->buffer(), 0, GlyphTexture::size * GlyphTexture::size);
-            }
-        }
+        it->quad[0].pos -= offset;
+        it->quad[1].pos -= offset;
+        it->quad[2].pos -= offset;
+        it->quad[3].pos -= offset;
     }
 
+    // Evict unused atlases incrementally, one per label. Their texture regions
+    // are overwritten as new glyphs are added.
+    evictAtlas();
+
     return true;
 }
 
@@ -280,6 +398,10 @@ void FontContext::addFont(const FontDescription& _ft, alfons::InputSource _sourc
     // NB: Synchronize for calls from download thread
     std::lock_guard<std::mutex> lock(m_fontMutex);
 
+    // Texts shaped before the font was available may use other faces
+    m_shapedText.clear();
+    m_fontGeneration = ++s_fontGenerations;
+
     for (size_t i = 0; i < s_fontRasterSizes.size(); i++) {
         if (auto font = m_alfons.getFont(_ft.alias, s_fontRasterSizes[i])) {
 
@@ -294,6 +416,11 @@ void FontContext::addFont(const FontDescription& _ft, alfons::InputSource _sourc
 void FontContext::releaseFonts() {
 
     std::lock_guard<std::mutex> lock(m_fontMutex);
+
+    m_shapedText.clear();
+    // Faces loaded by the threads are released on their next shaping
+    m_fontGeneration = ++s_fontGenerations;
+
     // Unload Freetype and Harfbuzz resources for all font faces
     m_alfons.unload();
 
@@ -341,6 +468,8 @@ std::shared_ptr<alfons::Font> FontContext::getFont(const std::string& _family, c
     std::lock_guard<std::mutex> lock(m_fontMutex);
 
     auto font = m_alfons.getFont(FontDescription::Alias(_family, _style, _weight), fontSize);
+    m_fontSizes[font.get()] = fontSize;
+
     if (font->hasFaces()) { return font; }
 
     // First, try to load from the system fonts.
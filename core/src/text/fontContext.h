@@ -4,6 +4,8 @@
 #include "labels/textLabel.h"
 #include "style/textStyle.h"
 #include "text/textUtil.h"
+#include "util/hash.h"
+#include "util/lruCache.h"
 
 #include "alfons/alfons.h"
 #include "alfons/atlas.h"
@@ -12,8 +14,11 @@
 #include "alfons/inputSource.h"
 #include "alfons/textBatch.h"
 #include "alfons/textShaper.h"
+#include <array>
+#include <atomic>
 #include <bitset>
 #include <mutex>
+#include <unordered_map>
 
 namespace Tangram {
 
@@ -41,32 +46,81 @@ struct FontDescription {
     }
 };
 
+/* Shaped and line-wrapped text, independent of font size and glyph atlases */
+struct ShapedText {
+    alfons::LineLayout line;
+    // Line wraps at unit scale, when word wrapping
+    TextWrapper::LineWraps lineWraps;
+    float width = 0;
+    bool complexShaping = false;
+};
+
+struct ShapedTextKey {
+    std::string text;
+    std::shared_ptr<alfons::Font> font;
+    TextLabelProperty::Transform transform;
+    bool wordWrap;
+    uint32_t maxLineWidth;
+    uint32_t maxLines;
+
+    bool operator==(const ShapedTextKey& _other) const {
+        return text == _other.text && font == _other.font && transform == _other.transform &&
+            wordWrap == _other.wordWrap && maxLineWidth == _other.maxLineWidth &&
+            maxLines == _other.maxLines;
+    }
+};
+
+struct ShapedTextKeyHash {
+    size_t operator()(const ShapedTextKey& _key) const {
+        size_t seed = 0;
+        hash_combine(seed, _key.text);
+        hash_combine(seed, _key.font.get());
+        hash_combine(seed, int(_key.transform));
+        hash_combine(seed, _key.wordWrap);
+        hash_combine(seed, _key.maxLineWidth);
+        hash_combine(seed, _key.maxLines);
+        return seed;
+    }
+};
+
+using ShapedTextCache = LruCache<ShapedTextKey, std::shared_ptr<const ShapedText>, ShapedTextKeyHash>;
+
 class FontContext : public alfons::TextureCallback {
 
 public:
 
     static constexpr int max_textures = 64;
 
+    // Number of shaped texts kept for reuse across tiles
+    static constexpr size_t shaped_text_cache_size = 4096;
+
     FontContext(std::shared_ptr<const Platform> _platform);
     virtual ~FontContext() {}
 
     void loadFonts();
 
-    /* Synchronized on m_mutex on tile-worker threads
+    /* Synchronized on m_fontMutex on tile-worker threads
      * Called from alfons when a texture atlas needs to be created
      * Triggered from TextStyleBuilder::prepareLabel
      */
     void addTexture(alfons::AtlasID id, uint16_t width, uint16_t height) override;
 
-    /* Synchronized on m_mutex, called tile-worker threads
-     * Called from alfons when a glyph needs to be added the the atlas identified by id
+    /* Synchronized on m_fontMutex, called tile-worker threads
+     * Called from alfons when a glyph needs to be added the the atlas identified by id.
+     * The distance field is built outside of m_textureMutex, which is only held to
+     * copy the glyph into the texture.
      * Triggered from TextStyleBuilder::prepareLabel
      */
     void addGlyph(alfons::AtlasID id, uint16_t gx, uint16_t gy, uint16_t gw, uint16_t gh,
                   const unsigned char* src, uint16_t pad) override;
 
+    /* Lock-free, atlases that are no longer referenced are marked for eviction
+     * and cleared later by layoutText() */
     void releaseAtlas(std::bitset<max_textures> _refs);
 
+    /* Number of TextLabels and builders referencing atlas @_id */
+    int atlasRefCount(size_t _id) const { return m_atlasRefCount[_id]; }
+
     /* Update all textures batches, uploads the data to the GPU */
     void updateTextures(RenderState& rs);
 
@@ -82,10 +136,18 @@ public:
 
     float maxStrokeWidth() { return m_sdfRadius; }
 
-    bool layoutText(TextStyle::Parameters& _params, const icu::UnicodeString& _text,
+    /* Lay out the text of @_params into glyph quads. Shaping results are cached
+     * by text, font, transform and wrapping so that labels repeating across tiles
+     * are only shaped once. Sets @_params.hasComplexShaping.
+     * Texts are shaped without holding m_fontMutex, with a shaper and faces of the
+     * calling thread. Only drawing glyphs into the atlas is synchronized.
+     */
+    bool layoutText(TextStyle::Parameters& _params,
                     std::vector<GlyphQuad>& _quads, std::bitset<max_textures>& _refs,
                     glm::vec2& _bbox, TextRange& _textRanges);
 
+    ShapedTextCache::Stats shapedTextCacheStats() const { return m_shapedText.stats(); }
+
     struct ScratchBuffer : public alfons::MeshCallback {
         void drawGlyph(const alfons::Quad& q, const alfons::AtlasGlyph& altasGlyph) override {}
         void drawGlyph(const alfons::Rect& q, const alfons::AtlasGlyph& atlasGlyph) override;
@@ -106,25 +168,54 @@ private:
     ScratchBuffer m_scratch;
     std::vector<unsigned char> m_sdfBuffer;
 
+    // Clear one unreferenced atlas, called with m_fontMutex held
+    void evictAtlas();
+
+    // Shaper and fonts of a tile-worker thread
+    struct ShapingState;
+
+    // State of the calling thread, renewed when fonts were added or released
+    ShapingState& shapingState();
+
+    // Font of the calling thread with the faces of @_font in the same order
+    std::shared_ptr<alfons::Font> threadFont(ShapingState& _state, const std::shared_ptr<alfons::Font>& _font);
+
+    // Shape and wrap text, returns null when glyphs are missing
+    std::shared_ptr<const ShapedText> shapeText(const ShapedTextKey& _key);
+
+    ShapedTextCache m_shapedText{shaped_text_cache_size};
+
     std::mutex m_fontMutex;
     std::mutex m_textureMutex;
 
-    std::array<int, max_textures> m_atlasRefCount = {{0}};
+    // Changed when faces are added to fonts or released, taken from
+    // s_fontGenerations so that it is unique across FontContexts
+    std::atomic<uint64_t> m_fontGeneration;
+    static std::atomic<uint64_t> s_fontGenerations;
+
+    // Raster size of the fonts returned by getFont(), guarded by m_fontMutex
+    std::unordered_map<const alfons::Font*, float> m_fontSizes;
+
+    // Number of labels using each atlas
+    std::array<std::atomic<int>, max_textures> m_atlasRefCount;
+    // Bitmask of atlases whose reference count dropped to zero
+    std::atomic<uint64_t> m_unusedAtlases{0};
+    static_assert(max_textures <= 64, "Unused atlases must fit into a 64 bit mask");
+
     alfons::GlyphAtlas m_atlas;
 
+    // Padded glyph for building its distance field
+    std::vector<unsigned char> m_glyphBuffer;
+
     alfons::FontManager m_alfons;
     std::array<std::shared_ptr<alfons::Font>, 3> m_font;
 
     std::vector<std::unique_ptr<GlyphTexture>> m_textures;
 
-    // TextShaper to create <LineLayout> for a given text and Font
-    alfons::TextShaper m_shaper;
-
     // TextBatch to 'draw' <LineLayout>s, i.e. creating glyph textures and glyph quads.
     // It is intialized with a TextureCallback implemented by FontContext for adding glyph
     // textures and a MeshCallback implemented by TextStyleBuilder for adding glyph quads.
     alfons::TextBatch m_batch;
-    TextWrapper m_textWrapper;
 
     std::shared_ptr<const Platform> m_platform;
 
@@ -2,8 +2,55 @@
 
 #include "platform.h"
 
+#include "unicode/schriter.h"
+#include "unicode/brkiter.h"
+#include "unicode/locid.h"
+
 namespace Tangram {
 
+void applyTextTransform(TextLabelProperty::Transform _transform, icu::UnicodeString& _string) {
+
+    icu::Locale loc("en");
+
+    switch (_transform) {
+    case TextLabelProperty::Transform::capitalize: {
+        UErrorCode status{U_ZERO_ERROR};
+        auto *wordIterator = icu::BreakIterator::createWordInstance(loc, status);
+
+        if (U_SUCCESS(status)) { _string.toTitle(wordIterator); }
+
+        delete wordIterator;
+        break;
+    }
+    case TextLabelProperty::Transform::lowercase:
+        _string.toLower(loc);
+        break;
+    case TextLabelProperty::Transform::uppercase:
+        _string.toUpper(loc);
+        break;
+    default:
+        break;
+    }
+}
+
+bool isComplexShapingScript(const icu::UnicodeString& _text) {
+
+    // Taken from:
+    // https://github.com/tangrams/tangram/blob/labels-rebase/src/styles/text/canvas_text.js#L538-L553
+    // See also http://r12a.github.io/scripts/featurelist/
+
+    icu::StringCharacterIterator iterator(_text);
+    for (UChar c = iterator.first(); c != icu::CharacterIterator::DONE; c = iterator.next()) {
+        if (c >= u'\u0600' && c <= u'\u18AF') {
+            if ((c <= u'\u06FF') ||                   // Arabic:     "\u0600-\u06FF"
+                (c >= u'\u1800' && c <= u'\u18AF')) { // Mongolian:  "\u1800-\u18AF"
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 float TextWrapper::getShapeRangeWidth(const alfons::LineLayout& _line) {
     float maxWidth = 0;
 
@@ -63,6 +110,13 @@ void TextWrapper::clearWraps() {
     m_lineWraps.clear();
 }
 
+void TextWrapper::setLineWraps(const LineWraps& _wraps, float _scale) {
+    m_lineWraps.clear();
+    for (auto& wrap : _wraps) {
+        m_lineWraps.emplace_back(wrap.first, wrap.second * _scale);
+    }
+}
+
 int TextWrapper::draw(alfons::TextBatch& _batch, float _maxWidth, const alfons::LineLayout& _line,
                       TextLabelProperty::Align _alignment, float _lineSpacing,
                       alfons::LineMetrics& _layoutMetrics) {
@@ -5,18 +5,34 @@
 #include "alfons/alfons.h"
 #include "alfons/lineLayout.h"
 #include "alfons/textBatch.h"
+#include "unicode/unistr.h"
 #include <vector>
 
 namespace Tangram {
 
+/* Apply a text-transform style (capitalize, lowercase, uppercase) to @_string */
+void applyTextTransform(TextLabelProperty::Transform _transform, icu::UnicodeString& _string);
+
+/* Whether @_text contains a script that cannot be drawn along curved lines */
+bool isComplexShapingScript(const icu::UnicodeString& _text);
+
 class TextWrapper {
 
 public:
 
+    // Shape index at the end of each line and the width of the line
+    using LineWraps = std::vector<std::pair<int,float>>;
+
     float getShapeRangeWidth(const alfons::LineLayout& _line);
 
     void clearWraps();
 
+    const LineWraps& lineWraps() const { return m_lineWraps; }
+
+    /* Use line wraps of a previous getShapeRangeWidth() call, with widths
+     * multiplied by @_scale */
+    void setLineWraps(const LineWraps& _wraps, float _scale);
+
     /* Wrap an Alfons line layout, and draw the glyph quads to the TextBatch.
      *
      * This method is not threadsafe!
@@ -34,7 +50,7 @@ public:
              alfons::LineMetrics& _metrics);
 
 private:
-    std::vector<std::pair<int,float>> m_lineWraps;
+    LineWraps m_lineWraps;
 };
 
 }
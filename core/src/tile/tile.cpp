@@ -66,6 +66,13 @@ void Tile::setMesh(const Style& _style, std::unique_ptr<StyledMesh> _mesh) {
     m_geometry[_style.getID()] = std::move(_mesh);
 }
 
+void Tile::removeMeshes(const std::vector<uint32_t>& _styleIds) {
+    for (auto id : _styleIds) {
+        if (id < m_geometry.size()) { m_geometry[id].reset(); }
+    }
+    m_memoryUsage = 0;
+}
+
 const std::unique_ptr<StyledMesh>& Tile::getMesh(const Style& _style) const {
     static std::unique_ptr<StyledMesh> NONE = nullptr;
     if (_style.getID() >= m_geometry.size()) { return NONE; }
@@ -102,4 +109,46 @@ size_t Tile::getMemoryUsage() const {
     return m_memoryUsage;
 }
 
+bool Tile::needsUpload() const {
+    for (auto& entry : m_geometry) {
+        if (entry && entry->needsUpload()) { return true; }
+    }
+    return false;
+}
+
+size_t Tile::upload(RenderState& rs, size_t _maxBytes) {
+    size_t uploaded = 0;
+
+    for (auto& entry : m_geometry) {
+        if (uploaded >= _maxBytes) { break; }
+        if (!entry) { continue; }
+
+        uploaded += entry->upload(rs, _maxBytes - uploaded);
+    }
+
+    return uploaded;
+}
+
+Tile::MemoryUsage Tile::getResidentMemoryUsage() const {
+    MemoryUsage usage;
+
+    for (auto& entry : m_geometry) {
+        if (!entry) { continue; }
+        if (entry->isUploaded()) {
+            usage.gpu += entry->bufferSize();
+        } else {
+            usage.cpu += entry->bufferSize();
+        }
+    }
+    for (auto& raster : m_rasters) {
+        if (!raster.texture) { continue; }
+        auto& texture = *raster.texture;
+        // Textures may keep their pixel data after upload
+        if (texture.isUploaded()) { usage.gpu += texture.bufferSize(); }
+        if (texture.hasBufferData()) { usage.cpu += texture.bufferSize(); }
+    }
+
+    return usage;
+}
+
 }
@@ -16,6 +16,7 @@ namespace Tangram {
 
 class MapProjection;
 struct Properties;
+class RenderState;
 class Style;
 class View;
 struct StyledMesh;
@@ -67,6 +68,9 @@ public:
 
     void setMesh(const Style& _style, std::unique_ptr<StyledMesh> _mesh);
 
+    /* Remove the meshes of the styles with IDs in @_styleIds */
+    void removeMeshes(const std::vector<uint32_t>& _styleIds);
+
     void setSelectionFeatures(const fastmap<uint32_t, std::shared_ptr<Properties>> _selectionFeatures);
 
     std::shared_ptr<Properties> getSelectionFeature(uint32_t _id) const;
@@ -84,6 +88,27 @@ public:
     /* Get the sum in bytes of static <Mesh>es */
     size_t getMemoryUsage() const;
 
+    struct MemoryUsage {
+        size_t gpu = 0;
+        size_t cpu = 0;
+    };
+
+    /* Get the bytes of <Mesh>es and rasters that are uploaded to GPU and the
+     * bytes that are still held in client memory */
+    MemoryUsage getResidentMemoryUsage() const;
+
+    /* Whether any <Mesh> of this tile still has to be uploaded */
+    bool needsUpload() const;
+
+    /* Upload up to _maxBytes of the <Mesh>es that are not yet in GPU
+     * memory, returns the number of bytes uploaded */
+    size_t upload(RenderState& rs, size_t _maxBytes);
+
+    /* Time in milliseconds it took the <TileBuilder> to build this tile */
+    float buildTime() const { return m_buildTime; }
+
+    void setBuildTime(float _buildTime) { m_buildTime = _buildTime; }
+
     int64_t sourceGeneration() const { return m_sourceGeneration; }
 
     int32_t sourceID() const { return m_sourceId; }
@@ -106,6 +131,8 @@ private:
 
     bool m_proxyState = false;
 
+    float m_buildTime = 0;
+
     glm::dvec2 m_tileOrigin; // South-West corner of the tile in 2D projection space in meters (e.g. mercator meters)
 
     glm::mat4 m_modelMatrix; // Matrix relating tile-local coordinates to global projection space coordinates;
@@ -5,26 +5,41 @@
 #include "data/tileSource.h"
 #include "gl/mesh.h"
 #include "log.h"
+#include "marker/marker.h"
 #include "scene/dataLayer.h"
 #include "scene/scene.h"
 #include "selection/featureSelection.h"
 #include "style/style.h"
 #include "tile/tile.h"
+#include "tile/tileMeshCache.h"
 #include "util/mapProjection.h"
 #include "view/view.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 namespace Tangram {
 
+// Only hash the scene configuration when a source stores built tiles
+static uint32_t meshCacheSceneHash(const Scene& _scene) {
+    for (const auto& source : _scene.tileSources()) {
+        if (source->meshCache()) { return TileMeshCache::sceneHash(_scene); }
+    }
+    return 0;
+}
+
 TileBuilder::TileBuilder(std::shared_ptr<Scene> _scene)
     : m_scene(_scene),
       m_styleContext(std::make_unique<StyleContext>()) {
 
     m_styleContext->initFunctions(*_scene);
 
-    // Initialize StyleBuilders
-    for (auto& style : _scene->styles()) {
-        m_styleBuilder[style->getName()] = style->createBuilder();
-    }
+    createStyleBuilders(m_styleBuilder);
+
+    m_sceneHash = meshCacheSceneHash(*_scene);
 }
 
 TileBuilder::TileBuilder(std::shared_ptr<Scene> _scene, StyleContext* _styleContext)
@@ -33,15 +48,22 @@ TileBuilder::TileBuilder(std::shared_ptr<Scene> _scene, StyleContext* _styleCont
 
     m_styleContext->initFunctions(*_scene);
 
-    // Initialize StyleBuilders
-    for (auto& style : _scene->styles()) {
-        m_styleBuilder[style->getName()] = style->createBuilder();
-    }
+    createStyleBuilders(m_styleBuilder);
+
+    m_sceneHash = meshCacheSceneHash(*_scene);
 }
 
 
 TileBuilder::~TileBuilder() {}
 
+void TileBuilder::createStyleBuilders(fastmap<std::string, std::unique_ptr<StyleBuilder>>& _builders) {
+    for (auto& style : m_scene->styles()) {
+        auto builder = style->createBuilder();
+        builder->setArena(&m_arena);
+        _builders[style->getName()] = std::move(builder);
+    }
+}
+
 StyleBuilder* TileBuilder::getStyleBuilder(const std::string& _name) {
     auto it = m_styleBuilder.find(_name);
     if (it == m_styleBuilder.end()) { return nullptr; }
@@ -54,9 +76,29 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
     // If no rules matched the feature, return immediately
     if (!m_ruleSet.match(_feature, _layer, *m_styleContext)) { return; }
 
+    addFeature(_feature);
+}
+
+void TileBuilder::applyStyling(const FeatureDecoder& _decoder, size_t _index, const SceneLayer& _layer) {
+
+    if (!_decoder.decodeFeature(_index, m_feature, m_decodeBuffers)) { return; }
+
+    if (!m_ruleSet.match(m_feature, _layer, *m_styleContext)) { return; }
+
+    // Only decode geometry of features that matched a draw rule
+    if (!_decoder.decodeGeometry(_index, m_feature, m_decodeBuffers)) { return; }
+
+    addFeature(m_feature);
+}
+
+void TileBuilder::addFeature(const Feature& _feature) {
+
     uint32_t selectionColor = 0;
     bool added = false;
 
+    // Release the scratch memory of StyleBuilders after each feature
+    auto arenaMarker = m_arena.mark();
+
     // For each matched rule, find the style to be used and
     // build the feature with the rule's parameters
     for (auto& rule : m_ruleSet.matchedRules()) {
@@ -71,6 +113,11 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
         // Apply default draw rules defined for this style
         style->style().applyDefaultDrawRules(rule);
 
+        const auto& outlineStyleName = rule.findParameter(StyleParamKey::outline_style);
+
+        bool restored = isRestored(*style);
+        if (restored && !outlineStyleName) { continue; }
+
         if (!m_ruleSet.evaluateRuleForContext(rule, *m_styleContext)) {
             continue;
         }
@@ -87,13 +134,12 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
         }
 
         // build outline explicitly with outline style
-        const auto& outlineStyleName = rule.findParameter(StyleParamKey::outline_style);
         if (outlineStyleName) {
             auto& styleName = outlineStyleName.value.get<std::string>();
             auto* outlineStyle = getStyleBuilder(styleName);
             if (!outlineStyle) {
                 LOGN("Invalid style %s", styleName.c_str());
-            } else {
+            } else if (!isRestored(*outlineStyle)) {
                 rule.isOutlineOnly = true;
                 outlineStyle->addFeature(_feature, rule);
                 rule.isOutlineOnly = false;
@@ -101,21 +147,211 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
         }
 
         // build feature with style
-        added |= style->addFeature(_feature, rule);
+        if (!restored) {
+            added |= style->addFeature(_feature, rule);
+        }
     }
 
     if (added && (selectionColor != 0)) {
         m_selectionFeatures[selectionColor] = std::make_shared<Properties>(_feature.props);
     }
+
+    m_arena.rewind(arenaMarker);
+}
+
+bool TileBuilder::isRestored(const StyleBuilder& _builder) const {
+    return m_restoredTile && m_restoredTile->getMesh(_builder.style());
+}
+
+// Number of features in a tile from which its layers are split into Parts
+static const size_t PARALLEL_BUILD_MIN_FEATURES = 2048;
+
+// Number of features that a Part should have at least to pay off the merge
+static const size_t PARALLEL_BUILD_PART_FEATURES = 512;
+
+struct TileBuilder::Part {
+    // Compared with the scene of the TileBuilder that takes the part
+    const Scene* scene;
+
+    const Tile* tile;
+    bool restored = false;
+    const TileData* data;
+    std::vector<const DataLayer*> layers;
+
+    // Result of the build
+    fastmap<std::string, std::unique_ptr<StyleBuilder>> styleBuilder;
+    fastmap<uint32_t, std::shared_ptr<Properties>> selectionFeatures;
+
+    std::atomic<bool> taken{false};
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool done = false;
+};
+
+static bool layerContainsCollection(const DataLayer& _layer, const Layer& _collection) {
+    if (_collection.name.empty()) { return true; }
+
+    const auto& dlc = _layer.collections();
+    return std::find(dlc.begin(), dlc.end(), _collection.name) != dlc.end();
+}
+
+void TileBuilder::addLayer(const DataLayer& _layer, const TileData& _data) {
+
+    for (const auto& collection : _data.layers) {
+
+        if (!layerContainsCollection(_layer, collection)) { continue; }
+
+        for (const auto& feat : collection.features) {
+            applyStyling(feat, _layer);
+        }
+
+        if (collection.decoder) {
+            const auto& decoder = *collection.decoder;
+            for (size_t i = 0, n = decoder.featureCount(); i < n; i++) {
+                applyStyling(decoder, i, _layer);
+            }
+        }
+    }
+}
+
+size_t TileBuilder::splitLayers(const Tile& _tile, const TileData& _data,
+                                const ArenaVector<const DataLayer*>& _layers,
+                                std::vector<std::shared_ptr<Part>>& _parts) {
+
+    if (!m_partQueue || _layers.size() < 2) { return _layers.size(); }
+
+    // Estimate the work per layer by the number of features it styles
+    ArenaVector<size_t> features(&m_arena);
+    size_t total = 0;
+
+    for (auto* layer : _layers) {
+        size_t count = 0;
+        for (const auto& collection : _data.layers) {
+            if (!layerContainsCollection(*layer, collection)) { continue; }
+
+            count += collection.features.size();
+            if (collection.decoder) { count += collection.decoder->featureCount(); }
+        }
+        features.push_back(count);
+        total += count;
+    }
+
+    if (total < PARALLEL_BUILD_MIN_FEATURES) { return _layers.size(); }
+
+    size_t numParts = std::min(m_partQueue->idleWorkers() + 1, _layers.size());
+    numParts = std::min(numParts, total / PARALLEL_BUILD_PART_FEATURES);
+
+    if (numParts < 2) { return _layers.size(); }
+
+    // Split into consecutive ranges of layers with about the same number of
+    // features. The first range is built on this thread.
+    size_t localLayers = _layers.size();
+    size_t begin = 0;
+    size_t sum = 0;
+    size_t range = 0;
+
+    for (size_t i = 0; i < _layers.size(); i++) {
+        sum += features[i];
+
+        bool last = (i + 1 == _layers.size());
+        if (!last && sum * numParts < total * (range + 1)) { continue; }
+
+        if (range == 0) {
+            localLayers = i + 1;
+        } else {
+            auto part = std::make_shared<Part>();
+            part->scene = m_scene.get();
+            part->tile = &_tile;
+            part->restored = (m_restoredTile != nullptr);
+            part->data = &_data;
+            part->layers.assign(_layers.begin() + begin, _layers.begin() + i + 1);
+            _parts.push_back(std::move(part));
+        }
+        begin = i + 1;
+        range++;
+    }
+
+    for (auto& part : _parts) {
+        m_partQueue->enqueue(part);
+    }
+
+    return localLayers;
+}
+
+void TileBuilder::buildMarkers(MarkerManager::Batch& _batch) {
+
+    if (_batch.scene == m_scene) {
+        auto arenaMarker = m_arena.mark();
+        for (auto& marker : _batch.markers) {
+            MarkerManager::buildMesh(*marker, _batch.zoom, m_styleBuilder, *m_styleContext,
+                                     m_ruleSet, *m_scene->featureSelection());
+            m_arena.rewind(arenaMarker);
+        }
+    }
+
+    _batch.done = true;
+}
+
+bool TileBuilder::buildPart(Part& _part) {
+
+    if (_part.scene != m_scene.get()) { return false; }
+
+    if (_part.taken.exchange(true)) { return false; }
+
+    runPart(_part);
+
+    return true;
+}
+
+void TileBuilder::runPart(Part& _part) {
+
+    createStyleBuilders(_part.styleBuilder);
+    for (auto& builder : _part.styleBuilder) {
+        builder.second->setup(*_part.tile);
+    }
+
+    // Build into the StyleBuilders of the part
+    std::swap(m_styleBuilder, _part.styleBuilder);
+    std::swap(m_selectionFeatures, _part.selectionFeatures);
+    m_restoredTile = _part.restored ? _part.tile : nullptr;
+
+    m_styleContext->setKeywordZoom(_part.tile->getID().s);
+
+    for (auto* layer : _part.layers) {
+        addLayer(*layer, *_part.data);
+    }
+
+    std::swap(m_styleBuilder, _part.styleBuilder);
+    std::swap(m_selectionFeatures, _part.selectionFeatures);
+    m_restoredTile = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(_part.mutex);
+        _part.done = true;
+    }
+    _part.condition.notify_all();
 }
 
-std::unique_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileData, const TileSource& _source) {
+std::unique_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileData, const TileSource& _source,
+                                         std::unique_ptr<Tile> _restored) {
+
+    auto startTime = std::chrono::steady_clock::now();
 
     m_selectionFeatures.clear();
 
-    auto tile = std::make_unique<Tile>(_tileID, _source.id(), _source.generation());
+    m_arena.reset();
 
-    tile->initGeometry(m_scene->styles().size());
+    std::unique_ptr<Tile> tile;
+
+    if (_restored) {
+        tile = std::move(_restored);
+        m_selectionFeatures = tile->getSelectionFeatures();
+        m_restoredTile = tile.get();
+    } else {
+        tile = std::make_unique<Tile>(_tileID, _source.id(), _source.generation());
+        tile->initGeometry(m_scene->styles().size());
+    }
 
     m_styleContext->setKeywordZoom(_tileID.s);
 
@@ -124,24 +360,38 @@ std::unique_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileDa
             builder.second->setup(*tile);
     }
 
+    ArenaVector<const DataLayer*> layers(&m_arena);
     for (const auto& datalayer : m_scene->layers()) {
+        if (datalayer.source() == _source.name()) { layers.push_back(&datalayer); }
+    }
 
-        if (datalayer.source() != _source.name()) { continue; }
-
-        for (const auto& collection : _tileData.layers) {
+    std::vector<std::shared_ptr<Part>> parts;
+    size_t localLayers = splitLayers(*tile, _tileData, layers, parts);
 
-            if (!collection.name.empty()) {
-                const auto& dlc = datalayer.collections();
-                bool layerContainsCollection =
-                    std::find(dlc.begin(), dlc.end(), collection.name) != dlc.end();
+    for (size_t i = 0; i < localLayers; i++) {
+        addLayer(*layers[i], _tileData);
+    }
 
-                if (!layerContainsCollection) { continue; }
-            }
+    // Merge the parts in layer order, so that features are drawn in the same
+    // order as when all layers are built on this thread. The merged meshes are
+    // not the same though: selection colors are taken per part and palette
+    // entries are renumbered by the merge.
+    for (auto& part : parts) {
+        // Build parts that were not taken by other threads yet
+        if (!buildPart(*part)) {
+            std::unique_lock<std::mutex> lock(part->mutex);
+            part->condition.wait(lock, [&]{ return part->done; });
+        }
 
-            for (const auto& feat : collection.features) {
-                applyStyling(feat, datalayer);
+        for (auto& builder : m_styleBuilder) {
+            auto it = part->styleBuilder.find(builder.first.k);
+            if (it != part->styleBuilder.end()) {
+                builder.second->merge(*it->second);
             }
         }
+        for (auto& feature : part->selectionFeatures) {
+            m_selectionFeatures[feature.first] = feature.second;
+        }
     }
 
     for (auto& builder : m_styleBuilder) {
@@ -154,11 +404,18 @@ std::unique_ptr<Tile> TileBuilder::build(TileID _tileID, const TileData& _tileDa
     m_labelLayout.process(_tileID, tile->getInverseScale(), tileSize);
 
     for (auto& builder : m_styleBuilder) {
+        if (isRestored(*builder.second)) { continue; }
         tile->setMesh(builder.second->style(), builder.second->build());
     }
 
+    m_restoredTile = nullptr;
+
     tile->setSelectionFeatures(m_selectionFeatures);
 
+    // Let the TileCache weigh the cost of rebuilding this tile
+    std::chrono::duration<float, std::milli> buildTime = std::chrono::steady_clock::now() - startTime;
+    tile->setBuildTime(buildTime.count());
+
     return tile;
 }
 
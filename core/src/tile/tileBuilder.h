@@ -1,9 +1,12 @@
 #pragma once
 
+#include "data/tileData.h"
 #include "data/tileSource.h"
 #include "labels/labelCollider.h"
+#include "marker/markerManager.h"
 #include "scene/styleContext.h"
 #include "scene/drawRule.h"
+#include "util/arena.h"
 
 namespace Tangram {
 
@@ -11,7 +14,6 @@ class DataLayer;
 class StyleBuilder;
 class Tile;
 class TileSource;
-struct Feature;
 struct Properties;
 struct TileData;
 
@@ -19,34 +21,106 @@ class TileBuilder {
 
 public:
 
+    /* Scene layers of a tile that are styled and built by another TileBuilder
+     * into its own StyleBuilders, which are then merged in layer order */
+    struct Part;
+
+    /* Runs Parts of a tile build on other threads by calling buildPart() */
+    class PartQueue {
+    public:
+        virtual ~PartQueue() {}
+
+        /* Number of threads that could start building a Part right away */
+        virtual size_t idleWorkers() = 0;
+
+        virtual void enqueue(std::shared_ptr<Part> _part) = 0;
+    };
+
     explicit TileBuilder(std::shared_ptr<Scene> _scene);
 
     ~TileBuilder();
 
     StyleBuilder* getStyleBuilder(const std::string& _name);
 
-    std::unique_ptr<Tile> build(TileID _tileID, const TileData& _data, const TileSource& _source);
+    /* Build the tile @_tileID from @_data. When @_restored is given, only the
+     * meshes of the styles it has no mesh for are built into it. */
+    std::unique_ptr<Tile> build(TileID _tileID, const TileData& _data, const TileSource& _source,
+                                std::unique_ptr<Tile> _restored = nullptr);
+
+    /* Split the layers of large tiles into Parts for idle threads of @_queue */
+    void setPartQueue(PartQueue* _queue) { m_partQueue = _queue; }
+
+    /* Build @_part unless it was already taken by another TileBuilder or
+     * belongs to another scene. Returns true when the part was built. */
+    bool buildPart(Part& _part);
+
+    /* Build the meshes of the markers in @_batch unless it belongs to another
+     * scene, and mark it done */
+    void buildMarkers(MarkerManager::Batch& _batch);
 
     const Scene& scene() const { return *m_scene; }
 
+    /* Hash of the scene configuration for the <TileMeshCache>s of the sources */
+    uint32_t sceneHash() const { return m_sceneHash; }
+
+    const Arena& arena() const { return m_arena; }
+
     // For testing
     TileBuilder(std::shared_ptr<Scene> _scene, StyleContext* _styleContext);
 
 private:
 
+    // Apply styling to the features of @_layer in all matching collections of @_data
+    void addLayer(const DataLayer& _layer, const TileData& _data);
+
+    // Hand trailing layers of a large tile to idle threads, returns the number
+    // of layers to build on this thread
+    size_t splitLayers(const Tile& _tile, const TileData& _data,
+                       const ArenaVector<const DataLayer*>& _layers,
+                       std::vector<std::shared_ptr<Part>>& _parts);
+
+    // Build @_part into its own StyleBuilders and notify the waiting TileBuilder
+    void runPart(Part& _part);
+
     // Determine and apply DrawRules for a @_feature
     void applyStyling(const Feature& _feature, const SceneLayer& _layer);
 
+    // Decode feature @_index and apply DrawRules, geometry is only decoded on match
+    void applyStyling(const FeatureDecoder& _decoder, size_t _index, const SceneLayer& _layer);
+
+    // Build @_feature with the matched rules of m_ruleSet
+    void addFeature(const Feature& _feature);
+
+    // Whether the tile being built already has a mesh for the style of @_builder
+    bool isRestored(const StyleBuilder& _builder) const;
+
+    // Create the StyleBuilders of the scene styles into @_builders
+    void createStyleBuilders(fastmap<std::string, std::unique_ptr<StyleBuilder>>& _builders);
+
     std::shared_ptr<Scene> m_scene;
 
+    // Scratch memory of this worker, reset for each tile
+    Arena m_arena;
+
     std::unique_ptr<StyleContext> m_styleContext;
     DrawRuleMergeSet m_ruleSet;
 
+    // Reused for lazily decoded features
+    Feature m_feature;
+    DecodeBuffers m_decodeBuffers;
+
     LabelCollider m_labelLayout;
 
     fastmap<std::string, std::unique_ptr<StyleBuilder>> m_styleBuilder;
 
     fastmap<uint32_t, std::shared_ptr<Properties>> m_selectionFeatures;
+
+    PartQueue* m_partQueue = nullptr;
+
+    // Tile restored from a <TileMeshCache> that is being completed
+    const Tile* m_restoredTile = nullptr;
+
+    uint32_t m_sceneHash = 0;
 };
 
 }
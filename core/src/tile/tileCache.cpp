@@ -0,0 +1,117 @@
+#include "tile/tileCache.h"
+
+#include "log.h"
+#include "tile/tile.h"
+
+namespace Tangram {
+
+// Build time in milliseconds added to the measured time of each tile, for
+// the work that is not measured: loading and decoding the tile data
+static const double BASE_BUILD_TIME = 2.0;
+
+// Bytes added to the size of each tile, so that tiles without geometry are
+// not kept forever
+static const double ENTRY_OVERHEAD = 1024.0;
+
+// Cost factor of tiles one or two zoom levels below the current zoom
+static const double PROXY_WEIGHT = 4.0;
+
+TileCache::TileCache(size_t _cacheSizeBytes) {
+    m_stats.maxBytes = _cacheSizeBytes;
+}
+
+TileCache::~TileCache() {}
+
+double TileCache::evictionPriority(const Tile& _tile, uint64_t _bytes) const {
+    double cost = _tile.buildTime() + BASE_BUILD_TIME;
+
+    int levels = m_zoom - _tile.getID().s;
+    if (levels == 1 || levels == 2) { cost *= PROXY_WEIGHT; }
+
+    return m_age + cost / (_bytes + ENTRY_OVERHEAD);
+}
+
+void TileCache::put(int32_t _sourceId, std::shared_ptr<Tile> _tile) {
+    TileCacheKey key(_sourceId, _tile->getID());
+
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) { remove(it); }
+
+    auto usage = _tile->getResidentMemoryUsage();
+    double priority = evictionPriority(*_tile, usage.gpu + usage.cpu);
+    auto queued = m_evictionQueue.emplace(EvictionKey(priority, m_serial++), key).first;
+
+    m_entries.emplace(key, CacheEntry{ std::move(_tile), usage.gpu, usage.cpu, queued });
+
+    m_stats.gpuBytes += usage.gpu;
+    m_stats.cpuBytes += usage.cpu;
+    m_stats.tiles = m_entries.size();
+
+    limitCacheSize(m_stats.maxBytes);
+}
+
+std::shared_ptr<Tile> TileCache::get(int32_t _sourceId, TileID _tileId) {
+
+    auto it = m_entries.find(TileCacheKey(_sourceId, _tileId));
+    if (it == m_entries.end()) {
+        m_stats.misses++;
+        return nullptr;
+    }
+
+    m_stats.hits++;
+    return remove(it);
+}
+
+std::shared_ptr<Tile> TileCache::contains(int32_t _source, TileID _tileID) {
+
+    auto it = m_entries.find(TileCacheKey(_source, _tileID));
+    if (it != m_entries.end()) {
+        return it->second.tile;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Tile> TileCache::remove(std::unordered_map<TileCacheKey, CacheEntry>::iterator _it) {
+    auto& entry = _it->second;
+
+    m_stats.gpuBytes -= entry.gpuBytes;
+    m_stats.cpuBytes -= entry.cpuBytes;
+
+    auto tile = std::move(entry.tile);
+    m_evictionQueue.erase(entry.queued);
+    m_entries.erase(_it);
+
+    m_stats.tiles = m_entries.size();
+
+    return tile;
+}
+
+void TileCache::limitCacheSize(size_t _cacheSizeBytes) {
+    m_stats.maxBytes = _cacheSizeBytes;
+
+    while (getMemoryUsage() > m_stats.maxBytes) {
+        if (m_evictionQueue.empty()) {
+            LOGE("Invalid cache state!");
+            m_stats.gpuBytes = 0;
+            m_stats.cpuBytes = 0;
+            break;
+        }
+        auto next = m_evictionQueue.begin();
+        m_age = next->first.first;
+
+        remove(m_entries.find(next->second));
+        m_stats.evictions++;
+    }
+}
+
+void TileCache::clear() {
+    m_entries.clear();
+    m_evictionQueue.clear();
+    m_age = 0;
+
+    m_stats.gpuBytes = 0;
+    m_stats.cpuBytes = 0;
+    m_stats.tiles = 0;
+}
+
+}
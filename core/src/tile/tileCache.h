@@ -1,11 +1,10 @@
 #pragma once
 
-#include "log.h"
-#include "tile/tile.h"
 #include "tile/tileHash.h"
 #include "tile/tileID.h"
+#include "tile/tileStats.h"
 
-#include <list>
+#include <map>
 #include <memory>
 #include <unordered_map>
 
@@ -28,92 +27,76 @@ namespace std {
 
 namespace Tangram {
 
+class Tile;
+
+/* Byte-budgeted cache for tiles that left the view
+ *
+ * Eviction follows the GreedyDual-Size policy: each tile gets a priority of
+ * the current cache 'age' plus the cost of rebuilding it per byte it takes.
+ * The tile with the lowest priority is evicted first and its priority becomes
+ * the new age, so that tiles which were not used for a while eventually lose
+ * against newly cached ones. With equal costs this degrades to LRU.
+ *
+ * The rebuild cost is the measured build time of a tile. Tiles one or two
+ * zoom levels below the current zoom are weighted up since they are used
+ * as proxies for the visible tiles.
+ */
 class TileCache {
+
+    using EvictionKey = std::pair<double, uint64_t>;
+    using EvictionQueue = std::map<EvictionKey, TileCacheKey>;
+
     struct CacheEntry {
-        TileCacheKey key;
         std::shared_ptr<Tile> tile;
+        uint64_t gpuBytes;
+        uint64_t cpuBytes;
+        EvictionQueue::iterator queued;
     };
 
-    using CacheList = std::list<CacheEntry>;
-    using CacheMap = std::unordered_map<TileCacheKey, typename CacheList::iterator>;
-
 public:
 
-    TileCache(size_t _cacheSizeMB) :
-        m_cacheUsage(0),
-        m_cacheMaxUsage(_cacheSizeMB) {}
+    explicit TileCache(size_t _cacheSizeBytes);
 
-    void put(int32_t _sourceId, std::shared_ptr<Tile> _tile) {
-        TileCacheKey k(_sourceId, _tile->getID());
+    ~TileCache();
 
-        m_cacheList.push_front({k, _tile});
-        m_cacheMap[k] = m_cacheList.begin();
-        m_cacheUsage += _tile->getMemoryUsage();
+    void put(int32_t _sourceId, std::shared_ptr<Tile> _tile);
 
-        limitCacheSize(m_cacheMaxUsage);
-    }
+    /* Returns the cached tile and removes it from the cache */
+    std::shared_ptr<Tile> get(int32_t _sourceId, TileID _tileId);
 
-    std::shared_ptr<Tile> get(int32_t _sourceId, TileID _tileId) {
-        std::shared_ptr<Tile> tile;
-        TileCacheKey k(_sourceId, _tileId);
-
-        auto it = m_cacheMap.find(k);
-        if (it != m_cacheMap.end()) {
-            std::swap(tile, (*(it->second)).tile);
-            m_cacheList.erase(it->second);
-            m_cacheMap.erase(it);
-            m_cacheUsage -= tile->getMemoryUsage();
-        }
-        return tile;
-    }
+    /* Returns the cached tile without removing it, not counted in the stats */
+    std::shared_ptr<Tile> contains(int32_t _source, TileID _tileID);
 
-    std::shared_ptr<Tile> contains(int32_t _source, TileID _tileID) {
-        std::shared_ptr<Tile> tile;
-        TileCacheKey k(_source, _tileID);
+    void limitCacheSize(size_t _cacheSizeBytes);
 
-        auto it = m_cacheMap.find(k);
-        if (it != m_cacheMap.end()) {
-            return it->second->tile;
-        }
-        return nullptr;
-    }
-
-    void limitCacheSize(size_t _cacheSizeBytes) {
-        m_cacheMaxUsage = _cacheSizeBytes;
-
-        while (m_cacheUsage > m_cacheMaxUsage) {
-            if (m_cacheList.empty()) {
-                LOGE("Invalid cache state!");
-                m_cacheUsage = 0;
-                break;
-            }
-            auto& tile = m_cacheList.back().tile;
-            m_cacheUsage -= tile->getMemoryUsage();
-            m_cacheMap.erase(m_cacheList.back().key);
-            m_cacheList.pop_back();
-        }
-    }
+    /* Set the current view zoom to weight the cost of proxy tiles */
+    void setZoom(int _zoom) { m_zoom = _zoom; }
 
-    size_t getMemoryUsage() const {
-        size_t sum = 0;
-        for (auto& entry : m_cacheList) {
-            sum += entry.tile->getMemoryUsage();
-        }
-        return sum;
-    }
+    uint64_t getMemoryUsage() const { return m_stats.gpuBytes + m_stats.cpuBytes; }
 
-    void clear() {
-        m_cacheMap.clear();
-        m_cacheList.clear();
-        m_cacheUsage = 0;
-    }
+    const TileCacheStats& stats() const { return m_stats; }
+
+    void clear();
 
 private:
-    CacheMap m_cacheMap;
-    CacheList m_cacheList;
 
-    int m_cacheUsage;
-    int m_cacheMaxUsage;
+    double evictionPriority(const Tile& _tile, uint64_t _bytes) const;
+
+    std::shared_ptr<Tile> remove(std::unordered_map<TileCacheKey, CacheEntry>::iterator _it);
+
+    std::unordered_map<TileCacheKey, CacheEntry> m_entries;
+
+    EvictionQueue m_evictionQueue;
+
+    // Priority of the last evicted tile
+    double m_age = 0;
+
+    // Tie breaker for equal priorities, older entries go first
+    uint64_t m_serial = 0;
+
+    int m_zoom = 0;
+
+    TileCacheStats m_stats;
 };
 
 }
@@ -1,6 +1,7 @@
 #include "tile/tileManager.h"
 
 #include "data/tileSource.h"
+#include "log.h"
 #include "map.h"
 #include "platform.h"
 #include "tile/tile.h"
@@ -14,6 +15,7 @@
 
 #define DBG(...) // LOGD(__VA_ARGS__)
 
+
 namespace Tangram {
 
 
@@ -30,7 +32,7 @@ enum class TileManager::ProxyID : uint8_t {
 struct TileManager::TileEntry {
 
     TileEntry(std::shared_ptr<Tile>& _tile)
-        : tile(_tile), m_proxyCounter(0), m_proxies(0), m_visible(false) {}
+        : tile(_tile), m_proxyCounter(0), m_proxies(0), m_visible(false), m_outdated(false) {}
 
     ~TileEntry() { clearTask(); }
 
@@ -44,6 +46,9 @@ struct TileManager::TileEntry {
     uint8_t m_proxies;
     bool m_visible;
 
+    /* Whether the tile was built for a previous scene and must be rebuilt */
+    bool m_outdated;
+
     bool isInProgress() {
         return bool(task) && !task->isCanceled();
     }
@@ -64,20 +69,37 @@ struct TileManager::TileEntry {
         return false;
     }
 
+    // Whether task has a tile ready and all rasters set
+    bool isTileTaskReady() {
+        if (bool(task) && task->isReady()) {
+
+            for (auto& rTask : task->subTasks()) {
+                if (!rTask->isReady()) { return false; }
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Whether a ready task waits for its meshes or rasters to be uploaded
+    bool isUploadPending() {
+        return isTileTaskReady() && task->needsUpload();
+    }
+
     // Complete task only when
     // - task still exists
     // - task has a tile ready
     // - tile has all rasters set
+    // - tile meshes and rasters are uploaded
     bool completeTileTask() {
-        if (bool(task) && task->isReady()) {
+        if (isTileTaskReady()) {
 
-            for (auto& rTask : task->subTasks()) {
-                if (!rTask->isReady()) { return false; }
-            }
+            if (task->needsUpload()) { return false; }
 
             task->complete();
             tile = task->getTile();
             task.reset();
+            m_outdated = false;
 
             return true;
         }
@@ -136,7 +158,9 @@ TileManager::TileSet::TileSet(std::shared_ptr<TileSource> _source, bool _clientS
 TileManager::TileSet::~TileSet() {}
 
 TileManager::TileManager(std::shared_ptr<Platform> platform, TileTaskQueue& _tileWorker) :
-    m_workers(_tileWorker) {
+    m_workers(_tileWorker),
+    m_prefetchMaxTiles(DEFAULT_PREFETCH_TILES),
+    m_prefetchMaxBytes(DEFAULT_PREFETCH_BYTES) {
 
     m_tileCache = std::unique_ptr<TileCache>(new TileCache(DEFAULT_CACHE_SIZE));
 
@@ -159,7 +183,8 @@ TileManager::~TileManager() {
     m_tileSets.clear();
 }
 
-void TileManager::setTileSources(const std::vector<std::shared_ptr<TileSource>>& _sources) {
+void TileManager::setTileSources(const std::vector<std::shared_ptr<TileSource>>& _sources,
+                                 bool _keepTiles) {
 
     m_tileCache->clear();
 
@@ -169,11 +194,16 @@ void TileManager::setTileSources(const std::vector<std::shared_ptr<TileSource>>&
         m_tileSets.begin(), m_tileSets.end(),
         [&](auto& tileSet) {
             if (!tileSet.clientTileSource) {
+                if (_keepTiles && std::find(_sources.begin(), _sources.end(),
+                                            tileSet.source) != _sources.end()) {
+                    return false;
+                }
                 LOGN("Remove source %s", tileSet.source->name().c_str());
+                clearPrefetchTasks(tileSet);
                 return true;
             }
             // Clear cache
-            tileSet.tiles.clear();
+            if (!_keepTiles) { tileSet.tiles.clear(); }
             return false;
         });
 
@@ -185,13 +215,14 @@ void TileManager::setTileSources(const std::vector<std::shared_ptr<TileSource>>&
         // ignore sources not used to generate tile geometry
         if (!source->generateGeometry()) { continue; }
 
-        if (std::find_if(m_tileSets.begin(), m_tileSets.end(),
-                         [&](const TileSet& a) {
-                             return a.source->name() == source->name();
-                         }) == m_tileSets.end()) {
+        auto it = std::find_if(m_tileSets.begin(), m_tileSets.end(),
+                               [&](const TileSet& a) {
+                                   return a.source->name() == source->name();
+                               });
+        if (it == m_tileSets.end()) {
             LOGN("add source %s", source->name().c_str());
             m_tileSets.push_back({ source, false });
-        } else {
+        } else if (it->source != source) {
             LOGW("Duplicate named datasource (not added): %s", source->name().c_str());
         }
     }
@@ -215,6 +246,7 @@ bool TileManager::removeClientTileSource(TileSource& _tileSource) {
     for (auto it = m_tileSets.begin(); it != m_tileSets.end();) {
         if (it->source.get() == &_tileSource) {
             // Remove the tile set associated with this tile source
+            clearPrefetchTasks(*it);
             it = m_tileSets.erase(it);
             removed = true;
         } else {
@@ -224,9 +256,37 @@ bool TileManager::removeClientTileSource(TileSource& _tileSource) {
     return removed;
 }
 
+void TileManager::rebuildTiles(const std::set<std::string>& _sources,
+                               const std::vector<uint32_t>& _styleIds) {
+
+    for (auto& tileSet : m_tileSets) {
+        if (_sources.find(tileSet.source->name()) == _sources.end()) { continue; }
+
+        clearPrefetchTasks(tileSet);
+
+        for (auto& it : tileSet.tiles) {
+            auto& entry = it.second;
+
+            // Tasks were started with the TileBuilder of the previous scene
+            if (entry.isInProgress()) {
+                tileSet.source->cancelLoadingTile(*entry.task);
+            }
+            entry.clearTask();
+
+            if (entry.tile) {
+                entry.tile->removeMeshes(_styleIds);
+                entry.m_outdated = true;
+            }
+        }
+    }
+
+    m_tileSetChanged = true;
+}
+
 void TileManager::clearTileSets(bool clearSourceCaches) {
     for (auto& tileSet : m_tileSets) {
         tileSet.tiles.clear();
+        clearPrefetchTasks(tileSet);
 
         if (clearSourceCaches) {
             tileSet.source->clearData();
@@ -240,6 +300,7 @@ void TileManager::clearTileSet(int32_t _sourceId) {
     for (auto& tileSet : m_tileSets) {
         if (tileSet.source->id() != _sourceId) { continue; }
         tileSet.tiles.clear();
+        clearPrefetchTasks(tileSet);
     }
 
     m_tileCache->clear();
@@ -249,6 +310,7 @@ void TileManager::clearTileSet(int32_t _sourceId) {
 void TileManager::updateTileSets(const View& _view) {
 
     m_tiles.clear();
+    m_pendingUploads.clear();
     m_tilesInProgress = 0;
     m_tileSetChanged = false;
 
@@ -271,6 +333,9 @@ void TileManager::updateTileSets(const View& _view) {
         _view.getVisibleTiles(tileCb);
     }
 
+    // Tiles below the view zoom are kept longer as proxies
+    m_tileCache->setZoom(_view.getIntegerZoom());
+
     for (auto& tileSet : m_tileSets) {
         // check if tile set is active for zoom (zoom might be below min_zoom)
         if (tileSet.source->isActiveForZoom(_view.getZoom())) {
@@ -278,8 +343,47 @@ void TileManager::updateTileSets(const View& _view) {
         }
     }
 
+    // Start prefetching only in frames without new visible tiles to load, so
+    // that their requests are never queued behind prefetch requests
+    bool startPrefetch = m_loadTasks.empty();
+
     loadTiles();
 
+    // Prefetched tiles which are not predicted anymore will likely not be used
+    for (auto it = m_prefetchedTiles.begin(); it != m_prefetchedTiles.end();) {
+        auto tileId = it->first.second;
+        bool predicted = std::any_of(m_tileSets.begin(), m_tileSets.end(), [&](auto& tileSet) {
+                if (tileSet.source->id() != it->first.first) { return false; }
+                auto id = [&](auto& _id) {
+                    return _id.zoomBiasAdjusted(tileSet.source->zoomBias())
+                        .withMaxSourceZoom(tileSet.source->maxZoom());
+                };
+                return std::any_of(m_prefetchTiles.begin(), m_prefetchTiles.end(),
+                                   [&](auto& _id) { return id(_id) == tileId; });
+            });
+
+        if (!predicted || !m_tileCache->contains(it->first.first, tileId)) {
+            m_prefetchStats.wasted++;
+            it = m_prefetchedTiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_prefetchStats.pending = 0;
+    for (auto& tileSet : m_tileSets) {
+        if (tileSet.source->isActiveForZoom(_view.getZoom())) {
+            updatePrefetchTasks(tileSet, _view.state(), startPrefetch);
+        } else {
+            clearPrefetchTasks(tileSet);
+        }
+    }
+
+    if (m_tasksReprioritized) {
+        m_workers.updatePriorities();
+        m_tasksReprioritized = false;
+    }
+
     // Make m_tiles an unique list of tiles for rendering sorted from
     // high to low zoom-levels.
     std::sort(m_tiles.begin(), m_tiles.end(), [](auto& a, auto& b) {
@@ -326,8 +430,6 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
     auto curTilesIt = tiles.begin();
     auto visTilesIt = visibleTiles.begin();
 
-    auto generation = _tileSet.source->generation();
-
     while (visTilesIt != visibleTiles.end() || curTilesIt != tiles.end()) {
 
         auto& visTileId = visTilesIt == visibleTiles.end()
@@ -355,17 +457,18 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             }
 
             // NB: Special handling to update tiles from ClientDataSource.
-            // Can be removed once ClientDataSource is immutable
+            // Only tiles whose data changed since they were built are reloaded.
             if (entry.tile) {
                 auto sourceGeneration = entry.tile->sourceGeneration();
-                if ((sourceGeneration < generation) && !entry.isInProgress()) {
+                if ((entry.m_outdated || sourceGeneration < _tileSet.source->generation(visTileId)) &&
+                    !entry.isInProgress()) {
                     // Tile needs update - enqueue for loading
                     entry.task = _tileSet.source->createTask(visTileId);
                     enqueueTask(_tileSet, visTileId, _view);
                 }
             } else if (entry.isCanceled()) {
                 auto sourceGeneration = entry.task->sourceGeneration();
-                if (sourceGeneration < generation) {
+                if (sourceGeneration < _tileSet.source->generation(visTileId)) {
                     // Tile needs update - enqueue for loading
                     entry.task = _tileSet.source->createTask(visTileId);
                     enqueueTask(_tileSet, visTileId, _view);
@@ -391,7 +494,13 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             //     NOT_A_TILE. (for the current implementation of > operator)
             assert(visTilesIt != visibleTiles.end());
 
-            if (!addTile(_tileSet, visTileId)) {
+            auto prefetch = _tileSet.prefetchTasks.find(visTileId);
+            if (prefetch != _tileSet.prefetchTasks.end() && !prefetch->second->isCanceled()) {
+                // Loading ahead of time - take over the prefetch task
+                addPrefetchedTile(_tileSet, visTileId);
+                m_tilesInProgress++;
+
+            } else if (!addTile(_tileSet, visTileId)) {
                 // Not in cache - enqueue for loading
                 enqueueTask(_tileSet, visTileId, _view);
                 m_tilesInProgress++;
@@ -467,8 +576,18 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             auto tileCenter = MapProjection::tileCenter(id);
             double scaleDiv = exp2(id.z - _view.zoom);
             if (scaleDiv < 1) { scaleDiv = 0.1/scaleDiv; } // prefer parent tiles
-            task->setPriority(glm::length2(tileCenter - _view.center) * scaleDiv);
-            task->setProxyState(entry.getProxyCounter() > 0);
+            float priority = glm::length2(tileCenter - _view.center) * scaleDiv;
+            bool proxy = entry.getProxyCounter() > 0;
+
+            if (task->getPriority() != priority || task->isProxy() != proxy) {
+                task->setPriority(priority);
+                task->setProxyState(proxy);
+                m_tasksReprioritized = true;
+            }
+
+            if (entry.isUploadPending()) {
+                m_pendingUploads.push_back(task);
+            }
         }
 
         if (entry.tile) {
@@ -493,6 +612,159 @@ void TileManager::enqueueTask(TileSet& _tileSet, const TileID& _tileID,
     m_loadTasks.insert(it, std::make_tuple(distance, &_tileSet, _tileID));
 }
 
+void TileManager::setPrefetchTiles(const std::vector<TileID>& _tiles) {
+    m_prefetchTiles = _tiles;
+}
+
+void TileManager::setPrefetchBudget(uint32_t _maxTiles, uint64_t _maxBytes) {
+    m_prefetchMaxTiles = _maxTiles;
+    m_prefetchMaxBytes = _maxBytes;
+
+    if (m_prefetchMaxTiles == 0) {
+        m_prefetchTiles.clear();
+        for (auto& tileSet : m_tileSets) { clearPrefetchTasks(tileSet); }
+    }
+}
+
+static void cancelTask(TileSource& _source, TileTask& _task) {
+    _source.cancelLoadingTile(_task);
+
+    for (auto& raster : _task.subTasks()) {
+        raster->cancel();
+    }
+    _task.subTasks().clear();
+    _task.cancel();
+}
+
+// Whether @_task has a tile ready and all rasters set
+static bool isTaskReady(TileTask& _task) {
+    if (!_task.isReady()) { return false; }
+
+    for (auto& raster : _task.subTasks()) {
+        if (!raster->isReady()) { return false; }
+    }
+    return true;
+}
+
+void TileManager::updatePrefetchTasks(TileSet& _tileSet, const ViewState& _view, bool _startTasks) {
+
+    auto& tasks = _tileSet.prefetchTasks;
+
+    auto sourceTileId = [&](const TileID& _tileID) {
+        return _tileID.zoomBiasAdjusted(_tileSet.source->zoomBias())
+            .withMaxSourceZoom(_tileSet.source->maxZoom());
+    };
+
+    auto isPredicted = [&](const TileID& _tileID) {
+        return std::any_of(m_prefetchTiles.begin(), m_prefetchTiles.end(),
+                           [&](auto& id) { return sourceTileId(id) == _tileID; });
+    };
+
+    for (auto it = tasks.begin(); it != tasks.end();) {
+        auto& task = it->second;
+
+        if (task->isCanceled()) {
+            m_prefetchStats.wasted++;
+            it = tasks.erase(it);
+            continue;
+        }
+
+        if (isTaskReady(*task)) {
+            if (task->needsUpload()) {
+                // Uploaded after the tiles in view, see UploadScheduler
+                m_pendingUploads.push_back(task);
+                m_prefetchStats.pending++;
+                ++it;
+                continue;
+            }
+            task->complete();
+
+            // Keep the tile in the cache until it becomes visible
+            std::shared_ptr<Tile> tile = task->getTile();
+            if (tile) {
+                m_prefetchedTiles[{ _tileSet.source->id(), it->first }] = tile->getMemoryUsage();
+                m_tileCache->put(_tileSet.source->id(), tile);
+            }
+            it = tasks.erase(it);
+            continue;
+        }
+
+        if (!isPredicted(it->first)) {
+            cancelTask(*_tileSet.source, *task);
+            m_prefetchStats.wasted++;
+            it = tasks.erase(it);
+            continue;
+        }
+
+        m_prefetchStats.pending++;
+        ++it;
+    }
+
+    m_prefetchStats.bytes = 0;
+    for (auto& tile : m_prefetchedTiles) {
+        m_prefetchStats.bytes += tile.second;
+    }
+
+    if (!_startTasks) { return; }
+
+    for (auto& predicted : m_prefetchTiles) {
+
+        if (m_prefetchStats.pending >= m_prefetchMaxTiles ||
+            m_prefetchStats.bytes >= m_prefetchMaxBytes) {
+            break;
+        }
+
+        auto tileId = sourceTileId(predicted);
+
+        if (_tileSet.tiles.count(tileId) || tasks.count(tileId) ||
+            m_tileCache->contains(_tileSet.source->id(), tileId)) {
+            continue;
+        }
+
+        auto task = _tileSet.source->createTask(tileId);
+
+        // Rank behind all tiles in view and their proxies
+        auto tileCenter = MapProjection::tileCenter(tileId);
+        task->setPrefetchState(true);
+        task->setPriority(glm::length2(tileCenter - _view.center));
+
+        tasks.emplace(tileId, task);
+        _tileSet.source->loadTileData(task, m_dataCallback);
+
+        m_prefetchStats.requested++;
+        m_prefetchStats.pending++;
+    }
+}
+
+void TileManager::addPrefetchedTile(TileSet& _tileSet, const TileID& _tileID) {
+
+    auto it = _tileSet.prefetchTasks.find(_tileID);
+    auto task = it->second;
+    _tileSet.prefetchTasks.erase(it);
+
+    m_prefetchStats.hits++;
+
+    // Rank with the other tiles in view from now on
+    task->setPrefetchState(false);
+    m_tasksReprioritized = true;
+
+    std::shared_ptr<Tile> tile;
+    auto& entry = _tileSet.tiles.emplace(_tileID, tile).first->second;
+
+    // Show proxies until the task is done
+    updateProxyTiles(_tileSet, _tileID, entry);
+
+    entry.task = task;
+    entry.setVisible(true);
+}
+
+void TileManager::clearPrefetchTasks(TileSet& _tileSet) {
+    for (auto& it : _tileSet.prefetchTasks) {
+        cancelTask(*_tileSet.source, *it.second);
+    }
+    _tileSet.prefetchTasks.clear();
+}
+
 void TileManager::loadTiles() {
 
     if (m_loadTasks.empty()) { return; }
@@ -519,7 +791,11 @@ bool TileManager::addTile(TileSet& _tileSet, const TileID& _tileID) {
     auto tile = m_tileCache->get(_tileSet.source->id(), _tileID);
 
     if (tile) {
-        if (tile->sourceGeneration() == _tileSet.source->generation()) {
+        if (m_prefetchedTiles.erase({ _tileSet.source->id(), _tileID })) {
+            m_prefetchStats.hits++;
+        }
+
+        if (tile->sourceGeneration() >= _tileSet.source->generation(_tileID)) {
             m_tiles.push_back(tile);
 
             // Reset tile on potential internal dynamic data set
@@ -555,7 +831,7 @@ void TileManager::removeTile(TileSet& _tileSet, std::map<TileID, TileEntry>::ite
 
         entry.clearTask();
 
-    } else if (entry.tile) {
+    } else if (entry.tile && !entry.m_outdated) {
         // Add to cache
         m_tileCache->put(_tileSet.source->id(), entry.tile);
     }
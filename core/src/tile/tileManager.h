@@ -4,6 +4,7 @@
 #include "data/tileSource.h"
 #include "tile/tile.h"
 #include "tile/tileID.h"
+#include "tile/tileStats.h"
 #include "tile/tileTask.h"
 #include "tile/tileWorker.h"
 
@@ -32,14 +33,27 @@ class TileManager {
 
     const static size_t DEFAULT_CACHE_SIZE = 32*1024*1024; // 32 MB
 
+    const static uint32_t DEFAULT_PREFETCH_TILES = 8;
+    const static uint64_t DEFAULT_PREFETCH_BYTES = 8*1024*1024; // 8 MB
+
 public:
 
     TileManager(std::shared_ptr<Platform> platform, TileTaskQueue& _tileWorker);
 
     virtual ~TileManager();
 
-    /* Sets the tile TileSources */
-    void setTileSources(const std::vector<std::shared_ptr<TileSource>>& _sources);
+    /* Sets the tile TileSources
+     * With @_keepTiles the tiles of client sources and of sources which were
+     * already set are kept, otherwise all tiles are removed
+     */
+    void setTileSources(const std::vector<std::shared_ptr<TileSource>>& _sources,
+                        bool _keepTiles = false);
+
+    /* Rebuild the tiles of the sources named in @_sources with the current scene.
+     * Tiles stay visible until they are replaced, without the meshes of the styles
+     * in @_styleIds which were built for styles that were replaced.
+     */
+    void rebuildTiles(const std::set<std::string>& _sources, const std::vector<uint32_t>& _styleIds);
 
     /* Updates visible tile set and load missing tiles */
     void updateTileSets(const View& _view);
@@ -51,6 +65,10 @@ public:
     /* Returns the set of currently visible tiles */
     const auto& getVisibleTiles() const { return m_tiles; }
 
+    /* Returns the tasks of built tiles that wait for their meshes to be
+     * uploaded before they replace their proxies */
+    auto& getPendingUploads() { return m_pendingUploads; }
+
     bool hasTileSetChanged() { return m_tileSetChanged; }
 
     bool hasLoadingTiles() {
@@ -65,6 +83,17 @@ public:
 
     std::unique_ptr<TileCache>& getTileCache() { return m_tileCache; }
 
+    /* Set the tiles which are expected to become visible soon, in the order
+     * in which they are expected, see <TilePrefetcher>. They are loaded with
+     * the lowest priority on the next updateTileSets() within the budget. */
+    void setPrefetchTiles(const std::vector<TileID>& _tiles);
+
+    /* At most @_maxTiles prefetch tasks run at a time and none are started
+     * while ready, unused prefetched tiles take @_maxBytes */
+    void setPrefetchBudget(uint32_t _maxTiles, uint64_t _maxBytes);
+
+    const TilePrefetchStats& prefetchStats() const { return m_prefetchStats; }
+
     /* @_cacheSize: Set size of in-memory tile cache in bytes.
      * This cache holds recently used <Tile>s that are ready for rendering.
      */
@@ -84,6 +113,9 @@ protected:
         std::set<TileID> visibleTiles;
         std::map<TileID, TileEntry> tiles;
 
+        /* Tasks of tiles which are not visible yet, see setPrefetchTiles() */
+        std::map<TileID, std::shared_ptr<TileTask>> prefetchTasks;
+
         int64_t sourceGeneration = 0;
         bool clientTileSource;
     };
@@ -92,6 +124,15 @@ protected:
 
     void enqueueTask(TileSet& _tileSet, const TileID& _tileID, const ViewState& _view);
 
+    /* Complete or drop the prefetch tasks of @_tileSet and, with @_startTasks,
+     * start new ones within the prefetch budget */
+    void updatePrefetchTasks(TileSet& _tileSet, const ViewState& _view, bool _startTasks);
+
+    /* Take over the prefetch task for @_tileID as the task of its new visible tile */
+    void addPrefetchedTile(TileSet& _tileSet, const TileID& _tileID);
+
+    void clearPrefetchTasks(TileSet& _tileSet);
+
     void loadTiles();
 
     /*
@@ -126,17 +167,35 @@ protected:
     /* Current tiles ready for rendering */
     std::vector<std::shared_ptr<Tile>> m_tiles;
 
+    /* Tasks with built tiles waiting for upload */
+    std::vector<std::shared_ptr<TileTask>> m_pendingUploads;
+
     std::unique_ptr<TileCache> m_tileCache;
 
     TileTaskQueue& m_workers;
 
     bool m_tileSetChanged = false;
 
+    /* Whether priority or proxy state of a pending TileTask changed */
+    bool m_tasksReprioritized = false;
+
     /* Callback for TileSource:
      * Passes TileTask back with data for further processing by <TileWorker>s
      */
     TileTaskCb m_dataCallback;
 
+    /* Predicted tiles, without source zoom bias */
+    std::vector<TileID> m_prefetchTiles;
+
+    uint32_t m_prefetchMaxTiles;
+    uint64_t m_prefetchMaxBytes;
+
+    /* Ready prefetched tiles in the cache and their size, until they become
+     * visible or are no longer predicted */
+    std::map<std::pair<int32_t, TileID>, uint64_t> m_prefetchedTiles;
+
+    TilePrefetchStats m_prefetchStats;
+
     /* Temporary list of tiles that need to be loaded */
     std::vector<std::tuple<double, TileSet*, TileID>> m_loadTasks;
 
@@ -0,0 +1,379 @@
+#include "tile/tileMeshCache.h"
+
+#include "data/diskCache.h"
+#include "data/properties.h"
+#include "data/propertyItem.h"
+#include "data/tileSource.h"
+#include "gl/mesh.h"
+#include "gl/texture.h"
+#include "log.h"
+#include "scene/scene.h"
+#include "selection/featureSelection.h"
+#include "style/colorPalette.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "util/zlibHelper.h"
+
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+static const uint32_t TILE_MAGIC = 0x4d544754; // 'TGTM'
+static const uint32_t VERSION = 2;
+
+// Followed by the source name, the meshes and the selection features
+struct TileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sceneHash;
+    // CRC-32 of the raw data the tile was built from
+    uint32_t dataHash;
+    int64_t generation;
+    int32_t sourceZoom;
+    uint32_t meshCount;
+    uint32_t featureCount;
+    // Whether the tile had meshes which can only be built from tile data
+    uint32_t partial;
+};
+
+enum class ValueType : uint8_t { none, number, string };
+
+// Meshes restored from the cache only hold compiled buffers
+struct CompiledVertex {};
+
+template<typename T>
+static void write(std::vector<char>& _out, const T& _value) {
+    const char* data = reinterpret_cast<const char*>(&_value);
+    _out.insert(_out.end(), data, data + sizeof(T));
+}
+
+static void write(std::vector<char>& _out, const std::string& _value) {
+    write(_out, uint32_t(_value.size()));
+    _out.insert(_out.end(), _value.begin(), _value.end());
+}
+
+struct Reader {
+    const char* pos;
+    const char* end;
+
+    // Returns the next @_size bytes, or null when the record is too short
+    const char* take(size_t _size) {
+        if (size_t(end - pos) < _size) { return nullptr; }
+        const char* data = pos;
+        pos += _size;
+        return data;
+    }
+
+    template<typename T>
+    bool read(T& _value) {
+        const char* data = take(sizeof(T));
+        if (!data) { return false; }
+        std::memcpy(&_value, data, sizeof(T));
+        return true;
+    }
+
+    bool read(std::string& _value) {
+        uint32_t size = 0;
+        if (!read(size)) { return false; }
+        const char* data = take(size);
+        if (!data) { return false; }
+        _value.assign(data, size);
+        return true;
+    }
+};
+
+static bool writeMesh(std::vector<char>& _out, const std::string& _style, const StyledMesh& _mesh) {
+
+    write(_out, _style);
+
+    uint32_t paletteWidth = 0, paletteHeight = 0;
+    const GLubyte* texels = nullptr;
+
+    if (auto* palette = _mesh.palette()) {
+        texels = palette->bufferData();
+        if (!texels) { return false; }
+        paletteWidth = palette->width();
+        paletteHeight = palette->height();
+    }
+    write(_out, paletteWidth);
+    write(_out, paletteHeight);
+    if (texels) {
+        _out.insert(_out.end(), texels, texels + paletteWidth * paletteHeight * sizeof(GLuint));
+    }
+
+    // Size of the mesh data is filled in after writing it
+    size_t sizePos = _out.size();
+    write(_out, uint64_t(0));
+
+    if (!_mesh.serialize(_out)) { return false; }
+
+    uint64_t meshSize = _out.size() - sizePos - sizeof(uint64_t);
+    std::memcpy(_out.data() + sizePos, &meshSize, sizeof(meshSize));
+    return true;
+}
+
+static std::unique_ptr<StyledMesh> readMesh(Reader& _in, const Style& _style,
+                                            const std::unordered_map<uint32_t, uint32_t>& _selectionColors) {
+
+    uint32_t paletteWidth = 0, paletteHeight = 0;
+    if (!_in.read(paletteWidth) || !_in.read(paletteHeight)) { return nullptr; }
+
+    std::unique_ptr<Mesh<CompiledVertex>> mesh;
+
+    if (paletteWidth > 0) {
+        size_t count = size_t(paletteWidth) * paletteHeight;
+        const char* data = _in.take(count * sizeof(GLuint));
+        if (!data) { return nullptr; }
+
+        // Entries are pairs of color and selection color
+        std::vector<GLuint> texels(count);
+        std::memcpy(texels.data(), data, count * sizeof(GLuint));
+        if (!_selectionColors.empty()) {
+            for (size_t i = 1; i < count; i += 2) {
+                auto it = _selectionColors.find(texels[i]);
+                if (it != _selectionColors.end()) { texels[i] = it->second; }
+            }
+        }
+
+        TextureOptions options;
+        options.minFilter = TextureMinFilter::NEAREST;
+        options.magFilter = TextureMagFilter::NEAREST;
+
+        auto palette = std::make_shared<Texture>(options);
+        palette->setPixelData(paletteWidth, paletteHeight, sizeof(GLuint),
+                              reinterpret_cast<const GLubyte*>(texels.data()),
+                              texels.size() * sizeof(GLuint));
+
+        mesh = std::make_unique<PaletteMesh<CompiledVertex>>(_style.vertexLayout(), _style.drawMode(),
+                                                             std::move(palette));
+    } else {
+        mesh = std::make_unique<Mesh<CompiledVertex>>(_style.vertexLayout(), _style.drawMode());
+    }
+
+    uint64_t meshSize = 0;
+    if (!_in.read(meshSize)) { return nullptr; }
+    const char* data = _in.take(meshSize);
+    if (!data) { return nullptr; }
+
+    mesh->setArenaPool(_style.meshArenas());
+
+    if (!mesh->restore(data, meshSize, _selectionColors)) { return nullptr; }
+
+    return std::move(mesh);
+}
+
+static void writeFeature(std::vector<char>& _out, uint32_t _id, const Properties& _props) {
+
+    write(_out, _id);
+    write(_out, uint32_t(_props.items().size()));
+
+    for (const auto& item : _props.items()) {
+        write(_out, item.key);
+
+        if (item.value.is<double>()) {
+            write(_out, ValueType::number);
+            write(_out, item.value.get<double>());
+        } else if (item.value.is<std::string>()) {
+            write(_out, ValueType::string);
+            write(_out, item.value.get<std::string>());
+        } else {
+            write(_out, ValueType::none);
+        }
+    }
+}
+
+static std::shared_ptr<Properties> readFeature(Reader& _in, int32_t _sourceId) {
+
+    uint32_t count = 0;
+    if (!_in.read(count)) { return nullptr; }
+
+    std::vector<Properties::Item> items;
+    items.reserve(std::min<size_t>(count, _in.end - _in.pos));
+
+    for (uint32_t i = 0; i < count; i++) {
+        std::string key;
+        ValueType type;
+        if (!_in.read(key) || !_in.read(type)) { return nullptr; }
+
+        switch (type) {
+        case ValueType::number: {
+            double number;
+            if (!_in.read(number)) { return nullptr; }
+            items.emplace_back(std::move(key), Value(number));
+            break;
+        }
+        case ValueType::string: {
+            std::string string;
+            if (!_in.read(string)) { return nullptr; }
+            items.emplace_back(std::move(key), Value(std::move(string)));
+            break;
+        }
+        case ValueType::none:
+            items.emplace_back(std::move(key), Value(none_type{}));
+            break;
+        default:
+            return nullptr;
+        }
+    }
+
+    // Items were written in sorted order
+    auto props = std::make_shared<Properties>();
+    props->setSorted(std::move(items));
+    props->sourceId = _sourceId;
+    return props;
+}
+
+// Keep the records of sources that share a segment file and of overzoomed
+// tiles apart
+static DiskCache::Key recordKey(const TileID& _tileID, const TileSource& _source) {
+    const auto& name = _source.name();
+    uint32_t crc = zlib::crc32(0, name.data(), name.size());
+    crc = zlib::crc32(crc, reinterpret_cast<const char*>(&_tileID.s), sizeof(_tileID.s));
+    return DiskCache::Key(_tileID, crc);
+}
+
+TileMeshCache::TileMeshCache(const std::string& _path, size_t _maxSize) :
+    m_cache(DiskCache::open(_path, _maxSize)) {
+}
+
+TileMeshCache::~TileMeshCache() {}
+
+uint32_t TileMeshCache::sceneHash(const Scene& _scene) {
+    std::string config = YAML::Dump(_scene.config());
+    float pixelScale = _scene.pixelScale();
+
+    uint32_t crc = zlib::crc32(0, config.data(), config.size());
+    return zlib::crc32(crc, reinterpret_cast<const char*>(&pixelScale), sizeof(pixelScale));
+}
+
+bool TileMeshCache::store(const Tile& _tile, const TileSource& _source, const Scene& _scene,
+                          uint32_t _sceneHash, uint32_t _dataHash) {
+
+    if (!m_cache->isOpen()) { return false; }
+
+    auto data = std::make_shared<std::vector<char>>();
+    auto& out = *data;
+
+    const TileID& tileID = _tile.getID();
+    TileHeader header{ TILE_MAGIC, VERSION, _sceneHash, _dataHash, _source.generation(tileID),
+                       tileID.s, 0, uint32_t(_tile.getSelectionFeatures().size()), 0 };
+    write(out, header);
+    write(out, _source.name());
+
+    for (const auto& style : _scene.styles()) {
+        const auto& mesh = _tile.getMesh(*style);
+        if (!mesh) { continue; }
+
+        // Leave out meshes that must be built again on restore
+        size_t meshStart = out.size();
+        if (!writeMesh(out, style->getName(), *mesh)) {
+            out.resize(meshStart);
+            header.partial = 1;
+            continue;
+        }
+        header.meshCount++;
+    }
+
+    if (header.meshCount == 0) { return false; }
+
+    for (const auto& feature : _tile.getSelectionFeatures()) {
+        writeFeature(out, feature.first, *feature.second);
+    }
+
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    m_cache->put(recordKey(tileID, _source), std::move(data));
+    return true;
+}
+
+std::unique_ptr<Tile> TileMeshCache::restore(const TileID& _tileID, const TileSource& _source,
+                                             const Scene& _scene, uint32_t _sceneHash,
+                                             uint32_t _dataHash, bool& _complete) {
+
+    _complete = false;
+
+    if (!m_cache->isOpen()) { return nullptr; }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::unique_ptr<Tile> tile;
+
+    m_cache->read(recordKey(_tileID, _source), [&](const char* _data, size_t _size) {
+        Reader in{ _data, _data + _size };
+
+        TileHeader header;
+        std::string sourceName;
+        if (!in.read(header) || header.magic != TILE_MAGIC || header.version != VERSION ||
+            header.sceneHash != _sceneHash || header.dataHash != _dataHash ||
+            header.generation != _source.generation(_tileID) || header.sourceZoom != _tileID.s ||
+            !in.read(sourceName) || sourceName != _source.name()) {
+            return false;
+        }
+
+        // Skip to the selection features, their colors are replaced by new
+        // ones of this scene in the restored meshes
+        Reader meshes = in;
+        for (uint32_t i = 0; i < header.meshCount; i++) {
+            std::string style;
+            uint32_t paletteWidth = 0, paletteHeight = 0;
+            uint64_t meshSize = 0;
+            if (!in.read(style) || !in.read(paletteWidth) || !in.read(paletteHeight) ||
+                !in.take(size_t(paletteWidth) * paletteHeight * sizeof(GLuint)) ||
+                !in.read(meshSize) || !in.take(meshSize)) {
+                return false;
+            }
+        }
+
+        fastmap<uint32_t, std::shared_ptr<Properties>> selectionFeatures;
+        std::unordered_map<uint32_t, uint32_t> selectionColors;
+
+        for (uint32_t i = 0; i < header.featureCount; i++) {
+            uint32_t id = 0;
+            if (!in.read(id)) { return false; }
+            auto props = readFeature(in, _source.id());
+            if (!props) { return false; }
+
+            uint32_t color = _scene.featureSelection()->nextColorIdentifier();
+            selectionColors[id] = color;
+            selectionFeatures[color] = std::move(props);
+        }
+
+        auto result = std::make_unique<Tile>(_tileID, _source.id(), _source.generation());
+        result->initGeometry(_scene.styles().size());
+
+        for (uint32_t i = 0; i < header.meshCount; i++) {
+            std::string name;
+            meshes.read(name);
+
+            const Style* style = _scene.findStyle(name);
+            if (!style) { return false; }
+
+            auto mesh = readMesh(meshes, *style, selectionColors);
+            if (!mesh) { return false; }
+
+            result->setMesh(*style, std::move(mesh));
+        }
+
+        result->setSelectionFeatures(selectionFeatures);
+        tile = std::move(result);
+        _complete = (header.partial == 0);
+        return true;
+    });
+
+    if (!tile) { return nullptr; }
+
+    // Let the TileCache weigh the cost of restoring this tile again
+    std::chrono::duration<float, std::milli> restoreTime = std::chrono::steady_clock::now() - startTime;
+    tile->setBuildTime(restoreTime.count());
+
+    return tile;
+}
+
+void TileMeshCache::flush() {
+    m_cache->flush();
+}
+
+}
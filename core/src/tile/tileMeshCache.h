@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Tangram {
+
+class Scene;
+class Tile;
+class TileSource;
+struct DiskCache;
+struct TileID;
+
+/* Persistent cache of built tiles
+ *
+ * Stores the compiled meshes and the selection features of tiles built by the
+ * <TileBuilder> in a <DiskCache>, so that a tile which was dropped from the
+ * TileCache can be restored without styling its data and building its
+ * geometry again.
+ *
+ * The vertices and indices are copied from the mapped segment into the upload
+ * buffers of the meshes, they are not drawn from the mapping itself: buffers
+ * are uploaded to GL from client memory anyway, and the segment is replaced
+ * by compaction while restored tiles are still waiting for upload.
+ *
+ * Label meshes are not stored, their glyph quads refer to the glyph atlas of
+ * the running FontContext. The TileBuilder builds them from the tile data
+ * on top of the restored meshes.
+ *
+ * A record is only used for the source, source generation, raw tile data and
+ * scene it was built with.
+ */
+class TileMeshCache {
+
+public:
+
+    /* @_path: Segment file of the cache, see <DiskCache>
+     * @_maxSize: Size limit for the segment file in bytes */
+    TileMeshCache(const std::string& _path, size_t _maxSize);
+
+    ~TileMeshCache();
+
+    /* Returns the tile stored for @_tileID of @_source, or null when there is
+     * none for the current generation of the source, @_sceneHash and the raw
+     * tile data hash @_dataHash. @_complete is set to false when the meshes of
+     * some styles were not stored and must be built from the tile data. */
+    std::unique_ptr<Tile> restore(const TileID& _tileID, const TileSource& _source,
+                                  const Scene& _scene, uint32_t _sceneHash,
+                                  uint32_t _dataHash, bool& _complete);
+
+    /* Store the meshes of @_tile except those which can only be built from
+     * tile data, returns whether any mesh was stored */
+    bool store(const Tile& _tile, const TileSource& _source, const Scene& _scene,
+               uint32_t _sceneHash, uint32_t _dataHash);
+
+    /* Wait until all tiles stored so far are written to the segment */
+    void flush();
+
+    /* Hash of the scene configuration that tiles are built with */
+    static uint32_t sceneHash(const Scene& _scene);
+
+private:
+
+    std::shared_ptr<DiskCache> m_cache;
+};
+
+}
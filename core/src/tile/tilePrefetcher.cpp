@@ -0,0 +1,121 @@
+#include "tile/tilePrefetcher.h"
+
+#include "view/view.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tangram {
+
+// Default time to predict ahead and number of predicted views
+static const float DEFAULT_LOOKAHEAD = 1.f;
+static const int DEFAULT_SAMPLES = 3;
+
+// Weight of the latest frame in the velocity estimate
+static const double VELOCITY_SMOOTHING = 0.5;
+
+// Longer frames do not contribute to the velocity, e.g. after the map was idle
+static const float MAX_FRAME_TIME = 0.25f;
+
+// Minimal predicted camera movement to prefetch for, in pixels and zoom levels
+static const double MIN_PAN_PIXELS = 32.0;
+static const double MIN_ZOOM_CHANGE = 0.25;
+
+TilePrefetcher::TilePrefetcher()
+    : m_lastPosition(0.0),
+      m_velocity(0.0),
+      m_lookahead(DEFAULT_LOOKAHEAD),
+      m_samples(DEFAULT_SAMPLES) {}
+
+void TilePrefetcher::setEnabled(bool _enabled) {
+    m_enabled = _enabled;
+
+    if (!m_enabled) {
+        m_tiles.clear();
+        m_velocity = glm::dvec3(0.0);
+        m_hasLastPosition = false;
+    }
+}
+
+void TilePrefetcher::setLookahead(float _seconds, int _samples) {
+    m_lookahead = std::max(0.f, _seconds);
+    m_samples = std::max(1, _samples);
+}
+
+void TilePrefetcher::setPath(PathFn _path, float _duration) {
+    m_path = std::move(_path);
+    m_pathDuration = _duration;
+    m_pathTime = -1.f;
+}
+
+void TilePrefetcher::clearPath() {
+    m_path = nullptr;
+    m_pathDuration = 0.f;
+    m_pathTime = -1.f;
+}
+
+void TilePrefetcher::update(const View& _view, float _dt) {
+
+    m_tiles.clear();
+
+    if (!m_enabled) { return; }
+
+    glm::dvec3 position(_view.getPosition().x, _view.getPosition().y, _view.getZoom());
+
+    if (m_hasLastPosition && _dt > 0.f && _dt < MAX_FRAME_TIME) {
+        glm::dvec3 velocity = (position - m_lastPosition) / double(_dt);
+        m_velocity = glm::mix(m_velocity, velocity, VELOCITY_SMOOTHING);
+    } else {
+        m_velocity = glm::dvec3(0.0);
+    }
+    m_lastPosition = position;
+    m_hasLastPosition = true;
+
+    if (m_path) {
+        // Like Ease, the animation starts with the first update
+        m_pathTime = m_pathTime < 0.f ? 0.f : m_pathTime + _dt;
+        if (m_pathTime >= m_pathDuration) { clearPath(); }
+    }
+
+    if (!m_path) {
+        double pan = glm::length(glm::dvec2(m_velocity)) * m_lookahead * _view.pixelsPerMeter();
+        double zoom = std::abs(m_velocity.z) * m_lookahead;
+
+        if (pan < MIN_PAN_PIXELS && zoom < MIN_ZOOM_CHANGE) { return; }
+    }
+
+    m_visible.clear();
+    _view.getVisibleTiles([this](TileID _tileID) { m_visible.push_back(_tileID); });
+    std::sort(m_visible.begin(), m_visible.end());
+
+    for (int i = 1; i <= m_samples; i++) {
+        float ahead = m_lookahead * i / m_samples;
+
+        if (m_path) {
+            float t = std::min(1.f, (m_pathTime + ahead) / m_pathDuration);
+            addTiles(_view, m_path(t));
+        } else {
+            addTiles(_view, position + m_velocity * double(ahead));
+        }
+    }
+}
+
+void TilePrefetcher::addTiles(const View& _view, const glm::dvec3& _position) {
+
+    View view(_view);
+    view.setPosition(_position.x, _position.y);
+    view.setZoom(_position.z);
+    view.update();
+
+    view.getVisibleTiles([this](TileID _tileID) {
+        if (std::binary_search(m_visible.begin(), m_visible.end(), _tileID)) { return; }
+
+        if (std::find(m_tiles.begin(), m_tiles.end(), _tileID) == m_tiles.end()) {
+            m_tiles.push_back(_tileID);
+        }
+    });
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include "glm/vec3.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace Tangram {
+
+class View;
+
+/* Predicts the tiles which become visible while the camera moves
+ *
+ * When the path of a camera animation is known (flyTo, eased camera updates)
+ * it is sampled ahead of the current animation time. Otherwise, e.g. during
+ * flings, the camera velocity and zoom rate are estimated from the last frames
+ * and extrapolated. Tiles of the predicted views which are not visible yet are
+ * listed in the order in which they are expected to become visible.
+ */
+class TilePrefetcher {
+
+public:
+
+    // Camera position (x, y in projected meters, z the zoom) for an animation
+    // progress in [0, 1]
+    using PathFn = std::function<glm::dvec3(float)>;
+
+    TilePrefetcher();
+
+    void setEnabled(bool _enabled);
+
+    // Predict @_seconds ahead with @_samples views
+    void setLookahead(float _seconds, int _samples);
+
+    // Set the path of a camera animation which runs for @_duration seconds
+    void setPath(PathFn _path, float _duration);
+
+    void clearPath();
+
+    // Track the camera of @_view after an update by @_dt seconds and predict
+    // the upcoming tiles
+    void update(const View& _view, float _dt);
+
+    // Predicted tiles which are not visible in the current view
+    const std::vector<TileID>& tiles() const { return m_tiles; }
+
+    // Estimated camera velocity in meters and zoom levels per second
+    const glm::dvec3& velocity() const { return m_velocity; }
+
+private:
+
+    void addTiles(const View& _view, const glm::dvec3& _position);
+
+    PathFn m_path;
+    float m_pathDuration = 0.f;
+    float m_pathTime = -1.f;
+
+    glm::dvec3 m_lastPosition;
+    glm::dvec3 m_velocity;
+    bool m_hasLastPosition = false;
+
+    float m_lookahead;
+    int m_samples;
+    bool m_enabled = true;
+
+    std::vector<TileID> m_visible;
+    std::vector<TileID> m_tiles;
+};
+
+}
@@ -0,0 +1,178 @@
+#include "tile/tileScheduler.h"
+
+#include "tile/tileTask.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+TileScheduler::TileScheduler(size_t _numQueues) {
+    for (size_t i = 0; i < std::max<size_t>(_numQueues, 1); i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+}
+
+TileScheduler::~TileScheduler() {}
+
+bool TileScheduler::lowerRank(const Entry& _a, const Entry& _b) {
+    if (_a.prefetch != _b.prefetch) {
+        return _a.prefetch;
+    }
+    if (_a.proxy != _b.proxy) {
+        return _a.proxy;
+    }
+    if (_a.stale != _b.stale) {
+        return !_a.stale;
+    }
+    return _a.priority > _b.priority;
+}
+
+bool TileScheduler::otherClass(const Entry& _a, const Entry& _b) {
+    return _a.prefetch != _b.prefetch || _a.proxy != _b.proxy || _a.stale != _b.stale;
+}
+
+TileScheduler::Entry TileScheduler::makeEntry(std::shared_ptr<TileTask> _task) {
+    bool stale = false;
+    {
+        std::lock_guard<std::mutex> lock(m_generationMutex);
+        auto& generation = m_generations[_task->sourceId()];
+        if (generation < _task->sourceGeneration()) {
+            // Queued tasks of this source may have become outdated
+            if (generation != 0) { m_epoch++; }
+            generation = _task->sourceGeneration();
+        }
+        stale = _task->sourceGeneration() < generation;
+    }
+    float priority = _task->getPriority();
+    bool prefetch = _task->isPrefetch();
+    bool proxy = _task->isProxy();
+
+    return { std::move(_task), priority, prefetch, proxy, stale };
+}
+
+void TileScheduler::push(std::shared_ptr<TileTask> _task) {
+    auto entry = makeEntry(std::move(_task));
+
+    auto& queue = *m_queues[m_nextQueue++ % m_queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.heap.push_back(std::move(entry));
+        std::push_heap(queue.heap.begin(), queue.heap.end(), lowerRank);
+    }
+    m_size++;
+}
+
+void TileScheduler::updatePriorities() {
+    m_epoch++;
+}
+
+void TileScheduler::refresh(Queue& _queue) {
+    uint32_t epoch = m_epoch;
+    if (_queue.epoch == epoch) { return; }
+    _queue.epoch = epoch;
+
+    auto& heap = _queue.heap;
+    auto removes = std::remove_if(heap.begin(), heap.end(),
+                                  [](const auto& e) { return e.task->isCanceled(); });
+    m_size -= std::distance(removes, heap.end());
+    heap.erase(removes, heap.end());
+
+    {
+        std::lock_guard<std::mutex> lock(m_generationMutex);
+        for (auto& entry : heap) {
+            entry.priority = entry.task->getPriority();
+            entry.prefetch = entry.task->isPrefetch();
+            entry.proxy = entry.task->isProxy();
+            entry.stale = entry.task->sourceGeneration() < m_generations[entry.task->sourceId()];
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), lowerRank);
+}
+
+bool TileScheduler::dropCanceled(Queue& _queue) {
+    auto& heap = _queue.heap;
+    while (!heap.empty() && heap.front().task->isCanceled()) {
+        std::pop_heap(heap.begin(), heap.end(), lowerRank);
+        heap.pop_back();
+        m_size--;
+    }
+    return !heap.empty();
+}
+
+std::shared_ptr<TileTask> TileScheduler::popTop(Queue& _queue) {
+    auto& heap = _queue.heap;
+    std::pop_heap(heap.begin(), heap.end(), lowerRank);
+    auto task = std::move(heap.back().task);
+    heap.pop_back();
+    m_size--;
+    return task;
+}
+
+std::shared_ptr<TileTask> TileScheduler::pop(size_t _queue) {
+    if (m_size == 0) { return nullptr; }
+
+    size_t numQueues = m_queues.size();
+    size_t ownId = _queue % numQueues;
+    auto& own = *m_queues[ownId];
+
+    std::unique_lock<std::mutex> ownLock(own.mutex);
+    refresh(own);
+    bool hasOwn = dropCanceled(own);
+
+    // Keep working on the own queue unless its best task is outranked by
+    // class (prefetch, proxy or generation) by another queue's best task.
+    const auto* front = hasOwn ? &own.heap.front() : nullptr;
+    if (front && !front->prefetch && !front->proxy && front->stale) {
+        return popTop(own);
+    }
+
+    Entry ownTop;
+    if (hasOwn) {
+        ownTop = own.heap.front();
+    }
+    ownLock.unlock();
+
+    // Find a victim with a better ranked top entry
+    size_t victimId = numQueues;
+    Entry victimTop;
+    for (size_t i = 1; i < numQueues; i++) {
+        size_t id = (ownId + i) % numQueues;
+        auto& queue = *m_queues[id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        refresh(queue);
+        if (!dropCanceled(queue)) { continue; }
+
+        const auto& top = queue.heap.front();
+        bool better = victimId == numQueues
+            ? (!hasOwn || (otherClass(top, ownTop) && lowerRank(ownTop, top)))
+            : lowerRank(victimTop, top);
+        if (better) {
+            victimId = id;
+            victimTop = top;
+        }
+    }
+
+    if (victimId != numQueues) {
+        auto& victim = *m_queues[victimId];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (dropCanceled(victim)) {
+            return popTop(victim);
+        }
+    }
+
+    ownLock.lock();
+    if (dropCanceled(own)) {
+        return popTop(own);
+    }
+    return nullptr;
+}
+
+void TileScheduler::clear() {
+    for (auto& queue : m_queues) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        m_size -= queue->heap.size();
+        queue->heap.clear();
+    }
+}
+
+}
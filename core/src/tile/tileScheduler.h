@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class TileTask;
+
+/* Priority scheduler for TileTasks
+ *
+ * TileScheduler keeps one binary heap per worker thread. Tasks are distributed
+ * round-robin on push, each worker pops from its own heap and steals the best
+ * task from another heap when its own is empty or only holds lower ranked
+ * tasks. Pop is O(log n) on the worker's own queue instead of a linear scan
+ * over all pending tasks under one global lock.
+ *
+ * Tasks are ordered by:
+ *  1. Tasks of tiles in view before prefetch tasks
+ *  2. Non-proxy tasks before proxy tasks
+ *  3. Tasks of an outdated source generation before current ones
+ *  4. Lower TileTask::getPriority() values first
+ *
+ * Canceled tasks are removed lazily, when they reach the top of a heap or when
+ * the heap is re-keyed. Ordering keys are snapshots of the task state at push
+ * time; updatePriorities() and a new source generation mark all heaps to be
+ * re-keyed from the current task state on their next access.
+ */
+class TileScheduler {
+
+public:
+
+    explicit TileScheduler(size_t _numQueues);
+
+    ~TileScheduler();
+
+    /* Add @_task to one of the queues. Thread-safe. */
+    void push(std::shared_ptr<TileTask> _task);
+
+    /* Returns the highest ranked task for worker @_queue, or nullptr when
+     * no runnable task is left. Thread-safe. */
+    std::shared_ptr<TileTask> pop(size_t _queue);
+
+    /* Re-key all queued tasks from their current priority and proxy state.
+     * The work is deferred to the next pop on each queue. */
+    void updatePriorities();
+
+    /* Number of queued tasks (may include canceled tasks not yet dropped) */
+    size_t size() const { return m_size; }
+
+    bool empty() const { return m_size == 0; }
+
+    void clear();
+
+private:
+
+    struct Entry {
+        std::shared_ptr<TileTask> task;
+        float priority = 0;
+        bool prefetch = false;
+        bool proxy = false;
+        bool stale = false;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::vector<Entry> heap;
+        uint32_t epoch = 0;
+    };
+
+    // Heap order: returns true when @_a ranks lower than @_b
+    static bool lowerRank(const Entry& _a, const Entry& _b);
+
+    // Whether @_a and @_b differ in one of the ordering classes above priority
+    static bool otherClass(const Entry& _a, const Entry& _b);
+
+    Entry makeEntry(std::shared_ptr<TileTask> _task);
+
+    // Must be called with _queue.mutex held
+    void refresh(Queue& _queue);
+    bool dropCanceled(Queue& _queue);
+    std::shared_ptr<TileTask> popTop(Queue& _queue);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+
+    std::atomic<size_t> m_size{0};
+    std::atomic<size_t> m_nextQueue{0};
+    std::atomic<uint32_t> m_epoch{0};
+
+    // Latest generation seen per TileSource id
+    std::mutex m_generationMutex;
+    std::unordered_map<int64_t, int64_t> m_generations;
+};
+
+}
@@ -4,7 +4,9 @@
 #include "scene/scene.h"
 #include "tile/tile.h"
 #include "tile/tileBuilder.h"
+#include "tile/tileMeshCache.h"
 #include "util/mapProjection.h"
+#include "util/zlibHelper.h"
 
 namespace Tangram {
 
@@ -18,7 +20,8 @@ TileTask::TileTask(TileID& _tileId, std::shared_ptr<TileSource> _source, int _su
     m_canceled(false),
     m_needsLoading(true),
     m_priority(0),
-    m_proxyState(false) {}
+    m_proxyState(false),
+    m_prefetchState(false) {}
 
 TileTask::~TileTask() {}
 
@@ -36,10 +39,33 @@ void TileTask::process(TileBuilder& _tileBuilder) {
     auto source = m_source.lock();
     if (!source) { return; }
 
+    auto* meshCache = source->meshCache();
+    uint32_t hash = 0;
+    std::unique_ptr<Tile> restored;
+
+    // Skip parsing and styling when the tile was built before
+    if (meshCache) {
+        hash = dataHash();
+        bool complete = false;
+        restored = meshCache->restore(m_tileId, *source, _tileBuilder.scene(),
+                                      _tileBuilder.sceneHash(), hash, complete);
+        if (restored && complete) {
+            m_tile = std::move(restored);
+            m_ready = true;
+            return;
+        }
+    }
+
     auto tileData = source->parse(*this);
 
     if (tileData) {
-        m_tile = _tileBuilder.build(m_tileId, *tileData, *source);
+        // Only the meshes that were not stored, like labels, are built for a
+        // restored tile
+        bool store = meshCache && !restored;
+        m_tile = _tileBuilder.build(m_tileId, *tileData, *source, std::move(restored));
+        if (store) {
+            meshCache->store(*m_tile, *source, _tileBuilder.scene(), _tileBuilder.sceneHash(), hash);
+        }
         m_ready = true;
     } else {
         cancel();
@@ -55,4 +81,32 @@ void TileTask::complete() {
 
 }
 
+bool TileTask::needsUpload() const {
+    if (m_tile && m_tile->needsUpload()) { return true; }
+
+    for (auto& subTask : m_subTasks) {
+        if (subTask->needsUpload()) { return true; }
+    }
+    return false;
+}
+
+size_t TileTask::upload(RenderState& _rs, size_t _maxBytes) {
+    size_t uploaded = 0;
+
+    for (auto& subTask : m_subTasks) {
+        if (uploaded >= _maxBytes) { return uploaded; }
+        uploaded += subTask->upload(_rs, _maxBytes - uploaded);
+    }
+
+    if (m_tile && uploaded < _maxBytes) {
+        uploaded += m_tile->upload(_rs, _maxBytes - uploaded);
+    }
+    return uploaded;
+}
+
+uint32_t BinaryTileTask::dataHash() const {
+    if (!rawTileData) { return 0; }
+    return zlib::crc32(0, rawTileData->data(), rawTileData->size());
+}
+
 }
@@ -8,17 +8,17 @@
 #include "tile/tileID.h"
 #include "tile/tileTask.h"
 
-#include <algorithm>
-
 #define WORKER_NICENESS 10
 
 namespace Tangram {
 
-TileWorker::TileWorker(std::shared_ptr<Platform> _platform, int _numWorker) : m_platform(_platform) {
+TileWorker::TileWorker(std::shared_ptr<Platform> _platform, int _numWorker)
+    : m_scheduler(_numWorker), m_platform(_platform) {
     m_running = true;
 
     for (int i = 0; i < _numWorker; i++) {
         auto worker = std::make_unique<Worker>();
+        worker->id = i;
         worker->thread = std::thread(&TileWorker::run, this, worker.get());
         m_workers.push_back(std::move(worker));
     }
@@ -38,13 +38,18 @@ void TileWorker::run(Worker* instance) {
 
     while (true) {
 
-        std::shared_ptr<TileTask> task;
+        std::shared_ptr<TileBuilder::Part> part;
+        std::shared_ptr<MarkerManager::Batch> batch;
+
         {
             std::unique_lock<std::mutex> lock(m_mutex);
 
+            m_idleWorkers++;
             m_condition.wait(lock, [&, this]{
-                    return !m_running || !m_queue.empty();
+                    return !m_running || !m_scheduler.empty() || !m_parts.empty() ||
+                        !m_markerBatches.empty();
                 });
+            m_idleWorkers--;
 
             if (instance->tileBuilder) {
                 builder = std::move(instance->tileBuilder);
@@ -60,31 +65,33 @@ void TileWorker::run(Worker* instance) {
                 continue;
             }
 
-            // Remove all canceled tasks
-            auto removes = std::remove_if(m_queue.begin(), m_queue.end(),
-                                          [](const auto& a) { return a->isCanceled(); });
+            // Finish tiles that are already being built first
+            if (!m_parts.empty()) {
+                part = std::move(m_parts.front());
+                m_parts.pop_front();
+            } else if (!m_markerBatches.empty()) {
+                batch = std::move(m_markerBatches.front());
+                m_markerBatches.pop_front();
+            }
+        }
 
-            m_queue.erase(removes, m_queue.end());
+        if (part) {
+            builder->buildPart(*part);
+            continue;
+        }
 
-            if (m_queue.empty()) {
-                continue;
-            }
+        if (batch) {
+            builder->buildMarkers(*batch);
+            m_platform->requestRender();
+            continue;
+        }
 
-            // Pop highest priority tile from queue
-            auto it = std::min_element(m_queue.begin(), m_queue.end(),
-                [](const auto& a, const auto& b) {
-                    if (a->isProxy() != b->isProxy()) {
-                        return !a->isProxy();
-                    }
-                    if (a->sourceId() == b->sourceId() &&
-                        a->sourceGeneration() != b->sourceGeneration()) {
-                        return a->sourceGeneration() < b->sourceGeneration();
-                    }
-                    return a->getPriority() < b->getPriority();
-                });
+        // Pop highest priority tile from the scheduler. Canceled tasks are
+        // dropped by the scheduler.
+        auto task = m_scheduler.pop(instance->id);
 
-            task = std::move(*it);
-            m_queue.erase(it);
+        if (!task) {
+            continue;
         }
 
         if (task->isCanceled()) {
@@ -100,6 +107,11 @@ void TileWorker::run(Worker* instance) {
 void TileWorker::setScene(std::shared_ptr<Scene>& _scene) {
     for (auto& worker : m_workers) {
         worker->tileBuilder = std::make_unique<TileBuilder>(_scene);
+
+        // Let idle workers help building large tiles
+        if (m_workers.size() > 1) {
+            worker->tileBuilder->setPartQueue(this);
+        }
     }
 }
 
@@ -109,7 +121,41 @@ void TileWorker::enqueue(std::shared_ptr<TileTask> task) {
         if (!m_running) {
             return;
         }
-        m_queue.push_back(std::move(task));
+        m_scheduler.push(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void TileWorker::updatePriorities() {
+    m_scheduler.updatePriorities();
+}
+
+size_t TileWorker::idleWorkers() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (!m_scheduler.empty() || m_idleWorkers <= m_parts.size()) { return 0; }
+
+    return m_idleWorkers - m_parts.size();
+}
+
+void TileWorker::enqueue(std::shared_ptr<TileBuilder::Part> _part) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_parts.push_back(std::move(_part));
+    }
+    m_condition.notify_one();
+}
+
+void TileWorker::enqueue(std::shared_ptr<MarkerManager::Batch> _batch) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_markerBatches.push_back(std::move(_batch));
     }
     m_condition.notify_one();
 }
@@ -126,7 +172,9 @@ void TileWorker::stop() {
         worker->thread.join();
     }
 
-    m_queue.clear();
+    m_scheduler.clear();
+    m_parts.clear();
+    m_markerBatches.clear();
 }
 
 }
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "tile/tileBuilder.h"
+#include "tile/tileScheduler.h"
 #include "tile/tileTask.h"
 #include "util/jobQueue.h"
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -15,9 +18,8 @@ namespace Tangram {
 class JobQueue;
 class Platform;
 class Scene;
-class TileBuilder;
 
-class TileWorker : public TileTaskQueue {
+class TileWorker : public TileTaskQueue, public TileBuilder::PartQueue, public MarkerManager::BatchQueue {
 
 public:
 
@@ -27,6 +29,14 @@ public:
 
     virtual void enqueue(std::shared_ptr<TileTask> task) override;
 
+    virtual void updatePriorities() override;
+
+    size_t idleWorkers() override;
+
+    void enqueue(std::shared_ptr<TileBuilder::Part> _part) override;
+
+    void enqueue(std::shared_ptr<MarkerManager::Batch> _batch) override;
+
     void stop();
 
     bool isRunning() const { return m_running; }
@@ -36,6 +46,7 @@ public:
 private:
 
     struct Worker {
+        size_t id;
         std::thread thread;
         std::unique_ptr<TileBuilder> tileBuilder;
     };
@@ -48,8 +59,19 @@ private:
 
     std::condition_variable m_condition;
 
+    // Guards m_running, TileBuilder handoff and worker wakeup
     std::mutex m_mutex;
-    std::vector<std::shared_ptr<TileTask>> m_queue;
+
+    TileScheduler m_scheduler;
+
+    // Parts of tiles that are built by other workers, taken before new tiles
+    std::deque<std::shared_ptr<TileBuilder::Part>> m_parts;
+
+    // Marker meshes to build, taken before new tiles
+    std::deque<std::shared_ptr<MarkerManager::Batch>> m_markerBatches;
+
+    // Workers waiting for tasks or parts
+    size_t m_idleWorkers = 0;
 
     std::shared_ptr<Platform> m_platform;
 };
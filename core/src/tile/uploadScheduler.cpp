@@ -0,0 +1,79 @@
+#include "tile/uploadScheduler.h"
+
+#include "gl/renderState.h"
+#include "tile/tile.h"
+#include "tile/tileTask.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace Tangram {
+
+// Default budget, about a quarter of a 60fps frame on mobile GPUs
+static const size_t DEFAULT_UPLOAD_BYTES = 2 * 1024 * 1024;
+static const float DEFAULT_UPLOAD_TIME = 4.f;
+
+// Upper bound of bytes uploaded between two checks of the time budget
+static const size_t UPLOAD_CHUNK_SIZE = 256 * 1024;
+
+UploadScheduler::UploadScheduler()
+    : m_maxBytes(DEFAULT_UPLOAD_BYTES),
+      m_maxTime(DEFAULT_UPLOAD_TIME) {}
+
+void UploadScheduler::setBudget(size_t _bytes, float _milliseconds) {
+    m_maxBytes = _bytes;
+    m_maxTime = _milliseconds;
+}
+
+bool UploadScheduler::upload(RenderState& rs, std::vector<std::shared_ptr<TileTask>>& _tasks) {
+
+    m_stats = FrameStats();
+    rs.uploadBudget = m_maxBytes;
+
+    _tasks.erase(std::remove_if(_tasks.begin(), _tasks.end(), [](auto& task) {
+                return task->isCanceled() || !task->needsUpload();
+            }), _tasks.end());
+
+    if (_tasks.empty()) { return false; }
+
+    std::sort(_tasks.begin(), _tasks.end(), [](auto& a, auto& b) {
+            if (a->isPrefetch() != b->isPrefetch()) { return b->isPrefetch(); }
+            if (a->isProxy() != b->isProxy()) { return b->isProxy(); }
+            return a->getPriority() < b->getPriority();
+        });
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::chrono::duration<float, std::milli> elapsed(0);
+
+    for (auto& task : _tasks) {
+        while (task->needsUpload()) {
+            if (m_stats.bytes > 0 &&
+                (m_stats.bytes >= m_maxBytes || elapsed.count() >= m_maxTime)) {
+                break;
+            }
+
+            size_t chunk = UPLOAD_CHUNK_SIZE;
+            if (m_stats.bytes > 0) {
+                chunk = std::min(chunk, m_maxBytes - m_stats.bytes);
+            }
+
+            size_t bytes = task->upload(rs, chunk);
+            m_stats.bytes += bytes;
+
+            elapsed = std::chrono::steady_clock::now() - startTime;
+
+            if (bytes == 0) { break; }
+        }
+
+        if (task->needsUpload()) { m_stats.pendingTiles++; }
+    }
+
+    m_stats.time = elapsed.count();
+
+    // Meshes that are first uploaded when drawn get what is left
+    rs.uploadBudget = m_maxBytes - std::min(m_stats.bytes, m_maxBytes);
+
+    return m_stats.pendingTiles > 0;
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+class TileTask;
+
+/* Spreads mesh and raster texture uploads of newly built tiles over frames
+ *
+ * Built tiles are only swapped in for their proxies once all their meshes and
+ * rasters are in GPU memory. Instead of uploading everything on first draw,
+ * the render thread calls upload() once per frame which moves data of the
+ * pending tiles until the frame budget of bytes or time is used. Non-proxy
+ * tiles go first, then tiles nearest to the view center. Meshes larger than
+ * the remaining budget are uploaded in parts with glBufferSubData, textures
+ * are uploaded as a whole.
+ *
+ * At least one chunk is uploaded per frame so that tiles are completed even
+ * with a budget smaller than the chunk size. The rest of the budget is left
+ * in RenderState::uploadBudget for meshes uploaded when drawn, like those of
+ * markers.
+ */
+class UploadScheduler {
+
+public:
+
+    struct FrameStats {
+        size_t bytes = 0;
+        float time = 0;
+        size_t pendingTiles = 0;
+    };
+
+    UploadScheduler();
+
+    /* Set the number of bytes and milliseconds spent on uploads per frame */
+    void setBudget(size_t _bytes, float _milliseconds);
+
+    /* Upload the meshes and rasters of @_tasks within the frame budget.
+     * Returns whether uploads are left for the next frames. */
+    bool upload(RenderState& rs, std::vector<std::shared_ptr<TileTask>>& _tasks);
+
+    /* Uploads of the last frame */
+    const FrameStats& stats() const { return m_stats; }
+
+private:
+
+    size_t m_maxBytes;
+    float m_maxTime;
+
+    FrameStats m_stats;
+};
+
+}
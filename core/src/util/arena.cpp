@@ -0,0 +1,80 @@
+#include "util/arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Tangram {
+
+Arena::Arena(size_t _blockSize, size_t _maxRetained)
+    : m_blockSize(_blockSize), m_maxRetained(_maxRetained) {}
+
+void* Arena::allocate(size_t _size, size_t _alignment) {
+    if (_size == 0) { _size = 1; }
+
+    while (true) {
+        // Bump within the current block, move on to the next retained block
+        // when it is full
+        for (; m_block < m_blocks.size(); m_block++, m_offset = 0) {
+            auto& block = m_blocks[m_block];
+
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            uintptr_t start = (base + m_offset + _alignment - 1) & ~uintptr_t(_alignment - 1);
+            size_t end = (start - base) + _size;
+
+            if (end <= block.size) {
+                m_offset = end;
+                m_peak = std::max(m_peak, m_block == 0 ? m_offset : used());
+                return reinterpret_cast<void*>(start);
+            }
+        }
+
+        size_t size = std::max(m_blockSize, _size + _alignment);
+        m_blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+        m_block = m_blocks.size() - 1;
+        m_offset = 0;
+    }
+}
+
+void Arena::rewind(Marker _marker) {
+    m_block = _marker.block;
+    m_offset = _marker.offset;
+}
+
+void Arena::reset() {
+    m_resets++;
+
+    size_t capacity = 0;
+    for (auto& block : m_blocks) { capacity += block.size; }
+
+    if (m_blocks.size() > 1 || capacity > m_maxRetained) {
+        m_blocks.clear();
+
+        size_t size = std::min(capacity, m_maxRetained);
+        if (size > m_blockSize) {
+            m_blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+        }
+    }
+
+    m_block = 0;
+    m_offset = 0;
+}
+
+size_t Arena::used() const {
+    size_t sum = m_offset;
+    for (size_t i = 0; i < m_block && i < m_blocks.size(); i++) {
+        sum += m_blocks[i].size;
+    }
+    return sum;
+}
+
+Arena::Stats Arena::stats() const {
+    Stats stats;
+    stats.used = used();
+    stats.peak = m_peak;
+    stats.blocks = m_blocks.size();
+    stats.resets = m_resets;
+    for (auto& block : m_blocks) { stats.capacity += block.size; }
+    return stats;
+}
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+/* Monotonic allocator for scratch memory of tile builds
+ *
+ * Allocations are bumped from large blocks and never freed one by one. Memory
+ * is handed back all at once with rewind() or reset(), so that each tile worker
+ * can reuse the same few blocks instead of going through the global heap for
+ * every feature. Not thread-safe: each TileBuilder owns its Arena.
+ *
+ * Memory from an Arena must not outlive the build step that allocated it; data
+ * which leaves the worker (meshes, labels, selection properties) is allocated
+ * on the heap as before.
+ */
+class Arena {
+
+public:
+
+    struct Marker {
+        size_t block = 0;
+        size_t offset = 0;
+    };
+
+    struct Stats {
+        // Bytes allocated since the last reset
+        size_t used = 0;
+        // Largest 'used' so far
+        size_t peak = 0;
+        // Bytes held in blocks
+        size_t capacity = 0;
+        size_t blocks = 0;
+        size_t resets = 0;
+    };
+
+    // New blocks have at least @_blockSize bytes. A reset keeps at most
+    // @_maxRetained bytes, so that one huge tile does not pin its memory.
+    explicit Arena(size_t _blockSize = 64 * 1024, size_t _maxRetained = 4 * 1024 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t _size, size_t _alignment = alignof(std::max_align_t));
+
+    // Position to rewind() to, to release everything allocated after it
+    Marker mark() const { return { m_block, m_offset }; }
+
+    void rewind(Marker _marker);
+
+    // Release all allocations. When the last round did not fit into one block,
+    // the blocks are merged into one so that the next round does.
+    void reset();
+
+    size_t used() const;
+
+    Stats stats() const;
+
+private:
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    size_t m_block = 0;
+    size_t m_offset = 0;
+
+    size_t m_blockSize;
+    size_t m_maxRetained;
+
+    size_t m_peak = 0;
+    size_t m_resets = 0;
+};
+
+/* STL allocator bumping from an Arena, falls back to the heap without one */
+template<typename T>
+class ArenaAllocator {
+
+public:
+
+    using value_type = T;
+
+    ArenaAllocator(Arena* _arena = nullptr) noexcept : m_arena(_arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& _other) noexcept : m_arena(_other.arena()) {}
+
+    T* allocate(size_t _n) {
+        if (!m_arena) { return static_cast<T*>(::operator new(_n * sizeof(T))); }
+
+        return static_cast<T*>(m_arena->allocate(_n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* _p, size_t) noexcept {
+        if (!m_arena) { ::operator delete(_p); }
+    }
+
+    Arena* arena() const { return m_arena; }
+
+private:
+    Arena* m_arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& _a, const ArenaAllocator<U>& _b) {
+    return _a.arena() == _b.arena();
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& _a, const ArenaAllocator<U>& _b) {
+    return _a.arena() != _b.arena();
+}
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}
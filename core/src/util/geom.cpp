@@ -125,4 +125,30 @@ bool isPowerOfTwo(int _value) {
     return (_value & (_value - 1)) == 0;
 }
 
+static glm::vec2 signNotZero(const glm::vec2& _v) {
+    return { _v.x >= 0.f ? 1.f : -1.f, _v.y >= 0.f ? 1.f : -1.f };
+}
+
+glm::vec2 octEncode(const glm::vec3& _normal) {
+    glm::vec3 n = _normal / (std::abs(_normal.x) + std::abs(_normal.y) + std::abs(_normal.z));
+    glm::vec2 e(n.x, n.y);
+
+    // Fold the lower hemisphere over the diagonals
+    if (n.z < 0.f) {
+        e = (1.f - glm::abs(glm::vec2(e.y, e.x))) * signNotZero(e);
+    }
+    return e;
+}
+
+glm::vec3 octDecode(const glm::vec2& _encoded) {
+    glm::vec3 n(_encoded.x, _encoded.y, 1.f - std::abs(_encoded.x) - std::abs(_encoded.y));
+
+    if (n.z < 0.f) {
+        glm::vec2 e = (1.f - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n.x, n.y));
+        n.x = e.x;
+        n.y = e.y;
+    }
+    return glm::normalize(n);
+}
+
 }
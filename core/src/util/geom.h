@@ -156,4 +156,10 @@ bool isPowerOfTwo(int _value);
 float sqPointSegmentDistance(const glm::vec2& _p, const glm::vec2& _a, const glm::vec2& _b);
 float pointSegmentDistance(const glm::vec2& _p, const glm::vec2& _a, const glm::vec2& _b);
 
+/* Octahedral encoding of the unit vector _normal in two components of [-1, 1] */
+glm::vec2 octEncode(const glm::vec3& _normal);
+
+/* Inverse of octEncode */
+glm::vec3 octDecode(const glm::vec2& _encoded);
+
 }
@@ -8,7 +8,7 @@ template<typename Points>
 struct LineSampler {
 
     template<typename T>
-    void set(std::vector<T> _points) {
+    void set(const std::vector<T>& _points) {
         m_points.clear();
 
         if (_points.empty()) { return; }
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Tangram {
+
+/* Bounded least-recently-used cache that can be shared between threads
+ *
+ * Entries are distributed over shards by the hash of their key. Each shard
+ * has its own lock and evicts its least recently used entry when it holds
+ * more than its part of the capacity. Values are copied out on lookup, so
+ * they should be cheap to copy, e.g. a shared_ptr to immutable data.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>>
+class LruCache {
+
+public:
+
+    struct Stats {
+        // Lookups that found an entry, or not
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        // Entries dropped to stay within the capacity
+        uint64_t evictions = 0;
+        // Number of cached entries
+        uint64_t entries = 0;
+    };
+
+    explicit LruCache(size_t _capacity, size_t _shards = 8)
+        : m_shards(new Shard[_shards]),
+          m_numShards(_shards),
+          m_shardCapacity(std::max<size_t>((_capacity + _shards - 1) / _shards, 1)) {}
+
+    /* Copy the value of @_key to @_value and mark it as most recently used,
+     * returns false when @_key is not cached */
+    bool get(const K& _key, V& _value) {
+        auto& shard = shardFor(_key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(_key);
+        if (it == shard.index.end()) {
+            shard.stats.misses++;
+            return false;
+        }
+        shard.stats.hits++;
+
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        _value = it->second->second;
+        return true;
+    }
+
+    /* Add or replace the value of @_key */
+    void put(const K& _key, V _value) {
+        auto& shard = shardFor(_key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(_key);
+        if (it != shard.index.end()) {
+            it->second->second = std::move(_value);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+
+        shard.entries.emplace_front(_key, std::move(_value));
+        shard.index.emplace(_key, shard.entries.begin());
+
+        if (shard.entries.size() > m_shardCapacity) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+            shard.stats.evictions++;
+        }
+    }
+
+    /* Remove all entries, the hit and miss counts are kept */
+    void clear() {
+        for (size_t i = 0; i < m_numShards; i++) {
+            std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+            m_shards[i].index.clear();
+            m_shards[i].entries.clear();
+        }
+    }
+
+    Stats stats() const {
+        Stats stats;
+        for (size_t i = 0; i < m_numShards; i++) {
+            std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+            stats.hits += m_shards[i].stats.hits;
+            stats.misses += m_shards[i].stats.misses;
+            stats.evictions += m_shards[i].stats.evictions;
+            stats.entries += m_shards[i].entries.size();
+        }
+        return stats;
+    }
+
+private:
+
+    using Entries = std::list<std::pair<K, V>>;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        // Most recently used first
+        Entries entries;
+        std::unordered_map<K, typename Entries::iterator, Hash> index;
+        Stats stats;
+    };
+
+    Shard& shardFor(const K& _key) {
+        // Mix the hash so that the shard does not correlate with the buckets
+        size_t h = Hash()(_key);
+        return m_shards[(h ^ (h >> 17)) % m_numShards];
+    }
+
+    std::unique_ptr<Shard[]> m_shards;
+    size_t m_numShards;
+    size_t m_shardCapacity;
+};
+
+}
@@ -90,5 +90,32 @@ bool getBoolOrDefault(const YAML::Node& node, bool defaultValue) {
     return defaultValue;
 }
 
+bool equal(const YAML::Node& a, const YAML::Node& b) {
+    if (!a.IsDefined() || !b.IsDefined()) {
+        return a.IsDefined() == b.IsDefined();
+    }
+    if (a.Type() != b.Type()) { return false; }
+
+    switch (a.Type()) {
+    case YAML::NodeType::Scalar:
+        return a.Scalar() == b.Scalar() && a.Tag() == b.Tag();
+    case YAML::NodeType::Sequence:
+        if (a.size() != b.size()) { return false; }
+        for (size_t i = 0; i < a.size(); i++) {
+            if (!equal(a[i], b[i])) { return false; }
+        }
+        return true;
+    case YAML::NodeType::Map:
+        if (a.size() != b.size()) { return false; }
+        for (const auto& entry : a) {
+            if (!entry.first.IsScalar()) { return false; }
+            if (!equal(entry.second, b[entry.first.Scalar()])) { return false; }
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
 } // namespace YamlUtil
 } // namespace Tangram
@@ -44,5 +44,9 @@ bool parseVec(const YAML::Node& sequence, T& result) {
 
 glm::vec4 getColorAsVec4(const YAML::Node& node);
 
+// Compare nodes by value, recursing into maps and sequences. Maps with
+// non-scalar keys are never equal.
+bool equal(const YAML::Node& a, const YAML::Node& b);
+
 } // namespace YamlUtil
 } // namespace Tangram
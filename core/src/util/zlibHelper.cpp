@@ -52,5 +52,9 @@ int inflate(const char* _data, size_t _size, std::vector<char>& dst) {
     return ret == Z_STREAM_END ? Z_OK : Z_DATA_ERROR;
 }
 
+uint32_t crc32(uint32_t _crc, const char* _data, size_t _size) {
+    return ::crc32(_crc, reinterpret_cast<const Bytef*>(_data), _size);
+}
+
 }
 }
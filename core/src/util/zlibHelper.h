@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string.h>
 
@@ -8,5 +9,8 @@ namespace zlib {
 
 int inflate(const char* _data, size_t _size, std::vector<char>& dst);
 
+// Update running CRC-32 checksum @_crc with @_data (start with 0)
+uint32_t crc32(uint32_t _crc, const char* _data, size_t _size);
+
 }
 }
@@ -2,6 +2,7 @@
 
 #include "data/properties.h"
 #include "data/propertyItem.h"
+#include "gl/hardware.h"
 #include "log.h"
 #include "map.h"
 #include "util/url.h"
@@ -30,6 +31,8 @@
 PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOESEXT = 0;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT = 0;
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT = 0;
+PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOESEXT = 0;
+PFNGLPROGRAMBINARYOESPROC glProgramBinaryOESEXT = 0;
 
 #define TANGRAM_JNI_VERSION JNI_VERSION_1_6
 
@@ -445,6 +448,10 @@ void AndroidPlatform::featurePickCallback(const Tangram::FeaturePickResult* feat
 
 void initGLExtensions() {
     if (glExtensionsLoaded) {
+        // Reset by Hardware::loadExtensions() on every GL setup
+        if (!glGetProgramBinaryOESEXT || !glProgramBinaryOESEXT) {
+            Hardware::supportsProgramBinary = false;
+        }
         return;
     }
 
@@ -454,6 +461,13 @@ void initGLExtensions() {
     glDeleteVertexArraysOESEXT = (PFNGLDELETEVERTEXARRAYSOESPROC) dlsym(libhandle, "glDeleteVertexArraysOES");
     glGenVertexArraysOESEXT = (PFNGLGENVERTEXARRAYSOESPROC) dlsym(libhandle, "glGenVertexArraysOES");
 
+    glGetProgramBinaryOESEXT = (PFNGLGETPROGRAMBINARYOESPROC) dlsym(libhandle, "glGetProgramBinaryOES");
+    glProgramBinaryOESEXT = (PFNGLPROGRAMBINARYOESPROC) dlsym(libhandle, "glProgramBinaryOES");
+
+    if (!glGetProgramBinaryOESEXT || !glProgramBinaryOESEXT) {
+        Hardware::supportsProgramBinary = false;
+    }
+
     glExtensionsLoaded = true;
 }
 
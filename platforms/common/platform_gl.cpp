@@ -131,6 +131,13 @@ void GL::getProgramiv(GLuint program, GLenum pname, GLint *params) {
 void GL::getShaderiv(GLuint shader, GLenum pname, GLint *params) {
     GL_CHECK(glGetShaderiv(shader,pname, params));
 }
+void GL::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                          GLenum *binaryFormat, void *binary) {
+    GL_CHECK(glGetProgramBinary(program, bufSize, length, binaryFormat, binary));
+}
+void GL::programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {
+    GL_CHECK(glProgramBinary(program, binaryFormat, binary, length));
+}
 
 // Buffers
 void GL::bindBuffer(GLenum target, GLuint buffer) {
@@ -17,6 +17,12 @@ extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT;
 #define glDeleteVertexArrays glDeleteVertexArraysOESEXT
 #define glGenVertexArrays glGenVertexArraysOESEXT
 #define glBindVertexArray glBindVertexArrayOESEXT
+
+extern PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOESEXT;
+extern PFNGLPROGRAMBINARYOESPROC glProgramBinaryOESEXT;
+
+#define glGetProgramBinary glGetProgramBinaryOESEXT
+#define glProgramBinary glProgramBinaryOESEXT
 #endif // TANGRAM_ANDROID
 
 #ifdef TANGRAM_IOS
@@ -25,6 +31,10 @@ extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT;
 #define glDeleteVertexArrays glDeleteVertexArraysOES
 #define glGenVertexArrays glGenVertexArraysOES
 #define glBindVertexArray glBindVertexArrayOES
+
+// Dummy program binary functions, not available in ES 2.0
+static void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) { if (length) { *length = 0; } }
+static void glProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {}
 #endif // TANGRAM_IOS
 
 #ifdef TANGRAM_OSX
@@ -36,6 +46,10 @@ extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT;
 #define glDeleteVertexArrays glDeleteVertexArraysAPPLE
 #define glGenVertexArrays glGenVertexArraysAPPLE
 #define glBindVertexArray glBindVertexArrayAPPLE
+
+// Dummy program binary functions, not available in the legacy GL context
+static void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) { if (length) { *length = 0; } }
+static void glProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {}
 #endif // TANGRAM_OSX
 
 #ifdef TANGRAM_LINUX
@@ -57,6 +71,10 @@ static void glBindVertexArray(GLuint array) {}
 static void glDeleteVertexArrays(GLsizei n, const GLuint *arrays) {}
 static void glGenVertexArrays(GLsizei n, GLuint *arrays) {}
 
+// Dummy program binary functions
+static void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) { if (length) { *length = 0; } }
+static void glProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {}
+
 #endif // TANGRAM_RPI
 
 #if defined(TANGRAM_ANDROID) || defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
@@ -1,8 +1,11 @@
 #include "urlClient.h"
 #include "log.h"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <curl/curl.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace Tangram {
 
@@ -19,82 +22,154 @@ struct CurlGlobals {
 
 const char* requestCancelledError = "Request cancelled";
 
+// Upper bound for the time the loop sleeps in curl_multi_wait.
+const int maxWaitMs = 1000;
+
+// Spare easy handles kept for reuse.
+const size_t maxFreeHandles = 8;
+
 UrlClient::UrlClient(Options options) : m_options(options) {
-    assert(options.numberOfThreads > 0);
-    // Start the curl threads.
-    m_keepRunning = true;
-    m_tasks.resize(options.numberOfThreads);
-    for (uint32_t i = 0; i < options.numberOfThreads; i++) {
-        m_threads.emplace_back(&UrlClient::curlLoop, this, i);
+    assert(options.maxActiveTasks > 0);
+    assert(options.maxActiveTasksPerHost > 0);
+
+    if (pipe(m_wakeFds) == 0) {
+        fcntl(m_wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(m_wakeFds[1], F_SETFL, O_NONBLOCK);
+    } else {
+        LOGE("Failed to create wake-up pipe for curl loop");
     }
+
+    // Start the curl thread.
+    m_keepRunning = true;
+    m_thread = std::thread(&UrlClient::curlLoop, this);
 }
 
 UrlClient::~UrlClient() {
-    // Make all tasks canceled.
+    std::vector<UrlCallback> callbacks;
     {
-        // Lock the mutex to prevent concurrent modification of the list by the curl loop thread.
-        std::lock_guard<std::mutex> lock(m_requestMutex);
-        // For all requests that have not started, finish them now with a canceled response.
-        for (auto& request : m_requests) {
-            if (request.callback) {
-                request.callback(getCanceledResponse());
+        // Lock the mutex to prevent concurrent modification of the tasks by the curl loop thread.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Finish all requests with a canceled response.
+        for (auto& entry : m_tasks) {
+            for (auto& request : entry.second->requests) {
+                if (request.callback) { callbacks.push_back(std::move(request.callback)); }
             }
+            entry.second->requests.clear();
+            entry.second->canceled = true;
         }
         m_requests.clear();
-        for (auto& task : m_tasks) {
-            task.request.canceled = true;
-        }
+        m_pending.clear();
+        m_keepRunning = false;
+    }
+    // Stop the curl thread.
+    wakeLoop();
+    m_thread.join();
+
+    for (auto& callback : callbacks) {
+        callback(getCanceledResponse());
     }
-    // Stop the curl threads.
-    m_keepRunning = false;
-    m_requestCondition.notify_all();
-    for (auto& thread : m_threads) {
-        thread.join();
+
+    for (int fd : m_wakeFds) {
+        if (fd >= 0) { close(fd); }
     }
 }
 
 UrlRequestHandle UrlClient::addRequest(const std::string& url, UrlCallback onComplete) {
-    // Create a new request.
-    m_requestCount++;
-    Request request = {url, onComplete, m_requestCount, false};
-    // Add the request to our list.
+    UrlRequestHandle handle;
+    bool startTask = false;
     {
-        // Lock the mutex to prevent concurrent modification of the list by the curl loop thread.
-        std::lock_guard<std::mutex> lock(m_requestMutex);
-        m_requests.push_back(request);
+        // Lock the mutex to prevent concurrent modification of the tasks by the curl loop thread.
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        handle = ++m_requestCount;
+
+        auto& task = m_tasks[url];
+        if (!task) {
+            // Create a new transfer for this URL.
+            task = std::make_unique<Task>();
+            task->url = url;
+            task->host = Url(url).netLocation();
+            task->order = m_taskCount++;
+            m_pending.push_back(task.get());
+            startTask = true;
+        } else {
+            // Join the pending or active transfer for this URL.
+            LOGD("Joining request for url: %s", url.c_str());
+            task->canceled = false;
+        }
+        task->requests.push_back({ handle, std::move(onComplete), 0.f });
+        task->updatePriority();
+
+        m_requests[handle] = task.get();
     }
-    // Notify a thread to start the transfer.
-    m_requestCondition.notify_one();
-    return m_requestCount;
+    if (startTask) { wakeLoop(); }
+
+    return handle;
 }
 
 void UrlClient::cancelRequest(UrlRequestHandle handle) {
     UrlCallback callback;
-    // First check the pending request list.
+    bool wake = false;
     {
-        // Lock the mutex to prevent concurrent modification of the list by the curl loop thread.
-        std::lock_guard<std::mutex> lock(m_requestMutex);
-        for (auto it = m_requests.begin(), end = m_requests.end(); it != end; ++it) {
-            auto& request = *it;
-            if (request.handle == handle) {
-                // Found the request! Now run its callback and remove it.
-                callback = std::move(request.callback);
-                m_requests.erase(it);
-                break;
+        // Lock the mutex to prevent concurrent modification of the tasks by the curl loop thread.
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_requests.find(handle);
+        if (it == m_requests.end()) { return; }
+
+        Task* task = it->second;
+        m_requests.erase(it);
+
+        auto& requests = task->requests;
+        auto request = std::find_if(requests.begin(), requests.end(),
+                                    [&](auto& r) { return r.handle == handle; });
+        callback = std::move(request->callback);
+        requests.erase(request);
+
+        if (requests.empty()) {
+            if (!task->handle) {
+                // Not started yet: drop the transfer right away.
+                m_pending.erase(std::find(m_pending.begin(), m_pending.end(), task));
+                m_tasks.erase(task->url);
+            } else {
+                // Let the curl thread abort the transfer. Until then, a new
+                // request for the same URL can still take it over.
+                task->canceled = true;
+                m_hasCanceledTasks = true;
+                wake = true;
             }
+        } else {
+            task->updatePriority();
         }
     }
+    if (wake) { wakeLoop(); }
+
     // We run the callback outside of the mutex lock to prevent deadlock in case the callback
     // makes further calls into this UrlClient.
     if (callback) {
         callback(getCanceledResponse());
     }
+}
 
-    // Next check the active request list.
-    for (auto& task : m_tasks) {
-        if (task.request.handle == handle) {
-            task.request.canceled = true;
-        }
+void UrlClient::setRequestPriority(UrlRequestHandle handle, float priority) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_requests.find(handle);
+    if (it == m_requests.end()) { return; }
+
+    Task* task = it->second;
+    for (auto& request : task->requests) {
+        if (request.handle == handle) { request.priority = priority; }
+    }
+    task->updatePriority();
+}
+
+void UrlClient::Task::updatePriority() {
+    if (requests.empty()) { return; }
+
+    priority = requests.front().priority;
+    for (auto& request : requests) {
+        priority = std::min(priority, request.priority);
     }
 }
 
@@ -106,95 +181,239 @@ UrlClient::Response UrlClient::getCanceledResponse() {
 
 size_t UrlClient::curlWriteCallback(char* ptr, size_t size, size_t n, void* user) {
     // Writes data received by libCURL.
-    auto* response = reinterpret_cast<UrlClient::Response*>(user);
-    auto& buffer = response->content;
+    auto& buffer = reinterpret_cast<UrlClient::Task*>(user)->content;
     auto addedSize = size * n;
-    auto oldSize = buffer.size();
-    buffer.resize(oldSize + addedSize);
-    std::memcpy(buffer.data() + oldSize, ptr, addedSize);
+    buffer.insert(buffer.end(), ptr, ptr + addedSize);
     return addedSize;
 }
 
-int UrlClient::curlProgressCallback(void* user, double dltotal, double dlnow, double ultotal, double ulnow) {
-    // Signals libCURL to abort the request if marked as canceled.
-    auto* task = reinterpret_cast<UrlClient::Task*>(user);
-    return static_cast<int>(task->request.canceled);
+void UrlClient::wakeLoop() {
+    if (m_wakeFds[1] < 0) { return; }
+
+    char byte = 0;
+    // A full pipe already wakes up the loop.
+    ssize_t written = write(m_wakeFds[1], &byte, 1);
+    (void)written;
 }
 
-void UrlClient::curlLoop(uint32_t index) {
-    assert(m_tasks.size() > index);
-    Task& task = m_tasks[index];
-    LOGD("curlLoop %u starting", index);
-    // Create a buffer for curl error messages.
-    char curlErrorString[CURL_ERROR_SIZE] = {0};
-    // Set up an easy handle for reuse.
+void* UrlClient::initEasyHandle() {
+    static_assert(sizeof(Task::error) >= CURL_ERROR_SIZE, "Error buffer too small");
+
+    if (!m_freeHandles.empty()) {
+        void* handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        return handle;
+    }
+
     auto handle = curl_easy_init();
+    curl_easy_setopt(handle, CURLOPT_SHARE, m_share);
     curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &curlWriteCallback);
-    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &task.content);
-    curl_easy_setopt(handle, CURLOPT_PROGRESSFUNCTION, &curlProgressCallback);
-    curl_easy_setopt(handle, CURLOPT_PROGRESSDATA, &task);
-    curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
     curl_easy_setopt(handle, CURLOPT_HEADER, 0L);
     curl_easy_setopt(handle, CURLOPT_VERBOSE, 0L);
     curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "gzip");
-    curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, curlErrorString);
     curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
-    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, m_options.connectionTimeoutMs);
-    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, m_options.requestTimeoutMs);
-    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1);
-    curl_easy_setopt(handle, CURLOPT_MAXREDIRS, 20);
-    // Loop until the session is destroyed.
-    while (m_keepRunning) {
-        bool haveRequest = false;
-        // Wait until the condition variable is notified.
-        {
-            std::unique_lock<std::mutex> lock(m_requestMutex);
-            if (m_requests.empty()) {
-                LOGD("curlLoop %u waiting", index);
-                m_requestCondition.wait(lock);
-            }
-            LOGD("curlLoop %u notified", index);
-            // Try to get a request from the list.
-            if (!m_requests.empty()) {
-                // Take the first request from our list.
-                task.request = m_requests.front();
-                m_requests.erase(m_requests.begin());
-                haveRequest = true;
-            }
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, long(m_options.connectionTimeoutMs));
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, long(m_options.requestTimeoutMs));
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_MAXREDIRS, 20L);
+#if LIBCURL_VERSION_NUM >= 0x072B00
+    // Prefer waiting for a connection that can multiplex over opening a new one.
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+#endif
+    return handle;
+}
+
+void UrlClient::startPendingTasks() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_pending.empty() || m_active >= m_options.maxActiveTasks) { return; }
+
+    std::sort(m_pending.begin(), m_pending.end(), [](const Task* a, const Task* b) {
+        if (a->priority != b->priority) { return a->priority < b->priority; }
+        return a->order < b->order;
+    });
+
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (m_active >= m_options.maxActiveTasks) { break; }
+
+        Task* task = *it;
+        auto& hostActive = m_activePerHost[task->host];
+        if (hostActive >= m_options.maxActiveTasksPerHost) {
+            ++it;
+            continue;
         }
-        if (haveRequest) {
-            UrlResponse response;
-
-            // Configure the easy handle.
-            const char* url = task.request.url.data();
-            curl_easy_setopt(handle, CURLOPT_URL, url);
-            LOGD("curlLoop %u starting request for url: %s", index, url);
-            // Perform the request.
-            auto result = curl_easy_perform(handle);
-            // Handle success or error.
-            if (result == CURLE_OK) {
-                LOGD("curlLoop %u succeeded for url: %s", index, url);
-                response.error = nullptr;
-            } else if (result == CURLE_ABORTED_BY_CALLBACK) {
-                LOGD("curlLoop %u aborted request for url: %s", index, url);
-                response.error = requestCancelledError;
+        hostActive++;
+        m_active++;
+
+        auto handle = initEasyHandle();
+        curl_easy_setopt(handle, CURLOPT_URL, task->url.c_str());
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, task);
+        curl_easy_setopt(handle, CURLOPT_PRIVATE, task);
+        curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, task->error);
+        task->handle = handle;
+
+        LOGD("curlLoop starting request for url: %s", task->url.c_str());
+        curl_multi_add_handle(m_multi, handle);
+
+        it = m_pending.erase(it);
+    }
+}
+
+void UrlClient::removeCanceledTasks() {
+    std::vector<std::unique_ptr<Task>> canceled;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_hasCanceledTasks) { return; }
+        m_hasCanceledTasks = false;
+
+        for (auto it = m_tasks.begin(); it != m_tasks.end();) {
+            auto& task = it->second;
+            if (task->canceled && task->handle) {
+                m_active--;
+                m_activePerHost[task->host]--;
+                canceled.push_back(std::move(task));
+                it = m_tasks.erase(it);
             } else {
-                LOGD("curlLoop %u failed with error '%s' for url: %s", index, curlErrorString, url);
-                response.error = curlErrorString;
+                ++it;
             }
-            // If a callback is given, always run it regardless of request result.
-            if (task.request.callback) {
-                LOGD("curlLoop %u performing request callback", index);
-                response.content = task.content;
-                task.request.callback(std::move(response));
+        }
+    }
+    for (auto& task : canceled) {
+        LOGD("curlLoop aborted request for url: %s", task->url.c_str());
+        curl_multi_remove_handle(m_multi, task->handle);
+        // Drop the handle, it may have been left in the middle of a transfer.
+        curl_easy_cleanup(task->handle);
+    }
+}
+
+void UrlClient::finishTask(void* handle, int result) {
+    Task* taskPtr = nullptr;
+    curl_easy_getinfo(handle, CURLINFO_PRIVATE, &taskPtr);
+    curl_multi_remove_handle(m_multi, handle);
+
+    std::unique_ptr<Task> task;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_tasks.find(taskPtr->url);
+        assert(it != m_tasks.end() && it->second.get() == taskPtr);
+        task = std::move(it->second);
+        m_tasks.erase(it);
+
+        for (auto& request : task->requests) {
+            m_requests.erase(request.handle);
+        }
+        m_active--;
+        m_activePerHost[task->host]--;
+    }
+
+    if (m_freeHandles.size() < maxFreeHandles) {
+        m_freeHandles.push_back(handle);
+    } else {
+        curl_easy_cleanup(handle);
+    }
+
+    // All requests were canceled after the transfer completed.
+    if (task->requests.empty()) { return; }
+
+    const char* error = nullptr;
+    if (result == CURLE_OK) {
+        LOGD("curlLoop succeeded for url: %s", task->url.c_str());
+    } else {
+        LOGD("curlLoop failed with error '%s' for url: %s", task->error, task->url.c_str());
+        error = task->error[0] ? task->error : curl_easy_strerror(CURLcode(result));
+    }
+
+    // If a callback is given, always run it regardless of request result.
+    size_t count = task->requests.size();
+    for (size_t i = 0; i < count; i++) {
+        auto& callback = task->requests[i].callback;
+        if (!callback) { continue; }
+
+        UrlResponse response;
+        response.error = error;
+        if (i + 1 == count) {
+            response.content = std::move(task->content);
+        } else {
+            response.content = task->content;
+        }
+        callback(std::move(response));
+    }
+}
+
+void UrlClient::curlLoop() {
+    LOGD("curlLoop starting");
+
+    m_multi = curl_multi_init();
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, long(m_options.maxActiveTasks));
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS, long(m_options.maxActiveTasksPerHost));
+#if LIBCURL_VERSION_NUM >= 0x072B00
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+    // Connections are shared by all handles of the multi handle; additionally
+    // share DNS results and TLS sessions.
+    m_share = curl_share_init();
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    curl_waitfd wakeFd;
+    wakeFd.fd = m_wakeFds[0];
+    wakeFd.events = CURL_WAIT_POLLIN;
+    wakeFd.revents = 0;
+    unsigned int numWakeFds = m_wakeFds[0] >= 0 ? 1 : 0;
+
+    // Loop until the client is destroyed.
+    while (true) {
+        removeCanceledTasks();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_keepRunning) { break; }
+        }
+        startPendingTasks();
+
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+
+        bool finished = false;
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(m_multi, &queued)) {
+            if (message->msg == CURLMSG_DONE) {
+                finishTask(message->easy_handle, message->data.result);
+                finished = true;
             }
         }
-        // Reset the task.
-        task.content.clear();
+
+        // Start pending transfers in the freed slots right away.
+        if (finished) { continue; }
+
+        int numFds = 0;
+        curl_multi_wait(m_multi, &wakeFd, numWakeFds, maxWaitMs, &numFds);
+
+        // Drain the wake-up pipe.
+        if (numWakeFds) {
+            char buffer[64];
+            while (read(m_wakeFds[0], buffer, sizeof(buffer)) > 0) {}
+        }
+    }
+    LOGD("curlLoop exiting");
+
+    // Clean up our handles.
+    for (auto& entry : m_tasks) {
+        if (entry.second->handle) {
+            curl_multi_remove_handle(m_multi, entry.second->handle);
+            curl_easy_cleanup(entry.second->handle);
+        }
+    }
+    m_tasks.clear();
+    for (auto handle : m_freeHandles) {
+        curl_easy_cleanup(handle);
     }
-    LOGD("curlLoop %u exiting", index);
-    // Clean up our easy handle.
-    curl_easy_cleanup(handle);
+    m_freeHandles.clear();
+    curl_multi_cleanup(m_multi);
+    curl_share_cleanup(m_share);
 }
 
 } // namespace Tangram
@@ -3,19 +3,31 @@
 #include "platform.h"
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace Tangram {
 
+/* Asynchronous URL loader on top of the libcurl multi interface
+ *
+ * All transfers run in one event loop thread, so that connections, DNS lookups
+ * and TLS sessions are shared between requests and HTTP/2 streams to the same
+ * host are multiplexed on one connection. Requests for a URL which is already
+ * pending or transferring join the existing transfer instead of starting a new
+ * one. Pending requests are started in order of their priority, as long as
+ * the limits of concurrent transfers in total and per host allow.
+ */
 class UrlClient {
 
 public:
 
     struct Options {
-        uint32_t numberOfThreads = 4;
+        uint32_t maxActiveTasks = 20;
+        uint32_t maxActiveTasksPerHost = 6;
         uint32_t connectionTimeoutMs = 3000;
         uint32_t requestTimeoutMs = 30000;
     };
@@ -27,35 +39,69 @@ public:
 
     void cancelRequest(UrlRequestHandle request);
 
+    // Lower values are started first; new requests have priority 0.
+    void setRequestPriority(UrlRequestHandle request, float priority);
+
 private:
 
     struct Request {
-        std::string url;
-        UrlCallback callback;
         UrlRequestHandle handle;
-        bool canceled;
+        UrlCallback callback;
+        float priority;
     };
 
     using Response = UrlResponse;
 
+    // One transfer per distinct URL, shared by all requests for it.
     struct Task {
-        Request request;
+        std::string url;
+        std::string host;
+        std::vector<Request> requests;
         std::vector<char> content;
+        char error[256] = {0};
+        // Minimum priority of the requests
+        float priority = 0;
+        // Insertion order, for equal priorities
+        uint64_t order = 0;
+        void* handle = nullptr;
+        bool canceled = false;
+
+        void updatePriority();
     };
 
     static Response getCanceledResponse();
     static size_t curlWriteCallback(char* ptr, size_t size, size_t n, void* user);
-    static int curlProgressCallback(void* user, double dltotal, double dlnow, double ultotal, double ulnow);
 
-    void curlLoop(uint32_t index);
+    void curlLoop();
+    void startPendingTasks();
+    void removeCanceledTasks();
+    void finishTask(void* handle, int result);
+    void wakeLoop();
 
-    std::vector<std::thread> m_threads;
-    std::vector<Task> m_tasks;
-    std::vector<Request> m_requests;
-    std::condition_variable m_requestCondition;
-    std::mutex m_requestMutex;
-    Options m_options;
+    void* initEasyHandle();
+
+    std::thread m_thread;
+
+    // Guards all members below which are not marked as loop-thread only.
+    std::mutex m_mutex;
+    std::unordered_map<std::string, std::unique_ptr<Task>> m_tasks;
+    std::unordered_map<UrlRequestHandle, Task*> m_requests;
+    std::vector<Task*> m_pending;
+    std::unordered_map<std::string, uint32_t> m_activePerHost;
+    uint32_t m_active = 0;
+    bool m_hasCanceledTasks = false;
     UrlRequestHandle m_requestCount = 0;
+    uint64_t m_taskCount = 0;
+
+    // Loop-thread only
+    void* m_multi = nullptr;
+    void* m_share = nullptr;
+    std::vector<void*> m_freeHandles;
+
+    // Pipe to wake up the loop thread from curl_multi_wait
+    int m_wakeFds[2] = {-1, -1};
+
+    Options m_options;
     bool m_keepRunning = false;
 };
 
@@ -4,6 +4,7 @@
 #import <UIKit/UIKit.h>
 
 #include "iosPlatform.h"
+#include "gl/hardware.h"
 #include "log.h"
 #include <cstdarg>
 #include <cstdio>
@@ -27,7 +28,8 @@ void setCurrentThreadPriority(int priority) {
 }
 
 void initGLExtensions() {
-    // No-op
+    // Not available in ES 2.0
+    Hardware::supportsProgramBinary = false;
 }
 
 iOSPlatform::iOSPlatform(__weak TGMapView* _mapView) :
@@ -75,6 +75,10 @@ void LinuxPlatform::cancelUrlRequest(UrlRequestHandle _request) {
     m_urlClient.cancelRequest(_request);
 }
 
+void LinuxPlatform::setUrlRequestPriority(UrlRequestHandle _request, float _priority) {
+    m_urlClient.setRequestPriority(_request, _priority);
+}
+
 LinuxPlatform::~LinuxPlatform() {}
 
 void setCurrentThreadPriority(int priority) {
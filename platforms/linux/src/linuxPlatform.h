@@ -20,6 +20,7 @@ public:
             const std::string& _face) const override;
     UrlRequestHandle startUrlRequest(Url _url, UrlCallback _callback) override;
     void cancelUrlRequest(UrlRequestHandle _request) override;
+    void setUrlRequestPriority(UrlRequestHandle _request, float _priority) override;
 
 protected:
 
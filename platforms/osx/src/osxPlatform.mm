@@ -27,6 +27,8 @@ void setCurrentThreadPriority(int priority) {
 
 void initGLExtensions() {
     Tangram::Hardware::supportsMapBuffer = true;
+    // Not available in the legacy GL context
+    Tangram::Hardware::supportsProgramBinary = false;
 }
 
 void OSXPlatform::requestRender() const {
@@ -119,7 +119,7 @@ int main(int argc, char **argv) {
     LaunchOptions options = getLaunchOptions(argc, argv);
 
     UrlClient::Options urlClientOptions;
-    urlClientOptions.numberOfThreads = 4;
+    urlClientOptions.maxActiveTasks = 20;
 
     platform = std::make_shared<RpiPlatform>(urlClientOptions);
 
@@ -72,6 +72,10 @@ void RpiPlatform::cancelUrlRequest(UrlRequestHandle _request) {
     m_urlClient.cancelRequest(_request);
 }
 
+void RpiPlatform::setUrlRequestPriority(UrlRequestHandle _request, float _priority) {
+    m_urlClient.setRequestPriority(_request, _priority);
+}
+
 RpiPlatform::~RpiPlatform() {}
 
 void setCurrentThreadPriority(int priority) {
@@ -79,7 +83,8 @@ void setCurrentThreadPriority(int priority) {
 }
 
 void initGLExtensions() {
-    // no-op
+    // Program binaries are not loaded
+    Hardware::supportsProgramBinary = false;
 }
 
 } // namespace Tangram
@@ -18,6 +18,7 @@ public:
     std::vector<FontSourceHandle> systemFontFallbacksHandle() const override;
     UrlRequestHandle startUrlRequest(Url _url, UrlCallback _callback) override;
     void cancelUrlRequest(UrlRequestHandle _url) override;
+    void setUrlRequestPriority(UrlRequestHandle _request, float _priority) override;
     FontSourceHandle systemFont(const std::string& _name, const std::string& _weight,
             const std::string& _face) const override;
 
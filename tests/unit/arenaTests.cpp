@@ -0,0 +1,87 @@
+#include "catch.hpp"
+
+#include "util/arena.h"
+
+#include <cstdint>
+
+using namespace Tangram;
+
+TEST_CASE("Arena allocations are aligned and do not overlap", "[Arena]") {
+    Arena arena(256);
+
+    char* a = static_cast<char*>(arena.allocate(3, 1));
+    double* b = static_cast<double*>(arena.allocate(sizeof(double), alignof(double)));
+    char* c = static_cast<char*>(arena.allocate(100, 16));
+
+    REQUIRE(reinterpret_cast<uintptr_t>(b) % alignof(double) == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(c) % 16 == 0);
+    REQUIRE(reinterpret_cast<char*>(b) >= a + 3);
+    REQUIRE(c >= reinterpret_cast<char*>(b + 1));
+
+    // Larger than a block
+    char* d = static_cast<char*>(arena.allocate(1000));
+    REQUIRE(d != nullptr);
+    REQUIRE(arena.stats().blocks == 2);
+    REQUIRE(arena.used() >= 1103);
+}
+
+TEST_CASE("Arena rewinds to a marker", "[Arena]") {
+    Arena arena(256);
+
+    arena.allocate(16);
+    auto marker = arena.mark();
+    size_t used = arena.used();
+
+    void* a = arena.allocate(64);
+    arena.allocate(512);
+    REQUIRE(arena.used() > used);
+
+    arena.rewind(marker);
+    REQUIRE(arena.used() == used);
+
+    // The same memory is handed out again
+    REQUIRE(arena.allocate(64) == a);
+}
+
+TEST_CASE("Arena reset merges blocks up to the retained limit", "[Arena]") {
+    Arena arena(256, 4096);
+
+    for (int i = 0; i < 8; i++) { arena.allocate(200); }
+    REQUIRE(arena.stats().blocks == 8);
+
+    arena.reset();
+    auto stats = arena.stats();
+    REQUIRE(stats.used == 0);
+    REQUIRE(stats.blocks == 1);
+    REQUIRE(stats.capacity == 8 * 256);
+    REQUIRE(stats.peak >= 8 * 200);
+    REQUIRE(stats.resets == 1);
+
+    // The next round fits into one block
+    for (int i = 0; i < 8; i++) { arena.allocate(200); }
+    REQUIRE(arena.stats().blocks == 1);
+
+    // Huge rounds are not retained
+    arena.allocate(10000);
+    arena.reset();
+    REQUIRE(arena.stats().capacity <= 4096);
+}
+
+TEST_CASE("ArenaVector allocates from the arena", "[Arena]") {
+    Arena arena;
+
+    {
+        ArenaVector<int> values(&arena);
+        for (int i = 0; i < 1000; i++) { values.push_back(i); }
+
+        REQUIRE(values[999] == 999);
+        REQUIRE(arena.used() >= 1000 * sizeof(int));
+    }
+
+    // Without arena the heap is used
+    ArenaVector<int> heap;
+    size_t used = arena.used();
+    heap.assign(100, 1);
+    REQUIRE(arena.used() == used);
+    REQUIRE(heap.size() == 100);
+}
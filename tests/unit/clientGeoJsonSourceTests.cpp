@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "data/clientGeoJsonSource.h"
+#include "data/properties.h"
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "tile/tileTask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+class TestSource : public ClientGeoJsonSource {
+public:
+    TestSource() : ClientGeoJsonSource(nullptr, "test", "") {}
+
+    // Names of the features in @_tileId
+    std::vector<std::string> names(TileID _tileId) {
+        auto data = parse(*createTask(_tileId, 0));
+
+        std::vector<std::string> result;
+        if (!data) { return result; }
+
+        REQUIRE(data->layers.size() == 1);
+        for (auto& feature : data->layers[0].features) {
+            result.push_back(feature.props.getString("name"));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+static Properties named(const std::string& _name) {
+    Properties props;
+    props.set("name", _name);
+    return props;
+}
+
+// Tile at @_zoom that contains @_point
+static TileID tileAt(LngLat _point, int _zoom) {
+    double n = 1 << _zoom;
+    double lat = _point.latitude * M_PI / 180.0;
+    double x = (_point.longitude + 180.0) / 360.0 * n;
+    double y = (1.0 - std::log(std::tan(lat) + 1.0 / std::cos(lat)) / M_PI) * 0.5 * n;
+    return TileID(int(x), int(y), _zoom);
+}
+
+static const LngLat west(-10.1, 10.1);
+static const LngLat east(20.1, -20.1);
+
+TEST_CASE("ClientGeoJsonSource parses the features of a tile", "[ClientGeoJsonSource]") {
+    auto source = std::make_shared<TestSource>();
+
+    CHECK(source->names(tileAt(west, 10)).empty());
+
+    source->addPoint(named("point"), west);
+    source->addLine(named("line"), { east, { east.longitude + 0.01, east.latitude } });
+
+    CHECK(source->names(tileAt(west, 10)) == std::vector<std::string>({ "point" }));
+    CHECK(source->names(tileAt(east, 10)) == std::vector<std::string>({ "line" }));
+    CHECK(source->names(TileID(0, 0, 10)).empty());
+
+    // Tiles of the shared low zoom index
+    CHECK(source->names(TileID(0, 0, 0)) == std::vector<std::string>({ "line", "point" }));
+    CHECK(source->names(tileAt(west, 3)) == std::vector<std::string>({ "point" }));
+}
+
+TEST_CASE("ClientGeoJsonSource only changes the generation of affected tiles", "[ClientGeoJsonSource]") {
+    auto source = std::make_shared<TestSource>();
+
+    uint64_t point = source->addPoint(named("point"), west);
+    source->addPoint(named("other"), east);
+
+    auto westTile = tileAt(west, 10);
+    auto eastTile = tileAt(east, 10);
+    int64_t westGeneration = source->generation(westTile);
+    int64_t eastGeneration = source->generation(eastTile);
+
+    CHECK(source->updatePoint(point, named("moved"), west));
+    CHECK(source->generation(westTile) > westGeneration);
+    CHECK(source->generation(eastTile) == eastGeneration);
+    CHECK(source->names(westTile) == std::vector<std::string>({ "moved" }));
+
+    westGeneration = source->generation(westTile);
+    CHECK(source->removeFeature(point));
+    CHECK_FALSE(source->removeFeature(point));
+    CHECK_FALSE(source->updatePoint(point, named("point"), west));
+    CHECK(source->generation(westTile) > westGeneration);
+    CHECK(source->generation(eastTile) == eastGeneration);
+    CHECK(source->names(westTile).empty());
+}
+
+TEST_CASE("ClientGeoJsonSource low zoom tiles follow changes", "[ClientGeoJsonSource]") {
+    auto source = std::make_shared<TestSource>();
+    TileID root(0, 0, 0);
+
+    uint64_t point = source->addPoint(named("point"), west);
+    CHECK(source->names(root) == std::vector<std::string>({ "point" }));
+    CHECK(source->names(root) == std::vector<std::string>({ "point" }));
+
+    source->addPoint(named("other"), east);
+    CHECK(source->names(root) == std::vector<std::string>({ "other", "point" }));
+
+    source->updatePoint(point, named("moved"), east);
+    CHECK(source->names(tileAt(west, 5)).empty());
+    CHECK(source->names(tileAt(east, 5)) == std::vector<std::string>({ "moved", "other" }));
+
+    source->removeFeature(point);
+    CHECK(source->names(root) == std::vector<std::string>({ "other" }));
+
+    source->clearData();
+    CHECK(source->names(root).empty());
+}
@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include "gl/texture.h"
+#include "style/colorPalette.h"
+#include "util/geom.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace Tangram;
+
+TEST_CASE("ColorPalette stores each color pair once", "[ColorPalette]") {
+    ColorPalette palette;
+
+    CHECK(palette.add(0xff0000ff, 1) == 0);
+    CHECK(palette.add(0xff00ff00, 1) == 1);
+    CHECK(palette.add(0xff0000ff, 2) == 2);
+    CHECK(palette.add(0xff0000ff, 1) == 0);
+    CHECK(palette.size() == 3);
+
+    auto texture = palette.createTexture();
+    CHECK(texture->width() == 6);
+    CHECK(texture->height() == 1);
+
+    palette.clear();
+    CHECK(palette.size() == 0);
+    CHECK(palette.add(0xff00ff00, 1) == 0);
+}
+
+TEST_CASE("ColorPalette wraps entries into texture rows", "[ColorPalette]") {
+    ColorPalette palette;
+
+    for (GLuint i = 0; i < 200; i++) { palette.add(i, 0); }
+
+    auto texture = palette.createTexture();
+    CHECK(texture->width() == ColorPalette::WIDTH);
+    CHECK(texture->height() == 2);
+}
+
+TEST_CASE("ColorPalette grows beyond 16 bit indices", "[ColorPalette]") {
+    ColorPalette palette;
+
+    GLuint index = 0;
+    while (palette.size() < ColorPalette::MAX_SHORT_ENTRIES) { index = palette.add(palette.size(), 1); }
+    CHECK(index == ColorPalette::MAX_SHORT_ENTRIES - 1);
+    CHECK_FALSE(palette.needsWideIndex());
+
+    const GLuint count = 300000;
+    while (palette.size() < count) { index = palette.add(palette.size(), 1); }
+    CHECK(index == count - 1);
+    CHECK(palette.needsWideIndex());
+    CHECK(palette.add(count - 1, 1) == count - 1);
+
+    // Rows get wider to stay within the texture size limit
+    auto texture = palette.createTexture();
+    CHECK(texture->height() <= ColorPalette::MAX_SIZE);
+    CHECK(texture->width() % 2 == 0);
+    CHECK(size_t(texture->width()) * texture->height() >= 2 * count);
+}
+
+TEST_CASE("ColorPalette merge remaps indices of the merged palette", "[ColorPalette]") {
+    ColorPalette a, b;
+    a.add(10, 0);
+    a.add(20, 0);
+
+    b.add(30, 0);
+    b.add(10, 0);
+
+    auto indices = a.merge(b);
+    REQUIRE(indices.size() == 2);
+    CHECK(indices[0] == 2);
+    CHECK(indices[1] == 0);
+    CHECK(a.size() == 3);
+
+    struct Vertex { uint16_t palette; };
+    std::vector<Vertex> vertices = { {1}, {0}, {1} };
+    ColorPalette::remap(vertices, 1, indices, std::true_type());
+    CHECK(vertices[0].palette == 1);
+    CHECK(vertices[1].palette == 2);
+    CHECK(vertices[2].palette == 0);
+}
+
+TEST_CASE("Octahedral normal encoding round trip", "[ColorPalette]") {
+    std::vector<glm::vec3> normals = {
+        { 0, 0, 1 }, { 0, 0, -1 }, { 1, 0, 0 }, { 0, -1, 0 },
+        glm::normalize(glm::vec3(1, 2, 3)), glm::normalize(glm::vec3(-1, 2, -3)),
+        glm::normalize(glm::vec3(-3, -1, -0.5)),
+    };
+
+    for (auto& n : normals) {
+        glm::vec2 e = octEncode(n);
+        CHECK(std::abs(e.x) <= 1.f);
+        CHECK(std::abs(e.y) <= 1.f);
+
+        // Quantized to signed bytes as in compact vertices
+        glm::vec2 q = glm::round(e * 127.f) / 127.f;
+        CHECK(glm::dot(octDecode(q), n) > 0.999f);
+    }
+}
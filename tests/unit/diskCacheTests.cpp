@@ -0,0 +1,245 @@
+#include "catch.hpp"
+
+#include "data/diskCacheDataSource.h"
+#include "data/tileSource.h"
+#include "tile/tileID.h"
+#include "tile/tileTask.h"
+
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Tangram;
+
+static const char* SEGMENT_PATH = "diskCacheTest.seg";
+static const char* INDEX_PATH = "diskCacheTest.seg.idx";
+static const char* TEST_URL = "https://tiles.test/{z}/{x}/{y}.mvt";
+
+static std::vector<char> tileBytes(const TileID& _id, size_t _size = 1024, char _seed = 0) {
+    std::vector<char> bytes(_size);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        bytes[i] = char(_id.x * 31 + _id.y * 17 + _id.z + i + _seed);
+    }
+    return bytes;
+}
+
+// Serves generated tile data and counts the requests
+struct MockDataSource : TileSource::DataSource {
+    int loadCount = 0;
+    size_t tileSize = 1024;
+    char seed = 0;
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        loadCount++;
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+        task.rawTileData = std::make_shared<std::vector<char>>(tileBytes(_task->tileId(), tileSize, seed));
+        _cb.func(_task);
+        return true;
+    }
+};
+
+struct TestCache {
+    std::shared_ptr<TileSource> source = std::make_shared<TileSource>("test", nullptr);
+    std::unique_ptr<DiskCacheDataSource> cache;
+    MockDataSource* mock;
+
+    TestCache(size_t _maxSize = 16 * 1024 * 1024, size_t _tileSize = 1024, const std::string& _url = TEST_URL) {
+        cache = std::make_unique<DiskCacheDataSource>(SEGMENT_PATH, _maxSize, _url);
+        auto next = std::make_unique<MockDataSource>();
+        next->tileSize = _tileSize;
+        mock = next.get();
+        cache->setNext(std::move(next));
+    }
+
+    std::shared_ptr<std::vector<char>> load(TileID _id) {
+        auto task = std::make_shared<BinaryTileTask>(_id, source, -1);
+
+        std::promise<void> loaded;
+        REQUIRE(cache->loadTileData(task, {[&](std::shared_ptr<TileTask>) { loaded.set_value(); }}));
+        loaded.get_future().wait();
+
+        return task->rawTileData;
+    }
+};
+
+static void removeCacheFiles() {
+    remove(SEGMENT_PATH);
+    remove(INDEX_PATH);
+}
+
+static size_t fileSize(const char* _path) {
+    struct stat st;
+    return stat(_path, &st) == 0 ? st.st_size : 0;
+}
+
+TEST_CASE("DiskCacheDataSource serves stored tiles after reopening", "[DiskCache]") {
+    removeCacheFiles();
+
+    {
+        TestCache test;
+        for (int i = 0; i < 10; i++) {
+            auto data = test.load(TileID(i, 1, 5));
+            REQUIRE(data);
+            CHECK(*data == tileBytes(TileID(i, 1, 5)));
+        }
+        CHECK(test.mock->loadCount == 10);
+    }
+
+    {
+        TestCache test;
+        for (int i = 0; i < 10; i++) {
+            auto data = test.load(TileID(i, 1, 5));
+            REQUIRE(data);
+            CHECK(*data == tileBytes(TileID(i, 1, 5)));
+        }
+        CHECK(test.mock->loadCount == 0);
+
+        test.load(TileID(20, 1, 5));
+        CHECK(test.mock->loadCount == 1);
+    }
+
+    removeCacheFiles();
+}
+
+TEST_CASE("DiskCacheDataSource drops incomplete records after a crash", "[DiskCache]") {
+    removeCacheFiles();
+
+    {
+        TestCache test;
+        for (int i = 0; i < 5; i++) { test.load(TileID(i, 2, 5)); }
+    }
+
+    // Lose the index and cut off the last record, as if the process
+    // was killed while appending it
+    remove(INDEX_PATH);
+    REQUIRE(truncate(SEGMENT_PATH, fileSize(SEGMENT_PATH) - 100) == 0);
+
+    {
+        TestCache test;
+        for (int i = 0; i < 5; i++) {
+            auto data = test.load(TileID(i, 2, 5));
+            REQUIRE(data);
+            CHECK(*data == tileBytes(TileID(i, 2, 5)));
+        }
+        // Only the truncated tile is loaded again
+        CHECK(test.mock->loadCount == 1);
+    }
+
+    removeCacheFiles();
+}
+
+TEST_CASE("DiskCacheDataSource compacts the segment to its size limit", "[DiskCache]") {
+    removeCacheFiles();
+
+    const size_t maxSize = 64 * 1024;
+    const size_t tileSize = 4 * 1024;
+
+    TestCache test(maxSize, tileSize);
+    for (int i = 0; i < 100; i++) {
+        test.load(TileID(i, 3, 8));
+        test.cache->flush();
+        CHECK(fileSize(SEGMENT_PATH) <= maxSize);
+    }
+    test.mock->loadCount = 0;
+
+    // The most recently used tiles are kept
+    for (int i = 99; i > 95; i--) {
+        auto data = test.load(TileID(i, 3, 8));
+        REQUIRE(data);
+        CHECK(*data == tileBytes(TileID(i, 3, 8), tileSize));
+    }
+    CHECK(test.mock->loadCount == 0);
+
+    test.cache.reset();
+    removeCacheFiles();
+}
+
+TEST_CASE("DiskCacheDataSource ignores index entries pointing to other tiles", "[DiskCache]") {
+    removeCacheFiles();
+
+    const std::string savedIndex = std::string(INDEX_PATH) + ".saved";
+
+    {
+        TestCache test;
+        for (int i = 0; i < 5; i++) {
+            test.load(TileID(i, 4, 5));
+            test.cache->flush();
+        }
+    }
+    REQUIRE(rename(INDEX_PATH, savedIndex.c_str()) == 0);
+    remove(SEGMENT_PATH);
+
+    // Write the same tiles in reverse order, so that the segment has the same
+    // size but the old index points each tile to the record of another one
+    {
+        TestCache test;
+        for (int i = 4; i >= 0; i--) {
+            test.load(TileID(i, 4, 5));
+            test.cache->flush();
+        }
+    }
+    REQUIRE(rename(savedIndex.c_str(), INDEX_PATH) == 0);
+
+    {
+        TestCache test;
+        for (int i = 0; i < 5; i++) {
+            auto data = test.load(TileID(i, 4, 5));
+            REQUIRE(data);
+            CHECK(*data == tileBytes(TileID(i, 4, 5)));
+        }
+        // Only the tile in the middle is still at its old offset
+        CHECK(test.mock->loadCount == 4);
+    }
+
+    removeCacheFiles();
+}
+
+TEST_CASE("DiskCacheDataSource keeps the tiles of sources sharing a segment apart", "[DiskCache]") {
+    removeCacheFiles();
+
+    const size_t maxSize = 16 * 1024 * 1024;
+    const TileID id(3, 5, 6);
+
+    {
+        TestCache first(maxSize, 1024, "https://a.test/{z}/{x}/{y}.mvt");
+        TestCache second(maxSize, 1024, "https://b.test/{z}/{x}/{y}.mvt");
+        second.mock->seed = 1;
+
+        first.load(id);
+        first.cache->flush();
+
+        // Not served from the record of the first source
+        auto data = second.load(id);
+        REQUIRE(data);
+        CHECK(*data == tileBytes(id, 1024, 1));
+        CHECK(second.mock->loadCount == 1);
+    }
+
+    {
+        TestCache first(maxSize, 1024, "https://a.test/{z}/{x}/{y}.mvt");
+        TestCache second(maxSize, 1024, "https://b.test/{z}/{x}/{y}.mvt");
+
+        auto data = first.load(id);
+        REQUIRE(data);
+        CHECK(*data == tileBytes(id, 1024, 0));
+
+        data = second.load(id);
+        REQUIRE(data);
+        CHECK(*data == tileBytes(id, 1024, 1));
+
+        CHECK(first.mock->loadCount == 0);
+        CHECK(second.mock->loadCount == 0);
+
+        // A changed URL template does not get the old tiles
+        TestCache changed(maxSize, 1024, "https://a.test/v2/{z}/{x}/{y}.mvt");
+        changed.load(id);
+        CHECK(changed.mock->loadCount == 1);
+    }
+
+    removeCacheFiles();
+}
@@ -0,0 +1,153 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "data/propertyKeys.h"
+#include "data/tileData.h"
+#include "scene/filterProgram.h"
+#include "scene/filters.h"
+#include "scene/styleContext.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+static Feature makeFeature(bool _keyIds, std::vector<std::pair<std::string, Value>> _props) {
+    Feature feature;
+    if (_keyIds) {
+        std::vector<PropertyItem> items;
+        for (auto& prop : _props) {
+            int32_t id = PropertyKeys::intern(prop.first);
+            items.emplace_back(prop.first, prop.second, id);
+        }
+        std::sort(items.begin(), items.end());
+        feature.props.setSorted(std::move(items));
+    } else {
+        for (auto& prop : _props) {
+            if (prop.second.is<double>()) {
+                feature.props.set(prop.first, prop.second.get<double>());
+            } else {
+                feature.props.set(prop.first, prop.second.get<std::string>());
+            }
+        }
+    }
+    return feature;
+}
+
+static std::vector<Feature> makeFeatures(bool _keyIds) {
+    return {
+        makeFeature(_keyIds, {{"name", Value("civic")}, {"brand", Value("honda")},
+                              {"wheel", Value(4.)}, {"type", Value("car")}}),
+        makeFeature(_keyIds, {{"name", Value("bmw320i")}, {"brand", Value("bmw")},
+                              {"wheel", Value(4.)}, {"series", Value("3")},
+                              {"serial", Value(4398046511104.)}}),
+        makeFeature(_keyIds, {{"name", Value("cb1100")}, {"brand", Value("honda")},
+                              {"wheel", Value(2.)}, {"type", Value("bike")}}),
+        makeFeature(_keyIds, {}),
+    };
+}
+
+TEST_CASE("FilterProgram matches like Filter::eval", "[filters][core]") {
+    StyleContext ctx;
+    ctx.setKeyword("$geometry", Value("line"));
+    ctx.setKeyword("$zoom", Value(12.));
+
+    std::vector<Filter> filters = {
+        Filter(),
+        Filter::MatchEquality("brand", { Value("honda") }),
+        Filter::MatchEquality("wheel", { Value(4.) }),
+        Filter::MatchEquality("serial", { Value(4398046511104.) }),
+        Filter::MatchEquality("brand", { Value("bmw"), Value("honda"), Value(4.) }),
+        Filter::MatchEquality("wheel", { Value("4"), Value(2.) }),
+        Filter::MatchEquality("$geometry", { Value("line"), Value("point") }),
+        Filter::MatchEquality("$zoom", { Value(12.) }),
+        Filter::MatchRange("wheel", 3, 5, false),
+        Filter::MatchRange("$zoom", 10, 12, false),
+        Filter::MatchExistence("type", true),
+        Filter::MatchExistence("type", false),
+        Filter::MatchAll({}),
+        Filter::MatchAny({}),
+        Filter::MatchNone({}),
+        Filter::MatchAll({ Filter::MatchEquality("brand", { Value("honda") }),
+                           Filter::MatchExistence("type", true),
+                           Filter::MatchRange("wheel", 3, 10, false) }),
+        Filter::MatchAny({ Filter::MatchEquality("series", { Value("3") }),
+                           Filter::MatchAll({ Filter::MatchEquality("type", { Value("bike") }),
+                                              Filter::MatchRange("$zoom", 0, 20, false) }) }),
+        Filter::MatchNone({ Filter::MatchEquality("brand", { Value("bmw") }),
+                            Filter::MatchAny({ Filter::MatchExistence("type", false),
+                                               Filter::MatchEquality("wheel", { Value(2.) }) }) }),
+    };
+
+    for (bool keyIds : { false, true }) {
+        auto features = makeFeatures(keyIds);
+        for (size_t i = 0; i < filters.size(); i++) {
+            FilterProgram program(filters[i]);
+            for (size_t j = 0; j < features.size(); j++) {
+                INFO("filter " << i << " feature " << j << " keyIds " << keyIds);
+                CHECK(program.eval(features[j], ctx) == filters[i].eval(features[j], ctx));
+            }
+        }
+    }
+}
+
+TEST_CASE("FilterProgram matches like Filter::eval on random filter trees", "[filters][core]") {
+    StyleContext ctx;
+    ctx.setKeyword("$zoom", Value(8.));
+
+    std::mt19937 random(42);
+    auto pick = [&](int n) { return int(random() % n); };
+
+    const std::vector<std::string> keys = { "name", "brand", "wheel", "type", "series", "kind" };
+    const std::vector<Value> values = { Value("civic"), Value("honda"), Value("bmw"),
+                                        Value("bike"), Value(4.), Value(2.), Value("3") };
+
+    std::function<Filter(int)> generate = [&](int depth) -> Filter {
+        int kind = pick(depth > 0 ? 7 : 4);
+        const auto& key = keys[pick(keys.size())];
+        switch (kind) {
+        case 0: return Filter::MatchEquality(key, { values[pick(values.size())] });
+        case 1: return Filter::MatchEquality(key, { values[pick(values.size())],
+                                                    values[pick(values.size())],
+                                                    values[pick(values.size())] });
+        case 2: return Filter::MatchRange(pick(2) ? key : "$zoom", pick(5), 2 + pick(10), false);
+        case 3: return Filter::MatchExistence(key, pick(2));
+        default: {
+            std::vector<Filter> operands;
+            for (int i = 0, n = 1 + pick(3); i < n; i++) { operands.push_back(generate(depth - 1)); }
+            if (kind == 4) { return Filter::MatchAll(std::move(operands)); }
+            if (kind == 5) { return Filter::MatchAny(std::move(operands)); }
+            return Filter::MatchNone(std::move(operands));
+        }
+        }
+    };
+
+    auto withIds = makeFeatures(true);
+    auto withoutIds = makeFeatures(false);
+
+    for (int i = 0; i < 500; i++) {
+        Filter filter = generate(3);
+        FilterProgram program(filter);
+        for (size_t j = 0; j < withIds.size(); j++) {
+            bool expected = filter.eval(withoutIds[j], ctx);
+            CHECK(program.eval(withoutIds[j], ctx) == expected);
+            CHECK(program.eval(withIds[j], ctx) == expected);
+        }
+    }
+}
+
+TEST_CASE("PropertyKeys returns stable ids", "[filters][core]") {
+    int32_t a = PropertyKeys::intern("property-keys-test-a");
+    int32_t b = PropertyKeys::intern("property-keys-test-b");
+    CHECK(a != b);
+    CHECK(PropertyKeys::intern("property-keys-test-a") == a);
+
+    std::vector<int32_t> ids;
+    PropertyKeys::intern({ "property-keys-test-b", "property-keys-test-a" }, ids);
+    REQUIRE(ids.size() == 2);
+    CHECK(ids[0] == b);
+    CHECK(ids[1] == a);
+}
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+
+#include "data/formats/geoJson.h"
+#include "data/formats/topoJson.h"
+#include "data/tileData.h"
+#include "data/tileSource.h"
+#include "tile/tileTask.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+static std::shared_ptr<TileTask> makeTask(TileID _tileId, const char* _json) {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    auto task = std::make_shared<BinaryTileTask>(_tileId, source, -1);
+    task->rawTileData = std::make_shared<std::vector<char>>(_json, _json + std::strlen(_json));
+    return task;
+}
+
+static bool near(Point _a, Point _b) {
+    return std::abs(_a.x - _b.x) < 1e-5 && std::abs(_a.y - _b.y) < 1e-5;
+}
+
+TEST_CASE("GeoJson parses features with members in any order", "[GeoJson]") {
+    TileID tileId(0, 0, 0);
+    GeoJson::TileTransform transform(tileId);
+
+    auto task = makeTask(tileId, R"({
+        "features": [
+            { "geometry": { "coordinates": [10, 20, 100], "type": "Point" },
+              "properties": { "name": "a", "height": 5, "open": true, "tags": { "x": 1 } },
+              "type": "Feature" },
+            { "type": "Feature", "properties": {},
+              "geometry": { "type": "LineString", "coordinates": [[0, 0], [10, 10]] } },
+            { "type": "Feature",
+              "geometry": { "type": "Polygon",
+                            "coordinates": [[[0, 0], [10, 0], [10, 10], [0, 0]],
+                                            [[1, 1], [2, 1], [2, 2], [1, 1]]] } },
+            { "type": "Feature",
+              "geometry": { "type": "MultiPolygon",
+                            "coordinates": [[[[0, 0], [1, 0], [1, 1], [0, 0]]],
+                                            [[[5, 5], [6, 5], [6, 6], [5, 5]]]] } },
+            { "type": "Feature", "geometry": { "type": "GeometryCollection", "geometries": [] } }
+        ],
+        "type": "FeatureCollection"
+    })");
+
+    auto tileData = GeoJson::parseTile(*task, 0);
+
+    REQUIRE(tileData->layers.size() == 1);
+    auto& features = tileData->layers[0].features;
+    REQUIRE(features.size() == 4);
+
+    CHECK(features[0].geometryType == GeometryType::points);
+    REQUIRE(features[0].points.size() == 1);
+    CHECK(near(features[0].points[0], transform(10, 20)));
+    CHECK(features[0].props.getString("name") == "a");
+    CHECK(features[0].props.getNumber("height") == 5);
+    CHECK(features[0].props.getNumber("open") == 1);
+    CHECK(!features[0].props.contains("tags"));
+
+    CHECK(features[1].geometryType == GeometryType::lines);
+    REQUIRE(features[1].lines.size() == 1);
+    CHECK(features[1].lines[0].size() == 2);
+    CHECK(near(features[1].lines[0][1], transform(10, 10)));
+
+    CHECK(features[2].geometryType == GeometryType::polygons);
+    REQUIRE(features[2].polygons.size() == 1);
+    CHECK(features[2].polygons[0].size() == 2);
+    CHECK(features[2].polygons[0][1].size() == 4);
+
+    REQUIRE(features[3].polygons.size() == 2);
+    CHECK(near(features[3].polygons[1][0][0], transform(5, 5)));
+}
+
+TEST_CASE("GeoJson skips collections that are not used", "[GeoJson]") {
+    auto task = makeTask(TileID(0, 0, 0), R"({
+        "water": { "type": "FeatureCollection", "features": [
+            { "type": "Feature", "geometry": { "type": "Point", "coordinates": [0, 0] } } ] },
+        "roads": { "features": [
+            { "type": "Feature", "geometry": { "type": "Point", "coordinates": [1, 1] } } ],
+            "type": "FeatureCollection" },
+        "meta": { "type": "Topology" }
+    })");
+
+    auto tileData = GeoJson::parseTile(*task, 0);
+    REQUIRE(tileData->layers.size() == 2);
+    CHECK(tileData->layers[0].name == "water");
+    CHECK(tileData->layers[1].name == "roads");
+
+    tileData = GeoJson::parseTile(*task, 0, { "roads" });
+    REQUIRE(tileData->layers.size() == 1);
+    CHECK(tileData->layers[0].name == "roads");
+    CHECK(tileData->layers[0].features.size() == 1);
+}
+
+TEST_CASE("GeoJson returns no layers for invalid JSON", "[GeoJson]") {
+    auto task = makeTask(TileID(0, 0, 0), R"({ "type": "FeatureCollection", "features": [ )");
+
+    auto tileData = GeoJson::parseTile(*task, 0);
+    REQUIRE(tileData);
+    CHECK(tileData->layers.empty());
+}
+
+TEST_CASE("TopoJson resolves arcs read after the objects", "[TopoJson]") {
+    TileID tileId(0, 0, 0);
+    GeoJson::TileTransform transform(tileId);
+
+    auto task = makeTask(tileId, R"({
+        "type": "Topology",
+        "objects": {
+            "roads": { "type": "GeometryCollection", "geometries": [
+                { "type": "LineString", "arcs": [0, 1], "properties": { "kind": "major" } },
+                { "type": "LineString", "arcs": [-1] },
+                { "type": "Point", "coordinates": [4, 4] } ] },
+            "water": { "type": "GeometryCollection", "geometries": [
+                { "type": "Polygon", "arcs": [[2]] } ] }
+        },
+        "arcs": [ [[0, 0], [1, 0]], [[1, 0], [0, 1]], [[0, 0], [2, 0], [0, 2], [-2, -2]] ],
+        "transform": { "scale": [2, 2], "translate": [-10, -10] }
+    })");
+
+    auto tileData = TopoJson::parseTile(*task, 0);
+    REQUIRE(tileData->layers.size() == 2);
+
+    auto& roads = tileData->layers[0].features;
+    REQUIRE(roads.size() == 3);
+
+    // Delta decoded arcs (0,0) (1,0) and (1,0) (1,1), shared point dropped
+    REQUIRE(roads[0].lines.size() == 1);
+    auto& line = roads[0].lines[0];
+    REQUIRE(line.size() == 3);
+    CHECK(near(line[0], transform(-10, -10)));
+    CHECK(near(line[1], transform(-8, -10)));
+    CHECK(near(line[2], transform(-8, -8)));
+    CHECK(roads[0].props.getString("kind") == "major");
+
+    REQUIRE(roads[1].lines.size() == 1);
+    REQUIRE(roads[1].lines[0].size() == 2);
+    CHECK(near(roads[1].lines[0][0], transform(-8, -10)));
+
+    CHECK(roads[2].geometryType == GeometryType::points);
+    REQUIRE(roads[2].points.size() == 1);
+    CHECK(near(roads[2].points[0], transform(-2, -2)));
+
+    auto& water = tileData->layers[1].features;
+    REQUIRE(water.size() == 1);
+    REQUIRE(water[0].polygons.size() == 1);
+    CHECK(water[0].polygons[0][0].size() == 4);
+
+    tileData = TopoJson::parseTile(*task, 0, { "water" });
+    REQUIRE(tileData->layers.size() == 1);
+    CHECK(tileData->layers[0].name == "water");
+}
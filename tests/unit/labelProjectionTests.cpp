@@ -0,0 +1,161 @@
+#include "catch.hpp"
+#include "labels/curvedLabel.h"
+#include "labels/labelProjection.h"
+#include "labels/screenTransform.h"
+#include "labels/textLabel.h"
+#include "labels/textLabels.h"
+#include "style/textStyle.h"
+#include "util/geom.h"
+#include "view/view.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <random>
+
+using namespace Tangram;
+
+namespace {
+
+TextStyle projectionStyle("textStyle", nullptr);
+TextLabels projectionLabels(projectionStyle);
+Label::AABB projectionBounds(-256.f, -256.f, 768.f, 768.f);
+
+struct TestTransform {
+    ScreenTransform::Buffer buffer;
+    Range range;
+    ScreenTransform transform;
+    TestTransform() : transform(buffer, range) {}
+};
+
+// Tilted camera looking across the plane, so that far anchors end up behind it
+glm::mat4 perspectiveMVP() {
+    glm::mat4 proj = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 100.f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f));
+    return proj * view;
+}
+
+Label::Options labelOptions() {
+    Label::Options options;
+    options.anchors.anchor[0] = LabelProperty::Anchor::center;
+    options.anchors.count = 1;
+    return options;
+}
+
+TextLabel makeTextLabel(TextLabel::Coordinates _coordinates, Label::Type _type) {
+    return TextLabel(_coordinates, _type, labelOptions(), {}, {10, 10},
+                     projectionLabels, {}, TextLabelProperty::Align::none);
+}
+
+// Update @_label once with the matrix and once from batch projected anchors
+void requireSameTransform(Label& _label, const glm::mat4& _mvp, const ViewState& _viewState) {
+    TestTransform scalar, batch;
+
+    bool scalarValid = _label.update(_mvp, _viewState, &projectionBounds, scalar.transform);
+    glm::vec2 scalarCenter = _label.screenCenter();
+
+    LabelAnchors anchors;
+    REQUIRE(_label.anchors(anchors));
+
+    ProjectedAnchors projected;
+    projectAnchors(_mvp, _viewState.viewportSize, anchors, projected);
+
+    bool batchValid = _label.update(AnchorProjection(projected, 0), _viewState,
+                                    &projectionBounds, batch.transform);
+
+    REQUIRE(scalarValid == batchValid);
+    REQUIRE(scalar.transform.size() == batch.transform.size());
+
+    for (size_t i = 0; i < scalar.transform.size(); i++) {
+        REQUIRE(scalar.buffer.points[i].x == Approx(batch.buffer.points[i].x));
+        REQUIRE(scalar.buffer.points[i].y == Approx(batch.buffer.points[i].y));
+        REQUIRE(scalar.buffer.points[i].z == Approx(batch.buffer.points[i].z));
+    }
+    if (scalarValid) {
+        REQUIRE(scalarCenter.x == Approx(_label.screenCenter().x));
+        REQUIRE(scalarCenter.y == Approx(_label.screenCenter().y));
+    }
+}
+
+}
+
+TEST_CASE("Batch projection matches projection of single anchors", "[Core][Label][Projection]") {
+    glm::mat4 mvp = perspectiveMVP();
+    glm::vec2 screenSize(512.f, 512.f);
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(-2.f, 3.f);
+
+    // Not a multiple of the vector width, to cover the scalar tail
+    LabelAnchors anchors;
+    for (int i = 0; i < 1001; i++) {
+        anchors.push_back({ dist(rng), dist(rng) });
+    }
+
+    ProjectedAnchors batch, scalar;
+    projectAnchors(mvp, screenSize, anchors, batch);
+
+    scalar.resize(anchors.size());
+    projectAnchorsScalar(mvp, screenSize, anchors, scalar, 0, anchors.size());
+
+    size_t clipped = 0;
+    for (size_t i = 0; i < anchors.size(); i++) {
+        REQUIRE(batch.x[i] == Approx(scalar.x[i]));
+        REQUIRE(batch.y[i] == Approx(scalar.y[i]));
+        REQUIRE(batch.w[i] == Approx(scalar.w[i]));
+
+        AnchorProjection projection(batch, i);
+
+        bool behind = false;
+        glm::vec2 expected = worldToScreenSpace(mvp, glm::vec4(anchors.x[i], anchors.y[i], 0.f, 1.f),
+                                                screenSize, behind);
+
+        REQUIRE(projection.clipped(0) == behind);
+        if (behind) {
+            clipped++;
+            continue;
+        }
+        REQUIRE(projection.position(0).x == Approx(expected.x).epsilon(1e-4));
+        REQUIRE(projection.position(0).y == Approx(expected.y).epsilon(1e-4));
+    }
+
+    // The camera setup must produce anchors behind the camera
+    REQUIRE(clipped > 0);
+    REQUIRE(clipped < anchors.size());
+}
+
+TEST_CASE("Batch projected labels match per label projection", "[Core][Label][Projection]") {
+    View view(512, 512);
+    view.update(false);
+    ViewState viewState = view.state();
+
+    glm::mat4 mvp = perspectiveMVP();
+
+    SECTION("Point labels") {
+        for (float x : { 0.1f, 0.5f, 0.9f, 2.f }) {
+            TextLabel label = makeTextLabel({{ glm::vec2(x, 0.5f) }}, Label::Type::point);
+            requireSameTransform(label, mvp, viewState);
+        }
+    }
+
+    SECTION("Line labels") {
+        TextLabel label = makeTextLabel({{ glm::vec2(0.2f, 0.3f), glm::vec2(0.8f, 0.6f) }},
+                                        Label::Type::line);
+        requireSameTransform(label, mvp, viewState);
+
+        // Second point behind the camera
+        TextLabel clipped = makeTextLabel({{ glm::vec2(0.2f, 0.3f), glm::vec2(0.5f, -2.f) }},
+                                          Label::Type::line);
+        requireSameTransform(clipped, mvp, viewState);
+    }
+
+    SECTION("Curved labels") {
+        CurvedLabel::ModelTransform line;
+        for (int i = 0; i <= 10; i++) {
+            line.emplace_back(0.1f + i * 0.08f, 0.5f + 0.05f * std::sin(i * 0.6f));
+        }
+        CurvedLabel label(line, labelOptions(), 0, {}, {20, 10}, projectionLabels, {},
+                          TextLabelProperty::Align::center, 5);
+
+        requireSameTransform(label, mvp, viewState);
+    }
+}
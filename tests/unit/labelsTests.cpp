@@ -11,6 +11,8 @@
 #include "tile/tile.h"
 #include "view/view.h"
 
+#include "glm/gtc/matrix_transform.hpp"
+
 #include <memory>
 
 namespace Tangram {
@@ -215,4 +217,92 @@ TEST_CASE( "Test anchor fallback behavior", "[Labels][AnchorFallback]" ) {
     }
 
 }
+
+TEST_CASE( "Labels keep their placement while they do not move", "[Labels][Placement]" ) {
+
+    View view(256, 256);
+    view.setPosition(0, 0);
+    view.setZoom(0);
+    view.update(false);
+
+    Tile tile({0,0,0});
+    tile.update(0, view);
+
+    class TestLabels : public Labels {
+    public:
+        TestLabels(View& _v) {
+            m_isect2d.resize({1, 1}, {_v.getWidth(), _v.getHeight()});
+        }
+
+        // Place @_labels like updateLabelSet, moved by @_offsets in pixels.
+        // Returns the number of labels that kept their placement
+        size_t place(View& _v, Tile& _t, std::vector<Label*> _labels, std::vector<glm::vec2> _offsets) {
+            m_updateCount++;
+            m_transforms.clear();
+            m_obbs.clear();
+            m_labels.clear();
+            m_dirtyRegions.clear();
+            placements.resize(_labels.size());
+
+            for (size_t i = 0; i < _labels.size(); i++) {
+                glm::vec2 offset = _offsets[i] / glm::vec2(_v.getWidth(), _v.getHeight()) * 2.f;
+                glm::mat4 mvp = glm::translate(glm::mat4(1.f), glm::vec3(offset.x, -offset.y, 0.f)) * _t.mvp();
+
+                Range range;
+                ScreenTransform transform { m_transforms, range };
+                _labels[i]->update(mvp, _v.state(), bounds, transform);
+
+                m_labels.emplace_back(_labels[i], nullptr, &_t, nullptr, false, range);
+                m_labels.back().placement = &placements[i];
+            }
+
+            size_t placed = reusePlacements(_v.state(), false);
+            std::sort(m_labels.begin() + placed, m_labels.end(), Labels::priorityComparator);
+            handleOcclusions(_v.state(), placed);
+            storePlacements(placed);
+            return placed;
+        }
+
+        std::vector<Placement> placements;
+    };
+
+    TestLabels labels(view);
+
+    // l1 and l2 overlap, l3 is far from both
+    auto l1 = makeLabel(glm::vec2{0.5,0.5}, Label::Type::point, "1");
+    auto l2 = makeLabel(glm::vec2{0.5 + 2./256,0.5}, Label::Type::point, "2");
+    auto l3 = makeLabel(glm::vec2{0.1,0.1}, Label::Type::point, "3");
+    std::vector<Label*> all{ l1.get(), l2.get(), l3.get() };
+
+    glm::vec2 zero(0.f);
+    REQUIRE(labels.place(view, tile, all, { zero, zero, zero }) == 0);
+    REQUIRE(l1->isOccluded() != l2->isOccluded());
+    REQUIRE(l3->isOccluded() == false);
+
+    Label* visible = l1->isOccluded() ? l2.get() : l1.get();
+    Label* occluded = l1->isOccluded() ? l1.get() : l2.get();
+
+    // Same view
+    REQUIRE(labels.place(view, tile, all, { zero, zero, zero }) == 3);
+    CHECK(occluded->isOccluded());
+    CHECK(!visible->isOccluded());
+
+    // All labels move together when the map is panned
+    glm::vec2 pan(20.f, -10.f);
+    REQUIRE(labels.place(view, tile, all, { pan, pan, pan }) == 3);
+    CHECK(occluded->isOccluded());
+    CHECK(!visible->isOccluded());
+
+    // Only the label that moved relative to the others is tested again
+    std::vector<glm::vec2> moved{ pan, pan, pan + glm::vec2(5.f, 0.f) };
+    REQUIRE(labels.place(view, tile, all, moved) == 2);
+    CHECK(occluded->isOccluded());
+    CHECK(!l3->isOccluded());
+
+    // The label which was occluded by a moved label is tested again
+    moved[visible == l1.get() ? 0 : 1] += glm::vec2(0.f, 50.f);
+    REQUIRE(labels.place(view, tile, all, moved) == 1);
+    CHECK(!l1->isOccluded());
+    CHECK(!l2->isOccluded());
+}
 }
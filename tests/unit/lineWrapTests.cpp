@@ -112,6 +112,30 @@ TEST_CASE() {
 
 }
 
+TEST_CASE("Line wraps are reused at another font scale", "[Core][Alfons]") {
+    initFont();
+
+    auto text = icu::UnicodeString::fromUTF8("The quick brown fox");
+    auto line = shaper.shapeICU(font, text, 4, 10);
+
+    TextWrapper textWrap;
+    float width = textWrap.getShapeRangeWidth(line);
+    REQUIRE(textWrap.lineWraps().size() == 2);
+
+    TextWrapper scaledWrap;
+    scaledWrap.setLineWraps(textWrap.lineWraps(), 2.f);
+
+    for (size_t i = 0; i < 2; i++) {
+        REQUIRE(scaledWrap.lineWraps()[i].first == textWrap.lineWraps()[i].first);
+        REQUIRE(scaledWrap.lineWraps()[i].second == Approx(textWrap.lineWraps()[i].second * 2.f));
+    }
+
+    line.setScale(2.f);
+    alfons::LineMetrics metrics;
+    int nbLines = scaledWrap.draw(batch, width * 2.f, line, TextLabelProperty::Align::center, 1.0, metrics);
+    REQUIRE(nbLines == 2);
+}
+
 TEST_CASE() {
     initFont(TEST_FONT_AR);
 
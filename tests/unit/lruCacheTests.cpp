@@ -0,0 +1,88 @@
+#include "catch.hpp"
+
+#include "util/lruCache.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+TEST_CASE("LruCache returns cached values", "[LruCache]") {
+    LruCache<std::string, int> cache(4, 1);
+
+    int value = 0;
+    REQUIRE_FALSE(cache.get("a", value));
+
+    cache.put("a", 1);
+    cache.put("b", 2);
+    REQUIRE(cache.get("a", value));
+    REQUIRE(value == 1);
+    REQUIRE(cache.get("b", value));
+    REQUIRE(value == 2);
+
+    // Replace existing value
+    cache.put("a", 3);
+    REQUIRE(cache.get("a", value));
+    REQUIRE(value == 3);
+
+    auto stats = cache.stats();
+    REQUIRE(stats.hits == 3);
+    REQUIRE(stats.misses == 1);
+    REQUIRE(stats.entries == 2);
+    REQUIRE(stats.evictions == 0);
+}
+
+TEST_CASE("LruCache evicts the least recently used value", "[LruCache]") {
+    LruCache<int, int> cache(3, 1);
+
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.put(3, 3);
+
+    // Use 1, so that 2 is the least recently used
+    int value = 0;
+    REQUIRE(cache.get(1, value));
+
+    cache.put(4, 4);
+    REQUIRE_FALSE(cache.get(2, value));
+    REQUIRE(cache.get(1, value));
+    REQUIRE(cache.get(3, value));
+    REQUIRE(cache.get(4, value));
+
+    auto stats = cache.stats();
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.entries == 3);
+
+    cache.clear();
+    REQUIRE_FALSE(cache.get(1, value));
+    REQUIRE(cache.stats().entries == 0);
+}
+
+TEST_CASE("LruCache is shared between threads", "[LruCache]") {
+    LruCache<int, int> cache(64);
+    std::atomic<int> wrongValues{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 1000; i++) {
+                int key = i % 32;
+                int value = 0;
+                if (cache.get(key, value)) {
+                    if (value != key * 2) { wrongValues++; }
+                } else {
+                    cache.put(key, key * 2);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+
+    REQUIRE(wrongValues == 0);
+
+    auto stats = cache.stats();
+    REQUIRE(stats.hits + stats.misses == 4000);
+    REQUIRE(stats.entries <= 64);
+}
@@ -1,7 +1,10 @@
 #include "catch.hpp"
 
 #include <iostream>
+#include "gl/hardware.h"
 #include "gl/mesh.h"
+#include "gl/renderState.h"
+#include "gl/staticQuadMesh.h"
 
 using namespace Tangram;
 
@@ -27,6 +30,11 @@ struct TestMesh : public Mesh<Vertex> {
 
     int numVertices() const { return m_nVertices; }
     int numIndices() const { return m_nIndices; }
+    size_t numBatches() const { return m_vertexOffsets.size(); }
+    GLenum indexType() const { return m_indexType; }
+
+    template<typename I>
+    I index(size_t i) const { return reinterpret_cast<const I*>(m_glIndexData)[i]; }
 };
 
 std::shared_ptr<TestMesh> newMesh(unsigned int size) {
@@ -41,6 +49,20 @@ std::shared_ptr<TestMesh> newMesh(unsigned int size) {
     return mesh;
 }
 
+// Mesh of _quads quads with 4 vertices and 6 indices each
+std::shared_ptr<TestMesh> newIndexedMesh(size_t _quads) {
+    auto mesh = std::make_shared<TestMesh>(layout, GL_TRIANGLES);
+    MeshData<Vertex> meshData;
+
+    for (size_t i = 0; i < _quads; ++i) {
+        meshData.vertices.insert(meshData.vertices.end(), 4, {0,0,0,0});
+        meshData.indices.insert(meshData.indices.end(), {0, 1, 2, 2, 3, 0});
+        meshData.offsets.emplace_back(6, 4);
+    }
+    mesh->compile(meshData);
+    return mesh;
+}
+
 void checkBounds(const std::shared_ptr<TestMesh>& mesh) {
 
     REQUIRE(mesh->getDirtyOffset() >= 0);
@@ -170,3 +192,235 @@ TEST_CASE( "Check overflow", "[Core][TypedMesh]" ) {
 
     checkBounds(mesh);
 }
+
+TEST_CASE( "Upload mesh in one piece within the budget", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    auto mesh = newMesh(10);
+
+    REQUIRE(mesh->needsUpload());
+    REQUIRE(mesh->upload(rs, 4096) == mesh->bufferSize());
+    REQUIRE(mesh->isUploaded());
+    REQUIRE(!mesh->needsUpload());
+    REQUIRE(mesh->upload(rs, 4096) == 0);
+}
+
+TEST_CASE( "Upload mesh in parts", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    auto mesh = newMesh(10);
+    size_t bytes = mesh->bufferSize();
+
+    size_t uploaded = 0;
+    size_t parts = 0;
+    while (mesh->needsUpload()) {
+        REQUIRE(!mesh->isUploaded());
+        uploaded += mesh->upload(rs, 32);
+        parts++;
+    }
+
+    REQUIRE(mesh->isUploaded());
+    REQUIRE(uploaded == bytes);
+    REQUIRE(parts == (bytes + 31) / 32);
+}
+
+TEST_CASE( "Split large meshes with 16 bit indices into batches", "[Core][TypedMesh]" ) {
+    Hardware::supportsElementIndexUint = false;
+
+    auto mesh = newIndexedMesh(40000);
+
+    REQUIRE(mesh->indexType() == GL_UNSIGNED_SHORT);
+    // 16383 quads fit into one batch
+    REQUIRE(mesh->numBatches() == 3);
+    REQUIRE(mesh->bufferSize() == 160000 * layout->getStride() + 240000 * sizeof(GLushort));
+    // Indices start again at zero in the second batch
+    REQUIRE(mesh->index<GLushort>(16383 * 6) == 0);
+    REQUIRE(mesh->index<GLushort>(16383 * 6 - 2) == 65531);
+}
+
+TEST_CASE( "Draw large meshes with 32 bit indices in one batch", "[Core][TypedMesh]" ) {
+    Hardware::supportsElementIndexUint = true;
+
+    auto mesh = newIndexedMesh(40000);
+
+    REQUIRE(mesh->indexType() == GL_UNSIGNED_INT);
+    REQUIRE(mesh->numBatches() == 1);
+    REQUIRE(mesh->bufferSize() == 160000 * layout->getStride() + 240000 * sizeof(GLuint));
+    REQUIRE(mesh->index<GLuint>(16383 * 6) == 65532);
+    REQUIRE(mesh->index<GLuint>(239998) == 159999);
+
+    // Meshes which 16 bit indices can address keep them
+    auto small = newIndexedMesh(100);
+    REQUIRE(small->indexType() == GL_UNSIGNED_SHORT);
+    REQUIRE(small->numBatches() == 1);
+
+    Hardware::supportsElementIndexUint = false;
+}
+
+TEST_CASE( "Group static quads", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    StaticQuadMesh<Vertex> mesh(layout);
+
+    mesh.pushQuad(0);
+    mesh.pushQuad(0);
+    mesh.pushQuad(2)[3].a = 1.f;
+
+    REQUIRE(mesh.groupCount() == 3);
+    REQUIRE(mesh.hasQuads(0, 1));
+    REQUIRE(!mesh.hasQuads(1, 2));
+    REQUIRE(mesh.hasQuads(1, 3));
+    REQUIRE(!mesh.hasQuads(3, 4));
+    REQUIRE(mesh.vertexCount(0, 3) == 12);
+    REQUIRE(mesh.vertexCount(2, 8) == 4);
+    REQUIRE(!mesh.needsUpload());
+
+    mesh.compile();
+
+    REQUIRE(mesh.bufferSize() == 12 * layout->getStride());
+    REQUIRE(mesh.needsUpload());
+    REQUIRE(mesh.upload(rs, 4096) == mesh.bufferSize());
+    REQUIRE(mesh.isUploaded());
+}
+
+TEST_CASE( "Place meshes into shared arenas on upload", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    auto pool = std::make_shared<MeshArenaPool>(layout);
+
+    auto a = newMesh(10);
+    auto b = newMesh(20);
+    a->setArenaPool(pool);
+    b->setArenaPool(pool);
+
+    REQUIRE(a->upload(rs, 16) == a->bufferSize());
+    REQUIRE(b->upload(rs, 16) == b->bufferSize());
+    REQUIRE(a->isUploaded());
+    REQUIRE(!b->needsUpload());
+
+    REQUIRE(a->arenaRanges()->size() == 1);
+    REQUIRE(b->arenaRanges()->size() == 1);
+    auto rangeA = a->arenaRanges()->front();
+    auto rangeB = b->arenaRanges()->front();
+
+    // Meshes without indices are drawn with sequential ones
+    REQUIRE(rangeA.nIndices == 10);
+    REQUIRE(rangeB.nVertices == 20);
+
+    // Adjacent in the same arena, so that both are drawn at once
+    REQUIRE(rangeA.arena == rangeB.arena);
+    REQUIRE(rangeA.slot != rangeB.slot);
+    REQUIRE(rangeB.indexOffset == rangeA.indexOffset + rangeA.nIndices);
+
+    // The room of a released mesh is reused
+    a.reset();
+    auto c = newMesh(5);
+    c->setArenaPool(pool);
+    c->upload(rs, 16);
+
+    auto rangeC = c->arenaRanges()->front();
+    REQUIRE(rangeC.arena == rangeB.arena);
+    REQUIRE(rangeC.vertexOffset == rangeA.vertexOffset);
+    REQUIRE(rangeC.slot == rangeA.slot);
+}
+
+TEST_CASE( "Open a new arena when all slots are used", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    auto pool = std::make_shared<MeshArenaPool>(layout);
+
+    std::vector<std::shared_ptr<TestMesh>> meshes;
+    for (size_t i = 0; i <= MeshArena::MAX_SLOTS; i++) {
+        meshes.push_back(newMesh(4));
+        meshes.back()->setArenaPool(pool);
+        meshes.back()->upload(rs, 4096);
+    }
+
+    auto* first = meshes.front()->arenaRanges()->front().arena;
+    for (size_t i = 0; i < MeshArena::MAX_SLOTS; i++) {
+        REQUIRE(meshes[i]->arenaRanges()->front().arena == first);
+    }
+    REQUIRE(meshes.back()->arenaRanges()->front().arena != first);
+}
+
+TEST_CASE( "Delete arenas once all of their ranges are released", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    auto pool = std::make_shared<MeshArenaPool>(layout);
+
+    auto a = newMesh(10);
+    auto b = newMesh(20);
+    a->setArenaPool(pool);
+    b->setArenaPool(pool);
+    a->upload(rs, 4096);
+    b->upload(rs, 4096);
+    REQUIRE(pool->arenaCount() == 1);
+
+    a.reset();
+    REQUIRE(pool->arenaCount() == 1);
+    b.reset();
+    REQUIRE(pool->arenaCount() == 0);
+}
+
+TEST_CASE( "Abandon arenas after context loss", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    auto pool = std::make_shared<MeshArenaPool>(layout);
+
+    auto a = newMesh(10);
+    a->setArenaPool(pool);
+    a->upload(rs, 4096);
+    auto* lost = a->arenaRanges()->front().arena;
+
+    pool->reset();
+    REQUIRE(lost->isAbandoned());
+
+    // New meshes do not go into the abandoned arena
+    auto b = newMesh(10);
+    b->setArenaPool(pool);
+    b->upload(rs, 4096);
+    REQUIRE(b->arenaRanges()->front().arena != lost);
+    REQUIRE(pool->arenaCount() == 2);
+
+    a.reset();
+    REQUIRE(pool->arenaCount() == 1);
+}
+
+TEST_CASE( "Place batches into arenas within the upload budget", "[Core][TypedMesh]" ) {
+    Hardware::supportsElementIndexUint = false;
+
+    RenderState rs;
+    auto pool = std::make_shared<MeshArenaPool>(layout);
+
+    auto mesh = newIndexedMesh(40000);
+    mesh->setArenaPool(pool);
+    REQUIRE(mesh->numBatches() == 3);
+    size_t bytes = mesh->bufferSize();
+
+    REQUIRE(mesh->upload(rs, 0) == 0);
+
+    // One batch per call when the budget is smaller than a batch
+    size_t uploaded = 0;
+    size_t parts = 0;
+    while (mesh->needsUpload()) {
+        uploaded += mesh->upload(rs, 1024);
+        parts++;
+        REQUIRE(mesh->arenaRanges()->size() == parts);
+    }
+
+    REQUIRE(parts == 3);
+    REQUIRE(uploaded == bytes);
+    REQUIRE(mesh->isUploaded());
+}
+
+TEST_CASE( "Meshes with batches too large for an arena get buffers of their own", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    auto pool = std::make_shared<MeshArenaPool>(layout);
+
+    auto small = newMesh(10);
+    small->setArenaPool(pool);
+    small->upload(rs, 4096);
+
+    // Meshes without indices are not split into batches
+    auto mesh = newMesh(MeshArena::MAX_VERTICES + 1);
+    mesh->setArenaPool(pool);
+    size_t bytes = mesh->bufferSize();
+
+    REQUIRE(mesh->upload(rs, 4096) == bytes);
+    REQUIRE(mesh->isUploaded());
+    REQUIRE(mesh->arenaRanges() == nullptr);
+    REQUIRE(pool->arenaCount() == 1);
+}
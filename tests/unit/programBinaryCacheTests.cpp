@@ -0,0 +1,154 @@
+#include "catch.hpp"
+
+#include "gl/hardware.h"
+#include "gl/programBinaryCache.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Tangram;
+
+static const char* CACHE_DIR = "programBinaryCacheTest";
+
+static const std::string vertSrc = "void main() { gl_Position = vec4(0.0); }";
+static const std::string fragSrc = "void main() { gl_FragColor = vec4(1.0); }";
+
+static std::string binaryPath(uint64_t _key) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s/program-%016" PRIx64 ".bin", CACHE_DIR, _key);
+    return name;
+}
+
+static ProgramBinaryCache::Entry binary(size_t _size) {
+    ProgramBinaryCache::Entry entry;
+    entry.format = 0x8E21;
+    for (size_t i = 0; i < _size; i++) {
+        entry.data.push_back(char(i * 7));
+    }
+    return entry;
+}
+
+static bool fileExists(const std::string& _path) {
+    struct stat st;
+    return stat(_path.c_str(), &st) == 0;
+}
+
+TEST_CASE("Program binaries are keyed by source and driver", "[Gl][ProgramBinary]") {
+    ProgramBinaryCache cache;
+    cache.setDriver("vendor\nrenderer\n1.0");
+
+    uint64_t key = cache.key(vertSrc, fragSrc);
+    REQUIRE(cache.key(vertSrc, fragSrc) == key);
+    REQUIRE(cache.key(vertSrc + " ", fragSrc) != key);
+    REQUIRE(cache.key(vertSrc, fragSrc + " ") != key);
+    REQUIRE(cache.key(vertSrc + fragSrc, "") != cache.key(vertSrc, fragSrc));
+
+    cache.setDriver("vendor\nrenderer\n1.1");
+    REQUIRE(cache.key(vertSrc, fragSrc) != key);
+}
+
+TEST_CASE("Program binaries persist in the cache directory", "[Gl][ProgramBinary]") {
+    mkdir(CACHE_DIR, 0755);
+
+    uint64_t key = 0;
+    {
+        ProgramBinaryCache cache(CACHE_DIR);
+        cache.setDriver("driver");
+        key = cache.key(vertSrc, fragSrc);
+
+        ProgramBinaryCache::Entry entry;
+        REQUIRE_FALSE(cache.get(key, entry));
+
+        cache.put(key, binary(1000));
+        REQUIRE(fileExists(binaryPath(key)));
+    }
+
+    ProgramBinaryCache cache(CACHE_DIR);
+    cache.setDriver("driver");
+    REQUIRE(cache.key(vertSrc, fragSrc) == key);
+
+    ProgramBinaryCache::Entry entry;
+    REQUIRE(cache.get(key, entry));
+    REQUIRE(entry.format == binary(1000).format);
+    REQUIRE(entry.data == binary(1000).data);
+
+    // Another driver does not find the binary
+    ProgramBinaryCache other(CACHE_DIR);
+    other.setDriver("other driver");
+    REQUIRE_FALSE(other.get(other.key(vertSrc, fragSrc), entry));
+
+    cache.remove(key);
+    REQUIRE_FALSE(fileExists(binaryPath(key)));
+    REQUIRE_FALSE(cache.get(key, entry));
+
+    rmdir(CACHE_DIR);
+}
+
+TEST_CASE("Corrupt program binaries are dropped", "[Gl][ProgramBinary]") {
+    mkdir(CACHE_DIR, 0755);
+
+    ProgramBinaryCache writer(CACHE_DIR);
+    writer.setDriver("driver");
+    uint64_t key = writer.key(vertSrc, fragSrc);
+    writer.put(key, binary(100));
+
+    // Flip a byte of the binary
+    FILE* file = fopen(binaryPath(key).c_str(), "r+b");
+    REQUIRE(file != nullptr);
+    fseek(file, -1, SEEK_END);
+    fputc(0xFF, file);
+    fclose(file);
+
+    ProgramBinaryCache reader(CACHE_DIR);
+    reader.setDriver("driver");
+
+    ProgramBinaryCache::Entry entry;
+    REQUIRE_FALSE(reader.get(key, entry));
+    REQUIRE(entry.data.empty());
+    REQUIRE_FALSE(fileExists(binaryPath(key)));
+
+    rmdir(CACHE_DIR);
+}
+
+TEST_CASE("Rejected program binaries fall back to compiling", "[Gl][ProgramBinary]") {
+    bool supported = Hardware::supportsProgramBinary;
+    Hardware::supportsProgramBinary = true;
+
+    RenderState rs;
+    auto cache = std::make_shared<ProgramBinaryCache>();
+    cache->setDriver("driver");
+    rs.programBinaryCache = cache;
+
+    // Nothing cached
+    REQUIRE(cache->loadProgram(vertSrc, fragSrc) == 0);
+    REQUIRE(cache->stats().misses == 1);
+
+    // The mock GL does not link programs, so the binary is rejected
+    uint64_t key = cache->key(vertSrc, fragSrc);
+    cache->put(key, binary(100));
+
+    ShaderProgram program;
+    program.setShaderSource(vertSrc, fragSrc);
+    program.build(rs);
+
+    REQUIRE(cache->stats().rejected == 1);
+    REQUIRE(cache->stats().hits == 0);
+
+    ProgramBinaryCache::Entry entry;
+    REQUIRE_FALSE(cache->get(key, entry));
+
+    // Without the extension the cache is not used
+    Hardware::supportsProgramBinary = false;
+    cache->put(key, binary(100));
+    REQUIRE(cache->loadProgram(vertSrc, fragSrc) == 0);
+    REQUIRE(cache->stats().rejected == 1);
+
+    Hardware::supportsProgramBinary = supported;
+}
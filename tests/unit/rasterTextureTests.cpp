@@ -0,0 +1,160 @@
+#include "catch.hpp"
+
+#include "gl/hardware.h"
+#include "gl/rasterTexture.h"
+#include "gl/renderState.h"
+
+#include <vector>
+
+using namespace Tangram;
+
+struct TestRasterTexture : public RasterTexture {
+    using RasterTexture::RasterTexture;
+    const GLubyte* buffer() { return m_buffer.get(); }
+    GLuint glHandle() { return m_glHandle; }
+    RenderState::TextureKey key() { return textureKey(); }
+};
+
+// Uncompressed 32 bit TGA image with top-left origin
+static std::vector<uint8_t> makeImage(int _width, int _height) {
+    std::vector<uint8_t> image = {
+        0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        uint8_t(_width), uint8_t(_width >> 8),
+        uint8_t(_height), uint8_t(_height >> 8),
+        32, 0x28
+    };
+    for (int y = 0; y < _height; y++) {
+        for (int x = 0; x < _width; x++) {
+            // BGRA
+            image.push_back(uint8_t(x * 16));
+            image.push_back(uint8_t(y * 16));
+            image.push_back(uint8_t(x * 8 + y * 8));
+            image.push_back(255);
+        }
+    }
+    return image;
+}
+
+static TextureOptions mipmapOptions() {
+    TextureOptions options;
+    options.generateMipmaps = true;
+    options.minFilter = TextureMinFilter::LINEAR_MIPMAP_LINEAR;
+    return options;
+}
+
+TEST_CASE("RasterTexture decodes into a pooled buffer", "[Texture][Raster]") {
+    Hardware::maxTextureSize = 1024;
+    RenderState rs;
+
+    auto pool = std::make_shared<PixelBufferPool>(4);
+    auto image = makeImage(8, 8);
+
+    const GLubyte* buffer = nullptr;
+    {
+        TestRasterTexture texture({}, pool);
+        REQUIRE(texture.decode(image.data(), image.size()));
+        REQUIRE(texture.width() == 8);
+        REQUIRE(texture.height() == 8);
+        REQUIRE(texture.levels() == 1);
+        REQUIRE(texture.bufferSize() == 8 * 8 * 4);
+        REQUIRE(texture.needsUpload());
+
+        // Rows are flipped for GL, RGBA order
+        buffer = texture.buffer();
+        REQUIRE(buffer[0] == 7 * 8);
+        REQUIRE(buffer[1] == 7 * 16);
+        REQUIRE(buffer[2] == 0);
+        REQUIRE(buffer[3] == 255);
+
+        // The buffer goes back to the pool after upload
+        REQUIRE(texture.bind(rs, 0));
+        REQUIRE_FALSE(texture.needsUpload());
+        REQUIRE(texture.buffer() == nullptr);
+        REQUIRE(pool->size() == 1);
+    }
+
+    TestRasterTexture texture({}, pool);
+    REQUIRE(texture.decode(image.data(), image.size()));
+    REQUIRE(texture.buffer() == buffer);
+    REQUIRE(pool->size() == 0);
+}
+
+TEST_CASE("RasterTexture builds mip levels", "[Texture][Raster]") {
+    auto pool = std::make_shared<PixelBufferPool>();
+    auto image = makeImage(8, 4);
+
+    TestRasterTexture texture(mipmapOptions(), pool);
+    REQUIRE(texture.decode(image.data(), image.size()));
+
+    // 8x4, 4x2, 2x1, 1x1
+    REQUIRE(texture.levels() == 4);
+    REQUIRE(texture.bufferSize() == (32 + 8 + 2 + 1) * 4);
+
+    const GLubyte* level0 = texture.buffer();
+    const GLubyte* level1 = level0 + 32 * 4;
+
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 4; x++) {
+            for (int c = 0; c < 4; c++) {
+                int sum = level0[((y * 2) * 8 + x * 2) * 4 + c] +
+                    level0[((y * 2) * 8 + x * 2 + 1) * 4 + c] +
+                    level0[((y * 2 + 1) * 8 + x * 2) * 4 + c] +
+                    level0[((y * 2 + 1) * 8 + x * 2 + 1) * 4 + c];
+                REQUIRE(level1[(y * 4 + x) * 4 + c] == (sum + 2) / 4);
+            }
+        }
+    }
+
+    // Alpha stays opaque on all levels
+    const GLubyte* level3 = level1 + (8 + 2) * 4;
+    REQUIRE(level3[3] == 255);
+}
+
+TEST_CASE("RasterTexture reuses pooled texture objects", "[Texture][Raster]") {
+    Hardware::maxTextureSize = 1024;
+    RenderState rs;
+
+    auto pool = std::make_shared<PixelBufferPool>();
+    auto image = makeImage(4, 4);
+
+    TestRasterTexture texture({}, pool);
+    texture.decode(image.data(), image.size());
+
+    // Texture objects of other sizes or options are not taken
+    auto key = texture.key();
+    auto otherSize = key;
+    otherSize.width = 8;
+    auto otherOptions = key;
+    otherOptions.mipmaps = true;
+
+    rs.releaseTexture(11, otherSize);
+    rs.releaseTexture(12, otherOptions);
+    rs.releaseTexture(13, key);
+    REQUIRE(rs.pooledTextures() == 3);
+
+    REQUIRE(texture.bind(rs, 0));
+    REQUIRE(texture.glHandle() == 13);
+    REQUIRE(rs.pooledTextures() == 2);
+
+    REQUIRE(rs.acquireTexture(key) == 0);
+}
+
+TEST_CASE("RenderState keeps a bounded number of texture objects", "[Texture][Raster]") {
+    RenderState rs;
+    RenderState::TextureKey key;
+    key.width = 256;
+    key.height = 256;
+
+    for (GLuint i = 1; i <= RenderState::MAX_POOLED_TEXTURES + 4; i++) {
+        rs.releaseTexture(i, key);
+    }
+    REQUIRE(rs.pooledTextures() == RenderState::MAX_POOLED_TEXTURES);
+
+    // Most recently released first, the oldest ones were dropped
+    REQUIRE(rs.acquireTexture(key) == RenderState::MAX_POOLED_TEXTURES + 4);
+
+    for (size_t i = 1; i < RenderState::MAX_POOLED_TEXTURES; i++) {
+        REQUIRE(rs.acquireTexture(key) > 4);
+    }
+    REQUIRE(rs.acquireTexture(key) == 0);
+}
@@ -0,0 +1,174 @@
+#include "catch.hpp"
+
+#include "data/tileSource.h"
+#include "scene/scene.h"
+#include "scene/sceneDiff.h"
+#include "util/yamlUtil.h"
+
+#include "yaml-cpp/yaml.h"
+
+using namespace Tangram;
+
+const static std::string baseScene = R"END(
+global:
+    width: 2px
+camera:
+    type: perspective
+sources:
+    osm:
+        type: MVT
+        url: https://example.com/{z}/{x}/{y}.mvt
+    pois:
+        type: GeoJSON
+        url: https://example.com/pois.json
+    terrain:
+        type: Raster
+        url: https://example.com/{z}/{x}/{y}.png
+styles:
+    roads:
+        base: lines
+        shaders:
+            uniforms:
+                u_scale: 1.0
+    water:
+        base: polygons
+layers:
+    roads:
+        data: { source: osm }
+        draw:
+            roads:
+                color: white
+                width: 2px
+    water:
+        data: { source: osm }
+        draw:
+            water:
+                color: blue
+    pois:
+        data: { source: pois }
+        major:
+            filter: { kind: major }
+            draw:
+                icons:
+                    style: roads
+lights:
+    light1:
+        type: directional
+)END";
+
+static SceneDiff diff(const std::string& _path, const std::string& _value) {
+    YAML::Node current = YAML::Load(baseScene);
+    YAML::Node next = YAML::Load(baseScene);
+
+    // Walk the '.'-separated path and set the value of the last key
+    YAML::Node node = next;
+    std::string path = _path;
+    size_t dot;
+    while ((dot = path.find('.')) != std::string::npos) {
+        node.reset(node[path.substr(0, dot)]);
+        path = path.substr(dot + 1);
+    }
+    node[path] = YAML::Load(_value);
+
+    return SceneDiff::compare(current, next);
+}
+
+TEST_CASE("YAML nodes compare by value", "[SceneDiff][YAML]") {
+    YAML::Node a = YAML::Load("{ a: 1, b: [1, 2], c: { d: x } }");
+
+    REQUIRE(YamlUtil::equal(a, YAML::Load("{ c: { d: x }, b: [1, 2], a: 1 }")));
+    REQUIRE_FALSE(YamlUtil::equal(a, YAML::Load("{ a: 1, b: [1, 2], c: { d: y } }")));
+    REQUIRE_FALSE(YamlUtil::equal(a, YAML::Load("{ a: 1, b: [2, 1], c: { d: x } }")));
+    REQUIRE_FALSE(YamlUtil::equal(a, YAML::Load("{ a: 1, b: [1, 2] }")));
+    REQUIRE_FALSE(YamlUtil::equal(a["a"], a["b"]));
+    REQUIRE(YamlUtil::equal(a["x"], a["y"]));
+    REQUIRE_FALSE(YamlUtil::equal(a["a"], a["x"]));
+}
+
+TEST_CASE("Unchanged scenes have no differences", "[SceneDiff]") {
+    auto result = SceneDiff::compare(YAML::Load(baseScene), YAML::Load(baseScene));
+    REQUIRE(result.change == SceneDiff::Change::none);
+
+    // Globals are applied to the nodes which use them
+    result = diff("global.width", "4px");
+    REQUIRE(result.change == SceneDiff::Change::none);
+}
+
+TEST_CASE("Camera and uniform changes are applied live", "[SceneDiff]") {
+    auto result = diff("camera.type", "isometric");
+    REQUIRE(result.change == SceneDiff::Change::live);
+    REQUIRE(result.settings);
+
+    result = diff("styles.roads.shaders.uniforms.u_scale", "2.0");
+    REQUIRE(result.change == SceneDiff::Change::live);
+    REQUIRE(result.uniforms == std::set<std::string>{ "roads" });
+    REQUIRE(result.styles.empty());
+    REQUIRE(result.rebuildSources.empty());
+}
+
+TEST_CASE("Style changes rebuild the sources of layers using them", "[SceneDiff]") {
+    auto result = diff("styles.water.base", "lines");
+    REQUIRE(result.change == SceneDiff::Change::partial);
+    REQUIRE(result.styles == std::set<std::string>{ "water" });
+    REQUIRE(result.rebuildSources == std::set<std::string>{ "osm" });
+
+    // Draw rules of sublayers may set the style explicitly
+    result = diff("styles.roads.base", "polygons");
+    REQUIRE(result.styles == std::set<std::string>{ "roads" });
+    REQUIRE(result.rebuildSources == (std::set<std::string>{ "osm", "pois" }));
+}
+
+TEST_CASE("Layer changes rebuild the sources of the layer", "[SceneDiff]") {
+    auto result = diff("layers.water.draw.water.color", "green");
+    REQUIRE(result.change == SceneDiff::Change::partial);
+    REQUIRE(result.styles.empty());
+    REQUIRE(result.rebuildSources == std::set<std::string>{ "osm" });
+
+    // Both the previous and the new source are rebuilt
+    result = diff("layers.pois.data.source", "osm");
+    REQUIRE(result.rebuildSources == (std::set<std::string>{ "osm", "pois" }));
+}
+
+TEST_CASE("Source changes reload only the changed source", "[SceneDiff]") {
+    auto result = diff("sources.pois.url", "https://example.com/other.json");
+    REQUIRE(result.change == SceneDiff::Change::partial);
+    REQUIRE(result.reloadSources == std::set<std::string>{ "pois" });
+    REQUIRE(result.rebuildSources.empty());
+}
+
+TEST_CASE("Sources are reloaded when layers use other collections", "[SceneDiff]") {
+    auto scene = [](const std::string& _layer, const std::vector<std::string>& _collections) {
+        auto scene = std::make_shared<Scene>();
+        scene->config() = YAML::Load(baseScene);
+        scene->config()["layers"]["water"]["data"]["layer"] = _layer;
+
+        auto source = std::make_shared<TileSource>("osm", nullptr);
+        source->addCollections(_collections);
+        scene->tileSources().push_back(source);
+        return scene;
+    };
+
+    auto current = scene("water", { "roads", "water" });
+
+    // Only rebuild when the kept source parses the collections already
+    auto result = SceneDiff::compare(*current, *scene("roads", { "roads" }));
+    REQUIRE(result.change == SceneDiff::Change::partial);
+    REQUIRE(result.rebuildSources == std::set<std::string>{ "osm" });
+    REQUIRE(result.reloadSources.empty());
+
+    result = SceneDiff::compare(*current, *scene("ocean", { "roads", "ocean" }));
+    REQUIRE(result.change == SceneDiff::Change::partial);
+    REQUIRE(result.reloadSources == std::set<std::string>{ "osm" });
+}
+
+TEST_CASE("Other changes reload the scene", "[SceneDiff]") {
+    REQUIRE(diff("sources.terrain.url", "https://example.com/{z}/{x}/{y}.jpg").change ==
+            SceneDiff::Change::full);
+
+    REQUIRE(diff("sources.added", "{ type: GeoJSON, url: https://example.com/a.json }").change ==
+            SceneDiff::Change::full);
+
+    REQUIRE(diff("lights.light1.type", "point").change == SceneDiff::Change::full);
+
+    REQUIRE(diff("textures", "{ icons: { url: icons.png } }").change == SceneDiff::Change::full);
+}
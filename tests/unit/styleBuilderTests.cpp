@@ -0,0 +1,231 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "gl/mesh.h"
+#include "gl/texture.h"
+#include "scene/drawRule.h"
+#include "scene/sceneLayer.h"
+#include "style/colorPalette.h"
+#include "style/polygonStyle.h"
+#include "style/textStyle.h"
+#include "style/textStyleBuilder.h"
+#include "text/fontContext.h"
+#include "tile/tile.h"
+
+#include "mockPlatform.h"
+
+#include "glm/gtc/type_precision.hpp"
+
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+#define TEST_FONT "res/fonts/NotoSans-Regular.ttf"
+
+// Layout of compact polygon vertices without texture coordinates
+struct CompactVertex {
+    glm::i16vec4 pos;
+    glm::i8vec2 norm;
+    uint16_t palette;
+};
+
+struct WideVertex {
+    glm::i16vec4 pos;
+    glm::i8vec2 norm;
+    uint16_t padding;
+    uint32_t palette;
+};
+
+template<class V>
+struct TestMesh : public Mesh<V> {
+    using Mesh<V>::Mesh;
+
+    size_t vertexCount() const { return this->m_nVertices; }
+
+    const V* vertices() const {
+        return reinterpret_cast<const V*>(this->m_glVertexData);
+    }
+};
+
+struct PolygonBuild {
+    PolygonStyle style{ "polygons" };
+    Tile tile{ TileID(0, 0, 0) };
+    std::vector<std::unique_ptr<SceneLayer>> layers;
+
+    PolygonBuild() {
+        style.setCompactVertices(true);
+        style.constructVertexLayout();
+    }
+
+    // Rule that draws features in @_color
+    DrawRule rule(uint32_t _color) {
+        StyleParam color(StyleParamKey::color);
+        color.value = _color;
+        StyleParam order(StyleParamKey::order);
+        order.value = uint32_t(1);
+
+        layers.push_back(std::make_unique<SceneLayer>("layer", Filter(),
+            std::vector<DrawRuleData>{ { "polygons", 0, { color, order } } },
+            std::vector<SceneLayer>{}, true));
+
+        DrawRuleMergeSet ruleSet;
+        ruleSet.mergeRules(*layers.back());
+        REQUIRE(ruleSet.matchedRules().size() == 1);
+        return ruleSet.matchedRules()[0];
+    }
+
+    std::unique_ptr<StyleBuilder> builder() {
+        auto builder = style.createBuilder();
+        builder->setup(tile);
+        return builder;
+    }
+};
+
+// Triangle at @_offset, all triangles have the same number of vertices
+static Feature triangle(float _offset) {
+    Feature feature;
+    feature.geometryType = GeometryType::polygons;
+    feature.polygons.push_back({ { { _offset, 0.f }, { _offset + .1f, 0.f }, { _offset, .1f }, { _offset, 0.f } } });
+    return feature;
+}
+
+// Palette colors of the vertices of @_mesh, one per triangle
+template<class V>
+static std::vector<GLuint> triangleColors(const StyledMesh& _mesh, const VertexLayout& _layout,
+                                          size_t _triangles) {
+    std::vector<char> data;
+    REQUIRE(_mesh.serialize(data));
+
+    auto layout = std::make_shared<VertexLayout>(_layout);
+    TestMesh<V> mesh(layout, GL_TRIANGLES);
+    REQUIRE(mesh.restore(data.data(), data.size(), {}));
+    REQUIRE(mesh.vertexCount() % _triangles == 0);
+
+    REQUIRE(_mesh.palette());
+    auto texels = reinterpret_cast<const GLuint*>(_mesh.palette()->bufferData());
+    REQUIRE(texels);
+
+    size_t stride = mesh.vertexCount() / _triangles;
+    std::vector<GLuint> colors;
+    for (size_t i = 0; i < mesh.vertexCount(); i += stride) {
+        // All vertices of a triangle have the same color
+        for (size_t j = i; j < i + stride; j++) {
+            REQUIRE(mesh.vertices()[j].palette == mesh.vertices()[i].palette);
+        }
+        // Entries are pairs of color and selection color
+        colors.push_back(texels[mesh.vertices()[i].palette * 2]);
+    }
+    return colors;
+}
+
+TEST_CASE("Merged polygon parts keep their colors", "[StyleBuilder]") {
+    PolygonBuild build;
+
+    const uint32_t red = 0xff0000ff, green = 0xff00ff00, blue = 0xffff0000;
+    auto redRule = build.rule(red);
+    auto greenRule = build.rule(green);
+    auto blueRule = build.rule(blue);
+
+    auto builder = build.builder();
+    REQUIRE(builder->addFeature(triangle(0), redRule));
+    REQUIRE(builder->addFeature(triangle(1), blueRule));
+
+    // The part has its own palette, where green and red have other indices
+    auto part = build.builder();
+    REQUIRE(part->addFeature(triangle(2), greenRule));
+    REQUIRE(part->addFeature(triangle(3), redRule));
+    REQUIRE(part->addFeature(triangle(4), greenRule));
+
+    builder->merge(*part);
+
+    auto mesh = builder->build();
+    REQUIRE(mesh);
+
+    auto colors = triangleColors<CompactVertex>(*mesh, *build.style.vertexLayout(), 5);
+    CHECK(colors == std::vector<GLuint>({ red, blue, green, red, green }));
+}
+
+TEST_CASE("Merged polygon parts switch to wide palette indices", "[StyleBuilder]") {
+    PolygonBuild build;
+
+    // Each builder has fewer colors than 16 bit indices can address, the
+    // merged palette has more
+    const size_t count = ColorPalette::MAX_SHORT_ENTRIES / 2 + 1000;
+
+    auto builder = build.builder();
+    auto part = build.builder();
+
+    auto feature = triangle(0);
+    for (size_t i = 0; i < count; i++) {
+        REQUIRE(builder->addFeature(feature, build.rule(0xff000000 | i)));
+        REQUIRE(part->addFeature(feature, build.rule(0xfe000000 | i)));
+    }
+    build.layers.clear();
+
+    builder->merge(*part);
+
+    auto mesh = builder->build();
+    REQUIRE(mesh);
+
+    auto colors = triangleColors<WideVertex>(*mesh, *build.style.wideVertexLayout(), 2 * count);
+    REQUIRE(colors.size() == 2 * count);
+    CHECK(colors[0] == 0xff000000);
+    CHECK(colors[count - 1] == (0xff000000 | (count - 1)));
+    CHECK(colors[count] == 0xfe000000);
+    CHECK(colors[2 * count - 1] == (0xfe000000 | (count - 1)));
+}
+
+struct TextBuilder : public TextStyleBuilder {
+    using TextStyleBuilder::TextStyleBuilder;
+
+    // Lay out @_text like prepareLabel, without adding a label for it
+    void layout(const std::string& _text) {
+        auto& context = m_style.context();
+
+        TextStyle::Parameters params;
+        params.text = _text;
+        params.fontSize = 16;
+        params.font = context->getFont("test", "normal", "400", params.fontSize);
+
+        glm::vec2 bbox;
+        TextRange ranges;
+        REQUIRE(context->layoutText(params, m_quads, m_atlasRefs, bbox, ranges));
+    }
+};
+
+TEST_CASE("Merged text parts release their shared atlas references", "[StyleBuilder]") {
+    auto context = std::make_shared<FontContext>(std::make_shared<MockPlatform>());
+    context->addFont(FontDescription("test", "normal", "400", ""),
+                     alfons::InputSource(MockPlatform::getBytesFromFile(TEST_FONT)));
+
+    TextStyle style("text", context, true);
+    style.constructVertexLayout();
+    Tile tile(TileID(0, 0, 0));
+
+    {
+        TextBuilder builder(style);
+        TextBuilder part(style);
+        builder.setup(tile);
+        part.setup(tile);
+
+        builder.layout("label");
+        part.layout("label");
+
+        REQUIRE(context->glyphTextureCount() == 1);
+        REQUIRE(context->atlasRefCount(0) == 2);
+
+        builder.merge(part);
+        CHECK(context->atlasRefCount(0) == 1);
+
+        // Released by the mesh of the tile
+        auto mesh = builder.build();
+        REQUIRE(mesh);
+        CHECK(context->atlasRefCount(0) == 1);
+    }
+
+    for (size_t i = 0; i < FontContext::max_textures; i++) {
+        CHECK(context->atlasRefCount(i) == 0);
+    }
+}
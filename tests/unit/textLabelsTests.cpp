@@ -0,0 +1,215 @@
+#include "catch.hpp"
+
+#include "gl/dynamicQuadMesh.h"
+#include "labels/screenTransform.h"
+#include "labels/textLabel.h"
+#include "labels/textLabels.h"
+#include "style/textStyle.h"
+#include "text/fontContext.h"
+#include "view/view.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+static const glm::vec2 screenSize(500.f, 500.f);
+static const Label::AABB screenBounds(0.f, 0.f, 500.f, 500.f);
+static const uint32_t BATCH = TextStyle::LABEL_SLOTS_PER_BATCH;
+
+class TestTextStyle : public TextStyle {
+public:
+    TestTextStyle() : TextStyle("text", std::make_shared<FontContext>(nullptr), true) {
+        constructVertexLayout();
+    }
+
+    const auto& staticRuns() const { return m_staticRuns; }
+
+    // Dynamic mesh for quads of labels which are not static
+    DynamicQuadMesh<TextVertex>& addMesh() {
+        m_meshes.push_back(std::make_unique<DynamicQuadMesh<TextVertex>>(m_vertexLayout, GL_TRIANGLES));
+        return *m_meshes.back();
+    }
+};
+
+struct StaticLabels {
+    TextLabels labels;
+
+    // Labels in the order of their slots
+    std::vector<TextLabel*> slots;
+
+    StaticLabels(const TextStyle& _style, size_t _count, Label::Type _type) : labels(_style) {
+        Label::Options options;
+        options.anchors.anchor[0] = LabelProperty::Anchor::center;
+        options.anchors.count = 1;
+        options.showTransition.time = 0.2;
+        options.hideTransition.time = 0.2;
+
+        std::vector<std::unique_ptr<Label>> list;
+        std::vector<GlyphQuad> quads;
+
+        for (size_t i = 0; i < _count; i++) {
+            // Two glyphs for the first alignment only
+            TextRange ranges;
+            ranges[0] = Range(quads.size(), 2);
+            quads.push_back({ 0, {} });
+            quads.push_back({ 0, {} });
+
+            glm::vec2 position(10.f + i, 20.f);
+            list.push_back(std::make_unique<TextLabel>(TextLabel::Coordinates{{ position, position }},
+                                                       _type, options, TextLabel::VertexAttributes{},
+                                                       glm::vec2(0.f), labels, ranges,
+                                                       TextLabelProperty::Align::none));
+            slots.push_back(static_cast<TextLabel*>(list.back().get()));
+        }
+
+        labels.setLabels(list);
+        labels.setQuads(std::move(quads), {});
+
+        std::sort(slots.begin(), slots.end());
+    }
+
+    /* Place @_label on screen like Labels does for the current frame,
+     * returns the position of its slot */
+    glm::vec2 place(TextLabel& _label, float _dt = 0.f, bool _occluded = false) {
+        View view(256, 256);
+        view.update(false);
+
+        ScreenTransform::Buffer buffer;
+        Range range;
+        ScreenTransform transform(buffer, range);
+
+        _label.update(glm::ortho(0.f, screenSize.x, screenSize.y, 0.f, -1.f, 1.f),
+                      view.state(), &screenBounds, transform);
+        _label.occlude(_occluded);
+        _label.evalState(_dt);
+        _label.addVerticesToMesh(transform, screenSize);
+
+        // Slots are rounded like the vertices of dynamic quads
+        glm::vec2 position = transform[0];
+        return glm::vec2(glm::i16vec2(position * TextVertex::position_scale)) * TextVertex::position_inv_scale;
+    }
+};
+
+TEST_CASE("Static labels are placed in the slots of the current frame", "[Labels][StaticLabels]") {
+    TestTextStyle style;
+    StaticLabels test(style, BATCH + 2, Label::Type::debug);
+    auto& slots = test.labels.labelSlots();
+    auto& runs = style.staticRuns();
+
+    for (auto* label : test.slots) { REQUIRE(label->hasStaticQuads()); }
+    REQUIRE(slots.size() == 2);
+
+    style.onBeginUpdate();
+
+    std::vector<glm::vec2> positions;
+    for (auto* label : test.slots) { positions.push_back(test.place(*label)); }
+
+    REQUIRE(slots[0].size() == BATCH);
+    REQUIRE(slots[1].size() == 2);
+    CHECK(slots[0][0] == glm::vec4(positions[0], 1.f, 0.f));
+    CHECK(slots[1][1] == glm::vec4(positions[BATCH + 1], 1.f, 0.f));
+
+    // One run per batch
+    REQUIRE(runs.size() == 2);
+    CHECK(runs[0].labels == &test.labels);
+    CHECK(runs[0].first == 0);
+    CHECK(runs[0].end == BATCH);
+    CHECK(runs[1].first == BATCH);
+    CHECK(runs[1].end == BATCH + 2);
+
+    // Slots of the previous frame are not drawn again
+    style.onBeginUpdate();
+    test.place(*test.slots[3]);
+
+    REQUIRE(slots[0].size() == 4);
+    CHECK(slots[0][0].z == 0.f);
+    CHECK(slots[0][2].z == 0.f);
+    CHECK(slots[0][3].z == 1.f);
+    CHECK(slots[1].empty());
+
+    REQUIRE(runs.size() == 1);
+    CHECK(runs[0].first == 3);
+    CHECK(runs[0].end == 4);
+}
+
+TEST_CASE("Only visible static labels are placed", "[Labels][StaticLabels]") {
+    TestTextStyle style;
+    StaticLabels test(style, 2, Label::Type::point);
+    auto& slots = test.labels.labelSlots();
+    auto& label = *test.slots[1];
+
+    style.onBeginUpdate();
+    ScreenTransform::Buffer buffer;
+    Range range;
+    ScreenTransform transform(buffer, range);
+    label.addVerticesToMesh(transform, screenSize);
+
+    CHECK(style.staticRuns().empty());
+    CHECK(slots[0].empty());
+
+    // Fading in
+    test.place(label);
+    REQUIRE(label.state() == Label::State::fading_in);
+    REQUIRE(slots[0].size() == 2);
+    CHECK(slots[0][0].z == 0.f);
+    CHECK(slots[0][1].z < 1.f);
+
+    style.onBeginUpdate();
+    test.place(label, 1.f);
+    REQUIRE(label.state() == Label::State::visible);
+    REQUIRE(slots[0].size() == 2);
+    CHECK(slots[0][1].z == 1.f);
+
+    // Occluded labels fade out and are then not placed anymore
+    style.onBeginUpdate();
+    test.place(label, 0.f, true);
+    REQUIRE(label.state() == Label::State::fading_out);
+    CHECK(style.staticRuns().size() == 1);
+
+    style.onBeginUpdate();
+    test.place(label, 1.f, true);
+    REQUIRE(!label.visibleState());
+    CHECK(style.staticRuns().empty());
+}
+
+TEST_CASE("Static label runs keep the order of dynamic quads", "[Labels][StaticLabels]") {
+    TestTextStyle style;
+    StaticLabels test(style, 4, Label::Type::debug);
+    auto& runs = style.staticRuns();
+
+    style.onBeginUpdate();
+    auto& mesh = style.addMesh();
+
+    test.labels.setSlot(0, glm::vec2(0.f), 1.f);
+    test.labels.setSlot(1, glm::vec2(0.f), 1.f);
+    REQUIRE(runs.size() == 1);
+
+    // Quads of a dynamic label in between start a new run
+    mesh.pushQuad();
+    test.labels.setSlot(2, glm::vec2(0.f), 1.f);
+
+    {
+        // So do labels of another tile
+        StaticLabels other(style, 1, Label::Type::debug);
+        other.labels.setSlot(0, glm::vec2(0.f), 1.f);
+        test.labels.setSlot(3, glm::vec2(0.f), 1.f);
+
+        REQUIRE(runs.size() == 4);
+        CHECK(runs[2].labels == &other.labels);
+    }
+
+    CHECK(runs[0].first == 0);
+    CHECK(runs[0].end == 2);
+    CHECK(runs[1].first == 2);
+    CHECK(runs[1].end == 3);
+    CHECK(runs[3].first == 3);
+    CHECK(runs[3].end == 4);
+
+    // Runs of removed labels are skipped
+    CHECK(runs[2].labels == nullptr);
+    CHECK(runs[3].labels == &test.labels);
+}
@@ -8,108 +8,82 @@ using namespace Tangram;
 struct TestTexture : public GlyphTexture {
     TestTexture() { resize(512, 512); }
     using GlyphTexture::GlyphTexture;
-    const std::vector<DirtyRowRange>& dirtyRanges() { return m_dirtyRows; }
+    const std::vector<DirtyRect>& dirtyRects() { return m_dirtyRects; }
 };
 
-TEST_CASE("Merging of dirty Regions - Non overlapping, test ordering", "[Texture]") {
+TEST_CASE("Merging of dirty Regions - Non overlapping", "[Texture]") {
     TestTexture texture{};
-    REQUIRE(texture.dirtyRanges().size() == 0);
-
-    // A range from 20-30
-    texture.setRowsDirty(20, 10);
-    REQUIRE(texture.dirtyRanges().size() == 1);
-
-    // B range from 0-10
-    texture.setRowsDirty(0, 10);
-    REQUIRE(texture.dirtyRanges().size() == 2);
-
-    // C range from 40-60
-    texture.setRowsDirty(40, 20);
-    REQUIRE(texture.dirtyRanges().size() == 3);
+    REQUIRE(texture.dirtyRects().size() == 0);
+
+    // A at 10,20 - 30,30
+    texture.setDirty(10, 20, 20, 10);
+    REQUIRE(texture.dirtyRects().size() == 1);
+
+    // B at 10,0 - 30,10
+    texture.setDirty(10, 0, 20, 10);
+    REQUIRE(texture.dirtyRects().size() == 2);
+
+    // C at 100,20 - 120,30, same rows as A
+    texture.setDirty(100, 20, 20, 10);
+    REQUIRE(texture.dirtyRects().size() == 3);
+
+    // Columns are aligned to 4 bytes
+    auto& a = texture.dirtyRects()[0];
+    REQUIRE(a.x0 == 8);
+    REQUIRE(a.x1 == 32);
+    REQUIRE(a.y0 == 20);
+    REQUIRE(a.y1 == 30);
+
+    auto& c = texture.dirtyRects()[2];
+    REQUIRE(c.x0 == 100);
+    REQUIRE(c.x1 == 120);
+}
 
-    // B
-    REQUIRE(texture.dirtyRanges()[0].min == 0);
-    REQUIRE(texture.dirtyRanges()[0].max == 10);
+TEST_CASE("Merging of dirty Regions - Merge overlapping", "[Texture]") {
+    TestTexture texture{};
 
-    // A
-    REQUIRE(texture.dirtyRanges()[1].min == 20);
-    REQUIRE(texture.dirtyRanges()[1].max == 30);
+    texture.setDirty(0, 50, 64, 50);
+    REQUIRE(texture.dirtyRects().size() == 1);
 
-    // C
-    REQUIRE(texture.dirtyRanges()[2].min == 40);
-    REQUIRE(texture.dirtyRanges()[2].max == 60);
+    texture.setDirty(32, 20, 64, 50);
+    REQUIRE(texture.dirtyRects().size() == 1);
 
+    auto& r = texture.dirtyRects()[0];
+    REQUIRE(r.x0 == 0);
+    REQUIRE(r.x1 == 96);
+    REQUIRE(r.y0 == 20);
+    REQUIRE(r.y1 == 100);
 }
 
-TEST_CASE("Merging of dirty Regions - Merge overlapping", "[Texture]") {
+TEST_CASE("Merging of dirty Regions - Merge three regions, when 3rd region is added", "[Texture]") {
     TestTexture texture{};
-    REQUIRE(texture.dirtyRanges().size() == 0);
 
-    // range from 50-100
-    texture.setRowsDirty(50, 50);
-    REQUIRE(texture.dirtyRanges().size() == 1);
+    texture.setDirty(0, 50, 100, 50);
+    texture.setDirty(0, 200, 100, 50);
+    REQUIRE(texture.dirtyRects().size() == 2);
 
-    // range from 20-70
-    texture.setRowsDirty(20, 50);
-    REQUIRE(texture.dirtyRanges().size() == 1);
+    // Touching both
+    texture.setDirty(40, 100, 20, 100);
+    REQUIRE(texture.dirtyRects().size() == 1);
 
-    REQUIRE(texture.dirtyRanges()[0].min == 20);
-    REQUIRE(texture.dirtyRanges()[0].max == 100);
+    auto& r = texture.dirtyRects()[0];
+    REQUIRE(r.x0 == 0);
+    REQUIRE(r.x1 == 100);
+    REQUIRE(r.y0 == 50);
+    REQUIRE(r.y1 == 250);
 }
 
-TEST_CASE("Merging of dirty Regions - Merge three regions, when 3rd region is added", "[Texture]") {
-    { // just touching
-
-        TestTexture texture{};
-        REQUIRE(texture.dirtyRanges().size() == 0);
-
-        // range from 50-100
-        texture.setRowsDirty(50, 50);
-        REQUIRE(texture.dirtyRanges().size() == 1);
-        REQUIRE(texture.dirtyRanges()[0].min == 50);
-        REQUIRE(texture.dirtyRanges()[0].max == 100);
-
-        // range from 200-250
-        texture.setRowsDirty(200, 50);
-        REQUIRE(texture.dirtyRanges().size() == 2);
-        REQUIRE(texture.dirtyRanges()[1].min == 200);
-        REQUIRE(texture.dirtyRanges()[1].max == 250);
-
-        // range from 100-200
-        texture.setRowsDirty(100, 100);
-        REQUIRE(texture.dirtyRanges().size() == 1);
-        REQUIRE(texture.dirtyRanges()[0].min == 50);
-        REQUIRE(texture.dirtyRanges()[0].max == 250);
-    }
+TEST_CASE("Merging of dirty Regions - Too many regions are merged into their bounds", "[Texture]") {
+    TestTexture texture{};
 
-    { // overlapping
-
-        TestTexture texture{};
-        REQUIRE(texture.dirtyRanges().size() == 0);
-
-        // range from 50-150
-        texture.setRowsDirty(50, 100);
-        REQUIRE(texture.dirtyRanges().size() == 1);
-        REQUIRE(texture.dirtyRanges()[0].min == 50);
-        REQUIRE(texture.dirtyRanges()[0].max == 150);
-
-        // range from 200-250
-        texture.setRowsDirty(200, 50);
-        REQUIRE(texture.dirtyRanges().size() == 2);
-        REQUIRE(texture.dirtyRanges()[1].min == 200);
-        REQUIRE(texture.dirtyRanges()[1].max == 250);
-
-        // range from 300-350
-        texture.setRowsDirty(300, 50);
-        REQUIRE(texture.dirtyRanges().size() == 3);
-        REQUIRE(texture.dirtyRanges()[2].min == 300);
-        REQUIRE(texture.dirtyRanges()[2].max == 350);
-
-        // range from 100-300
-        texture.setRowsDirty(100, 200);
-        REQUIRE(texture.dirtyRanges().size() == 1);
-        REQUIRE(texture.dirtyRanges()[0].min == 50);
-        REQUIRE(texture.dirtyRanges()[0].max == 350);
+    for (int i = 0; i < 33; i++) {
+        texture.setDirty(i * 12, (i % 2) * 100, 4, 4);
     }
+    REQUIRE(texture.dirtyRects().size() == 1);
 
+    auto& r = texture.dirtyRects()[0];
+    REQUIRE(r.x0 == 0);
+    REQUIRE(r.x1 == 388);
+    REQUIRE(r.y0 == 0);
+    REQUIRE(r.y1 == 104);
 }
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include "gl/texture.h"
+#include "tile/tile.h"
+#include "tile/tileCache.h"
+
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+static const size_t TILE_SIZE = 64 * 64 * 4;
+
+// Tile holding a raster texture of TILE_SIZE bytes in client memory
+static std::shared_ptr<Tile> makeTile(TileID _id, float _buildTime = 0) {
+    auto tile = std::make_shared<Tile>(_id);
+    tile->setBuildTime(_buildTime);
+
+    std::vector<GLubyte> pixels(TILE_SIZE);
+    auto texture = std::make_shared<Texture>(TextureOptions{});
+    texture->setPixelData(64, 64, 4, pixels.data(), pixels.size());
+    tile->rasters().emplace_back(_id, texture);
+
+    return tile;
+}
+
+TEST_CASE("TileCache accounts memory and counts lookups", "[TileCache]") {
+    TileCache cache(16 * TILE_SIZE);
+
+    cache.put(0, makeTile(TileID(0, 0, 5)));
+    cache.put(0, makeTile(TileID(1, 0, 5)));
+    cache.put(1, makeTile(TileID(0, 0, 5)));
+
+    CHECK(cache.getMemoryUsage() == 3 * TILE_SIZE);
+    CHECK(cache.stats().cpuBytes == 3 * TILE_SIZE);
+    CHECK(cache.stats().gpuBytes == 0);
+    CHECK(cache.stats().tiles == 3);
+
+    CHECK(cache.contains(1, TileID(0, 0, 5)));
+    CHECK(cache.stats().hits == 0);
+
+    CHECK(cache.get(0, TileID(1, 0, 5)));
+    CHECK(!cache.get(0, TileID(1, 0, 5)));
+    CHECK(!cache.get(2, TileID(0, 0, 5)));
+
+    CHECK(cache.stats().hits == 1);
+    CHECK(cache.stats().misses == 2);
+    CHECK(cache.getMemoryUsage() == 2 * TILE_SIZE);
+
+    // Putting a tile again replaces the previous entry
+    cache.put(0, makeTile(TileID(0, 0, 5)));
+    CHECK(cache.getMemoryUsage() == 2 * TILE_SIZE);
+    CHECK(cache.stats().tiles == 2);
+
+    cache.clear();
+    CHECK(cache.getMemoryUsage() == 0);
+    CHECK(cache.stats().tiles == 0);
+    CHECK(cache.stats().hits == 1);
+}
+
+TEST_CASE("TileCache evicts least recently cached tiles of equal cost first", "[TileCache]") {
+    TileCache cache(4 * TILE_SIZE);
+
+    for (int i = 0; i < 6; i++) {
+        cache.put(0, makeTile(TileID(i, 0, 5)));
+    }
+    CHECK(cache.stats().evictions == 2);
+    CHECK(cache.getMemoryUsage() == 4 * TILE_SIZE);
+
+    CHECK(!cache.contains(0, TileID(0, 0, 5)));
+    CHECK(!cache.contains(0, TileID(1, 0, 5)));
+    for (int i = 2; i < 6; i++) {
+        CHECK(cache.contains(0, TileID(i, 0, 5)));
+    }
+
+    cache.limitCacheSize(TILE_SIZE);
+    CHECK(cache.stats().evictions == 5);
+    CHECK(cache.contains(0, TileID(5, 0, 5)));
+}
+
+TEST_CASE("TileCache keeps tiles that are expensive to rebuild", "[TileCache]") {
+    TileCache cache(4 * TILE_SIZE);
+
+    cache.put(0, makeTile(TileID(0, 0, 5), 100.f));
+    for (int i = 1; i < 8; i++) {
+        cache.put(0, makeTile(TileID(i, 0, 5), 1.f));
+    }
+
+    CHECK(cache.contains(0, TileID(0, 0, 5)));
+    CHECK(!cache.contains(0, TileID(1, 0, 5)));
+    CHECK(cache.contains(0, TileID(7, 0, 5)));
+}
+
+TEST_CASE("TileCache keeps parent tiles of the current zoom", "[TileCache]") {
+    TileCache cache(4 * TILE_SIZE);
+    cache.setZoom(6);
+
+    cache.put(0, makeTile(TileID(0, 0, 5)));
+    cache.put(0, makeTile(TileID(0, 0, 2)));
+    for (int i = 0; i < 6; i++) {
+        cache.put(0, makeTile(TileID(i, 0, 6)));
+    }
+
+    CHECK(cache.contains(0, TileID(0, 0, 5)));
+    CHECK(!cache.contains(0, TileID(0, 0, 2)));
+    CHECK(cache.contains(0, TileID(5, 0, 6)));
+}
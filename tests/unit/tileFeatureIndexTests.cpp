@@ -0,0 +1,116 @@
+#include "catch.hpp"
+
+#include "data/tileFeatureIndex.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace Tangram;
+
+static BoundingBox box(double _minLng, double _minLat, double _maxLng, double _maxLat) {
+    return { { _minLng, _minLat }, { _maxLng, _maxLat } };
+}
+
+static std::vector<uint64_t> query(const TileFeatureIndex& _index, TileID _tile) {
+    std::vector<uint64_t> ids;
+    _index.query(_tile, ids);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Tiles at zoom 14 around the Greenwich meridian, north of the equator
+static const TileID west(8191, 8191, 14);
+static const TileID east(8192, 8191, 14);
+
+TEST_CASE("TileFeatureIndex finds features in the tiles they intersect", "[TileFeatureIndex]") {
+    TileFeatureIndex index;
+
+    // Small features on either side of the meridian
+    index.insert(1, box(-0.01, 0.005, -0.005, 0.01), 2);
+    index.insert(2, box(0.005, 0.005, 0.01, 0.01), 3);
+    // Large feature covering both
+    index.insert(3, box(-10, -10, 10, 10), 4);
+
+    CHECK(index.size() == 3);
+
+    CHECK(query(index, west) == std::vector<uint64_t>({ 1, 3 }));
+    CHECK(query(index, east) == std::vector<uint64_t>({ 2, 3 }));
+    CHECK(query(index, TileID(0, 0, 0)) == std::vector<uint64_t>({ 1, 2, 3 }));
+    CHECK(query(index, TileID(0, 1, 1)) == std::vector<uint64_t>({ 3 }));
+    CHECK(query(index, TileID(5, 5, 4)).empty());
+
+    // Tiles above the index zoom use their parent at MAX_ZOOM
+    CHECK(query(index, TileID(east.x * 4, east.y * 4, 16)) == std::vector<uint64_t>({ 2, 3 }));
+}
+
+TEST_CASE("TileFeatureIndex only marks tiles of changed features", "[TileFeatureIndex]") {
+    TileFeatureIndex index;
+    index.clear(1);
+
+    index.insert(1, box(-0.01, 0.005, -0.005, 0.01), 2);
+    index.insert(2, box(0.005, 0.005, 0.01, 0.01), 3);
+
+    CHECK(index.generation(west) == 2);
+    CHECK(index.generation(east) == 3);
+    CHECK(index.generation(TileID(0, 0, 0)) == 3);
+    CHECK(index.generation(TileID(5, 5, 4)) == 1);
+
+    // Moving a feature marks the tiles it left and the tiles it entered
+    index.insert(1, box(0.005, 0.005, 0.01, 0.01), 4);
+    CHECK(index.generation(west) == 4);
+    CHECK(index.generation(east) == 4);
+    CHECK(query(index, west).empty());
+    CHECK(query(index, east) == std::vector<uint64_t>({ 1, 2 }));
+
+    index.touch(2, 5);
+    CHECK(index.generation(west) == 4);
+    CHECK(index.generation(east) == 5);
+
+    // A large feature changes all tiles below it
+    index.insert(3, box(-10, -10, 10, 10), 6);
+    CHECK(index.generation(west) == 6);
+    CHECK(index.generation(TileID(12, 12, 4)) == 1);
+
+    CHECK(index.remove(2, 7));
+    CHECK_FALSE(index.remove(2, 8));
+    CHECK(index.generation(east) == 7);
+    CHECK(index.generation(west) == 6);
+    CHECK(query(index, east) == std::vector<uint64_t>({ 1, 3 }));
+
+    index.clear(9);
+    CHECK(index.size() == 0);
+    CHECK(index.generation(east) == 9);
+    CHECK(query(index, east).empty());
+}
+
+TEST_CASE("TileFeatureIndex drops tiles without features", "[TileFeatureIndex]") {
+    TileFeatureIndex index;
+    index.clear(1);
+
+    index.insert(1, box(-0.01, 0.005, -0.005, 0.01), 2);
+    index.insert(2, box(0.005, 0.005, 0.01, 0.01), 3);
+    // One tile per zoom for each feature, they share the root
+    CHECK(index.tileCount() == 2 * 15 - 1);
+
+    // Moving a feature drops the tiles it left
+    index.insert(1, box(0.005, 0.005, 0.01, 0.01), 4);
+    CHECK(index.tileCount() == 15);
+    CHECK(query(index, west).empty());
+
+    // Dropped tiles and the tiles below them keep their last change
+    CHECK(index.generation(west) == 4);
+    CHECK(index.generation(TileID(west.x * 2, west.y * 2, 15)) == 4);
+    CHECK(index.generation(TileID(west.x - 1, west.y, 14)) == 4);
+    CHECK(index.generation(east) == 4);
+    CHECK(index.generation(TileID(12, 12, 4)) == 1);
+
+    CHECK(index.remove(1, 5));
+    CHECK(index.tileCount() == 15);
+    CHECK(index.generation(east) == 5);
+
+    CHECK(index.remove(2, 6));
+    CHECK(index.tileCount() == 0);
+    CHECK(index.generation(east) == 6);
+    CHECK(index.generation(west) == 6);
+    CHECK(query(index, TileID(0, 0, 0)).empty());
+}
@@ -0,0 +1,210 @@
+#include "catch.hpp"
+
+#include "data/properties.h"
+#include "data/tileSource.h"
+#include "gl/mesh.h"
+#include "scene/scene.h"
+#include "selection/featureSelection.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "tile/tileMeshCache.h"
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+static const char* SEGMENT_PATH = "tileMeshCacheTest.seg";
+static const char* INDEX_PATH = "tileMeshCacheTest.seg.idx";
+static const uint32_t DATA_HASH = 0x1234;
+
+struct TestVertex {
+    glm::vec2 pos;
+    GLuint selection;
+};
+
+struct TestMesh : public Mesh<TestVertex> {
+    using Mesh<TestVertex>::Mesh;
+
+    const TestVertex* vertices() const {
+        return reinterpret_cast<const TestVertex*>(m_glVertexData);
+    }
+};
+
+// Meshes which can only be built from tile data, like label sets
+struct BuildOnlyMesh : public StyledMesh {
+    bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) override { return false; }
+    size_t bufferSize() const override { return 0; }
+};
+
+class TestStyle : public Style {
+public:
+    TestStyle(std::string _name) : Style(_name, Blending::opaque, GL_TRIANGLES, true) {
+        constructVertexLayout();
+    }
+
+    void constructVertexLayout() override {
+        m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
+            {"a_position", 2, GL_FLOAT, false, 0},
+            {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        }));
+    }
+    void constructShaderProgram() override {}
+    std::unique_ptr<StyleBuilder> createBuilder() const override { return nullptr; }
+};
+
+struct TestScene {
+    std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+    std::shared_ptr<TileSource> source = std::make_shared<TileSource>("test", nullptr);
+    TileID tileID{ 1, 2, 3 };
+
+    TestScene() {
+        std::remove(SEGMENT_PATH);
+        std::remove(INDEX_PATH);
+
+        scene->featureSelection() = std::make_unique<FeatureSelection>();
+        auto style = std::make_unique<TestStyle>("polygons");
+        style->setID(0);
+        scene->styles().push_back(std::move(style));
+    }
+
+    ~TestScene() {
+        std::remove(SEGMENT_PATH);
+        std::remove(INDEX_PATH);
+    }
+
+    const Style& style() const { return *scene->styles()[0]; }
+
+    std::unique_ptr<Tile> buildTile(GLuint _selection = 0) {
+        MeshData<TestVertex> meshData;
+        meshData.vertices = { {{0, 0}, _selection}, {{1, 0}, _selection},
+                              {{1, 1}, _selection}, {{0, 1}, 0} };
+        meshData.indices = { 0, 1, 2, 2, 3, 0 };
+        meshData.offsets.emplace_back(6, 4);
+
+        auto mesh = std::make_unique<TestMesh>(style().vertexLayout(), GL_TRIANGLES);
+        mesh->compile(meshData);
+
+        auto tile = std::make_unique<Tile>(tileID, source->id(), source->generation());
+        tile->initGeometry(1);
+        tile->setMesh(style(), std::move(mesh));
+        return tile;
+    }
+};
+
+static std::vector<char> serialize(const Tile& _tile, const Style& _style) {
+    std::vector<char> data;
+    REQUIRE(_tile.getMesh(_style));
+    REQUIRE(_tile.getMesh(_style)->serialize(data));
+    return data;
+}
+
+TEST_CASE("Restore the meshes of a stored tile", "[TileMeshCache]") {
+    TestScene test;
+    TileMeshCache cache(SEGMENT_PATH, 1024 * 1024);
+    bool complete = false;
+
+    auto tile = test.buildTile();
+
+    REQUIRE(cache.restore(test.tileID, *test.source, *test.scene, 1, DATA_HASH, complete) == nullptr);
+    REQUIRE(cache.store(*tile, *test.source, *test.scene, 1, DATA_HASH));
+    cache.flush();
+
+    auto restored = cache.restore(test.tileID, *test.source, *test.scene, 1, DATA_HASH, complete);
+    REQUIRE(restored != nullptr);
+    CHECK(complete);
+    CHECK(restored->getID() == test.tileID);
+    CHECK(restored->getSelectionFeatures().size() == 0);
+    CHECK(restored->getMesh(test.style())->bufferSize() == tile->getMesh(test.style())->bufferSize());
+    CHECK(serialize(*restored, test.style()) == serialize(*tile, test.style()));
+
+    // Records are only used for the scene, tile data, source and source
+    // generation they were built with
+    CHECK(cache.restore(test.tileID, *test.source, *test.scene, 2, DATA_HASH, complete) == nullptr);
+    CHECK(cache.restore(test.tileID, *test.source, *test.scene, 1, DATA_HASH + 1, complete) == nullptr);
+
+    TileSource otherSource("other", nullptr);
+    CHECK(cache.restore(test.tileID, otherSource, *test.scene, 1, DATA_HASH, complete) == nullptr);
+
+    TileID overzoomed(test.tileID.x, test.tileID.y, test.tileID.z, test.tileID.z + 1);
+    CHECK(cache.restore(overzoomed, *test.source, *test.scene, 1, DATA_HASH, complete) == nullptr);
+
+    test.source->clearData();
+    CHECK(cache.restore(test.tileID, *test.source, *test.scene, 1, DATA_HASH, complete) == nullptr);
+}
+
+TEST_CASE("Restored selection features get new selection colors", "[TileMeshCache]") {
+    TestScene test;
+    TileMeshCache cache(SEGMENT_PATH, 1024 * 1024);
+    bool complete = false;
+
+    const GLuint storedColor = 7;
+    auto tile = test.buildTile(storedColor);
+
+    fastmap<uint32_t, std::shared_ptr<Properties>> features;
+    features[storedColor] = std::make_shared<Properties>();
+    features[storedColor]->set("name", "park");
+    features[storedColor]->set("area", 42.0);
+    tile->setSelectionFeatures(features);
+
+    REQUIRE(cache.store(*tile, *test.source, *test.scene, 1, DATA_HASH));
+
+    auto restored = cache.restore(test.tileID, *test.source, *test.scene, 1, DATA_HASH, complete);
+    REQUIRE(restored != nullptr);
+
+    const auto& restoredFeatures = restored->getSelectionFeatures();
+    REQUIRE(restoredFeatures.size() == 1);
+
+    uint32_t color = restoredFeatures.begin()->first;
+    const auto& props = *restoredFeatures.begin()->second;
+    CHECK(color != storedColor);
+    CHECK(props.getString("name") == "park");
+    CHECK(props.getNumber("area") == 42.0);
+    CHECK(props.sourceId == test.source->id());
+
+    // Read back the vertices of the restored mesh
+    auto data = serialize(*restored, test.style());
+    TestMesh mesh(test.style().vertexLayout(), GL_TRIANGLES);
+    REQUIRE(mesh.restore(data.data(), data.size(), {}));
+
+    CHECK(mesh.vertices()[0].selection == color);
+    CHECK(mesh.vertices()[2].selection == color);
+    CHECK(mesh.vertices()[3].selection == 0);
+}
+
+TEST_CASE("Tiles with meshes that cannot be serialized are not stored", "[TileMeshCache]") {
+    TestScene test;
+    TileMeshCache cache(SEGMENT_PATH, 1024 * 1024);
+    bool complete = false;
+
+    auto tile = std::make_unique<Tile>(test.tileID, test.source->id(), test.source->generation());
+    tile->initGeometry(1);
+    tile->setMesh(test.style(), std::make_unique<BuildOnlyMesh>());
+
+    CHECK_FALSE(cache.store(*tile, *test.source, *test.scene, 1, DATA_HASH));
+    cache.flush();
+    CHECK(cache.restore(test.tileID, *test.source, *test.scene, 1, DATA_HASH, complete) == nullptr);
+}
+
+TEST_CASE("Label meshes are left out and marked for rebuilding", "[TileMeshCache]") {
+    TestScene test;
+    TileMeshCache cache(SEGMENT_PATH, 1024 * 1024);
+    bool complete = true;
+
+    auto labels = std::make_unique<TestStyle>("labels");
+    labels->setID(1);
+    test.scene->styles().push_back(std::move(labels));
+    const Style& labelStyle = *test.scene->styles()[1];
+
+    auto tile = test.buildTile();
+    tile->setMesh(labelStyle, std::make_unique<BuildOnlyMesh>());
+
+    REQUIRE(cache.store(*tile, *test.source, *test.scene, 1, DATA_HASH));
+
+    auto restored = cache.restore(test.tileID, *test.source, *test.scene, 1, DATA_HASH, complete);
+    REQUIRE(restored != nullptr);
+    CHECK_FALSE(complete);
+    CHECK(serialize(*restored, test.style()) == serialize(*tile, test.style()));
+    CHECK(restored->getMesh(labelStyle) == nullptr);
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include "tile/tilePrefetcher.h"
+#include "view/view.h"
+
+#include <algorithm>
+#include <set>
+
+using namespace Tangram;
+
+static View makeView() {
+    View view(512, 512);
+    view.setPosition(0, 0);
+    view.setZoom(10);
+    view.update(false);
+    return view;
+}
+
+static std::set<TileID> visibleTiles(const View& _view) {
+    std::set<TileID> tiles;
+    _view.getVisibleTiles([&](TileID _tileID) { tiles.insert(_tileID); });
+    return tiles;
+}
+
+TEST_CASE("TilePrefetcher predicts nothing for a still camera", "[TilePrefetcher]") {
+    View view = makeView();
+    TilePrefetcher prefetcher;
+
+    for (int i = 0; i < 5; i++) {
+        view.update(false);
+        prefetcher.update(view, 1.f / 60);
+    }
+
+    REQUIRE(prefetcher.tiles().empty());
+    REQUIRE(prefetcher.velocity() == glm::dvec3(0.0));
+}
+
+TEST_CASE("TilePrefetcher extrapolates the camera velocity", "[TilePrefetcher]") {
+    View view = makeView();
+    TilePrefetcher prefetcher;
+
+    // Pan east by 16 pixels per frame at 60fps
+    double step = 16.0 / view.pixelsPerMeter();
+    double x = 0;
+
+    for (int i = 0; i < 5; i++) {
+        x += step;
+        view.setPosition(x, 0);
+        view.update(false);
+        prefetcher.update(view, 1.f / 60);
+    }
+
+    REQUIRE(prefetcher.velocity().x > 0);
+    REQUIRE(!prefetcher.tiles().empty());
+
+    auto visible = visibleTiles(view);
+    int maxVisibleX = 0;
+    for (auto& tile : visible) { maxVisibleX = std::max(maxVisibleX, tile.x); }
+
+    for (auto& tile : prefetcher.tiles()) {
+        REQUIRE(visible.count(tile) == 0);
+        // Only tiles ahead of the camera
+        REQUIRE(tile.x > maxVisibleX);
+    }
+
+    // A long pause resets the estimate
+    prefetcher.update(view, 1.f);
+    REQUIRE(prefetcher.tiles().empty());
+}
+
+TEST_CASE("TilePrefetcher samples the path of a camera animation", "[TilePrefetcher]") {
+    View view = makeView();
+    TilePrefetcher prefetcher;
+
+    View target = makeView();
+    double distance = 100.0 * 256 / target.pixelsPerMeter();
+    target.setPosition(distance, 0);
+    target.update(false);
+    auto destination = visibleTiles(target);
+
+    prefetcher.setLookahead(1.f, 4);
+    prefetcher.setPath([&](float t) { return glm::dvec3(distance * t, 0.0, 10.0); }, 1.f);
+
+    prefetcher.update(view, 0.f);
+
+    // The last sample is the end of the animation
+    auto& tiles = prefetcher.tiles();
+    REQUIRE(!tiles.empty());
+    REQUIRE(std::all_of(destination.begin(), destination.end(), [&](const TileID& _tile) {
+        return std::find(tiles.begin(), tiles.end(), _tile) != tiles.end();
+    }));
+
+    // The path is dropped once the animation is over
+    prefetcher.update(view, 2.f);
+    REQUIRE(prefetcher.tiles().empty());
+}
@@ -0,0 +1,173 @@
+#include "catch.hpp"
+
+#include "data/tileSource.h"
+#include "tile/tileScheduler.h"
+#include "tile/tileTask.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+static std::shared_ptr<TileTask> makeTask(std::shared_ptr<TileSource> _source, int _x,
+                                          double _priority, bool _proxy = false) {
+    TileID tileId(_x, 0, 10);
+    auto task = std::make_shared<TileTask>(tileId, _source, -1);
+    task->setPriority(_priority);
+    task->setProxyState(_proxy);
+    return task;
+}
+
+TEST_CASE("TileScheduler pops tasks in priority order", "[TileScheduler]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    TileScheduler scheduler(2);
+
+    std::vector<double> priorities = { 5, 3, 9, 1, 7, 2, 8 };
+    for (size_t i = 0; i < priorities.size(); i++) {
+        scheduler.push(makeTask(source, i, priorities[i]));
+    }
+    REQUIRE(scheduler.size() == priorities.size());
+
+    // A single queue must be drained strictly by priority
+    TileScheduler single(1);
+    for (size_t i = 0; i < priorities.size(); i++) {
+        single.push(makeTask(source, i, priorities[i]));
+    }
+    double last = -1;
+    while (auto task = single.pop(0)) {
+        CHECK(task->getPriority() >= last);
+        last = task->getPriority();
+    }
+    CHECK(single.empty());
+
+    size_t popped = 0;
+    while (scheduler.pop(0)) { popped++; }
+    CHECK(popped == priorities.size());
+    CHECK(scheduler.empty());
+}
+
+TEST_CASE("TileScheduler orders proxy tasks last", "[TileScheduler]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    TileScheduler scheduler(2);
+
+    scheduler.push(makeTask(source, 0, 0, true));
+    scheduler.push(makeTask(source, 1, 0, true));
+    scheduler.push(makeTask(source, 2, 10));
+    scheduler.push(makeTask(source, 3, 20));
+
+    // Proxy tasks in the own queue are outranked by regular tasks of other queues
+    CHECK(!scheduler.pop(0)->isProxy());
+    CHECK(!scheduler.pop(0)->isProxy());
+    CHECK(scheduler.pop(0)->isProxy());
+    CHECK(scheduler.pop(0)->isProxy());
+    CHECK(scheduler.pop(0) == nullptr);
+}
+
+TEST_CASE("TileScheduler orders prefetch tasks after proxy tasks", "[TileScheduler]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    TileScheduler scheduler(2);
+
+    // Visible and proxy tiles at low zoom have priorities far beyond those of
+    // prefetch tasks close to the view center
+    auto prefetch = makeTask(source, 0, 1);
+    prefetch->setPrefetchState(true);
+    scheduler.push(prefetch);
+    scheduler.push(makeTask(source, 1, 1e14, true));
+    scheduler.push(makeTask(source, 2, 1e15));
+
+    CHECK(!scheduler.pop(0)->isProxy());
+    CHECK(scheduler.pop(0)->isProxy());
+    CHECK(scheduler.pop(0) == prefetch);
+    CHECK(scheduler.pop(0) == nullptr);
+
+    // A prefetch task that is taken over by a visible tile ranks with it
+    TileScheduler single(1);
+    auto taken = makeTask(source, 3, 5);
+    taken->setPrefetchState(true);
+    single.push(taken);
+    single.push(makeTask(source, 4, 10));
+
+    taken->setPrefetchState(false);
+    single.updatePriorities();
+
+    CHECK(single.pop(0) == taken);
+}
+
+TEST_CASE("TileScheduler drops canceled tasks", "[TileScheduler]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    TileScheduler scheduler(1);
+
+    auto a = makeTask(source, 0, 1);
+    auto b = makeTask(source, 1, 2);
+    scheduler.push(a);
+    scheduler.push(b);
+
+    a->cancel();
+
+    CHECK(scheduler.pop(0) == b);
+    CHECK(scheduler.pop(0) == nullptr);
+    CHECK(scheduler.empty());
+}
+
+TEST_CASE("TileScheduler re-keys tasks on updatePriorities", "[TileScheduler]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    TileScheduler scheduler(1);
+
+    auto a = makeTask(source, 0, 1);
+    auto b = makeTask(source, 1, 2);
+    scheduler.push(a);
+    scheduler.push(b);
+
+    b->setPriority(0);
+    scheduler.updatePriorities();
+
+    CHECK(scheduler.pop(0) == b);
+    CHECK(scheduler.pop(0) == a);
+}
+
+TEST_CASE("TileScheduler prefers tasks of outdated source generation", "[TileScheduler]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+    TileScheduler scheduler(1);
+
+    auto old = makeTask(source, 0, 10);
+    source->clearData();
+    auto current = makeTask(source, 1, 1);
+
+    scheduler.push(old);
+    scheduler.push(current);
+
+    CHECK(scheduler.pop(0) == old);
+    CHECK(scheduler.pop(0) == current);
+}
+
+TEST_CASE("TileScheduler concurrent push and steal", "[TileScheduler]") {
+    auto source = std::make_shared<TileSource>("test", nullptr);
+
+    const int numWorkers = 4;
+    const int numTasks = 2000;
+
+    TileScheduler scheduler(numWorkers);
+    std::atomic<int> popped{0};
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < numWorkers; w++) {
+        workers.emplace_back([&, w] {
+            while (!done || !scheduler.empty()) {
+                if (scheduler.pop(w)) { popped++; }
+            }
+        });
+    }
+
+    for (int i = 0; i < numTasks; i++) {
+        scheduler.push(makeTask(source, i, i % 17));
+    }
+    done = true;
+
+    for (auto& worker : workers) { worker.join(); }
+
+    CHECK(popped == numTasks);
+    CHECK(scheduler.empty());
+}
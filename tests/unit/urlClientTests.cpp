@@ -0,0 +1,242 @@
+#include "catch.hpp"
+
+#include "urlClient.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+// Minimal HTTP/1.1 server on localhost. Responds to 'GET /<name>' with <name>
+// as content, after 'delayMs' for paths starting with '/slow', with 404 for
+// paths starting with '/missing'.
+class TestServer {
+public:
+    int delayMs = 200;
+
+    TestServer() {
+        m_socket = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(m_socket, 16);
+
+        socklen_t len = sizeof(addr);
+        getsockname(m_socket, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+
+        m_acceptThread = std::thread([this]() {
+            while (true) {
+                int client = accept(m_socket, nullptr, nullptr);
+                if (client < 0) { break; }
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_clients.push_back(client);
+                m_clientThreads.emplace_back(&TestServer::serve, this, client);
+            }
+        });
+    }
+
+    ~TestServer() {
+        shutdown(m_socket, SHUT_RDWR);
+        close(m_socket);
+        m_acceptThread.join();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (int client : m_clients) { shutdown(client, SHUT_RDWR); }
+        }
+        for (auto& thread : m_clientThreads) { thread.join(); }
+        for (int client : m_clients) { close(client); }
+    }
+
+    std::string url(const std::string& _path) const {
+        return "http://127.0.0.1:" + std::to_string(m_port) + _path;
+    }
+
+    int hits(const std::string& _path) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hits[_path];
+    }
+
+    std::vector<std::string> requested() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_requested;
+    }
+
+private:
+    void serve(int _client) {
+        std::string buffer;
+        char chunk[1024];
+        while (true) {
+            size_t end = buffer.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                ssize_t n = recv(_client, chunk, sizeof(chunk), 0);
+                if (n <= 0) { return; }
+                buffer.append(chunk, n);
+                continue;
+            }
+            std::string request = buffer.substr(0, end);
+            buffer.erase(0, end + 4);
+
+            size_t start = request.find(' ') + 1;
+            std::string path = request.substr(start, request.find(' ', start) - start);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_hits[path]++;
+                m_requested.push_back(path);
+            }
+
+            if (path.compare(0, 5, "/slow") == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+            }
+
+            std::string response;
+            if (path.compare(0, 8, "/missing") == 0) {
+                response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+            } else {
+                std::string body = path.substr(1);
+                response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) +
+                    "\r\n\r\n" + body;
+            }
+            send(_client, response.data(), response.size(), MSG_NOSIGNAL);
+        }
+    }
+
+    int m_socket;
+    int m_port;
+    std::thread m_acceptThread;
+    std::vector<std::thread> m_clientThreads;
+    std::vector<int> m_clients;
+    std::mutex m_mutex;
+    std::map<std::string, int> m_hits;
+    std::vector<std::string> m_requested;
+};
+
+struct Results {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> contents;
+    std::vector<std::string> errors;
+
+    UrlCallback callback() {
+        return [this](UrlResponse&& response) {
+            std::lock_guard<std::mutex> lock(mutex);
+            contents.emplace_back(response.content.begin(), response.content.end());
+            errors.emplace_back(response.error ? response.error : "");
+            cv.notify_all();
+        };
+    }
+
+    bool waitFor(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&]() { return contents.size() >= count; });
+    }
+};
+
+TEST_CASE("UrlClient fetches content and reports errors", "[UrlClient]") {
+    TestServer server;
+    Results results;
+    {
+        UrlClient client(UrlClient::Options{});
+
+        client.addRequest(server.url("/tile"), results.callback());
+        REQUIRE(results.waitFor(1));
+        REQUIRE(results.contents[0] == "tile");
+        REQUIRE(results.errors[0].empty());
+
+        client.addRequest(server.url("/missing"), results.callback());
+        REQUIRE(results.waitFor(2));
+        REQUIRE(!results.errors[1].empty());
+    }
+}
+
+TEST_CASE("UrlClient coalesces requests for the same URL", "[UrlClient]") {
+    TestServer server;
+    Results results;
+    {
+        UrlClient client(UrlClient::Options{});
+
+        client.addRequest(server.url("/slow-a"), results.callback());
+        client.addRequest(server.url("/slow-a"), results.callback());
+        client.addRequest(server.url("/slow-a"), results.callback());
+
+        REQUIRE(results.waitFor(3));
+        for (auto& content : results.contents) { REQUIRE(content == "slow-a"); }
+        REQUIRE(server.hits("/slow-a") == 1);
+    }
+}
+
+TEST_CASE("UrlClient cancels requests", "[UrlClient]") {
+    TestServer server;
+    Results canceled;
+    Results completed;
+    {
+        UrlClient client(UrlClient::Options{});
+
+        auto handle = client.addRequest(server.url("/slow-b"), canceled.callback());
+        client.addRequest(server.url("/slow-b"), completed.callback());
+
+        // Canceling one request runs its callback right away
+        client.cancelRequest(handle);
+        REQUIRE(canceled.contents.size() == 1);
+        REQUIRE(canceled.errors[0] == "Request cancelled");
+
+        // The other request for the same URL still completes
+        REQUIRE(completed.waitFor(1));
+        REQUIRE(completed.contents[0] == "slow-b");
+
+        // Canceling a pending request drops its transfer
+        UrlClient::Options options;
+        options.maxActiveTasksPerHost = 1;
+        UrlClient limited(options);
+        limited.addRequest(server.url("/slow-c"), completed.callback());
+        auto pending = limited.addRequest(server.url("/d"), canceled.callback());
+        limited.cancelRequest(pending);
+        REQUIRE(completed.waitFor(2));
+        REQUIRE(server.hits("/d") == 0);
+    }
+}
+
+TEST_CASE("UrlClient starts requests by priority within the host limit", "[UrlClient]") {
+    TestServer server;
+    Results results;
+    {
+        UrlClient::Options options;
+        options.maxActiveTasksPerHost = 1;
+        UrlClient client(options);
+
+        // Occupy the only slot for the host
+        client.addRequest(server.url("/slow-e"), results.callback());
+
+        auto p3 = client.addRequest(server.url("/p3"), results.callback());
+        auto p1 = client.addRequest(server.url("/p1"), results.callback());
+        auto p2 = client.addRequest(server.url("/p2"), results.callback());
+        client.setRequestPriority(p3, 3);
+        client.setRequestPriority(p1, 1);
+        client.setRequestPriority(p2, 2);
+
+        REQUIRE(results.waitFor(4));
+    }
+
+    auto requested = server.requested();
+    REQUIRE(requested.size() == 4);
+    REQUIRE(requested[0] == "/slow-e");
+    REQUIRE(requested[1] == "/p1");
+    REQUIRE(requested[2] == "/p2");
+    REQUIRE(requested[3] == "/p3");
+}